@@ -0,0 +1,41 @@
+#include <stdlib.h>
+#include "Arena.h"
+
+using namespace std;
+
+/*********************
+ * ARENA
+ * *******************/
+
+Arena::Arena():next(NULL), end(NULL){}
+
+Arena::~Arena()
+{
+     Release();
+}
+
+void* Arena::allocateSlow(size_t size)
+{
+     //Big allocations get a block to themselves so the current one isn't wasted
+     if(size > ARENA_BLOCK_SIZE / 4)
+     {
+          char* block = (char*)malloc(size);
+          blocks.push_back(block);
+          return block;
+     }
+
+     char* block = (char*)malloc(ARENA_BLOCK_SIZE);
+     blocks.push_back(block);
+     next = block + size;
+     end = block + ARENA_BLOCK_SIZE;
+     return block;
+}
+
+void Arena::Release()
+{
+     for(size_t i = 0; i < blocks.size(); i++)
+          free(blocks[i]);
+     blocks.clear();
+     next = NULL;
+     end = NULL;
+}
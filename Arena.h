@@ -0,0 +1,137 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      Arena.h
+     Purpose:       A bump-pointer arena. Many small objects that all live
+                    exactly as long as each other, like the nodes of a syntax
+                    tree, are carved out of a few large blocks one after
+                    another and given back all at once.
+
+*/
+
+/** @defgroup ARENA Arena
+ *  Bump-pointer allocation, released in one shot.
+ *  @{
+ */
+
+#ifndef ARENA
+#define ARENA
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+//Bytes in each block the arena carves allocations out of
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+/**
+ * @brief Hands out memory from large blocks by bumping a pointer. Nothing is
+ * freed on its own; everything goes back at once when the arena is released or
+ * destroyed, without running any destructors.
+ *
+ */
+class Arena
+{
+     public:
+          /**
+           * @brief Construct a new, empty arena. No block is made until the first
+           * allocation.
+           *
+           */
+          Arena();
+
+          /**
+           * @brief Gives back every block.
+           *
+           */
+          ~Arena();
+
+          /**
+           * @brief Carves out memory suitably aligned for any object.
+           *
+           * @param size Number of bytes.
+           * @return void* The memory, which stays valid until the arena is released.
+           */
+          void* Allocate(size_t size)
+          {
+               size = (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+               if(size > (size_t)(end - next))
+                    return allocateSlow(size);
+               void* memory = next;
+               next += size;
+               return memory;
+          }
+
+          /**
+           * @brief Gives back every block at once, so the arena can be used again
+           * from empty.
+           *
+           */
+          void Release();
+
+     private:
+          /**
+           * @brief Starts a new block for an allocation that doesn't fit in what's
+           * left of the current one. Allocations too large to share a block get one
+           * of their own, leaving the current block in use.
+           *
+           */
+          void* allocateSlow(size_t size);
+
+          /**
+           * @brief Every block, in the order they were made.
+           *
+           */
+          vector<char*> blocks;
+
+          /**
+           * @brief The next free byte in the current block.
+           *
+           */
+          char* next;
+
+          /**
+           * @brief One past the last byte of the current block.
+           *
+           */
+          char* end;
+};
+
+/**
+ * @brief Lets standard containers keep their elements in an arena. Freeing does
+ * nothing; a container that grows leaves its old storage behind until the arena
+ * is released.
+ *
+ */
+template<class T>
+class ArenaAllocator
+{
+     public:
+          typedef T value_type;
+
+          ArenaAllocator(Arena* arena):arena(arena){}
+
+          template<class U>
+          ArenaAllocator(const ArenaAllocator<U> &other):arena(other.arena){}
+
+          T* allocate(size_t n)
+          {
+               return (T*)arena->Allocate(n * sizeof(T));
+          }
+
+          void deallocate(T* memory, size_t n){}
+
+          template<class U>
+          bool operator==(const ArenaAllocator<U> &other) const {return arena == other.arena;}
+
+          template<class U>
+          bool operator!=(const ArenaAllocator<U> &other) const {return arena != other.arena;}
+
+          /**
+           * @brief The arena allocations come from.
+           *
+           */
+          Arena* arena;
+};
+/** @} */
+#endif
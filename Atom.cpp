@@ -0,0 +1,100 @@
+#include <string.h>
+#include <vector>
+#include "Atom.h"
+
+using namespace std;
+
+//Slots in the table to start with; always a power of two
+#define ATOM_TABLE_INITIAL_SIZE 1024
+
+/*********************
+ * ATOM TABLE
+ * *******************/
+
+/**
+ * @brief Open addressing table of atoms, probed linearly and grown to keep it
+ * at most half full. Atoms are never removed.
+ *
+ */
+class AtomTable
+{
+     public:
+          AtomTable():slots(ATOM_TABLE_INITIAL_SIZE, (Atom)NULL), hashes(ATOM_TABLE_INITIAL_SIZE, 0), count(0){}
+
+          Atom Intern(const char* chars, size_t length)
+          {
+               unsigned int h = hash(chars, length);
+               size_t mask = slots.size() - 1;
+               size_t i = h & mask;
+               while(slots[i] != NULL)
+               {
+                    if(hashes[i] == h && slots[i]->size() == length && memcmp(slots[i]->data(), chars, length) == 0)
+                         return slots[i];
+                    i = (i + 1) & mask;
+               }
+
+               Atom atom = new string(chars, length);
+               slots[i] = atom;
+               hashes[i] = h;
+               if(++count * 2 > slots.size())
+                    grow();
+               return atom;
+          }
+
+     private:
+          static unsigned int hash(const char* chars, size_t length)
+          {
+               //FNV-1a
+               unsigned int h = 2166136261u;
+               for(size_t i = 0; i < length; i++)
+               {
+                    h ^= (unsigned char)chars[i];
+                    h *= 16777619u;
+               }
+               return h;
+          }
+
+          void grow()
+          {
+               vector<Atom> oldSlots(slots.size() * 2, (Atom)NULL);
+               vector<unsigned int> oldHashes(hashes.size() * 2, 0);
+               oldSlots.swap(slots);
+               oldHashes.swap(hashes);
+               size_t mask = slots.size() - 1;
+               for(size_t j = 0; j < oldSlots.size(); j++)
+               {
+                    if(oldSlots[j] == NULL)
+                         continue;
+                    size_t i = oldHashes[j] & mask;
+                    while(slots[i] != NULL)
+                         i = (i + 1) & mask;
+                    slots[i] = oldSlots[j];
+                    hashes[i] = oldHashes[j];
+               }
+          }
+
+          vector<Atom> slots;
+          vector<unsigned int> hashes;
+          size_t count;
+};
+
+//Made on first use, so atoms can be interned while other globals are set up
+static AtomTable &atomTable()
+{
+     static AtomTable* table = new AtomTable();
+     return *table;
+}
+
+Atom Intern(const char* chars, size_t length)
+{
+     return atomTable().Intern(chars, length);
+}
+
+Atom Intern(const string &text)
+{
+     return atomTable().Intern(text.data(), text.size());
+}
+
+const Atom ATOM_INT = Intern("int", 3);
+const Atom ATOM_STRING = Intern("string", 6);
+const Atom ATOM_UNIT = Intern("unit", 4);
@@ -0,0 +1,58 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      Atom.h
+     Purpose:       One table of every identifier and string literal in the
+                    program. The lexer interns each one as it is scanned, and
+                    every later stage keys on the interned atom, so names are
+                    compared and looked up by pointer instead of by characters.
+
+*/
+
+/** @defgroup ATOM Atoms
+ *  Interned identifiers.
+ *  @{
+ */
+
+#ifndef ATOM
+#define ATOM
+
+#include <string>
+#include <stddef.h>
+
+using namespace std;
+
+/**
+ * @brief An interned string. Two atoms are equal exactly when they are the same
+ * pointer, and the string they point at lives as long as the program does.
+ *
+ */
+typedef const string* Atom;
+
+/**
+ * @brief Returns the one atom for some characters, adding it to the table the
+ * first time they are seen.
+ *
+ * @param chars The first character.
+ * @param length Number of characters.
+ * @return Atom The atom for those characters.
+ */
+Atom Intern(const char* chars, size_t length);
+
+/**
+ * @brief Returns the one atom for a string.
+ *
+ * @param text The string.
+ * @return Atom The atom for its characters.
+ */
+Atom Intern(const string &text);
+
+/**
+ * @brief Atoms for the names of the builtin types, which semantic analysis
+ * checks against.
+ *
+ */
+extern const Atom ATOM_INT;
+extern const Atom ATOM_STRING;
+extern const Atom ATOM_UNIT;
+/** @} */
+#endif
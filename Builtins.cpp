@@ -0,0 +1,137 @@
+#include <iostream>
+#include <stdlib.h>
+#include "Builtins.h"
+#include "Output.h"
+
+using namespace std;
+
+/*********************
+ * SHARED OPERATIONS
+ * *******************/
+
+void builtinError(int lineNumber, const string &errorMessage)
+{
+     cout << "ERROR " << lineNumber << ": Runtime: " << errorMessage << endl;
+     exit(4);
+}
+
+string builtinGetchar()
+{
+     int c = cin.get();
+     if(c == EOF)
+          return string();
+     return string(1, (char)c);
+}
+
+int builtinOrd(const char* chars, int length)
+{
+     if(length == 0)
+          return -1;
+     return (unsigned char)chars[0];
+}
+
+string builtinChr(int code, int lineNumber)
+{
+     if(code < 0 || code > 255)
+          builtinError(lineNumber, "chr() of a code outside 0 to 255.");
+     return string(1, (char)code);
+}
+
+void builtinSubstringRange(int length, int first, int n, int lineNumber)
+{
+     //Compare against what's left so first + n can't overflow
+     if(first < 0 || n < 0 || first > length || n > length - first)
+          builtinError(lineNumber, "substring() out of range.");
+}
+
+void builtinExit(int code)
+{
+     output->Flush();
+     exit(code);
+}
+
+/*********************
+ * NATIVE FUNCTIONS
+ * *******************/
+
+static Value nativePrint(Value* args, int lineNumber)
+{
+     StringObject* s = args[0].GetStringObject();
+     output->Write(s->GetChars(), s->GetLength());
+     return Value();
+}
+static Value nativePrinti(Value* args, int lineNumber)
+{
+     output->WriteInt(args[0].GetInt());
+     return Value();
+}
+static Value nativeFlush(Value* args, int lineNumber)
+{
+     output->Flush();
+     return Value();
+}
+static Value nativeGetchar(Value* args, int lineNumber)
+{
+     return Value(new StringObject(builtinGetchar()));
+}
+static Value nativeOrd(Value* args, int lineNumber)
+{
+     StringObject* s = args[0].GetStringObject();
+     return Value(builtinOrd(s->GetChars(), s->GetLength()));
+}
+static Value nativeChr(Value* args, int lineNumber)
+{
+     return Value(new StringObject(builtinChr(args[0].GetInt(), lineNumber)));
+}
+static Value nativeSize(Value* args, int lineNumber)
+{
+     return Value(args[0].GetStringObject()->GetLength());
+}
+static Value nativeSubstring(Value* args, int lineNumber)
+{
+     StringObject* s = args[0].GetStringObject();
+     int first = args[1].GetInt();
+     int n = args[2].GetInt();
+     builtinSubstringRange(s->GetLength(), first, n, lineNumber);
+     if(n == s->GetLength())
+          return args[0];
+     return Value(new StringObject(s, first, n));
+}
+static Value nativeConcat(Value* args, int lineNumber)
+{
+     //Either side being empty means the other string object can be shared as is
+     StringObject* left = args[0].GetStringObject();
+     StringObject* right = args[1].GetStringObject();
+     if(left->GetLength() == 0)
+          return args[1];
+     if(right->GetLength() == 0)
+          return args[0];
+     return Value(new StringObject(left, right));
+}
+static Value nativeNot(Value* args, int lineNumber)
+{
+     return Value(args[0].GetInt() == 0 ? 1 : 0);
+}
+static Value nativeExit(Value* args, int lineNumber)
+{
+     builtinExit(args[0].GetInt());
+     return Value();
+}
+
+/*********************
+ * BUILTIN TABLE
+ * *******************/
+
+Builtin builtins[BUILTIN_COUNT] = {
+     {"print", BUILTIN_PRINT, "unit", 1, {{"s", "string"}}, nativePrint},
+     {"printi", BUILTIN_PRINTI, "unit", 1, {{"i", "int"}}, nativePrinti},
+     {"flush", BUILTIN_FLUSH, "unit", 0, {}, nativeFlush},
+     {"getchar", BUILTIN_GETCHAR, "string", 0, {}, nativeGetchar},
+     {"ord", BUILTIN_ORD, "int", 1, {{"s", "string"}}, nativeOrd},
+     {"chr", BUILTIN_CHR, "string", 1, {{"i", "int"}}, nativeChr},
+     {"size", BUILTIN_SIZE, "int", 1, {{"s", "string"}}, nativeSize},
+     {"substring", BUILTIN_SUBSTRING, "string", 3, {{"s", "string"}, {"first", "int"}, {"n", "int"}}, nativeSubstring},
+     {"concat", BUILTIN_CONCAT, "string", 2, {{"s1", "string"}, {"s2", "string"}}, nativeConcat},
+     {"not", BUILTIN_NOT, "int", 1, {{"i", "int"}}, nativeNot},
+     {"exit", BUILTIN_EXIT, "unit", 1, {{"i", "int"}}, nativeExit}
+};
@@ -0,0 +1,149 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      Builtins.h
+     Purpose:       The Tiger standard library: one table of the builtin functions,
+                    their signatures and the native code that runs them, which
+                    semantic analysis binds call sites to.
+
+*/
+
+/** @defgroup BUILTINS Builtin Functions
+ *  The standard library, implemented natively.
+ *  @{
+ */
+
+#ifndef BUILTINS
+#define BUILTINS
+
+#include <string>
+#include "SymbolTable.h"
+
+using namespace std;
+
+//Most parameters any builtin takes
+#define BUILTIN_MAX_PARAMS 3
+
+/**
+ * @brief Every builtin function, in the order they appear in the table.
+ *
+ */
+enum BuiltinKind
+{
+     BUILTIN_PRINT,      //print(s: string)
+     BUILTIN_PRINTI,     //printi(i: int)
+     BUILTIN_FLUSH,      //flush()
+     BUILTIN_GETCHAR,    //getchar(): string
+     BUILTIN_ORD,        //ord(s: string): int
+     BUILTIN_CHR,        //chr(i: int): string
+     BUILTIN_SIZE,       //size(s: string): int
+     BUILTIN_SUBSTRING,  //substring(s: string, first: int, n: int): string
+     BUILTIN_CONCAT,     //concat(s1: string, s2: string): string
+     BUILTIN_NOT,        //not(i: int): int
+     BUILTIN_EXIT,       //exit(i: int)
+     BUILTIN_COUNT
+};
+
+/**
+ * @brief Runs a builtin on arguments that are already evaluated.
+ *
+ * @param args The arguments, in order.
+ * @param lineNumber Line of the call, to report runtime errors on.
+ * @return Value The result, or an empty value for builtins returning unit.
+ */
+typedef Value (*BuiltinFunction)(Value* args, int lineNumber);
+
+/**
+ * @brief One builtin function: its signature, for semantic analysis, and the
+ * native code for the tree-walking engines. The compiled engines dispatch on
+ * its kind instead.
+ *
+ */
+class Builtin
+{
+     public:
+          /**
+           * @brief Name it is called by.
+           *
+           */
+          const char* name;
+
+          /**
+           * @brief Which builtin it is.
+           *
+           */
+          BuiltinKind kind;
+
+          /**
+           * @brief Name of the result type.
+           *
+           */
+          const char* result;
+
+          /**
+           * @brief Number of formal parameters.
+           *
+           */
+          int numParams;
+
+          /**
+           * @brief Name and type name of each formal parameter.
+           *
+           */
+          const char* params[BUILTIN_MAX_PARAMS][2];
+
+          /**
+           * @brief The native code that runs it.
+           *
+           */
+          BuiltinFunction function;
+};
+
+/**
+ * @brief Every builtin, indexed by kind.
+ *
+ */
+extern Builtin builtins[BUILTIN_COUNT];
+
+/**
+ * @brief Stops the program with a runtime error.
+ *
+ */
+void builtinError(int lineNumber, const string &errorMessage);
+
+/**
+ * @brief Reads one character from standard input.
+ *
+ * @return string The character, or the empty string at end of input.
+ */
+string builtinGetchar();
+
+/**
+ * @brief The character code of the first character of a string.
+ *
+ * @param chars The string's characters.
+ * @param length Number of characters.
+ * @return int The code, or -1 for the empty string.
+ */
+int builtinOrd(const char* chars, int length);
+
+/**
+ * @brief A one character string, stopping the program if the code is not
+ * between 0 and 255.
+ *
+ */
+string builtinChr(int code, int lineNumber);
+
+/**
+ * @brief Stops the program if the n characters starting at first aren't all
+ * inside a string of the given length.
+ *
+ */
+void builtinSubstringRange(int length, int first, int n, int lineNumber);
+
+/**
+ * @brief Flushes output and ends the program with a status code.
+ *
+ */
+void builtinExit(int code);
+/** @} */
+#endif
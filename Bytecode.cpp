@@ -0,0 +1,735 @@
+#include <iostream>
+#include "Bytecode.h"
+#include "Builtins.h"
+
+using namespace std;
+
+const int opOperandCount[BC_NUM_OPCODES] = {
+     1, 1, 0, 0, 0, 1, 1, 2, 2, 1,    //CONST..LINK
+     0, 0, 0, 1, 0, 1, 2,             //ADD..INCL
+     0, 0, 0, 0, 0, 0,                //LT..NE
+     0, 0, 0, 0, 0, 0,                //SLT..SNE
+     0, 0, 0,                         //PEQ, PNE, NOT
+     1, 1, 1,                         //JMP, JZ, JNZ
+     1, 1, 1, 1, 1, 1,                //JFLT..JFNE
+     3,                               //FORLOOP
+     1, 1, 1, 2, 2, 2,                //NEWARR..SETF
+     1, 0, 0, 0, 2, 0                 //CALL..HALT
+};
+
+const int opJumpOperand[BC_NUM_OPCODES] = {
+     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     -1, -1, -1, -1, -1, -1, -1,
+     -1, -1, -1, -1, -1, -1,
+     -1, -1, -1, -1, -1, -1,
+     -1, -1, -1,
+     0, 0, 0,
+     0, 0, 0, 0, 0, 0,
+     2,
+     -1, -1, -1, -1, -1, -1,
+     -1, -1, -1, -1, -1, -1
+};
+
+const char* opNames[BC_NUM_OPCODES] = {
+     "CONST", "STR", "NIL", "POP", "DUP", "LOAD", "STORE", "LOADUP", "STOREUP", "LINK",
+     "ADD", "SUB", "MUL", "DIV", "NEG", "ADDI", "INCL",
+     "LT", "LE", "GT", "GE", "EQ", "NE",
+     "SLT", "SLE", "SGT", "SGE", "SEQ", "SNE",
+     "PEQ", "PNE", "NOT",
+     "JMP", "JZ", "JNZ",
+     "JFLT", "JFLE", "JFGT", "JFGE", "JFEQ", "JFNE",
+     "FORLOOP",
+     "NEWARR", "ALOAD", "ASTORE", "NEWREC", "GETF", "SETF",
+     "CALL", "RET", "PRINT", "PRINTI", "BUILTIN", "HALT"
+};
+
+/*********************
+ * BYTECODE FUNCTION
+ * *******************/
+
+BytecodeFunction::BytecodeFunction(const string &name, int level)
+:name(name), level(level), numParams(0), frameSize(1), maxStack(0){}
+
+void BytecodeFunction::Disassemble()
+{
+     cout << name << " (params: " << numParams << ", frame: " << frameSize << ", stack: " << maxStack << ")" << endl;
+     int pc = 0;
+     while(pc < code.size())
+     {
+          int op = code[pc];
+          cout << "     " << pc << ": " << opNames[op];
+          for(int i = 1; i <= opOperandCount[op]; i++)
+          {
+               if(op == BC_STR && i == 1)
+               {
+                    StringObject* literal = (StringObject*)code[pc+i];
+                    cout << " \"";
+                    cout.write(literal->GetChars(), literal->GetLength());
+                    cout << "\"";
+               }
+               else
+                    cout << " " << code[pc+i];
+          }
+          cout << endl;
+          pc += 1 + opOperandCount[op];
+     }
+}
+
+/*********************
+ * BYTECODE PROGRAM
+ * *******************/
+
+BytecodeProgram::~BytecodeProgram()
+{
+     for(int i = 0; i < functions.size(); i++)
+          delete functions[i];
+}
+
+void BytecodeProgram::Disassemble()
+{
+     for(int i = 0; i < functions.size(); i++)
+     {
+          cout << "#" << i << " ";
+          functions[i]->Disassemble();
+     }
+}
+
+/*********************
+ * BYTECODE COMPILER
+ * *******************/
+
+BytecodeCompiler::BytecodeCompiler(node* astRoot):astRoot(astRoot){}
+
+BytecodeProgram* BytecodeCompiler::Compile()
+{
+     BytecodeProgram* program = new BytecodeProgram();
+     nodeBytecodeCompiler compiler(program);
+     compiler.compileProgram(astRoot);
+     return program;
+}
+
+/***************************
+ * NODE BYTECODE COMPILER
+ * *************************/
+
+nodeBytecodeCompiler::nodeBytecodeCompiler(BytecodeProgram* program):prog(program), wantValue(false)
+{
+     //The outermost scope mirrors DefaultTigerTable(), but calls to builtins are
+     // bound during semantic analysis so it never has anything to look up
+     scopes.push_back(map<Atom, Binding>());
+}
+
+void nodeBytecodeCompiler::compileProgram(node* root)
+{
+     BytecodeFunction* main = new BytecodeFunction("<program>", 0);
+     prog->functions.push_back(main);
+
+     FunctionContext context = {main, 1, 0};
+     functions.push_back(context);
+
+     compile(root, false);
+     emit(BC_HALT, 0);
+
+     functions.pop_back();
+}
+
+void nodeBytecodeCompiler::compile(node* Node, bool want)
+{
+     bool saved = wantValue;
+     wantValue = want;
+     Node->accept(this);
+     wantValue = saved;
+}
+
+int nodeBytecodeCompiler::compileJumpIfFalse(node* condition)
+{
+     //Comparisons between ints can test and branch in one instruction
+     if(dynamic_cast<infixExp*>(condition) != NULL)
+     {
+          infixExp* InfixExp = (infixExp*) condition;
+          if(isIntType(InfixExp->leftNode->type) && InfixExp->op >= OP_EQ)
+          {
+               compile(InfixExp->leftNode, true);
+               compile(InfixExp->rightNode, true);
+               OpCode op;
+               switch(InfixExp->op)
+               {
+                    case OP_EQ: op = BC_JFEQ; break;
+                    case OP_NEQ: op = BC_JFNE; break;
+                    case OP_LT: op = BC_JFLT; break;
+                    case OP_LEQ: op = BC_JFLE; break;
+                    case OP_GT: op = BC_JFGT; break;
+                    default: op = BC_JFGE; break;
+               }
+               emit(op, -2);
+               emitOperand(0);
+               return current().function->code.size()-1;
+          }
+     }
+
+     compile(condition, true);
+     emit(BC_JZ, -1);
+     emitOperand(0);
+     return current().function->code.size()-1;
+}
+
+int nodeBytecodeCompiler::emit(OpCode op, int stackEffect)
+{
+     FunctionContext& context = current();
+     context.function->code.push_back(op);
+     context.stackDepth += stackEffect;
+     if(context.stackDepth > context.function->maxStack)
+          context.function->maxStack = context.stackDepth;
+     return context.function->code.size()-1;
+}
+
+void nodeBytecodeCompiler::emitOperand(intptr_t operand)
+{
+     current().function->code.push_back(operand);
+}
+
+void nodeBytecodeCompiler::patchJump(int operandPosition)
+{
+     vector<intptr_t>& code = current().function->code;
+     code[operandPosition] = code.size();
+}
+
+void nodeBytecodeCompiler::unitValue()
+{
+     if(wantValue)
+     {
+          emit(BC_CONST, 1);
+          emitOperand(0);
+     }
+}
+
+void nodeBytecodeCompiler::discardValue()
+{
+     if(!wantValue)
+          emit(BC_POP, -1);
+}
+
+Type* nodeBytecodeCompiler::resolveType(Type* type)
+{
+     //Can't use GetActualType() here since it looks through arrays to their elements
+     while(dynamic_cast<RefType*>(type) != NULL)
+          type = ((RefType*)type)->ref;
+     return type;
+}
+
+bool nodeBytecodeCompiler::isStringType(Type* type)
+{
+     return type != NULL && resolveType(type)->name == ATOM_STRING;
+}
+
+bool nodeBytecodeCompiler::isIntType(Type* type)
+{
+     return type != NULL && resolveType(type)->name == ATOM_INT;
+}
+
+Binding* nodeBytecodeCompiler::lookup(Atom name)
+{
+     for(int i = scopes.size()-1; i >= 0; i--)
+     {
+          map<Atom, Binding>::iterator itr = scopes[i].find(name);
+          if(itr != scopes[i].end())
+               return &(itr->second);
+     }
+     return NULL;
+}
+
+void nodeBytecodeCompiler::emitVariable(Binding* binding, bool store)
+{
+     int hops = (functions.size()-1) - binding->level;
+     if(hops == 0)
+     {
+          emit(store ? BC_STORE : BC_LOAD, store ? -1 : 1);
+          emitOperand(binding->index);
+     }
+     else
+     {
+          emit(store ? BC_STOREUP : BC_LOADUP, store ? -1 : 1);
+          emitOperand(hops);
+          emitOperand(binding->index);
+     }
+}
+
+int nodeBytecodeCompiler::allocateSlot()
+{
+     FunctionContext& context = current();
+     int slot = context.nextSlot++;
+     if(context.nextSlot > context.function->frameSize)
+          context.function->frameSize = context.nextSlot;
+     return slot;
+}
+
+FunctionContext& nodeBytecodeCompiler::current()
+{
+     return functions.back();
+}
+
+/*********
+ * VISITS
+ * *******/
+
+void nodeBytecodeCompiler::visitProgram(program* Program)
+{
+     compile(Program->Node, wantValue);
+}
+void nodeBytecodeCompiler::visitBreak(NBreak* Break)
+{
+     //Drop anything that was pushed since the loop started, without
+     // disturbing the depth the code after the break is compiled at
+     LoopContext& loop = loops.back();
+     FunctionContext& context = current();
+     for(int i = loop.stackDepth; i < context.stackDepth; i++)
+          context.function->code.push_back(BC_POP);
+
+     emit(BC_JMP, 0);
+     emitOperand(0);
+     loop.breakJumps.push_back(context.function->code.size()-1);
+     unitValue();
+}
+void nodeBytecodeCompiler::visitNil(NNil* Nil)
+{
+     if(wantValue)
+          emit(BC_NIL, 1);
+}
+void nodeBytecodeCompiler::visitID(NId* id)
+{
+     if(wantValue)
+          emitVariable(lookup(id->name), false);
+}
+void nodeBytecodeCompiler::visitTyID(NTyId* tyid)
+{
+
+}
+void nodeBytecodeCompiler::visitIntLit(NIntLit* intLit)
+{
+     if(wantValue)
+     {
+          emit(BC_CONST, 1);
+          emitOperand(intLit->val);
+     }
+}
+void nodeBytecodeCompiler::visitStrLit(NStrLit* strLit)
+{
+     if(wantValue)
+     {
+          //Semantic analysis pooled the literal, so every evaluation shares it
+          emit(BC_STR, 1);
+          emitOperand((intptr_t)strLit->value.GetStringObject());
+     }
+}
+void nodeBytecodeCompiler::visitSubscript(subscript* Subscript)
+{
+     compile(Subscript->lValue, true);
+     compile(Subscript->exp, true);
+     emit(BC_ALOAD, -1);
+     emitOperand(Subscript->exp->lineNumber);
+     discardValue();
+}
+void nodeBytecodeCompiler::visitFieldExp(fieldExp* FieldExp)
+{
+     compile(FieldExp->lValue, true);
+     emit(BC_GETF, 0);
+     emitOperand(FieldExp->slot);
+     emitOperand(FieldExp->lineNumber);
+     discardValue();
+}
+void nodeBytecodeCompiler::visitSeqExp(seqExp* SeqExp)
+{
+     NodeList* exps = SeqExp->exps;
+     if(exps->size() == 0)
+     {
+          unitValue();
+          return;
+     }
+
+     //Only the last expression's value is the value of the sequence
+     for(int i = 0; i < exps->size()-1; i++)
+          compile((*exps)[i], false);
+     compile((*exps)[exps->size()-1], wantValue);
+}
+void nodeBytecodeCompiler::visitNegation(negation* neg)
+{
+     compile(neg->operand, true);
+     emit(BC_NEG, 0);
+     discardValue();
+}
+void nodeBytecodeCompiler::visitCallExp(callExp* CallExp)
+{
+     NodeList* args = CallExp->exps;
+     Builtin* builtin = CallExp->builtin;
+     if(builtin != NULL)
+     {
+          for(int i = 0; i < args->size(); i++)
+               compile((*args)[i], true);
+
+          //print, printi and not are common enough to get their own opcodes
+          if(builtin->kind == BUILTIN_NOT)
+          {
+               emit(BC_NOT, 0);
+               discardValue();
+          }
+          else if(builtin->kind == BUILTIN_PRINT || builtin->kind == BUILTIN_PRINTI)
+          {
+               emit(builtin->kind == BUILTIN_PRINT ? BC_PRINT : BC_PRINTI, -1);
+               unitValue();
+          }
+          else
+          {
+               //The arguments are replaced by the result, unit included
+               emit(BC_BUILTIN, 1 - builtin->numParams);
+               emitOperand(builtin->kind);
+               emitOperand(CallExp->lineNumber);
+               discardValue();
+          }
+          return;
+     }
+
+     Binding* binding = lookup(((NId*)(CallExp->id))->name);
+
+     //The callee's static link is the frame of the function it was declared in
+     int hops = (functions.size()-1) - (binding->level-1);
+     emit(BC_LINK, 1);
+     emitOperand(hops);
+     for(int i = 0; i < args->size(); i++)
+          compile((*args)[i], true);
+
+     //The static link and arguments are replaced by the return value
+     emit(BC_CALL, -(int)args->size());
+     emitOperand(binding->index);
+     discardValue();
+}
+void nodeBytecodeCompiler::visitInfixExp(infixExp* InfixExp)
+{
+     //Short circuit operators only evaluate the right side when they have to
+     if(InfixExp->op == OP_AND || InfixExp->op == OP_OR)
+     {
+          compile(InfixExp->leftNode, true);
+          emit(InfixExp->op == OP_AND ? BC_JZ : BC_JNZ, -1);
+          emitOperand(0);
+          int shortJump = current().function->code.size()-1;
+
+          compile(InfixExp->rightNode, true);
+          emit(InfixExp->op == OP_AND ? BC_JZ : BC_JNZ, -1);
+          emitOperand(0);
+          int rightJump = current().function->code.size()-1;
+
+          emit(BC_CONST, 1);
+          emitOperand(InfixExp->op == OP_AND ? 1 : 0);
+          emit(BC_JMP, -1);
+          emitOperand(0);
+          int endJump = current().function->code.size()-1;
+
+          patchJump(shortJump);
+          patchJump(rightJump);
+          emit(BC_CONST, 1);
+          emitOperand(InfixExp->op == OP_AND ? 0 : 1);
+          patchJump(endJump);
+          discardValue();
+          return;
+     }
+
+     //x + constant and x - constant are common enough to get their own instruction
+     if((InfixExp->op == OP_ADD || InfixExp->op == OP_SUBTRACT) && dynamic_cast<NIntLit*>(InfixExp->rightNode) != NULL)
+     {
+          int constant = ((NIntLit*)(InfixExp->rightNode))->val;
+          compile(InfixExp->leftNode, true);
+          emit(BC_ADDI, 0);
+          emitOperand(InfixExp->op == OP_ADD ? constant : -constant);
+          discardValue();
+          return;
+     }
+
+     compile(InfixExp->leftNode, true);
+     compile(InfixExp->rightNode, true);
+
+     bool strings = isStringType(InfixExp->leftNode->type) || isStringType(InfixExp->rightNode->type);
+     bool ints = isIntType(InfixExp->leftNode->type) || isIntType(InfixExp->rightNode->type);
+     OpCode op;
+     switch(InfixExp->op)
+     {
+          case OP_ADD: op = BC_ADD; break;
+          case OP_SUBTRACT: op = BC_SUB; break;
+          case OP_MULTIPLY: op = BC_MUL; break;
+          case OP_DIVIDE: op = BC_DIV; break;
+          case OP_LT: op = strings ? BC_SLT : BC_LT; break;
+          case OP_LEQ: op = strings ? BC_SLE : BC_LE; break;
+          case OP_GT: op = strings ? BC_SGT : BC_GT; break;
+          case OP_GEQ: op = strings ? BC_SGE : BC_GE; break;
+          case OP_EQ: op = strings ? BC_SEQ : (ints ? BC_EQ : BC_PEQ); break;
+          default: op = strings ? BC_SNE : (ints ? BC_NE : BC_PNE); break;
+     }
+     emit(op, -1);
+     if(op == BC_DIV)
+          emitOperand(InfixExp->lineNumber);
+     discardValue();
+}
+void nodeBytecodeCompiler::visitArrCreate(arrCreate* ArrCreate)
+{
+     compile(ArrCreate->subscriptExp, true);
+     compile(ArrCreate->postExp, true);
+     emit(BC_NEWARR, -1);
+     emitOperand(ArrCreate->lineNumber);
+     discardValue();
+}
+void nodeBytecodeCompiler::visitRecCreate(recCreate* RecCreate)
+{
+     emit(BC_NEWREC, 1);
+     emitOperand(RecCreate->record->fields->size());
+     emitOperand(RecCreate->lineNumber);
+
+     //Fill the fields in the order they were written
+     for(int i = 0; i < RecCreate->fields->size(); i++)
+     {
+          fieldCreate* FieldCreate = (fieldCreate*)(*(RecCreate->fields))[i];
+          emit(BC_DUP, 1);
+          compile(FieldCreate, true);
+          emit(BC_SETF, -2);
+          emitOperand(FieldCreate->slot);
+          emitOperand(FieldCreate->lineNumber);
+     }
+     discardValue();
+}
+void nodeBytecodeCompiler::visitFieldCreate(fieldCreate* FieldCreate)
+{
+     compile(FieldCreate->exp, wantValue);
+}
+void nodeBytecodeCompiler::visitAssignment(assignment* Assign)
+{
+     if(dynamic_cast<subscript*>(Assign->lVal) != NULL)
+     {
+          subscript* Subscript = (subscript*) Assign->lVal;
+          compile(Subscript->lValue, true);
+          compile(Subscript->exp, true);
+          compile(Assign->exp, true);
+          emit(BC_ASTORE, -3);
+          emitOperand(Subscript->exp->lineNumber);
+     }
+     else if(dynamic_cast<fieldExp*>(Assign->lVal) != NULL)
+     {
+          fieldExp* FieldExp = (fieldExp*) Assign->lVal;
+          compile(FieldExp->lValue, true);
+          compile(Assign->exp, true);
+          emit(BC_SETF, -2);
+          emitOperand(FieldExp->slot);
+          emitOperand(FieldExp->lineNumber);
+     }
+     else
+     {
+          Binding* binding = lookup(((NId*)(Assign->lVal))->name);
+
+          //x := x + constant on a local can be done in place
+          infixExp* InfixExp = dynamic_cast<infixExp*>(Assign->exp);
+          if(InfixExp != NULL && (InfixExp->op == OP_ADD || InfixExp->op == OP_SUBTRACT)
+               && dynamic_cast<NIntLit*>(InfixExp->rightNode) != NULL
+               && dynamic_cast<NId*>(InfixExp->leftNode) != NULL
+               && lookup(((NId*)(InfixExp->leftNode))->name) == binding
+               && binding->level == functions.size()-1)
+          {
+               int constant = ((NIntLit*)(InfixExp->rightNode))->val;
+               emit(BC_INCL, 0);
+               emitOperand(binding->index);
+               emitOperand(InfixExp->op == OP_ADD ? constant : -constant);
+          }
+          else
+          {
+               compile(Assign->exp, true);
+               emitVariable(binding, true);
+          }
+     }
+     unitValue();
+}
+void nodeBytecodeCompiler::visitIfThenElse(ifThenElse* iTE)
+{
+     int elseJump = compileJumpIfFalse(iTE->ifExp);
+
+     if(iTE->elseExp == NULL)
+     {
+          compile(iTE->thenExp, false);
+          patchJump(elseJump);
+          unitValue();
+          return;
+     }
+
+     int depth = current().stackDepth;
+     compile(iTE->thenExp, wantValue);
+     emit(BC_JMP, 0);
+     emitOperand(0);
+     int endJump = current().function->code.size()-1;
+
+     //Both branches start from the same stack depth
+     current().stackDepth = depth;
+     patchJump(elseJump);
+     compile(iTE->elseExp, wantValue);
+     patchJump(endJump);
+}
+void nodeBytecodeCompiler::visitWhileExp(whileExp* While)
+{
+     LoopContext loop;
+     loop.stackDepth = current().stackDepth;
+     loops.push_back(loop);
+
+     int top = current().function->code.size();
+     int exitJump = compileJumpIfFalse(While->condition);
+     compile(While->action, false);
+     emit(BC_JMP, 0);
+     emitOperand(top);
+     patchJump(exitJump);
+
+     for(int i = 0; i < loops.back().breakJumps.size(); i++)
+          patchJump(loops.back().breakJumps[i]);
+     loops.pop_back();
+     unitValue();
+}
+void nodeBytecodeCompiler::visitForExp(forExp* forEx)
+{
+     //The loop variable and the limit get their own slots in a new scope
+     map<Atom, Binding> forScope;
+     int savedSlot = current().nextSlot;
+     int varSlot = allocateSlot();
+     int limitSlot = allocateSlot();
+     Binding var = {BIND_VAR, (int)functions.size()-1, varSlot};
+
+     compile(forEx->assign, true);
+     emitVariable(&var, true);
+     compile(forEx->condition, true);
+     emit(BC_STORE, -1);
+     emitOperand(limitSlot);
+
+     //Skip the loop entirely if it starts past the limit
+     emit(BC_LOAD, 1);
+     emitOperand(varSlot);
+     emit(BC_LOAD, 1);
+     emitOperand(limitSlot);
+     emit(BC_JFLE, -2);
+     emitOperand(0);
+     int exitJump = current().function->code.size()-1;
+
+     forScope[((NId*)(forEx->id))->name] = var;
+     scopes.push_back(forScope);
+     LoopContext loop;
+     loop.stackDepth = current().stackDepth;
+     loops.push_back(loop);
+
+     int top = current().function->code.size();
+     compile(forEx->action, false);
+     emit(BC_FORLOOP, 0);
+     emitOperand(varSlot);
+     emitOperand(limitSlot);
+     emitOperand(top);
+     patchJump(exitJump);
+
+     for(int i = 0; i < loops.back().breakJumps.size(); i++)
+          patchJump(loops.back().breakJumps[i]);
+     loops.pop_back();
+     scopes.pop_back();
+     current().nextSlot = savedSlot;
+     unitValue();
+}
+void nodeBytecodeCompiler::visitLetExp(letExp* LetExp)
+{
+     map<Atom, Binding> letScope;
+     scopes.push_back(letScope);
+     int savedSlot = current().nextSlot;
+
+     //Declare every function first so they can call each other
+     for(int i = 0; i < LetExp->decs->size(); i++)
+     {
+          decc* dec = (decc*)(*(LetExp->decs))[i];
+          if(dec->kind == D_FUNC)
+          {
+               funDec* FunDec = (funDec*) dec;
+               Atom name = ((NId*)(FunDec->id))->name;
+               BytecodeFunction* function = new BytecodeFunction(*name, functions.size());
+               function->numParams = FunDec->params->size();
+               function->frameSize = 1 + function->numParams;
+               Binding binding = {BIND_FUNC, (int)functions.size(), (int)prog->functions.size()};
+               prog->functions.push_back(function);
+               scopes.back()[name] = binding;
+          }
+     }
+
+     for(int i = 0; i < LetExp->decs->size(); i++)
+          compile((*(LetExp->decs))[i], false);
+
+     NodeList* exps = LetExp->exps;
+     if(exps->size() == 0)
+          unitValue();
+     else
+     {
+          for(int i = 0; i < exps->size()-1; i++)
+               compile((*exps)[i], false);
+          compile((*exps)[exps->size()-1], wantValue);
+     }
+
+     scopes.pop_back();
+     current().nextSlot = savedSlot;
+}
+void nodeBytecodeCompiler::visitDec(decc* Dec)
+{
+
+}
+void nodeBytecodeCompiler::visitTyDec(tyDec* TyDec)
+{
+     //Types are entirely handled by semantic analysis
+}
+void nodeBytecodeCompiler::visitTyDef(tyDef* TyDef)
+{
+
+}
+void nodeBytecodeCompiler::visitRefTy(refTy* RefTy)
+{
+
+}
+void nodeBytecodeCompiler::visitArrTy(arrTy* ArrTy)
+{
+
+}
+void nodeBytecodeCompiler::visitRecTy(recTy* RecTy)
+{
+
+}
+void nodeBytecodeCompiler::visitFieldDec(fieldDec* FieldDec)
+{
+
+}
+void nodeBytecodeCompiler::visitFunDec(funDec* FunDec)
+{
+     Binding* binding = lookup(((NId*)(FunDec->id))->name);
+     BytecodeFunction* function = prog->functions[binding->index];
+
+     //Parameters sit right after the static link
+     map<Atom, Binding> paramScope;
+     for(int i = 0; i < FunDec->params->size(); i++)
+     {
+          fieldDec* param = (fieldDec*)(*(FunDec->params))[i];
+          Binding var = {BIND_VAR, function->level, i+1};
+          paramScope[((NId*)(param->id))->name] = var;
+     }
+
+     //Breaks can't escape a function, so the body gets a fresh loop stack
+     vector<LoopContext> savedLoops = loops;
+     loops.clear();
+     FunctionContext context = {function, function->frameSize, 0};
+     functions.push_back(context);
+     scopes.push_back(paramScope);
+
+     compile(FunDec->exp, true);
+     emit(BC_RET, -1);
+
+     scopes.pop_back();
+     functions.pop_back();
+     loops = savedLoops;
+}
+void nodeBytecodeCompiler::visitVarDec(varDec* VarDec)
+{
+     compile(VarDec->exp, true);
+
+     //The name only comes into scope after its initializer
+     Binding var = {BIND_VAR, (int)functions.size()-1, allocateSlot()};
+     emitVariable(&var, true);
+     scopes.back()[((NId*)(VarDec->id))->name] = var;
+}
@@ -0,0 +1,502 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      Bytecode.h
+     Purpose:       Lowers a semantically valid Tiger AST into a compact,
+                    stack-based bytecode that can be executed by the
+                    VirtualMachine instead of walking the tree.
+
+*/
+
+/** @defgroup BYTECODE Bytecode Compiler
+ *  Everything for lowering the AST into bytecode.
+ *  @{
+ */
+
+#ifndef BYTECODE
+#define BYTECODE
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "ast.h"
+#include "SymbolTable.h"
+
+using namespace std;
+
+/**
+ * @brief Every instruction understood by the virtual machine. Each instruction
+ * is one code word followed by its operands (listed next to each opcode), all stored
+ * as intptr_t so that the VM can overwrite opcodes and jump targets with raw addresses
+ * when it threads the code.
+ *
+ */
+enum OpCode
+{
+     BC_CONST,      // value          : push an integer constant
+     BC_STR,        // string*        : push a pooled string literal
+     BC_NIL,        //                : push nil
+     BC_POP,        //                : discard the top of the stack
+     BC_DUP,        //                : duplicate the top of the stack
+     BC_LOAD,       // slot           : push a slot of the current frame
+     BC_STORE,      // slot           : pop into a slot of the current frame
+     BC_LOADUP,     // hops, slot     : push a slot of an enclosing function's frame
+     BC_STOREUP,    // hops, slot     : pop into a slot of an enclosing function's frame
+     BC_LINK,       // hops           : push the static link for a call
+     BC_ADD,        //                : integer arithmetic...
+     BC_SUB,
+     BC_MUL,
+     BC_DIV,        // line
+     BC_NEG,
+     BC_ADDI,       // value          : add a constant to the top of the stack
+     BC_INCL,       // slot, value    : add a constant to a slot in place
+     BC_LT,         //                : integer comparisons, push 1 or 0...
+     BC_LE,
+     BC_GT,
+     BC_GE,
+     BC_EQ,
+     BC_NE,
+     BC_SLT,        //                : string comparisons, push 1 or 0...
+     BC_SLE,
+     BC_SGT,
+     BC_SGE,
+     BC_SEQ,
+     BC_SNE,
+     BC_PEQ,        //                : array/record identity comparisons...
+     BC_PNE,
+     BC_NOT,        //                : builtin not()
+     BC_JMP,        // target
+     BC_JZ,         // target         : pop, jump if zero
+     BC_JNZ,        // target         : pop, jump if non-zero
+     BC_JFLT,       // target         : pop two ints, jump if the comparison is false...
+     BC_JFLE,
+     BC_JFGT,
+     BC_JFGE,
+     BC_JFEQ,
+     BC_JFNE,
+     BC_FORLOOP,    // slot, limit slot, target : bump the loop variable and jump back if not done
+     BC_NEWARR,     // line           : pop init and size, push a new array
+     BC_ALOAD,      // line           : pop index and array, push element
+     BC_ASTORE,     // line           : pop value, index and array
+     BC_NEWREC,     // fields, line   : push a new record with every field nil/0
+     BC_GETF,       // field, line    : pop record, push field
+     BC_SETF,       // field, line    : pop value and record, store field
+     BC_CALL,       // function       : call a user function (static link and args already pushed)
+     BC_RET,        //                : return the top of the stack to the caller
+     BC_PRINT,      //                : builtin print()
+     BC_PRINTI,     //                : builtin printi()
+     BC_BUILTIN,    // builtin, line  : pop the arguments, push the result of any other builtin
+     BC_HALT,       //                : stop the machine
+     BC_NUM_OPCODES
+};
+
+/**
+ * @brief Number of operand words that follow each opcode.
+ *
+ */
+extern const int opOperandCount[BC_NUM_OPCODES];
+
+/**
+ * @brief Index of the operand that holds a jump target for each opcode, or
+ * -1 if the opcode doesn't jump.
+ *
+ */
+extern const int opJumpOperand[BC_NUM_OPCODES];
+
+/**
+ * @brief Printable names of each opcode, used when disassembling.
+ *
+ */
+extern const char* opNames[BC_NUM_OPCODES];
+
+/**
+ * @brief A single Tiger function lowered to bytecode, complete with the frame
+ * layout the VM needs to call it.
+ *
+ */
+class BytecodeFunction
+{
+     public:
+          /**
+           * @brief Construct a new, empty bytecode function.
+           *
+           * @param name Name of the function, for disassembly.
+           * @param level Lexical nesting level of the function body (the program is 0).
+           */
+          BytecodeFunction(const string &name, int level);
+
+          /**
+           * @brief Prints every instruction in the function.
+           *
+           */
+          void Disassemble();
+
+          /**
+           * @brief Name of the function.
+           *
+           */
+          string name;
+
+          /**
+           * @brief Lexical nesting level of the function body; used to resolve
+           * static links at call sites.
+           *
+           */
+          int level;
+
+          /**
+           * @brief Number of formal parameters; they sit in slots 1..numParams
+           * right after the static link in slot 0.
+           *
+           */
+          int numParams;
+
+          /**
+           * @brief Total number of slots (static link, parameters, and locals) in a frame.
+           *
+           */
+          int frameSize;
+
+          /**
+           * @brief Most operands this function will ever have on the stack at once.
+           *
+           */
+          int maxStack;
+
+          /**
+           * @brief The function's instructions. Jump targets are indices into this vector.
+           *
+           */
+          vector<intptr_t> code;
+};
+
+/**
+ * @brief A whole Tiger program lowered to bytecode.
+ *
+ */
+class BytecodeProgram
+{
+     public:
+          /**
+           * @brief Destroy the program and the functions and strings it owns.
+           *
+           */
+          ~BytecodeProgram();
+
+          /**
+           * @brief Prints every function in the program.
+           *
+           */
+          void Disassemble();
+
+          /**
+           * @brief All functions in the program; the program body itself is function 0.
+           *
+           */
+          vector<BytecodeFunction*> functions;
+};
+
+/**
+ * @brief Lowers a semantically valid AST into a BytecodeProgram.
+ *
+ */
+class BytecodeCompiler
+{
+     public:
+          /**
+           * @brief Construct a new compiler for an analyzed AST.
+           *
+           * @param astRoot The root of the AST; must have already passed semantic analysis.
+           */
+          BytecodeCompiler(node* astRoot);
+
+          /**
+           * @brief Compiles the whole tree.
+           *
+           * @return BytecodeProgram* The compiled program; owned by the caller.
+           */
+          BytecodeProgram* Compile();
+
+          /**
+           * @brief The AST to compile.
+           *
+           */
+          node* astRoot;
+};
+
+/**
+ * @brief What a name in the compiler's environment refers to.
+ *
+ */
+enum BindingKind
+{
+     /**
+      * @brief A variable living in a frame slot.
+      *
+      */
+     BIND_VAR,
+
+     /**
+      * @brief A user defined function.
+      *
+      */
+     BIND_FUNC
+};
+
+/**
+ * @brief A name resolved at compile time to a frame slot or a function.
+ *
+ */
+class Binding
+{
+     public:
+          /**
+           * @brief What the name refers to.
+           *
+           */
+          BindingKind kind;
+
+          /**
+           * @brief Nesting level of the function whose frame holds the variable, or
+           * the body level of the bound function.
+           *
+           */
+          int level;
+
+          /**
+           * @brief Frame slot for variables or function index for functions.
+           *
+           */
+          int index;
+};
+
+/**
+ * @brief Per-function state used while compiling a function body.
+ *
+ */
+class FunctionContext
+{
+     public:
+          /**
+           * @brief The function being filled in.
+           *
+           */
+          BytecodeFunction* function;
+
+          /**
+           * @brief Next free frame slot.
+           *
+           */
+          int nextSlot;
+
+          /**
+           * @brief Operands currently on the stack at this point in the code.
+           *
+           */
+          int stackDepth;
+};
+
+/**
+ * @brief Bookkeeping for the innermost loop so breaks know where to go.
+ *
+ */
+class LoopContext
+{
+     public:
+          /**
+           * @brief Stack depth when the loop was entered; a break drops anything above it.
+           *
+           */
+          int stackDepth;
+
+          /**
+           * @brief Code positions of break jumps waiting for the loop's exit address.
+           *
+           */
+          vector<int> breakJumps;
+};
+
+/**
+ * @brief A node visitor that emits bytecode for every node it visits.
+ *
+ */
+class nodeBytecodeCompiler : public nodeVisitor
+{
+     public:
+          /**
+           * @brief Construct a new compiler visitor with the builtin functions in scope.
+           *
+           * @param program The program that compiled functions and strings go into.
+           */
+          nodeBytecodeCompiler(BytecodeProgram* program);
+
+          /**
+           * @brief Compiles the program body as function 0.
+           *
+           * @param root The root of the AST.
+           */
+          void compileProgram(node* root);
+
+          /**
+           * @brief Emits code for a node. If the value is wanted, the code leaves
+           * exactly one value on the stack; otherwise it leaves nothing.
+           *
+           * @param Node The node to compile.
+           * @param wantValue Whether the node's value is needed.
+           */
+          void compile(node* Node, bool wantValue);
+
+          /**
+           * @brief Emits code that jumps to a not-yet-known address if the condition
+           * is false, fusing comparisons into a single branch where possible.
+           *
+           * @param condition The integer condition to test.
+           * @return int Code position of the jump operand to patch.
+           */
+          int compileJumpIfFalse(node* condition);
+
+          /**
+           * @brief Appends an instruction to the current function and tracks its effect
+           * on the operand stack.
+           *
+           * @param op The opcode.
+           * @param stackEffect Net number of values the instruction pushes (negative if it pops).
+           * @return int Code position of the opcode.
+           */
+          int emit(OpCode op, int stackEffect);
+
+          /**
+           * @brief Appends an operand word to the current function.
+           *
+           * @param operand The operand.
+           */
+          void emitOperand(intptr_t operand);
+
+          /**
+           * @brief Points a previously emitted jump operand at the current end of code.
+           *
+           * @param operandPosition Code position of the jump operand.
+           */
+          void patchJump(int operandPosition);
+
+          /**
+           * @brief Pushes a unit placeholder if the caller wanted a value from a
+           * node that doesn't produce one.
+           *
+           */
+          void unitValue();
+
+          /**
+           * @brief Drops a value the caller didn't want.
+           *
+           */
+          void discardValue();
+
+          /**
+           * @brief Follows reference types down to the type they name.
+           *
+           */
+          Type* resolveType(Type* type);
+
+          /**
+           * @brief Returns true if a type is (or refers to) the string type.
+           *
+           */
+          bool isStringType(Type* type);
+
+          /**
+           * @brief Returns true if a type is (or refers to) the int type.
+           *
+           */
+          bool isIntType(Type* type);
+
+          /**
+           * @brief Finds what a name refers to in the innermost scope that declares it.
+           *
+           */
+          Binding* lookup(Atom name);
+
+          /**
+           * @brief Emits a load or store of a variable from whichever frame owns it.
+           *
+           * @param binding The resolved variable.
+           * @param store True for a store, false for a load.
+           */
+          void emitVariable(Binding* binding, bool store);
+
+          /**
+           * @brief Reserves a new slot in the current frame.
+           *
+           */
+          int allocateSlot();
+
+          /**
+           * @brief The current function's context.
+           *
+           */
+          FunctionContext& current();
+
+          //Visitor functions
+          void visitProgram(program* prog) override;
+          void visitBreak(NBreak* Break) override;
+          void visitNil(NNil* Nil) override;
+          void visitID(NId* id) override;
+          void visitTyID(NTyId* tyid) override;
+          void visitSubscript(subscript* Subscript) override;
+          void visitFieldExp(fieldExp* FieldExp) override;
+          void visitSeqExp(seqExp*) override;
+          void visitNegation(negation*) override;
+          void visitCallExp(callExp*) override;
+          void visitIntLit(NIntLit*) override;
+          void visitStrLit(NStrLit*) override;
+          void visitInfixExp(infixExp*) override;
+          void visitArrCreate(arrCreate*) override;
+          void visitRecCreate(recCreate*) override;
+          void visitFieldCreate(fieldCreate*) override;
+          void visitAssignment(assignment*) override;
+          void visitIfThenElse(ifThenElse*) override;
+          void visitWhileExp(whileExp*) override;
+          void visitForExp(forExp*) override;
+          void visitLetExp(letExp*) override;
+          void visitDec(decc*) override;
+          void visitTyDec(tyDec*) override;
+          void visitTyDef(tyDef*) override;
+          void visitRefTy(refTy*) override;
+          void visitArrTy(arrTy*) override;
+          void visitRecTy(recTy*) override;
+          void visitFieldDec(fieldDec*) override;
+          void visitFunDec(funDec*) override;
+          void visitVarDec(varDec*) override;
+
+          /**
+           * @brief The program being built.
+           *
+           */
+          BytecodeProgram* prog;
+
+          /**
+           * @brief Whether the node currently being visited must leave a value.
+           *
+           */
+          bool wantValue;
+
+          /**
+           * @brief Scopes of names, innermost last.
+           *
+           */
+          vector< map<Atom, Binding> > scopes;
+
+          /**
+           * @brief Functions currently being compiled, innermost last.
+           *
+           */
+          vector<FunctionContext> functions;
+
+          /**
+           * @brief Loops currently being compiled in the innermost function, innermost last.
+           *
+           */
+          vector<LoopContext> loops;
+};
+/** @} */
+#endif
@@ -0,0 +1,1014 @@
+#include <stdio.h>
+#include "CBackend.h"
+#include "Builtins.h"
+
+using namespace std;
+
+/*********************
+ * RUNTIME
+ * *******************/
+
+//Copied verbatim to the top of every translation unit. Integer arithmetic goes
+// through unsigned so overflow wraps the way it does in the interpreter.
+static const char* cRuntime = R"RUNTIME(/* Generated by tigerc --emit-c */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TG_ADD(a, b) ((int)((unsigned)(a) + (unsigned)(b)))
+#define TG_SUB(a, b) ((int)((unsigned)(a) - (unsigned)(b)))
+#define TG_MUL(a, b) ((int)((unsigned)(a) * (unsigned)(b)))
+#define TG_NEG(a) ((int)(0u - (unsigned)(a)))
+#define TG_INDEX(array, index, line) \
+     ((unsigned)(index) < (unsigned)(array)->size ? (index) : tg_bounds_error(line))
+
+static void tg_error(int line, const char* message)
+{
+     printf("ERROR %d: Runtime: %s\n", line, message);
+     exit(4);
+}
+
+static int tg_bounds_error(int line)
+{
+     tg_error(line, "Array access out of bounds.");
+     return 0;
+}
+
+static void tg_nil_error(int line)
+{
+     tg_error(line, "Field access on nil record.");
+}
+
+static int tg_div(int a, int b, int line)
+{
+     if(b == 0)
+          tg_error(line, "Division by zero.");
+     if(b == -1)
+          return TG_NEG(a);
+     return a / b;
+}
+
+static void* tg_alloc(size_t size)
+{
+     void* memory = calloc(1, size);
+     if(memory == NULL)
+     {
+          printf("ERROR: Runtime: Out of memory.\n");
+          exit(4);
+     }
+     return memory;
+}
+
+/* Strings carry their length, since a Tiger string may hold chr(0) */
+struct tg_string
+{
+     int length;
+     const char* chars;
+};
+
+static const struct tg_string tg_empty = {0, ""};
+
+static struct tg_string* tg_string_new(int length, const char* chars)
+{
+     struct tg_string* s = (struct tg_string*)tg_alloc(sizeof(struct tg_string));
+     s->length = length;
+     s->chars = chars;
+     return s;
+}
+
+static int tg_compare(const struct tg_string* a, const struct tg_string* b)
+{
+     int shorter = a->length < b->length ? a->length : b->length;
+     int result = memcmp(a->chars, b->chars, (size_t)shorter);
+     if(result != 0)
+          return result;
+     return a->length - b->length;
+}
+
+static void tg_print(const struct tg_string* s)
+{
+     fwrite(s->chars, 1, (size_t)s->length, stdout);
+}
+
+static void tg_printi(int i)
+{
+     printf("%d", i);
+}
+
+static void tg_flush(void)
+{
+     fflush(stdout);
+}
+
+/* Every one character string, so chr() and getchar() never allocate */
+static char tg_codes[256];
+static struct tg_string tg_chars[256];
+
+static const struct tg_string* tg_char(int c)
+{
+     tg_codes[c] = (char)c;
+     tg_chars[c].length = 1;
+     tg_chars[c].chars = &tg_codes[c];
+     return &tg_chars[c];
+}
+
+static const struct tg_string* tg_getchar(void)
+{
+     int c = getchar();
+     if(c == EOF)
+          return &tg_empty;
+     return tg_char(c);
+}
+
+static int tg_ord(const struct tg_string* s)
+{
+     return s->length == 0 ? -1 : (unsigned char)s->chars[0];
+}
+
+static const struct tg_string* tg_chr(int i, int line)
+{
+     if(i < 0 || i > 255)
+          tg_error(line, "chr() of a code outside 0 to 255.");
+     return tg_char(i);
+}
+
+static int tg_size(const struct tg_string* s)
+{
+     return s->length;
+}
+
+/* Strings never change once made, so a substring shares its characters */
+static const struct tg_string* tg_substring(const struct tg_string* s, int first, int n, int line)
+{
+     if(first < 0 || n < 0 || first > s->length || n > s->length - first)
+          tg_error(line, "substring() out of range.");
+     if(n == s->length)
+          return s;
+     return tg_string_new(n, s->chars + first);
+}
+
+static const struct tg_string* tg_concat(const struct tg_string* a, const struct tg_string* b)
+{
+     char* chars;
+     if(a->length == 0)
+          return b;
+     if(b->length == 0)
+          return a;
+     chars = (char*)tg_alloc((size_t)a->length + (size_t)b->length);
+     memcpy(chars, a->chars, (size_t)a->length);
+     memcpy(chars + a->length, b->chars, (size_t)b->length);
+     return tg_string_new(a->length + b->length, chars);
+}
+
+static void tg_exit(int i)
+{
+     fflush(stdout);
+     exit(i);
+}
+)RUNTIME";
+
+/*********************
+ * C BACKEND
+ * *******************/
+
+CBackend::CBackend(node* astRoot):astRoot(astRoot){}
+
+string CBackend::Emit()
+{
+     //The first pass only finds out which variables nested functions use
+     nodeCBackend analysis;
+     analysis.compileProgram(astRoot);
+
+     nodeCBackend generator;
+     generator.escaping = analysis.escaping;
+     generator.compileProgram(astRoot);
+     return generator.Assemble();
+}
+
+/*********************
+ * NODE C BACKEND
+ * *******************/
+
+nodeCBackend::nodeCBackend():wantValue(false), tailPosition(false), compiledType(NULL), nextName(0)
+{
+     //Calls to builtins are bound during semantic analysis, so the outermost
+     // scope never has anything to look up
+     scopes.push_back(map<Atom, CBinding>());
+}
+
+void nodeCBackend::compileProgram(node* root)
+{
+     CFunction function;
+     function.name = "main";
+     function.frame = "tg_main_frame";
+     function.signature = "int main(void)";
+     function.loops = false;
+     function.indent = 1;
+     functions.push_back(function);
+
+     compile(root, false);
+     emit("return 0;");
+     finishFunction();
+}
+
+string nodeCBackend::Assemble()
+{
+     string unit = cRuntime;
+     unit += "\n";
+     for(int i = 0; i < declarations.size(); i++)
+          unit += declarations[i];
+     unit += "\n";
+     for(int i = 0; i < definitions.size(); i++)
+          unit += definitions[i];
+     for(int i = 0; i < helpers.size(); i++)
+          unit += helpers[i];
+     for(int i = 0; i < prototypes.size(); i++)
+          unit += prototypes[i];
+     unit += "\n";
+     for(int i = 0; i < functionDefinitions.size(); i++)
+          unit += functionDefinitions[i];
+     return unit;
+}
+
+string nodeCBackend::compile(node* Node, bool want, bool tail)
+{
+     bool savedWant = wantValue;
+     bool savedTail = tailPosition;
+     wantValue = want;
+     tailPosition = tail;
+     result = "0";
+     compiledType = NULL;
+     Node->accept(this);
+     wantValue = savedWant;
+     tailPosition = savedTail;
+     return result;
+}
+
+string nodeCBackend::compileBlock(node* Node, bool want, string &value, bool tail)
+{
+     //Generate into an empty body, then put the old one back
+     string saved;
+     saved.swap(current().body);
+     current().indent++;
+     value = compile(Node, want, tail);
+     current().indent--;
+     saved.swap(current().body);
+     return saved;
+}
+
+void nodeCBackend::emit(const string &line)
+{
+     current().body += indentation(0) + line + "\n";
+}
+
+void nodeCBackend::emitBlock(const string &statements, const string &last)
+{
+     emit("{");
+     current().body += statements;
+     if(!last.empty())
+          current().body += indentation(1) + last + "\n";
+     emit("}");
+}
+
+string nodeCBackend::indentation(int extra)
+{
+     return string(5 * (current().indent + extra), ' ');
+}
+
+void nodeCBackend::finishFunction()
+{
+     CFunction& function = current();
+
+     //Every frame starts with the static link, even if nothing else escapes into it
+     string frame = "struct " + function.frame + "\n{\n";
+     if(function.parentFrame.empty())
+          frame += "     void* link;\n";
+     else
+          frame += "     struct " + function.parentFrame + "* link;\n";
+     for(int i = 0; i < function.frameFields.size(); i++)
+          frame += "     " + function.frameFields[i] + "\n";
+     frame += "};\n\n";
+     declarations.push_back("struct " + function.frame + ";\n");
+     definitions.push_back(frame);
+
+     string text = function.signature + "\n{\n";
+     text += "     struct " + function.frame + " fr;\n";
+     text += function.parentFrame.empty() ? "     fr.link = NULL;\n" : "     fr.link = link;\n";
+     if(function.loops)
+          text += "tg_top:;\n";
+     text += function.body + "}\n\n";
+     functionDefinitions.push_back(text);
+     functions.pop_back();
+}
+
+string nodeCBackend::temporary(Type* type, const string &value)
+{
+     string name = "tg_t" + to_string(nextName++);
+     emit(cType(type) + " " + name + " = " + value + ";");
+     return name;
+}
+
+void nodeCBackend::stabilize(string &value, Type* type, int mark)
+{
+     if(current().body.size() == mark || isStable(value))
+          return;
+
+     string name = "tg_t" + to_string(nextName++);
+     current().body.insert(mark, indentation(0) + cType(type) + " " + name + " = " + value + ";\n");
+     value = name;
+}
+
+bool nodeCBackend::isStable(const string &value)
+{
+     if(value.empty() || value == "NULL" || value.compare(0, 5, "&tg_s") == 0)
+          return true;
+     size_t digits = (value.compare(0, 4, "tg_t") == 0) ? 4 : 0;
+     if(digits == value.size())
+          return false;
+     for(size_t i = digits; i < value.size(); i++)
+     {
+          if(value[i] < '0' || value[i] > '9')
+               return false;
+     }
+     return true;
+}
+
+string nodeCBackend::cType(Type* type)
+{
+     if(isUnitType(type))
+          return "void*";
+     Type* actual = resolveType(type);
+     if(dynamic_cast<ArrType*>(actual) != NULL)
+          return "struct " + arrayName(((ArrType*)actual)->ref) + "*";
+     if(dynamic_cast<RecType*>(actual) != NULL)
+          return "struct " + recordName((RecType*)actual) + "*";
+     if(actual->name == ATOM_STRING)
+          return "const struct tg_string*";
+     return "int";
+}
+
+string nodeCBackend::recordName(RecType* type)
+{
+     map<RecType*, string>::iterator itr = recordNames.find(type);
+     if(itr != recordNames.end())
+          return itr->second;
+
+     //Named before the fields are looked at, so records can refer to themselves
+     string name = "tg_record" + to_string(recordNames.size());
+     recordNames[type] = name;
+     declarations.push_back("struct " + name + ";\n");
+
+     string definition = "struct " + name + "\n{\n";
+     for(map<Atom, Type*>::iterator field = type->fields->begin(); field != type->fields->end(); field++)
+          definition += "     " + cType(field->second) + " f_" + *field->first + ";\n";
+     if(type->fields->empty())
+          definition += "     char unused;\n";
+     definition += "};\n\n";
+     definitions.push_back(definition);
+     return name;
+}
+
+string nodeCBackend::arrayName(Type* element)
+{
+     string elementType = cType(element);
+     map<string, string>::iterator itr = arrayNames.find(elementType);
+     if(itr != arrayNames.end())
+          return itr->second;
+
+     string name = "tg_array" + to_string(arrayNames.size());
+     arrayNames[elementType] = name;
+     declarations.push_back("struct " + name + ";\n");
+     definitions.push_back("struct " + name + "\n{\n     int size;\n     " + elementType + " data[];\n};\n\n");
+
+     helpers.push_back("static struct " + name + "* " + name + "_new(int size, " + elementType + " init, int line)\n"
+          "{\n"
+          "     struct " + name + "* array;\n"
+          "     int i;\n"
+          "     if(size < 0)\n"
+          "          tg_error(line, \"Negative array size.\");\n"
+          "     array = (struct " + name + "*)tg_alloc(sizeof(struct " + name + ") + (size_t)size * sizeof(" + elementType + "));\n"
+          "     array->size = size;\n"
+          "     for(i = 0; i < size; i++)\n"
+          "          array->data[i] = init;\n"
+          "     return array;\n"
+          "}\n\n");
+     return name;
+}
+
+Type* nodeCBackend::resolveType(Type* type)
+{
+     //Can't use GetActualType() here since it looks through arrays to their elements
+     while(dynamic_cast<RefType*>(type) != NULL)
+          type = ((RefType*)type)->ref;
+     return type;
+}
+
+bool nodeCBackend::isStringType(Type* type)
+{
+     return type != NULL && resolveType(type)->name == ATOM_STRING;
+}
+
+bool nodeCBackend::isIntType(Type* type)
+{
+     return type != NULL && resolveType(type)->name == ATOM_INT;
+}
+
+bool nodeCBackend::isUnitType(Type* type)
+{
+     return type == NULL || resolveType(type)->name == ATOM_UNIT;
+}
+
+string nodeCBackend::uniqueName(const string &name)
+{
+     //Nothing in the runtime or C itself ends in an underscore and a number
+     return name + "_" + to_string(nextName++);
+}
+
+string nodeCBackend::stringLiteral(const string &value)
+{
+     //Tiger strings are printed exactly as written, so escape anything C would read differently
+     string literal = "\"";
+     for(int i = 0; i < value.size(); i++)
+     {
+          unsigned char c = value[i];
+          if(c == '"' || c == '\\' || c == '?')
+          {
+               literal += '\\';
+               literal += c;
+          }
+          else if(c < 32 || c >= 127)
+          {
+               char octal[8];
+               snprintf(octal, sizeof(octal), "\\%03o", c);
+               literal += octal;
+          }
+          else
+               literal += c;
+     }
+     return literal + "\"";
+}
+
+CBinding* nodeCBackend::lookup(Atom name)
+{
+     for(int i = scopes.size()-1; i >= 0; i--)
+     {
+          map<Atom, CBinding>::iterator itr = scopes[i].find(name);
+          if(itr != scopes[i].end())
+               return &(itr->second);
+     }
+     return NULL;
+}
+
+CBinding nodeCBackend::declareVariable(Atom name, Type* type, node* declaration)
+{
+     CBinding var = {CBIND_VAR, uniqueName(*name), type, (int)functions.size()-1, declaration, escaping.count(declaration) > 0};
+     if(var.escapes)
+          current().frameFields.push_back(cType(type) + " " + var.name + ";");
+     scopes.back()[name] = var;
+     return var;
+}
+
+string nodeCBackend::variable(CBinding* binding)
+{
+     int level = functions.size()-1;
+     if(binding->level != level)
+          escaping.insert(binding->declaration);
+
+     if(!binding->escapes)
+          return binding->name;
+     if(binding->level == level)
+          return "fr." + binding->name;
+     return frameAt(binding->level) + "->" + binding->name;
+}
+
+string nodeCBackend::frameAt(int level)
+{
+     int hops = (functions.size()-1) - level;
+     if(hops == 0)
+          return "&fr";
+     string frame = "link";
+     for(int i = 1; i < hops; i++)
+          frame += "->link";
+     return frame;
+}
+
+CFunction& nodeCBackend::current()
+{
+     return functions.back();
+}
+
+/*********
+ * VISITS
+ * *******/
+
+void nodeCBackend::visitProgram(program* Program)
+{
+     result = compile(Program->Node, wantValue);
+}
+void nodeCBackend::visitBreak(NBreak* Break)
+{
+     //Every Tiger loop is a C loop, with nothing in between that break would stop at
+     emit("break;");
+}
+void nodeCBackend::visitNil(NNil* Nil)
+{
+     result = "NULL";
+}
+void nodeCBackend::visitID(NId* id)
+{
+     CBinding* binding = lookup(id->name);
+     result = variable(binding);
+     compiledType = binding->type;
+}
+void nodeCBackend::visitTyID(NTyId* tyid)
+{
+
+}
+void nodeCBackend::visitIntLit(NIntLit* intLit)
+{
+     result = to_string(intLit->val);
+     compiledType = intLit->type;
+}
+void nodeCBackend::visitStrLit(NStrLit* strLit)
+{
+     //Each distinct literal is one constant string, defined once
+     map<string, string>::iterator itr = stringNames.find(*strLit->val);
+     if(itr == stringNames.end())
+     {
+          string name = "tg_s" + to_string(stringNames.size());
+          definitions.push_back("static const struct tg_string " + name + " = {" + to_string(strLit->val->size()) + ", " + stringLiteral(*strLit->val) + "};\n");
+          itr = stringNames.insert(pair<string, string>(*strLit->val, name)).first;
+     }
+     result = "&" + itr->second;
+     compiledType = strLit->type;
+}
+void nodeCBackend::visitSubscript(subscript* Subscript)
+{
+     string array = compile(Subscript->lValue, true);
+     Type* arrayType = compiledType;
+     int mark = current().body.size();
+     string index = compile(Subscript->exp, true);
+     stabilize(array, arrayType, mark);
+
+     //Read into a local right away so an out of bounds error happens here
+     Type* element = ((ArrType*)resolveType(arrayType))->ref;
+     string line = to_string(Subscript->exp->lineNumber);
+     result = temporary(element, array + "->data[TG_INDEX(" + array + ", " + index + ", " + line + ")]");
+     compiledType = element;
+}
+void nodeCBackend::visitFieldExp(fieldExp* FieldExp)
+{
+     string record = compile(FieldExp->lValue, true);
+     RecType* type = (RecType*) resolveType(compiledType);
+     Atom name = ((NId*)(FieldExp->ID))->name;
+
+     emit("if(" + record + " == NULL)");
+     emit("     tg_nil_error(" + to_string(FieldExp->lineNumber) + ");");
+     compiledType = (*(type->fields))[name];
+     result = temporary(compiledType, record + "->f_" + *name);
+}
+void nodeCBackend::visitSeqExp(seqExp* SeqExp)
+{
+     NodeList* exps = SeqExp->exps;
+     if(exps->size() == 0)
+          return;
+
+     //Only the last expression's value is the value of the sequence
+     for(int i = 0; i < exps->size()-1; i++)
+          compile((*exps)[i], false);
+     result = compile((*exps)[exps->size()-1], wantValue, tailPosition);
+}
+void nodeCBackend::visitNegation(negation* neg)
+{
+     result = "TG_NEG(" + compile(neg->operand, true) + ")";
+     compiledType = neg->type;
+}
+void nodeCBackend::visitCallExp(callExp* CallExp)
+{
+     NodeList* args = CallExp->exps;
+
+     //Arguments are worked out left to right, so earlier ones are copied if later ones
+     // have side effects
+     vector<string> values;
+     vector<Type*> types;
+     for(int i = 0; i < args->size(); i++)
+     {
+          int mark = current().body.size();
+          string value = compile((*args)[i], true);
+          for(int j = 0; j < values.size(); j++)
+               stabilize(values[j], types[j], mark);
+          values.push_back(value);
+          types.push_back(compiledType);
+     }
+
+     //Builtins are calls into the runtime, apart from not which is inlined
+     Builtin* builtin = CallExp->builtin;
+     if(builtin != NULL)
+     {
+          if(builtin->kind == BUILTIN_NOT)
+          {
+               result = "(" + values[0] + " == 0)";
+               compiledType = CallExp->type;
+               return;
+          }
+          string call = string("tg_") + builtin->name + "(";
+          for(int i = 0; i < values.size(); i++)
+               call += (i > 0 ? ", " : "") + values[i];
+          if(builtin->kind == BUILTIN_CHR || builtin->kind == BUILTIN_SUBSTRING)
+               call += (values.empty() ? "" : ", ") + to_string(CallExp->lineNumber);
+          call += ")";
+
+          if(wantValue && !isUnitType(CallExp->type))
+          {
+               result = temporary(CallExp->type, call);
+               compiledType = CallExp->type;
+          }
+          else
+          {
+               emit(call + ";");
+               result = "0";
+               compiledType = NULL;
+          }
+          return;
+     }
+
+     //A tail call to the function itself starts its body over with the new arguments,
+     // all worked out before any parameter changes
+     CBinding binding = *lookup(((NId*)(CallExp->id))->name);
+     if(tailPosition && binding.name == current().name)
+     {
+          vector<CBinding>& params = current().parameters;
+          for(int i = 0; i < values.size(); i++)
+          {
+               if(!isStable(values[i]))
+                    values[i] = temporary(params[i].type, values[i]);
+          }
+          for(int i = 0; i < values.size(); i++)
+               emit(params[i].name + " = " + values[i] + ";");
+          emit("goto tg_top;");
+          current().loops = true;
+
+          //Nothing after the jump runs, but the caller still needs a value to store
+          result = (wantValue && !isIntType(binding.type) && !isUnitType(binding.type)) ? "NULL" : "0";
+          compiledType = binding.type;
+          return;
+     }
+
+     //The callee's static link is the frame of the function it was declared in
+     string call = binding.name + "(" + frameAt(binding.level);
+     for(int i = 0; i < values.size(); i++)
+          call += ", " + values[i];
+     call += ")";
+
+     if(wantValue && !isUnitType(binding.type))
+     {
+          result = temporary(binding.type, call);
+          compiledType = binding.type;
+     }
+     else
+          emit(call + ";");
+}
+void nodeCBackend::visitInfixExp(infixExp* InfixExp)
+{
+     compiledType = InfixExp->type;
+     string left = compile(InfixExp->leftNode, true);
+     Type* leftType = compiledType;
+
+     //Short circuit operators only run the right side's statements when they have to
+     if(InfixExp->op == OP_AND || InfixExp->op == OP_OR)
+     {
+          string right;
+          string statements = compileBlock(InfixExp->rightNode, true, right);
+          compiledType = InfixExp->type;
+          if(statements.empty())
+          {
+               result = "(" + left + (InfixExp->op == OP_AND ? " && " : " || ") + right + ")";
+               return;
+          }
+
+          string flag = temporary(compiledType, "(" + left + " != 0)");
+          emit(InfixExp->op == OP_AND ? "if(" + flag + ")" : "if(!" + flag + ")");
+          emitBlock(statements, flag + " = (" + right + " != 0);");
+          result = flag;
+          return;
+     }
+
+     int mark = current().body.size();
+     string right = compile(InfixExp->rightNode, true);
+     Type* rightType = compiledType;
+     stabilize(left, leftType, mark);
+     compiledType = InfixExp->type;
+
+     bool strings = isStringType(leftType) || isStringType(rightType);
+     string op;
+     switch(InfixExp->op)
+     {
+          case OP_ADD:
+               result = "TG_ADD(" + left + ", " + right + ")";
+               return;
+          case OP_SUBTRACT:
+               result = "TG_SUB(" + left + ", " + right + ")";
+               return;
+          case OP_MULTIPLY:
+               result = "TG_MUL(" + left + ", " + right + ")";
+               return;
+          case OP_DIVIDE:
+               //Literal divisors can't be zero or -1, so those divisions can't go wrong
+               if(dynamic_cast<NIntLit*>(InfixExp->rightNode) != NULL && ((NIntLit*)(InfixExp->rightNode))->val != 0)
+                    result = "(" + left + " / " + right + ")";
+               else
+                    result = temporary(compiledType, "tg_div(" + left + ", " + right + ", " + to_string(InfixExp->lineNumber) + ")");
+               return;
+          case OP_EQ: op = "=="; break;
+          case OP_NEQ: op = "!="; break;
+          case OP_LT: op = "<"; break;
+          case OP_LEQ: op = "<="; break;
+          case OP_GT: op = ">"; break;
+          default: op = ">="; break;
+     }
+
+     //Arrays and records compare by identity
+     if(strings)
+          result = "(tg_compare(" + left + ", " + right + ") " + op + " 0)";
+     else
+          result = "(" + left + " " + op + " " + right + ")";
+}
+void nodeCBackend::visitArrCreate(arrCreate* ArrCreate)
+{
+     string size = compile(ArrCreate->subscriptExp, true);
+     int mark = current().body.size();
+     string init = compile(ArrCreate->postExp, true);
+     stabilize(size, ArrCreate->subscriptExp->type, mark);
+
+     string name = arrayName(((ArrType*)resolveType(ArrCreate->type))->ref);
+     result = temporary(ArrCreate->type, name + "_new(" + size + ", " + init + ", " + to_string(ArrCreate->lineNumber) + ")");
+     compiledType = ArrCreate->type;
+}
+void nodeCBackend::visitRecCreate(recCreate* RecCreate)
+{
+     string name = recordName((RecType*) resolveType(RecCreate->type));
+     string record = temporary(RecCreate->type, "(struct " + name + "*)tg_alloc(sizeof(struct " + name + "))");
+
+     //Fill the fields in the order they were written
+     for(int i = 0; i < RecCreate->fields->size(); i++)
+     {
+          fieldCreate* FieldCreate = (fieldCreate*)(*(RecCreate->fields))[i];
+          string value = compile(FieldCreate, true);
+          emit(record + "->f_" + *((NId*)(FieldCreate->id))->name + " = " + value + ";");
+     }
+     result = record;
+     compiledType = RecCreate->type;
+}
+void nodeCBackend::visitFieldCreate(fieldCreate* FieldCreate)
+{
+     result = compile(FieldCreate->exp, true);
+}
+void nodeCBackend::visitAssignment(assignment* Assign)
+{
+     //Like the interpreter, find the element or field before working out the value
+     string target;
+     if(dynamic_cast<subscript*>(Assign->lVal) != NULL)
+     {
+          subscript* Subscript = (subscript*) Assign->lVal;
+          string array = compile(Subscript->lValue, true);
+          Type* arrayType = compiledType;
+          int mark = current().body.size();
+          string index = compile(Subscript->exp, true);
+          stabilize(array, arrayType, mark);
+          index = temporary(Subscript->exp->type, "TG_INDEX(" + array + ", " + index + ", " + to_string(Subscript->exp->lineNumber) + ")");
+
+          mark = current().body.size();
+          string value = compile(Assign->exp, true);
+          stabilize(array, arrayType, mark);
+          emit(array + "->data[" + index + "] = " + value + ";");
+     }
+     else if(dynamic_cast<fieldExp*>(Assign->lVal) != NULL)
+     {
+          fieldExp* FieldExp = (fieldExp*) Assign->lVal;
+          string record = compile(FieldExp->lValue, true);
+          Type* recordType = compiledType;
+          emit("if(" + record + " == NULL)");
+          emit("     tg_nil_error(" + to_string(FieldExp->lineNumber) + ");");
+
+          int mark = current().body.size();
+          string value = compile(Assign->exp, true);
+          stabilize(record, recordType, mark);
+          emit(record + "->f_" + *((NId*)(FieldExp->ID))->name + " = " + value + ";");
+     }
+     else
+     {
+          string value = compile(Assign->exp, true);
+          emit(variable(lookup(((NId*)(Assign->lVal))->name)) + " = " + value + ";");
+     }
+     result = "0";
+     compiledType = NULL;
+}
+void nodeCBackend::visitIfThenElse(ifThenElse* iTE)
+{
+     string condition = compile(iTE->ifExp, true);
+
+     if(iTE->elseExp == NULL)
+     {
+          string value;
+          string statements = compileBlock(iTE->thenExp, false, value, tailPosition);
+          emit("if(" + condition + ")");
+          emitBlock(statements, "");
+          result = "0";
+          compiledType = NULL;
+          return;
+     }
+
+     string thenValue, elseValue;
+     string thenStatements = compileBlock(iTE->thenExp, wantValue, thenValue, tailPosition);
+     Type* thenType = compiledType;
+     string elseStatements = compileBlock(iTE->elseExp, wantValue, elseValue, tailPosition);
+     Type* elseType = compiledType;
+
+     //A nil branch has no record type of its own, so take the other branch's
+     Type* type = isUnitType(thenType) ? elseType : thenType;
+     string value;
+     if(wantValue)
+     {
+          value = "tg_t" + to_string(nextName++);
+          emit(cType(type) + " " + value + ";");
+     }
+
+     emit("if(" + condition + ")");
+     emitBlock(thenStatements, wantValue ? value + " = " + thenValue + ";" : "");
+     emit("else");
+     emitBlock(elseStatements, wantValue ? value + " = " + elseValue + ";" : "");
+     result = wantValue ? value : "0";
+     compiledType = type;
+}
+void nodeCBackend::visitWhileExp(whileExp* While)
+{
+     string condition;
+     string conditionStatements = compileBlock(While->condition, true, condition);
+     string value;
+     string body = compileBlock(While->action, false, value);
+
+     //Conditions that need statements of their own are tested inside the loop
+     if(conditionStatements.empty())
+     {
+          emit("while(" + condition + ")");
+          emitBlock(body, "");
+     }
+     else
+     {
+          emit("for(;;)");
+          emitBlock(conditionStatements + indentation(1) + "if(!(" + condition + "))\n"
+               + indentation(2) + "break;\n" + body, "");
+     }
+     result = "0";
+     compiledType = NULL;
+}
+void nodeCBackend::visitForExp(forExp* forEx)
+{
+     string low = compile(forEx->assign, true);
+     int mark = current().body.size();
+     string high = compile(forEx->condition, true);
+     stabilize(low, forEx->assign->type, mark);
+
+     //The loop variable and the limit are fixed before the body can run
+     map<Atom, CBinding> forScope;
+     scopes.push_back(forScope);
+     CBinding var = declareVariable(((NId*)(forEx->id))->name, forEx->assign->type, forEx);
+     string loopVariable = variable(&var);
+     if(var.escapes)
+          emit(loopVariable + " = " + low + ";");
+     else
+          emit("int " + var.name + " = " + low + ";");
+     string limit = temporary(forEx->condition->type, high);
+
+     //Check before incrementing so a limit of INT_MAX doesn't overflow
+     emit("if(" + loopVariable + " <= " + limit + ")");
+     emit("{");
+     current().indent++;
+     emit("for(;;)");
+     string value;
+     string body = compileBlock(forEx->action, false, value);
+     emitBlock(body + indentation(1) + "if(" + loopVariable + " >= " + limit + ")\n"
+          + indentation(2) + "break;\n", loopVariable + "++;");
+     current().indent--;
+     emit("}");
+
+     scopes.pop_back();
+     result = "0";
+     compiledType = NULL;
+}
+void nodeCBackend::visitLetExp(letExp* LetExp)
+{
+     map<Atom, CBinding> letScope;
+     scopes.push_back(letScope);
+
+     //Declare every function first so they can call each other
+     for(int i = 0; i < LetExp->decs->size(); i++)
+     {
+          decc* dec = (decc*)(*(LetExp->decs))[i];
+          if(dec->kind == D_FUNC)
+          {
+               funDec* FunDec = (funDec*) dec;
+               Atom name = ((NId*)(FunDec->id))->name;
+               CBinding binding = {CBIND_FUNC, uniqueName(*name), FunDec->returnType->type, (int)functions.size()-1, FunDec, false};
+               scopes.back()[name] = binding;
+          }
+     }
+
+     for(int i = 0; i < LetExp->decs->size(); i++)
+          compile((*(LetExp->decs))[i], false);
+
+     NodeList* exps = LetExp->exps;
+     if(exps->size() > 0)
+     {
+          for(int i = 0; i < exps->size()-1; i++)
+               compile((*exps)[i], false);
+          string value = compile((*exps)[exps->size()-1], wantValue, tailPosition);
+          Type* type = compiledType;
+          result = value;
+          compiledType = type;
+     }
+     else
+     {
+          result = "0";
+          compiledType = NULL;
+     }
+
+     scopes.pop_back();
+}
+void nodeCBackend::visitDec(decc* Dec)
+{
+
+}
+void nodeCBackend::visitTyDec(tyDec* TyDec)
+{
+     //Types become structs as values of them are used
+}
+void nodeCBackend::visitTyDef(tyDef* TyDef)
+{
+
+}
+void nodeCBackend::visitRefTy(refTy* RefTy)
+{
+
+}
+void nodeCBackend::visitArrTy(arrTy* ArrTy)
+{
+
+}
+void nodeCBackend::visitRecTy(recTy* RecTy)
+{
+
+}
+void nodeCBackend::visitFieldDec(fieldDec* FieldDec)
+{
+
+}
+void nodeCBackend::visitFunDec(funDec* FunDec)
+{
+     CBinding* binding = lookup(((NId*)(FunDec->id))->name);
+     bool returnsValue = !isUnitType(binding->type);
+
+     CFunction function;
+     function.name = binding->name;
+     function.frame = binding->name + "_frame";
+     function.parentFrame = current().frame;
+     function.signature = "static " + (returnsValue ? cType(binding->type) : string("void")) + " " + binding->name
+          + "(struct " + function.parentFrame + "* link";
+     function.loops = false;
+     function.indent = 1;
+     functions.push_back(function);
+
+     //Parameters that nested functions use are copied into the frame on entry
+     map<Atom, CBinding> paramScope;
+     scopes.push_back(paramScope);
+     for(int i = 0; i < FunDec->params->size(); i++)
+     {
+          fieldDec* param = (fieldDec*)(*(FunDec->params))[i];
+          CBinding var = declareVariable(((NId*)(param->id))->name, param->type, param);
+          current().signature += ", " + cType(param->type) + " " + var.name;
+          current().parameters.push_back(var);
+          if(var.escapes)
+               emit("fr." + var.name + " = " + var.name + ";");
+     }
+     current().signature += ")";
+     prototypes.push_back(current().signature + ";\n");
+
+     string value = compile(FunDec->exp, returnsValue, true);
+     if(returnsValue)
+          emit("return " + value + ";");
+
+     scopes.pop_back();
+     finishFunction();
+}
+void nodeCBackend::visitVarDec(varDec* VarDec)
+{
+     string value = compile(VarDec->exp, true);
+
+     //The name only comes into scope after its initializer
+     Type* type = VarDec->tyId->type;
+     CBinding var = declareVariable(((NId*)(VarDec->id))->name, type, VarDec);
+     if(var.escapes)
+          emit("fr." + var.name + " = " + value + ";");
+     else
+          emit(cType(type) + " " + var.name + " = " + value + ";");
+}
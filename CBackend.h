@@ -0,0 +1,469 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      CBackend.h
+     Purpose:       Translates a semantically valid Tiger AST into a single,
+                    standalone C translation unit (runtime included) that the
+                    system C compiler can build into a native program.
+
+*/
+
+/** @defgroup CBACKEND C Backend
+ *  Ahead-of-time compilation to C.
+ *  @{
+ */
+
+#ifndef C_BACKEND
+#define C_BACKEND
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include "ast.h"
+#include "SymbolTable.h"
+
+using namespace std;
+
+/**
+ * @brief Translates an analyzed AST into C.
+ *
+ */
+class CBackend
+{
+     public:
+          /**
+           * @brief Construct a new backend for an analyzed AST.
+           *
+           * @param astRoot The root of the AST; must have already passed semantic analysis.
+           */
+          CBackend(node* astRoot);
+
+          /**
+           * @brief Translates the whole tree.
+           *
+           * @return string A complete C translation unit, runtime included.
+           */
+          string Emit();
+
+          /**
+           * @brief The AST to translate.
+           *
+           */
+          node* astRoot;
+};
+
+/**
+ * @brief What a name in the backend's environment refers to.
+ *
+ */
+enum CBindingKind
+{
+     /**
+      * @brief A variable, held in a C local or in its function's frame struct.
+      *
+      */
+     CBIND_VAR,
+
+     /**
+      * @brief A user defined function.
+      *
+      */
+     CBIND_FUNC
+};
+
+/**
+ * @brief A name resolved to its C counterpart.
+ *
+ */
+class CBinding
+{
+     public:
+          /**
+           * @brief What the name refers to.
+           *
+           */
+          CBindingKind kind;
+
+          /**
+           * @brief Name of the C variable or function; unique across the whole program.
+           *
+           */
+          string name;
+
+          /**
+           * @brief Type of the variable, or return type of the function.
+           *
+           */
+          Type* type;
+
+          /**
+           * @brief Nesting level of the function that owns the variable, or that
+           * the function was declared in.
+           *
+           */
+          int level;
+
+          /**
+           * @brief The node that declared the variable (varDec, fieldDec or forExp).
+           *
+           */
+          node* declaration;
+
+          /**
+           * @brief Whether a nested function uses the variable, so it has to live
+           * in the frame struct rather than a C local.
+           *
+           */
+          bool escapes;
+};
+
+/**
+ * @brief A C function being generated, one per Tiger function plus main.
+ *
+ */
+class CFunction
+{
+     public:
+          /**
+           * @brief Name of the C function.
+           *
+           */
+          string name;
+
+          /**
+           * @brief The function's parameters, in order.
+           *
+           */
+          vector<CBinding> parameters;
+
+          /**
+           * @brief Whether a tail call to itself jumps back to the top of the body.
+           *
+           */
+          bool loops;
+
+          /**
+           * @brief Tag of the struct holding the function's escaping variables and static link.
+           *
+           */
+          string frame;
+
+          /**
+           * @brief Tag of the frame struct the static link points to, or empty for main.
+           *
+           */
+          string parentFrame;
+
+          /**
+           * @brief Everything before the opening brace.
+           *
+           */
+          string signature;
+
+          /**
+           * @brief Declarations of the variables that live in the frame struct.
+           *
+           */
+          vector<string> frameFields;
+
+          /**
+           * @brief Statements generated so far.
+           *
+           */
+          string body;
+
+          /**
+           * @brief Nesting of the statement being generated.
+           *
+           */
+          int indent;
+};
+
+/**
+ * @brief A node visitor that generates C for every node it visits. Each node's
+ * side effects are emitted as statements, and what's left is a C expression for
+ * its value that can be read at any point before the next statement.
+ *
+ * A function's tail calls to itself become jumps back to its top. Tail calls
+ * between different functions stay C calls, and run in constant stack only if the
+ * C compiler turns them into jumps (gcc and clang do at -O2), so build the output
+ * with -O2 or deep mutual recursion can overflow the stack.
+ *
+ */
+class nodeCBackend : public nodeVisitor
+{
+     public:
+          /**
+           * @brief Construct a new backend visitor with the builtin functions in scope.
+           *
+           */
+          nodeCBackend();
+
+          /**
+           * @brief Generates main from the program body.
+           *
+           * @param root The root of the AST.
+           */
+          void compileProgram(node* root);
+
+          /**
+           * @brief Puts everything generated together into one translation unit.
+           *
+           */
+          string Assemble();
+
+          /**
+           * @brief Generates a node's statements.
+           *
+           * @param Node The node to generate.
+           * @param want Whether the node's value is needed.
+           * @param tail Whether the node's value is what the current function returns.
+           * @return string A C expression for the value, or "0" if there isn't one.
+           * The value's type is left in compiledType.
+           */
+          string compile(node* Node, bool want, bool tail = false);
+
+          /**
+           * @brief Generates a node as the body of a new C block, one level deeper.
+           *
+           * @param Node The node to generate.
+           * @param want Whether the node's value is needed.
+           * @param value Set to a C expression for the value.
+           * @param tail Whether the node's value is what the current function returns.
+           * @return string The block's statements.
+           */
+          string compileBlock(node* Node, bool want, string &value, bool tail = false);
+
+          /**
+           * @brief Appends a statement to the current function.
+           *
+           */
+          void emit(const string &line);
+
+          /**
+           * @brief Appends a braced block of statements from compileBlock.
+           *
+           * @param statements The block's statements.
+           * @param last One more statement to end the block with, or empty.
+           */
+          void emitBlock(const string &statements, const string &last);
+
+          /**
+           * @brief Spaces for a statement some levels deeper than the current one.
+           *
+           */
+          string indentation(int extra);
+
+          /**
+           * @brief Adds the current function to the output along with its frame
+           * struct, and leaves it.
+           *
+           */
+          void finishFunction();
+
+          /**
+           * @brief Stores a value in a new C local.
+           *
+           * @return string Name of the local.
+           */
+          string temporary(Type* type, const string &value);
+
+          /**
+           * @brief Makes sure an earlier value still reads the same after whatever
+           * was emitted since, by copying it into a local before those statements.
+           *
+           * @param value The value, replaced by the local if one was needed.
+           * @param type The value's type.
+           * @param mark Length of the function body when the value was generated.
+           */
+          void stabilize(string &value, Type* type, int mark);
+
+          /**
+           * @brief Whether a value is a literal or a local nothing else writes to.
+           *
+           */
+          bool isStable(const string &value);
+
+          /**
+           * @brief The C type that holds a Tiger type.
+           *
+           */
+          string cType(Type* type);
+
+          /**
+           * @brief Tag of the struct for a record type, defining it the first time.
+           *
+           */
+          string recordName(RecType* type);
+
+          /**
+           * @brief Tag of the struct for arrays of a type, defining it the first time.
+           * Arrays with the same element C type share a struct.
+           *
+           */
+          string arrayName(Type* element);
+
+          /**
+           * @brief Follows reference types down to the type they name.
+           *
+           */
+          Type* resolveType(Type* type);
+
+          /**
+           * @brief Returns true if a type is (or refers to) a builtin type.
+           *
+           */
+          bool isStringType(Type* type);
+          bool isIntType(Type* type);
+          bool isUnitType(Type* type);
+
+          /**
+           * @brief A name no other C identifier in the program uses.
+           *
+           */
+          string uniqueName(const string &name);
+
+          /**
+           * @brief A Tiger string's characters as a C string literal.
+           *
+           */
+          string stringLiteral(const string &value);
+
+          /**
+           * @brief Finds what a name refers to in the innermost scope that declares it.
+           *
+           */
+          CBinding* lookup(Atom name);
+
+          /**
+           * @brief Brings a new variable into the innermost scope.
+           *
+           * @param name The Tiger name.
+           * @param type The variable's type.
+           * @param declaration The declaring node, used to find out whether it escapes.
+           * @return CBinding The variable.
+           */
+          CBinding declareVariable(Atom name, Type* type, node* declaration);
+
+          /**
+           * @brief An lvalue for a variable, reaching through static links if it
+           * belongs to an enclosing function.
+           *
+           */
+          string variable(CBinding* binding);
+
+          /**
+           * @brief The frame pointer of the function at a given nesting level.
+           *
+           */
+          string frameAt(int level);
+
+          /**
+           * @brief The current function.
+           *
+           */
+          CFunction& current();
+
+          //Visitor functions
+          void visitProgram(program* prog) override;
+          void visitBreak(NBreak* Break) override;
+          void visitNil(NNil* Nil) override;
+          void visitID(NId* id) override;
+          void visitTyID(NTyId* tyid) override;
+          void visitSubscript(subscript* Subscript) override;
+          void visitFieldExp(fieldExp* FieldExp) override;
+          void visitSeqExp(seqExp*) override;
+          void visitNegation(negation*) override;
+          void visitCallExp(callExp*) override;
+          void visitIntLit(NIntLit*) override;
+          void visitStrLit(NStrLit*) override;
+          void visitInfixExp(infixExp*) override;
+          void visitArrCreate(arrCreate*) override;
+          void visitRecCreate(recCreate*) override;
+          void visitFieldCreate(fieldCreate*) override;
+          void visitAssignment(assignment*) override;
+          void visitIfThenElse(ifThenElse*) override;
+          void visitWhileExp(whileExp*) override;
+          void visitForExp(forExp*) override;
+          void visitLetExp(letExp*) override;
+          void visitDec(decc*) override;
+          void visitTyDec(tyDec*) override;
+          void visitTyDef(tyDef*) override;
+          void visitRefTy(refTy*) override;
+          void visitArrTy(arrTy*) override;
+          void visitRecTy(recTy*) override;
+          void visitFieldDec(fieldDec*) override;
+          void visitFunDec(funDec*) override;
+          void visitVarDec(varDec*) override;
+
+          /**
+           * @brief Declarations of variables used by nested functions. Found by a
+           * first pass over the tree, and used by the second to place them in frames.
+           *
+           */
+          set<node*> escaping;
+
+          /**
+           * @brief Whether the node currently being visited must produce a value.
+           *
+           */
+          bool wantValue;
+
+          /**
+           * @brief Whether the node currently being visited is in tail position, so
+           * its value is returned as is.
+           *
+           */
+          bool tailPosition;
+
+          /**
+           * @brief The value of the node just visited, and its type (NULL for unit).
+           *
+           */
+          string result;
+          Type* compiledType;
+
+          /**
+           * @brief Scopes of names, innermost last.
+           *
+           */
+          vector< map<Atom, CBinding> > scopes;
+
+          /**
+           * @brief Functions currently being generated, innermost last; the index
+           * of each is its nesting level.
+           *
+           */
+          vector<CFunction> functions;
+
+          /**
+           * @brief Counter behind unique names and locals.
+           *
+           */
+          int nextName;
+
+          /**
+           * @brief Struct tags of every record type and array element type seen.
+           *
+           */
+          map<RecType*, string> recordNames;
+          map<string, string> arrayNames;
+
+          /**
+           * @brief Names of the constant defined for each distinct string literal.
+           *
+           */
+          map<string, string> stringNames;
+
+          /**
+           * @brief Pieces of the translation unit, in the order they're output.
+           *
+           */
+          vector<string> declarations;
+          vector<string> definitions;
+          vector<string> helpers;
+          vector<string> prototypes;
+          vector<string> functionDefinitions;
+};
+/** @} */
+#endif
@@ -0,0 +1,1007 @@
+#include <iostream>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include "ClosureCompiler.h"
+#include "Builtins.h"
+#include "Output.h"
+
+using namespace std;
+
+//Most slots the frame stack may hold before a runaway recursion is reported
+#define CLOSURE_MAX_STACK (1 << 24)
+
+/*********************
+ * RUNTIME STATE
+ * *******************/
+
+//Frames are carved out of one block; a call takes the slots above the caller's
+static VMWord* stackBase = NULL;
+static VMWord* stackTop = NULL;
+static VMWord* stackLimit = NULL;
+
+//Evaluators recurse on the native stack, so calls stop short of overrunning it
+static char* nativeStackBase = NULL;
+static size_t nativeStackBudget = 0;
+
+//Set by break and cleared by the loop it leaves, just like nodeInterpreter::breakCalled
+static bool breakCalled = false;
+
+//A call in tail position waiting for the call running its function to take it over,
+// with its static link and the arguments left just above the top of the stack
+static ClosureFunction* tailFunction = NULL;
+static VMWord* tailLink = NULL;
+static VMWord* tailArguments = NULL;
+
+//Frees arrays, records and strings nothing in a frame or held refers to any more
+static GarbageCollector* collector = NULL;
+
+static void throwError(const int &lineNumber, const string &errorMessage)
+{
+     cout << "ERROR " << lineNumber << ": Runtime: " << errorMessage << endl;
+     exit(4);
+}
+
+//Keeps a value the collector must see just above the frames, while the closures
+// that still need it run; release() lets go of it again
+static inline VMWord hold(VMWord word)
+{
+     if(stackTop >= stackLimit)
+     {
+          cout << "ERROR: Runtime: Stack overflow." << endl;
+          exit(4);
+     }
+     *stackTop++ = word;
+     return word;
+}
+
+static inline void release(int count)
+{
+     stackTop -= count;
+}
+
+//Nothing says which words are pointers, so every one in use is a root
+static void pollCollector()
+{
+     if(collector != NULL)
+          collector->PollWords((void* const*)stackBase, stackTop - stackBase);
+}
+
+//Makes a zeroed array or record, collecting and trying again before giving up
+static VMWord* allocate(size_t count, int lineNumber)
+{
+     void** words = WordBlock::Make(count);
+     if(words == NULL && collector != NULL)
+     {
+          collector->CollectWords((void* const*)stackBase, stackTop - stackBase);
+          words = WordBlock::Make(count);
+     }
+     if(words == NULL)
+          throwError(lineNumber, "Out of memory.");
+     return (VMWord*)words;
+}
+
+#define EVAL(closure) ((closure)->evaluate((closure), frame))
+
+static VMWord intWord(int i)
+{
+     VMWord word;
+     word.p = NULL;
+     word.i = i;
+     return word;
+}
+
+/*********************
+ * EVALUATORS
+ * *******************/
+
+static VMWord evalConst(Closure* self, VMWord* frame)
+{
+     return self->value;
+}
+
+static VMWord evalLocal(Closure* self, VMWord* frame)
+{
+     return frame[self->value.i];
+}
+
+static VMWord evalUp(Closure* self, VMWord* frame)
+{
+     VMWord* owner = frame;
+     for(int hops = self->operand; hops > 0; hops--)
+          owner = (VMWord*)owner[0].p;
+     return owner[self->value.i];
+}
+
+static VMWord evalStoreLocal(Closure* self, VMWord* frame)
+{
+     frame[self->value.i] = EVAL(self->a);
+     return intWord(0);
+}
+
+static VMWord evalStoreUp(Closure* self, VMWord* frame)
+{
+     VMWord value = EVAL(self->a);
+     VMWord* owner = frame;
+     for(int hops = self->operand; hops > 0; hops--)
+          owner = (VMWord*)owner[0].p;
+     owner[self->value.i] = value;
+     return intWord(0);
+}
+
+//x := x + constant on a local
+static VMWord evalIncLocal(Closure* self, VMWord* frame)
+{
+     frame[self->value.i].i = intAdd(frame[self->value.i].i, self->operand);
+     return intWord(0);
+}
+
+//Arithmetic wraps around like the hardware does instead of being undefined
+static VMWord evalAdd(Closure* self, VMWord* frame)
+{
+     int left = EVAL(self->a).i;
+     return intWord(intAdd(left, EVAL(self->b).i));
+}
+
+static VMWord evalAddConst(Closure* self, VMWord* frame)
+{
+     return intWord(intAdd(EVAL(self->a).i, self->operand));
+}
+
+static VMWord evalLocalAddConst(Closure* self, VMWord* frame)
+{
+     return intWord(intAdd(frame[self->value.i].i, self->operand));
+}
+
+static VMWord evalSub(Closure* self, VMWord* frame)
+{
+     int left = EVAL(self->a).i;
+     return intWord(intSubtract(left, EVAL(self->b).i));
+}
+
+static VMWord evalMul(Closure* self, VMWord* frame)
+{
+     int left = EVAL(self->a).i;
+     return intWord(intMultiply(left, EVAL(self->b).i));
+}
+
+static VMWord evalDiv(Closure* self, VMWord* frame)
+{
+     int left = EVAL(self->a).i;
+     int right = EVAL(self->b).i;
+     if(right == 0)
+          throwError(self->lineNumber, "Division by zero.");
+     if(right == -1)
+          return intWord(intNegate(left));
+     return intWord(left / right);
+}
+
+static VMWord evalNeg(Closure* self, VMWord* frame)
+{
+     return intWord(intNegate(EVAL(self->a).i));
+}
+
+static VMWord evalNot(Closure* self, VMWord* frame)
+{
+     return intWord(EVAL(self->a).i == 0 ? 1 : 0);
+}
+
+#define INT_COMPARE(name, op) \
+     static VMWord name(Closure* self, VMWord* frame) \
+     { \
+          int left = EVAL(self->a).i; \
+          return intWord(left op EVAL(self->b).i ? 1 : 0); \
+     }
+
+#define STRING_COMPARE(name, op) \
+     static VMWord name(Closure* self, VMWord* frame) \
+     { \
+          StringObject* left = (StringObject*)hold(EVAL(self->a)).p; \
+          StringObject* right = (StringObject*)EVAL(self->b).p; \
+          release(1); \
+          return intWord(left->Compare(right) op 0 ? 1 : 0); \
+     }
+
+#define POINTER_COMPARE(name, op) \
+     static VMWord name(Closure* self, VMWord* frame) \
+     { \
+          void* left = hold(EVAL(self->a)).p; \
+          void* right = EVAL(self->b).p; \
+          release(1); \
+          return intWord(left op right ? 1 : 0); \
+     }
+
+INT_COMPARE(evalLt, <)
+INT_COMPARE(evalLe, <=)
+INT_COMPARE(evalGt, >)
+INT_COMPARE(evalGe, >=)
+INT_COMPARE(evalEq, ==)
+INT_COMPARE(evalNe, !=)
+STRING_COMPARE(evalStrLt, <)
+STRING_COMPARE(evalStrLe, <=)
+STRING_COMPARE(evalStrGt, >)
+STRING_COMPARE(evalStrGe, >=)
+
+static VMWord evalStrEq(Closure* self, VMWord* frame)
+{
+     StringObject* left = (StringObject*)hold(EVAL(self->a)).p;
+     StringObject* right = (StringObject*)EVAL(self->b).p;
+     release(1);
+     return intWord(left->Equals(right) ? 1 : 0);
+}
+
+static VMWord evalStrNe(Closure* self, VMWord* frame)
+{
+     StringObject* left = (StringObject*)hold(EVAL(self->a)).p;
+     StringObject* right = (StringObject*)EVAL(self->b).p;
+     release(1);
+     return intWord(left->Equals(right) ? 0 : 1);
+}
+POINTER_COMPARE(evalPtrEq, ==)
+POINTER_COMPARE(evalPtrNe, !=)
+
+static VMWord evalAnd(Closure* self, VMWord* frame)
+{
+     return intWord(EVAL(self->a).i != 0 && EVAL(self->b).i != 0 ? 1 : 0);
+}
+
+static VMWord evalOr(Closure* self, VMWord* frame)
+{
+     return intWord(EVAL(self->a).i != 0 || EVAL(self->b).i != 0 ? 1 : 0);
+}
+
+static VMWord evalPrint(Closure* self, VMWord* frame)
+{
+     StringObject* s = (StringObject*)EVAL(self->a).p;
+     output->Write(s->GetChars(), s->GetLength());
+     return intWord(0);
+}
+
+static VMWord evalPrinti(Closure* self, VMWord* frame)
+{
+     output->WriteInt(EVAL(self->a).i);
+     return intWord(0);
+}
+
+static VMWord evalBuiltin(Closure* self, VMWord* frame)
+{
+     //The arguments stay held while the builtin runs
+     VMWord* args = stackTop;
+     for(int i = 0; i < self->list.size(); i++)
+          hold(EVAL(self->list[i]));
+     pollCollector();
+     VMWord result = callBuiltin(self->value.i, args, self->lineNumber);
+     release(self->list.size());
+     return result;
+}
+
+static VMWord evalSeq(Closure* self, VMWord* frame)
+{
+     VMWord result = intWord(0);
+     for(int i = 0; i < self->list.size(); i++)
+     {
+          result = EVAL(self->list[i]);
+          if(breakCalled)
+               break;
+     }
+     return result;
+}
+
+static VMWord evalIf(Closure* self, VMWord* frame)
+{
+     if(EVAL(self->a).i != 0)
+          return EVAL(self->b);
+     return EVAL(self->c);
+}
+
+static VMWord evalIfThen(Closure* self, VMWord* frame)
+{
+     if(EVAL(self->a).i != 0)
+          EVAL(self->b);
+     return intWord(0);
+}
+
+static VMWord evalWhile(Closure* self, VMWord* frame)
+{
+     while(EVAL(self->a).i != 0)
+     {
+          EVAL(self->b);
+          if(breakCalled)
+          {
+               breakCalled = false;
+               break;
+          }
+     }
+     return intWord(0);
+}
+
+//The loop variable lives in its frame slot so the body can read it like any other variable
+static VMWord evalFor(Closure* self, VMWord* frame)
+{
+     int slot = self->value.i;
+     frame[slot] = EVAL(self->a);
+     int limit = EVAL(self->b).i;
+     if(frame[slot].i > limit)
+          return intWord(0);
+     while(true)
+     {
+          EVAL(self->c);
+          if(breakCalled)
+          {
+               breakCalled = false;
+               break;
+          }
+          if(frame[slot].i >= limit)
+               break;
+          frame[slot].i++;
+     }
+     return intWord(0);
+}
+
+static VMWord evalBreak(Closure* self, VMWord* frame)
+{
+     breakCalled = true;
+     return intWord(0);
+}
+
+//Arrays are a length word followed by the elements
+static VMWord evalNewArray(Closure* self, VMWord* frame)
+{
+     int size = EVAL(self->a).i;
+     VMWord init = hold(EVAL(self->b));
+     if(size < 0)
+          throwError(self->lineNumber, "Negative array size.");
+     pollCollector();
+     VMWord* array = allocate((size_t)size + 1, self->lineNumber);
+     release(1);
+     array[0].i = size;
+     for(int i = 1; i <= size; i++)
+          array[i] = init;
+     VMWord result;
+     result.p = array;
+     return result;
+}
+
+static VMWord evalSubscript(Closure* self, VMWord* frame)
+{
+     VMWord* array = (VMWord*)hold(EVAL(self->a)).p;
+     unsigned index = EVAL(self->b).i;
+     release(1);
+     if(index >= (unsigned)array[0].i)
+          throwError(self->lineNumber, "Array access out of bounds.");
+     return array[index + 1];
+}
+
+static VMWord evalArrayStore(Closure* self, VMWord* frame)
+{
+     VMWord* array = (VMWord*)hold(EVAL(self->a)).p;
+     unsigned index = EVAL(self->b).i;
+     VMWord value = EVAL(self->c);
+     release(1);
+     if(index >= (unsigned)array[0].i)
+          throwError(self->lineNumber, "Array access out of bounds.");
+     array[index + 1] = value;
+     return intWord(0);
+}
+
+//Records are just their fields, in the order the type lists them;
+// each entry in the list holds a field's index and its initializer. The fields
+// are evaluated first and held until the record is made to put them in.
+static VMWord evalNewRecord(Closure* self, VMWord* frame)
+{
+     VMWord* fields = stackTop;
+     for(int i = 0; i < self->list.size(); i++)
+          hold(EVAL(self->list[i]->a));
+     pollCollector();
+     VMWord* record = allocate(self->value.i + 1, self->lineNumber);
+     for(int i = 0; i < self->list.size(); i++)
+          record[self->list[i]->value.i] = fields[i];
+     release(self->list.size());
+     VMWord result;
+     result.p = record;
+     return result;
+}
+
+static VMWord evalGetField(Closure* self, VMWord* frame)
+{
+     VMWord* record = (VMWord*)EVAL(self->a).p;
+     if(record == NULL)
+          throwError(self->lineNumber, "Field access on nil record.");
+     return record[self->value.i];
+}
+
+static VMWord evalSetField(Closure* self, VMWord* frame)
+{
+     VMWord* record = (VMWord*)hold(EVAL(self->a)).p;
+     VMWord value = EVAL(self->b);
+     release(1);
+     if(record == NULL)
+          throwError(self->lineNumber, "Field access on nil record.");
+     record[self->value.i] = value;
+     return intWord(0);
+}
+
+static VMWord evalCall(Closure* self, VMWord* frame)
+{
+     ClosureFunction* function = self->function;
+
+     //Claim the callee's frame before evaluating arguments, so calls made
+     // by the arguments stack up above it
+     VMWord* callee = stackTop;
+     stackTop += function->frameSize;
+     char marker;
+     if(stackTop > stackLimit || (size_t)(nativeStackBase - &marker) > nativeStackBudget)
+     {
+          cout << "ERROR: Runtime: Stack overflow." << endl;
+          exit(4);
+     }
+
+     VMWord* link = frame;
+     for(int hops = self->operand; hops > 0; hops--)
+          link = (VMWord*)link[0].p;
+     callee[0].p = link;
+     for(int i = 0; i < self->list.size(); i++)
+          callee[i + 1] = EVAL(self->list[i]);
+
+     VMWord result = function->body->evaluate(function->body, callee);
+
+     //Run any tail calls the body left in the same frame, until one returns
+     while(tailFunction != NULL)
+     {
+          function = tailFunction;
+          tailFunction = NULL;
+          stackTop = callee + function->frameSize;
+          if(stackTop > stackLimit)
+          {
+               cout << "ERROR: Runtime: Stack overflow." << endl;
+               exit(4);
+          }
+          callee[0].p = tailLink;
+          for(int i = 0; i < function->numParams; i++)
+               callee[i + 1] = tailArguments[i];
+          result = function->body->evaluate(function->body, callee);
+     }
+     stackTop = callee;
+     return result;
+}
+
+//Evaluates the arguments above the top of the stack and leaves the call for the
+// evalCall running this function, which reuses its frame for it
+static VMWord evalTailCall(Closure* self, VMWord* frame)
+{
+     VMWord* arguments = stackTop;
+     stackTop += self->list.size();
+     if(stackTop > stackLimit)
+     {
+          cout << "ERROR: Runtime: Stack overflow." << endl;
+          exit(4);
+     }
+     for(int i = 0; i < self->list.size(); i++)
+          arguments[i] = EVAL(self->list[i]);
+     stackTop = arguments;
+
+     VMWord* link = frame;
+     for(int hops = self->operand; hops > 0; hops--)
+          link = (VMWord*)link[0].p;
+     tailFunction = self->function;
+     tailLink = link;
+     tailArguments = arguments;
+     return intWord(0);
+}
+
+/*********************
+ * CLOSURE
+ * *******************/
+
+Closure::Closure(ClosureFn evaluate, int lineNumber)
+:evaluate(evaluate), a(NULL), b(NULL), c(NULL), operand(0), function(NULL), lineNumber(lineNumber)
+{
+     value.p = NULL;
+}
+
+/*********************
+ * CLOSURE PROGRAM
+ * *******************/
+
+ClosureProgram::ClosureProgram():collector(NULL){}
+
+ClosureProgram::~ClosureProgram()
+{
+     for(int i = 0; i < closures.size(); i++)
+          delete closures[i];
+     for(int i = 0; i < functions.size(); i++)
+          delete functions[i];
+}
+
+void ClosureProgram::Run()
+{
+     ::collector = this->collector;
+     stackBase = (VMWord*)malloc(CLOSURE_MAX_STACK * sizeof(VMWord));
+     if(stackBase == NULL)
+     {
+          cout << "ERROR: Runtime: Out of memory." << endl;
+          exit(4);
+     }
+     stackLimit = stackBase + CLOSURE_MAX_STACK;
+     stackTop = stackBase + main.frameSize;
+     stackBase[0].p = NULL;
+     breakCalled = false;
+     tailFunction = NULL;
+
+     //Leave a margin of the native stack for everything that isn't a Tiger call
+     char marker;
+     struct rlimit limit;
+     nativeStackBase = &marker;
+     nativeStackBudget = 6 << 20;
+     if(getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+          nativeStackBudget = limit.rlim_cur - (limit.rlim_cur / 8) - (256 << 10);
+
+     main.body->evaluate(main.body, stackBase);
+
+     free(stackBase);
+     stackBase = stackTop = stackLimit = NULL;
+     ::collector = NULL;
+}
+
+/*********************
+ * CLOSURE COMPILER
+ * *******************/
+
+ClosureCompiler::ClosureCompiler(node* astRoot):astRoot(astRoot){}
+
+ClosureProgram* ClosureCompiler::Compile()
+{
+     ClosureProgram* program = new ClosureProgram();
+     nodeClosureCompiler compiler(program);
+     compiler.compileProgram(astRoot);
+     return program;
+}
+
+/***************************
+ * NODE CLOSURE COMPILER
+ * *************************/
+
+nodeClosureCompiler::nodeClosureCompiler(ClosureProgram* program):prog(program), result(NULL)
+{
+     //The outermost scope mirrors DefaultTigerTable(), but calls to builtins are
+     // bound during semantic analysis so it never has anything to look up
+     scopes.push_back(map<Atom, Binding>());
+}
+
+void nodeClosureCompiler::compileProgram(node* root)
+{
+     prog->main.numParams = 0;
+     prog->main.frameSize = 1;
+     ClosureContext context = {&(prog->main), 1};
+     functions.push_back(context);
+
+     prog->main.body = compile(root);
+
+     functions.pop_back();
+}
+
+Closure* nodeClosureCompiler::compile(node* Node)
+{
+     Node->accept(this);
+     return result;
+}
+
+Closure* nodeClosureCompiler::make(ClosureFn evaluate, int lineNumber)
+{
+     Closure* closure = new Closure(evaluate, lineNumber);
+     prog->closures.push_back(closure);
+     return closure;
+}
+
+Closure* nodeClosureCompiler::makeInt(int constant)
+{
+     Closure* closure = make(evalConst, 0);
+     closure->value.i = constant;
+     return closure;
+}
+
+Closure* nodeClosureCompiler::makeVariable(Binding* binding, Closure* store)
+{
+     int hops = (functions.size()-1) - binding->level;
+     Closure* closure;
+     if(hops == 0)
+          closure = make(store != NULL ? evalStoreLocal : evalLocal, 0);
+     else
+          closure = make(store != NULL ? evalStoreUp : evalUp, 0);
+     closure->value.i = binding->index;
+     closure->operand = hops;
+     closure->a = store;
+     return closure;
+}
+
+Type* nodeClosureCompiler::resolveType(Type* type)
+{
+     //Can't use GetActualType() here since it looks through arrays to their elements
+     while(dynamic_cast<RefType*>(type) != NULL)
+          type = ((RefType*)type)->ref;
+     return type;
+}
+
+bool nodeClosureCompiler::isStringType(Type* type)
+{
+     return type != NULL && resolveType(type)->name == ATOM_STRING;
+}
+
+bool nodeClosureCompiler::isIntType(Type* type)
+{
+     return type != NULL && resolveType(type)->name == ATOM_INT;
+}
+
+Binding* nodeClosureCompiler::lookup(Atom name)
+{
+     for(int i = scopes.size()-1; i >= 0; i--)
+     {
+          map<Atom, Binding>::iterator itr = scopes[i].find(name);
+          if(itr != scopes[i].end())
+               return &(itr->second);
+     }
+     return NULL;
+}
+
+int nodeClosureCompiler::allocateSlot()
+{
+     ClosureContext& context = functions.back();
+     int slot = context.nextSlot++;
+     if(context.nextSlot > context.function->frameSize)
+          context.function->frameSize = context.nextSlot;
+     return slot;
+}
+
+/*********
+ * VISITS
+ * *******/
+
+void nodeClosureCompiler::visitProgram(program* Program)
+{
+     result = compile(Program->Node);
+}
+void nodeClosureCompiler::visitBreak(NBreak* Break)
+{
+     result = make(evalBreak, Break->lineNumber);
+}
+void nodeClosureCompiler::visitNil(NNil* Nil)
+{
+     result = make(evalConst, Nil->lineNumber);
+}
+void nodeClosureCompiler::visitID(NId* id)
+{
+     result = makeVariable(lookup(id->name), NULL);
+}
+void nodeClosureCompiler::visitTyID(NTyId* tyid)
+{
+     result = makeInt(0);
+}
+void nodeClosureCompiler::visitIntLit(NIntLit* intLit)
+{
+     result = makeInt(intLit->val);
+}
+void nodeClosureCompiler::visitStrLit(NStrLit* strLit)
+{
+     //Semantic analysis pooled the literal, so every evaluation shares it
+     result = make(evalConst, strLit->lineNumber);
+     result->value.p = strLit->value.GetStringObject();
+}
+void nodeClosureCompiler::visitSubscript(subscript* Subscript)
+{
+     Closure* closure = make(evalSubscript, Subscript->exp->lineNumber);
+     closure->a = compile(Subscript->lValue);
+     closure->b = compile(Subscript->exp);
+     result = closure;
+}
+void nodeClosureCompiler::visitFieldExp(fieldExp* FieldExp)
+{
+     Closure* closure = make(evalGetField, FieldExp->lineNumber);
+     closure->a = compile(FieldExp->lValue);
+     closure->value.i = FieldExp->slot;
+     result = closure;
+}
+void nodeClosureCompiler::visitSeqExp(seqExp* SeqExp)
+{
+     NodeList* exps = SeqExp->exps;
+     if(exps->size() == 1)
+     {
+          result = compile((*exps)[0]);
+          return;
+     }
+
+     Closure* closure = make(evalSeq, SeqExp->lineNumber);
+     for(int i = 0; i < exps->size(); i++)
+          closure->list.push_back(compile((*exps)[i]));
+     result = closure;
+}
+void nodeClosureCompiler::visitNegation(negation* neg)
+{
+     Closure* closure = make(evalNeg, neg->lineNumber);
+     closure->a = compile(neg->operand);
+     result = closure;
+}
+void nodeClosureCompiler::visitCallExp(callExp* CallExp)
+{
+     NodeList* args = CallExp->exps;
+     Builtin* builtin = CallExp->builtin;
+     if(builtin != NULL)
+     {
+          //print, printi and not are common enough to get their own evaluators
+          Closure* closure;
+          switch(builtin->kind)
+          {
+               case BUILTIN_PRINT: closure = make(evalPrint, CallExp->lineNumber); break;
+               case BUILTIN_PRINTI: closure = make(evalPrinti, CallExp->lineNumber); break;
+               case BUILTIN_NOT: closure = make(evalNot, CallExp->lineNumber); break;
+               default:
+                    closure = make(evalBuiltin, CallExp->lineNumber);
+                    closure->value.i = builtin->kind;
+                    for(int i = 0; i < args->size(); i++)
+                         closure->list.push_back(compile((*args)[i]));
+                    result = closure;
+                    return;
+          }
+          closure->a = compile((*args)[0]);
+          result = closure;
+          return;
+     }
+
+     Binding* binding = lookup(((NId*)(CallExp->id))->name);
+
+     //The callee's static link is the frame of the function it was declared in
+     Closure* closure = make(CallExp->tail ? evalTailCall : evalCall, CallExp->lineNumber);
+     closure->function = prog->functions[binding->index];
+     closure->operand = (functions.size()-1) - (binding->level-1);
+     for(int i = 0; i < args->size(); i++)
+          closure->list.push_back(compile((*args)[i]));
+     result = closure;
+}
+void nodeClosureCompiler::visitInfixExp(infixExp* InfixExp)
+{
+     //x + constant and x - constant are common enough to get their own evaluators
+     if((InfixExp->op == OP_ADD || InfixExp->op == OP_SUBTRACT) && dynamic_cast<NIntLit*>(InfixExp->rightNode) != NULL)
+     {
+          int constant = ((NIntLit*)(InfixExp->rightNode))->val;
+          Closure* left = compile(InfixExp->leftNode);
+          Closure* closure;
+          if(left->evaluate == evalLocal)
+          {
+               closure = make(evalLocalAddConst, InfixExp->lineNumber);
+               closure->value = left->value;
+          }
+          else
+          {
+               closure = make(evalAddConst, InfixExp->lineNumber);
+               closure->a = left;
+          }
+          closure->operand = InfixExp->op == OP_ADD ? constant : -constant;
+          result = closure;
+          return;
+     }
+
+     bool strings = isStringType(InfixExp->leftNode->type) || isStringType(InfixExp->rightNode->type);
+     bool ints = isIntType(InfixExp->leftNode->type) || isIntType(InfixExp->rightNode->type);
+     ClosureFn evaluate;
+     switch(InfixExp->op)
+     {
+          case OP_ADD: evaluate = evalAdd; break;
+          case OP_SUBTRACT: evaluate = evalSub; break;
+          case OP_MULTIPLY: evaluate = evalMul; break;
+          case OP_DIVIDE: evaluate = evalDiv; break;
+          case OP_AND: evaluate = evalAnd; break;
+          case OP_OR: evaluate = evalOr; break;
+          case OP_LT: evaluate = strings ? evalStrLt : evalLt; break;
+          case OP_LEQ: evaluate = strings ? evalStrLe : evalLe; break;
+          case OP_GT: evaluate = strings ? evalStrGt : evalGt; break;
+          case OP_GEQ: evaluate = strings ? evalStrGe : evalGe; break;
+          case OP_EQ: evaluate = strings ? evalStrEq : (ints ? evalEq : evalPtrEq); break;
+          default: evaluate = strings ? evalStrNe : (ints ? evalNe : evalPtrNe); break;
+     }
+
+     Closure* closure = make(evaluate, InfixExp->lineNumber);
+     closure->a = compile(InfixExp->leftNode);
+     closure->b = compile(InfixExp->rightNode);
+     result = closure;
+}
+void nodeClosureCompiler::visitArrCreate(arrCreate* ArrCreate)
+{
+     Closure* closure = make(evalNewArray, ArrCreate->lineNumber);
+     closure->a = compile(ArrCreate->subscriptExp);
+     closure->b = compile(ArrCreate->postExp);
+     result = closure;
+}
+void nodeClosureCompiler::visitRecCreate(recCreate* RecCreate)
+{
+     Closure* closure = make(evalNewRecord, RecCreate->lineNumber);
+     closure->value.i = RecCreate->record->fields->size();
+
+     //Fill the fields in the order they were written
+     for(int i = 0; i < RecCreate->fields->size(); i++)
+     {
+          fieldCreate* FieldCreate = (fieldCreate*)(*(RecCreate->fields))[i];
+          Closure* field = make(NULL, FieldCreate->lineNumber);
+          field->value.i = FieldCreate->slot;
+          field->a = compile(FieldCreate);
+          closure->list.push_back(field);
+     }
+     result = closure;
+}
+void nodeClosureCompiler::visitFieldCreate(fieldCreate* FieldCreate)
+{
+     result = compile(FieldCreate->exp);
+}
+void nodeClosureCompiler::visitAssignment(assignment* Assign)
+{
+     if(dynamic_cast<subscript*>(Assign->lVal) != NULL)
+     {
+          subscript* Subscript = (subscript*) Assign->lVal;
+          Closure* closure = make(evalArrayStore, Subscript->exp->lineNumber);
+          closure->a = compile(Subscript->lValue);
+          closure->b = compile(Subscript->exp);
+          closure->c = compile(Assign->exp);
+          result = closure;
+     }
+     else if(dynamic_cast<fieldExp*>(Assign->lVal) != NULL)
+     {
+          fieldExp* FieldExp = (fieldExp*) Assign->lVal;
+          Closure* closure = make(evalSetField, FieldExp->lineNumber);
+          closure->a = compile(FieldExp->lValue);
+          closure->b = compile(Assign->exp);
+          closure->value.i = FieldExp->slot;
+          result = closure;
+     }
+     else
+     {
+          Binding* binding = lookup(((NId*)(Assign->lVal))->name);
+          Closure* value = compile(Assign->exp);
+
+          //x := x + constant on a local can be done in place
+          if(value->evaluate == evalLocalAddConst && value->value.i == binding->index
+               && binding->level == functions.size()-1)
+          {
+               Closure* closure = make(evalIncLocal, Assign->lineNumber);
+               closure->value.i = binding->index;
+               closure->operand = value->operand;
+               result = closure;
+          }
+          else
+               result = makeVariable(binding, value);
+     }
+}
+void nodeClosureCompiler::visitIfThenElse(ifThenElse* iTE)
+{
+     Closure* closure = make(iTE->elseExp == NULL ? evalIfThen : evalIf, iTE->lineNumber);
+     closure->a = compile(iTE->ifExp);
+     closure->b = compile(iTE->thenExp);
+     if(iTE->elseExp != NULL)
+          closure->c = compile(iTE->elseExp);
+     result = closure;
+}
+void nodeClosureCompiler::visitWhileExp(whileExp* While)
+{
+     Closure* closure = make(evalWhile, While->lineNumber);
+     closure->a = compile(While->condition);
+     closure->b = compile(While->action);
+     result = closure;
+}
+void nodeClosureCompiler::visitForExp(forExp* forEx)
+{
+     Closure* closure = make(evalFor, forEx->lineNumber);
+     closure->a = compile(forEx->assign);
+     closure->b = compile(forEx->condition);
+
+     //The loop variable gets its own slot in a new scope
+     int savedSlot = functions.back().nextSlot;
+     Binding var = {BIND_VAR, (int)functions.size()-1, allocateSlot()};
+     map<Atom, Binding> forScope;
+     forScope[((NId*)(forEx->id))->name] = var;
+     scopes.push_back(forScope);
+
+     closure->value.i = var.index;
+     closure->c = compile(forEx->action);
+
+     scopes.pop_back();
+     functions.back().nextSlot = savedSlot;
+     result = closure;
+}
+void nodeClosureCompiler::visitLetExp(letExp* LetExp)
+{
+     map<Atom, Binding> letScope;
+     scopes.push_back(letScope);
+     int savedSlot = functions.back().nextSlot;
+
+     //Declare every function first so they can call each other
+     for(int i = 0; i < LetExp->decs->size(); i++)
+     {
+          decc* dec = (decc*)(*(LetExp->decs))[i];
+          if(dec->kind == D_FUNC)
+          {
+               funDec* FunDec = (funDec*) dec;
+               ClosureFunction* function = new ClosureFunction();
+               function->body = NULL;
+               function->numParams = FunDec->params->size();
+               function->frameSize = 1 + function->numParams;
+               Binding binding = {BIND_FUNC, (int)functions.size(), (int)prog->functions.size()};
+               prog->functions.push_back(function);
+               scopes.back()[((NId*)(FunDec->id))->name] = binding;
+          }
+     }
+
+     //Variable declarations become stores, run in order ahead of the body
+     Closure* closure = make(evalSeq, LetExp->lineNumber);
+     for(int i = 0; i < LetExp->decs->size(); i++)
+     {
+          result = NULL;
+          compile((*(LetExp->decs))[i]);
+          if(result != NULL)
+               closure->list.push_back(result);
+     }
+
+     for(int i = 0; i < LetExp->exps->size(); i++)
+          closure->list.push_back(compile((*(LetExp->exps))[i]));
+
+     scopes.pop_back();
+     functions.back().nextSlot = savedSlot;
+     result = closure;
+}
+void nodeClosureCompiler::visitDec(decc* Dec)
+{
+
+}
+void nodeClosureCompiler::visitTyDec(tyDec* TyDec)
+{
+     //Types are entirely handled by semantic analysis
+     result = NULL;
+}
+void nodeClosureCompiler::visitTyDef(tyDef* TyDef)
+{
+
+}
+void nodeClosureCompiler::visitRefTy(refTy* RefTy)
+{
+
+}
+void nodeClosureCompiler::visitArrTy(arrTy* ArrTy)
+{
+
+}
+void nodeClosureCompiler::visitRecTy(recTy* RecTy)
+{
+
+}
+void nodeClosureCompiler::visitFieldDec(fieldDec* FieldDec)
+{
+
+}
+void nodeClosureCompiler::visitFunDec(funDec* FunDec)
+{
+     Binding* binding = lookup(((NId*)(FunDec->id))->name);
+     ClosureFunction* function = prog->functions[binding->index];
+
+     //Parameters sit right after the static link
+     map<Atom, Binding> paramScope;
+     for(int i = 0; i < FunDec->params->size(); i++)
+     {
+          fieldDec* param = (fieldDec*)(*(FunDec->params))[i];
+          Binding var = {BIND_VAR, binding->level, i+1};
+          paramScope[((NId*)(param->id))->name] = var;
+     }
+
+     ClosureContext context = {function, function->frameSize};
+     functions.push_back(context);
+     scopes.push_back(paramScope);
+
+     function->body = compile(FunDec->exp);
+
+     scopes.pop_back();
+     functions.pop_back();
+     result = NULL;
+}
+void nodeClosureCompiler::visitVarDec(varDec* VarDec)
+{
+     Closure* value = compile(VarDec->exp);
+
+     //The name only comes into scope after its initializer
+     Binding var = {BIND_VAR, (int)functions.size()-1, allocateSlot()};
+     scopes.back()[((NId*)(VarDec->id))->name] = var;
+     result = makeVariable(&var, value);
+}
@@ -0,0 +1,368 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      ClosureCompiler.h
+     Purpose:       Compiles a semantically valid AST into a tree of pre-bound
+                    evaluators, resolving operators, types and variable slots
+                    once so execution never goes back through the visitor.
+
+*/
+
+/** @defgroup CLOSURE Closure Compiler
+ *  Turns the AST into directly callable evaluators.
+ *  @{
+ */
+
+#ifndef CLOSURE_COMPILER
+#define CLOSURE_COMPILER
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "ast.h"
+#include "SymbolTable.h"
+#include "Bytecode.h"
+#include "VirtualMachine.h"
+
+using namespace std;
+
+class Closure;
+class ClosureFunction;
+
+/**
+ * @brief Evaluates a closure against the frame of the function it was compiled in.
+ * Slot 0 of every frame is the frame of the enclosing function (the static link).
+ *
+ */
+typedef VMWord (*ClosureFn)(Closure* self, VMWord* frame);
+
+/**
+ * @brief One compiled expression: the evaluator picked for it, plus everything
+ * that evaluator needs already bound in.
+ *
+ */
+class Closure
+{
+     public:
+          /**
+           * @brief Construct a new closure with no operands.
+           *
+           * @param evaluate The evaluator for this expression.
+           * @param lineNumber Line to report runtime errors on.
+           */
+          Closure(ClosureFn evaluate, int lineNumber);
+
+          /**
+           * @brief Specialized evaluator for this expression.
+           *
+           */
+          ClosureFn evaluate;
+
+          /**
+           * @brief Sub-expressions; which ones are used depends on the evaluator.
+           *
+           */
+          Closure* a;
+          Closure* b;
+          Closure* c;
+
+          /**
+           * @brief Sub-expressions for sequences, calls, and record creation.
+           *
+           */
+          vector<Closure*> list;
+
+          /**
+           * @brief A constant, a frame slot, or a field index.
+           *
+           */
+          VMWord value;
+
+          /**
+           * @brief Static link hops for variables and calls, or a second constant.
+           *
+           */
+          intptr_t operand;
+
+          /**
+           * @brief Callee of a call.
+           *
+           */
+          ClosureFunction* function;
+
+          /**
+           * @brief Line to report runtime errors on.
+           *
+           */
+          int lineNumber;
+};
+
+/**
+ * @brief A compiled Tiger function and its frame layout.
+ *
+ */
+class ClosureFunction
+{
+     public:
+          /**
+           * @brief The function body.
+           *
+           */
+          Closure* body;
+
+          /**
+           * @brief Number of formal parameters; they sit in slots 1..numParams.
+           *
+           */
+          int numParams;
+
+          /**
+           * @brief Total number of slots (static link, parameters, and locals) in a frame.
+           *
+           */
+          int frameSize;
+};
+
+/**
+ * @brief A whole Tiger program compiled to closures.
+ *
+ */
+class ClosureProgram
+{
+     public:
+          /**
+           * @brief Construct an empty program, without a collector.
+           *
+           */
+          ClosureProgram();
+
+          /**
+           * @brief Destroy the program and every closure, function and string it owns.
+           *
+           */
+          ~ClosureProgram();
+
+          /**
+           * @brief Runs the program to completion.
+           *
+           */
+          void Run();
+
+          /**
+           * @brief The program body, run in a frame of its own.
+           *
+           */
+          ClosureFunction main;
+
+          /**
+           * @brief Every function in the program.
+           *
+           */
+          vector<ClosureFunction*> functions;
+
+          /**
+           * @brief Every closure in the program.
+           *
+           */
+          vector<Closure*> closures;
+
+          /**
+           * @brief Frees arrays, records and strings the program can't reach any more.
+           * Values don't say which words are pointers, so every word in a frame, or
+           * held above them while it's still needed, is scanned.
+           *
+           */
+          GarbageCollector* collector;
+};
+
+/**
+ * @brief Compiles a semantically valid AST into a ClosureProgram.
+ *
+ */
+class ClosureCompiler
+{
+     public:
+          /**
+           * @brief Construct a new compiler for an analyzed AST.
+           *
+           * @param astRoot The root of the AST; must have already passed semantic analysis.
+           */
+          ClosureCompiler(node* astRoot);
+
+          /**
+           * @brief Compiles the whole tree.
+           *
+           * @return ClosureProgram* The compiled program; owned by the caller.
+           */
+          ClosureProgram* Compile();
+
+          /**
+           * @brief The AST to compile.
+           *
+           */
+          node* astRoot;
+};
+
+/**
+ * @brief A function whose body is being compiled.
+ *
+ */
+class ClosureContext
+{
+     public:
+          /**
+           * @brief The function being compiled.
+           *
+           */
+          ClosureFunction* function;
+
+          /**
+           * @brief Next free slot in the function's frame.
+           *
+           */
+          int nextSlot;
+};
+
+/**
+ * @brief A node visitor that builds the closure for each node it visits.
+ *
+ */
+class nodeClosureCompiler : public nodeVisitor
+{
+     public:
+          /**
+           * @brief Construct a new closure compiler that adds to a program.
+           *
+           * @param program The program to add closures to.
+           */
+          nodeClosureCompiler(ClosureProgram* program);
+
+          /**
+           * @brief Compiles the program body.
+           *
+           * @param root The root of the AST.
+           */
+          void compileProgram(node* root);
+
+          /**
+           * @brief Compiles a single node.
+           *
+           * @param Node The node to compile.
+           * @return Closure* The closure that evaluates it.
+           */
+          Closure* compile(node* Node);
+
+          /**
+           * @brief Makes a new closure owned by the program.
+           *
+           * @param evaluate The evaluator for the closure.
+           * @param lineNumber Line to report runtime errors on.
+           */
+          Closure* make(ClosureFn evaluate, int lineNumber);
+
+          /**
+           * @brief Makes a closure that evaluates to an integer constant.
+           *
+           * @param constant The constant.
+           */
+          Closure* makeInt(int constant);
+
+          /**
+           * @brief Makes a closure that reads or writes a variable in whichever frame owns it.
+           *
+           * @param binding The resolved variable.
+           * @param store The value to store, or NULL to load.
+           */
+          Closure* makeVariable(Binding* binding, Closure* store);
+
+          /**
+           * @brief Follows references to their actual type, without looking
+           * through arrays the way Type::GetActualType() does.
+           *
+           * @param type The type to resolve.
+           */
+          Type* resolveType(Type* type);
+
+          /**
+           * @brief Whether a type is string.
+           *
+           */
+          bool isStringType(Type* type);
+
+          /**
+           * @brief Whether a type is int.
+           *
+           */
+          bool isIntType(Type* type);
+
+          /**
+           * @brief Finds what a name is bound to in the current scopes.
+           *
+           * @param name The name to look up.
+           */
+          Binding* lookup(Atom name);
+
+          /**
+           * @brief Reserves a new slot in the current frame.
+           *
+           */
+          int allocateSlot();
+
+          //Visitor functions
+          void visitProgram(program* prog) override;
+          void visitBreak(NBreak* Break) override;
+          void visitNil(NNil* Nil) override;
+          void visitID(NId* id) override;
+          void visitTyID(NTyId* tyid) override;
+          void visitSubscript(subscript* Subscript) override;
+          void visitFieldExp(fieldExp* FieldExp) override;
+          void visitSeqExp(seqExp*) override;
+          void visitNegation(negation*) override;
+          void visitCallExp(callExp*) override;
+          void visitIntLit(NIntLit*) override;
+          void visitStrLit(NStrLit*) override;
+          void visitInfixExp(infixExp*) override;
+          void visitArrCreate(arrCreate*) override;
+          void visitRecCreate(recCreate*) override;
+          void visitFieldCreate(fieldCreate*) override;
+          void visitAssignment(assignment*) override;
+          void visitIfThenElse(ifThenElse*) override;
+          void visitWhileExp(whileExp*) override;
+          void visitForExp(forExp*) override;
+          void visitLetExp(letExp*) override;
+          void visitDec(decc*) override;
+          void visitTyDec(tyDec*) override;
+          void visitTyDef(tyDef*) override;
+          void visitRefTy(refTy*) override;
+          void visitArrTy(arrTy*) override;
+          void visitRecTy(recTy*) override;
+          void visitFieldDec(fieldDec*) override;
+          void visitFunDec(funDec*) override;
+          void visitVarDec(varDec*) override;
+
+          /**
+           * @brief The program being built.
+           *
+           */
+          ClosureProgram* prog;
+
+          /**
+           * @brief The closure built by the last visit.
+           *
+           */
+          Closure* result;
+
+          /**
+           * @brief Scopes of names, innermost last.
+           *
+           */
+          vector< map<Atom, Binding> > scopes;
+
+          /**
+           * @brief Functions currently being compiled, innermost last.
+           *
+           */
+          vector<ClosureContext> functions;
+};
+/** @} */
+#endif
@@ -0,0 +1,425 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <iostream>
+#include "FastLexer.h"
+#include "ast.h"
+#include "tigerParse.tab.h"
+
+using namespace std;
+
+extern int lineNumber;
+
+/*********************
+ * VECTOR HELPERS
+ * *******************/
+
+//Each compare covers a chunk of source and gives back one bit per byte in it.
+// SSE2 is always there on x86-64; AVX2 is used when the CPU running the lexer
+// has it, by the copies of the chunk loops built for it below.
+#if defined(__SSE2__)
+#define VECTOR_LEXER
+#include <immintrin.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VECTOR_LEXER_AVX2
+#endif
+
+//Chunk loops inline into whichever copy of them is built for an instruction set
+#define CHUNK_LOOP static inline __attribute__((always_inline))
+
+//A chunk of source loaded for compares
+class Sse2Chunk
+{
+     public:
+          static const int SIZE = 16;
+          static const unsigned int BITS = 0xFFFFu;
+
+          Sse2Chunk(const char* chars):bytes(_mm_loadu_si128((const __m128i*)chars)){}
+
+          unsigned int matches(char c) const
+          {
+               return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(c)));
+          }
+          unsigned int inRange(char low, char high) const
+          {
+               return between(bytes, low, high);
+          }
+          unsigned int letters() const
+          {
+               return between(_mm_or_si128(bytes, _mm_set1_epi8(0x20)), 'a', 'z');
+          }
+
+     private:
+          static unsigned int between(__m128i chars, char low, char high)
+          {
+               //Shifted down to low, a byte in range is at most high - low, unsigned
+               __m128i shifted = _mm_sub_epi8(chars, _mm_set1_epi8(low));
+               __m128i clamped = _mm_min_epu8(shifted, _mm_set1_epi8((char)(high - low)));
+               return (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(shifted, clamped));
+          }
+
+          __m128i bytes;
+};
+
+#ifdef VECTOR_LEXER_AVX2
+#define AVX2 __attribute__((target("avx2")))
+
+class Avx2Chunk
+{
+     public:
+          static const int SIZE = 32;
+          static const unsigned int BITS = 0xFFFFFFFFu;
+
+          AVX2 Avx2Chunk(const char* chars):bytes(_mm256_loadu_si256((const __m256i*)chars)){}
+
+          AVX2 unsigned int matches(char c) const
+          {
+               return (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(c)));
+          }
+          AVX2 unsigned int inRange(char low, char high) const
+          {
+               return between(bytes, low, high);
+          }
+          AVX2 unsigned int letters() const
+          {
+               return between(_mm256_or_si256(bytes, _mm256_set1_epi8(0x20)), 'a', 'z');
+          }
+
+     private:
+          AVX2 static unsigned int between(__m256i chars, char low, char high)
+          {
+               __m256i shifted = _mm256_sub_epi8(chars, _mm256_set1_epi8(low));
+               __m256i clamped = _mm256_min_epu8(shifted, _mm256_set1_epi8((char)(high - low)));
+               return (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(shifted, clamped));
+          }
+
+          __m256i bytes;
+};
+#endif
+
+//Bits for the bytes before the one at position
+#define BITS_BEFORE(position) ((1u << (position)) - 1)
+
+//Skips whole chunks of spaces, tabs and newlines, counting the newlines, up to the
+// first other character or the last part of the source too short for a chunk
+template<class V> CHUNK_LOOP const char* whitespaceChunks(const char* next, const char* end)
+{
+     while(next + V::SIZE <= end)
+     {
+          V chunk(next);
+          unsigned int newlines = chunk.matches('\n');
+          unsigned int stops = ~(chunk.matches(' ') | chunk.matches('\t') | newlines) & V::BITS;
+          if(stops != 0)
+          {
+               int stop = __builtin_ctz(stops);
+               lineNumber += __builtin_popcount(newlines & BITS_BEFORE(stop));
+               return next + stop;
+          }
+          lineNumber += __builtin_popcount(newlines);
+          next += V::SIZE;
+     }
+     return next;
+}
+
+//Skips a comment's text a chunk at a time, counting newlines, to just past its
+// end; a '*' in one chunk lined up with a '/' in the chunk a byte on closes it
+template<class V> CHUNK_LOOP const char* commentChunks(const char* next, const char* end, bool &closed)
+{
+     while(next + V::SIZE + 1 <= end)
+     {
+          V chunk(next), following(next + 1);
+          unsigned int newlines = chunk.matches('\n');
+          unsigned int closes = chunk.matches('*') & following.matches('/');
+          if(closes != 0)
+          {
+               int close = __builtin_ctz(closes);
+               lineNumber += __builtin_popcount(newlines & BITS_BEFORE(close));
+               closed = true;
+               return next + close + 2;
+          }
+          lineNumber += __builtin_popcount(newlines);
+          next += V::SIZE;
+     }
+     return next;
+}
+
+//Skips characters of a string literal a chunk at a time, up to a quote or escape
+template<class V> CHUNK_LOOP const char* stringChunks(const char* chars, const char* end)
+{
+     while(chars + V::SIZE <= end)
+     {
+          V chunk(chars);
+          unsigned int stops = chunk.matches('"') | chunk.matches('\\');
+          if(stops != 0)
+               return chars + __builtin_ctz(stops);
+          chars += V::SIZE;
+     }
+     return chars;
+}
+
+//Skips letters, digits and underscores a chunk at a time
+template<class V> CHUNK_LOOP const char* identifierChunks(const char* chars, const char* end)
+{
+     while(chars + V::SIZE <= end)
+     {
+          V chunk(chars);
+          unsigned int word = chunk.letters() | chunk.inRange('0', '9') | chunk.matches('_');
+          unsigned int stops = ~word & V::BITS;
+          if(stops != 0)
+               return chars + __builtin_ctz(stops);
+          chars += V::SIZE;
+     }
+     return chars;
+}
+
+#ifdef VECTOR_LEXER_AVX2
+//The AVX2 copies, built for it whatever the rest of the program is built for
+AVX2 static const char* whitespaceChunksAvx2(const char* next, const char* end)
+{
+     return whitespaceChunks<Avx2Chunk>(next, end);
+}
+AVX2 static const char* commentChunksAvx2(const char* next, const char* end, bool &closed)
+{
+     return commentChunks<Avx2Chunk>(next, end, closed);
+}
+AVX2 static const char* stringChunksAvx2(const char* chars, const char* end)
+{
+     return stringChunks<Avx2Chunk>(chars, end);
+}
+AVX2 static const char* identifierChunksAvx2(const char* chars, const char* end)
+{
+     return identifierChunks<Avx2Chunk>(chars, end);
+}
+#endif
+#endif
+
+/*********************
+ * FAST LEXER
+ * *******************/
+
+FastLexer::FastLexer(SourceFile* source):source(source), avx2(false)
+{
+     next = source->Text();
+     end = next + source->Length();
+
+#ifdef VECTOR_LEXER_AVX2
+     //Checked once here, rather than for every chunk loop that's run
+     avx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+void FastLexer::skipWhitespace()
+{
+#ifdef VECTOR_LEXER
+#ifdef VECTOR_LEXER_AVX2
+     if(avx2)
+          next = whitespaceChunksAvx2(next, end);
+     else
+#endif
+          next = whitespaceChunks<Sse2Chunk>(next, end);
+#endif
+     while(next < end && (*next == ' ' || *next == '\t' || *next == '\n'))
+     {
+          if(*next == '\n')
+               lineNumber++;
+          next++;
+     }
+}
+
+void FastLexer::skipComment()
+{
+     int startLine = lineNumber;
+
+#ifdef VECTOR_LEXER
+     bool closed = false;
+#ifdef VECTOR_LEXER_AVX2
+     if(avx2)
+          next = commentChunksAvx2(next, end, closed);
+     else
+#endif
+          next = commentChunks<Sse2Chunk>(next, end, closed);
+     if(closed)
+          return;
+#endif
+     while(next < end)
+     {
+          if(*next == '*' && next + 1 < end && next[1] == '/')
+          {
+               next += 2;
+               return;
+          }
+          if(*next == '\n')
+               lineNumber++;
+          next++;
+     }
+
+     cout << "ERROR: " << lineNumber << ": Lexer: Unterminated comment starting at line " << startLine << ".\n";
+     exit(1);
+}
+
+const char* FastLexer::stringEnd(const char* start)
+{
+     const char* chars = start + 1;
+     while(true)
+     {
+          //Only a quote or an escape can end the run of plain characters
+#ifdef VECTOR_LEXER
+#ifdef VECTOR_LEXER_AVX2
+          if(avx2)
+               chars = stringChunksAvx2(chars, end);
+          else
+#endif
+               chars = stringChunks<Sse2Chunk>(chars, end);
+#endif
+          while(chars < end && *chars != '"' && *chars != '\\')
+               chars++;
+
+          if(chars >= end)
+               return NULL;
+          if(*chars == '"')
+               return chars + 1;
+
+          //An escape takes any character but a newline
+          if(chars + 1 >= end || chars[1] == '\n')
+               return NULL;
+          chars += 2;
+     }
+}
+
+const char* FastLexer::identifierEnd(const char* start)
+{
+     const char* chars = start + 1;
+#ifdef VECTOR_LEXER
+#ifdef VECTOR_LEXER_AVX2
+     if(avx2)
+          chars = identifierChunksAvx2(chars, end);
+     else
+#endif
+          chars = identifierChunks<Sse2Chunk>(chars, end);
+#endif
+     while(chars < end && (isalnum((unsigned char)*chars) || *chars == '_'))
+          chars++;
+     return chars;
+}
+
+int FastLexer::keyword(const char* word, size_t length)
+{
+     static const char* const KEYWORDS[] = {"array", "break", "do", "else", "end", "for", "function", "if",
+          "in", "let", "nil", "of", "then", "to", "type", "var", "while"};
+     static const int TOKENS[] = {ARRAY, BREAK, DO, ELSE, END, FOR, FUNCTION, IF,
+          IN, LET, NIL, OF, THEN, TO, TYPE, VAR, WHILE};
+
+     if(length < 2 || length > 8)
+          return 0;
+     for(int i = 0; i < sizeof(TOKENS) / sizeof(TOKENS[0]); i++)
+     {
+          if(KEYWORDS[i][0] == word[0] && strlen(KEYWORDS[i]) == length && memcmp(KEYWORDS[i], word, length) == 0)
+               return TOKENS[i];
+     }
+     return 0;
+}
+
+int FastLexer::Lex()
+{
+     //Skip everything between tokens
+     while(true)
+     {
+          skipWhitespace();
+          if(next >= end)
+               return 0;
+          if(next[0] == '/' && next + 1 < end && next[1] == '*')
+          {
+               next += 2;
+               skipComment();
+          }
+          else if(next[0] == '\r' && next + 1 < end && next[1] == '\n')
+          {
+               next += 2;
+               lineNumber++;
+          }
+          else
+               break;
+     }
+
+     const char* start = next;
+     char c = *next++;
+     if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+     {
+          next = identifierEnd(start);
+          int token = keyword(start, next - start);
+          if(token != 0)
+               return token;
+          yylval.atom = Intern(start, next - start);
+          return ID;
+     }
+     if(c >= '0' && c <= '9')
+     {
+          while(next < end && *next >= '0' && *next <= '9')
+               next++;
+
+          //The source ends in NULs, so atoi stops at the end of the digits
+          yylval.iValue = atoi(start);
+          return INTLIT;
+     }
+     if(c == '"')
+     {
+          next = stringEnd(start);
+          if(next == NULL)
+          {
+               std::cout << "ERROR: " << lineNumber << ": Lexer: Unterminated string \n";
+               exit(1);
+          }
+          yylval.view = source->View(start, next - start);
+          return STRLIT;
+     }
+
+     switch(c)
+     {
+          case '(': return LPAREN;
+          case ')': return RPAREN;
+          case '[': return LBRACK;
+          case ']': return RBRACK;
+          case '{': return LBRACE;
+          case '}': return RBRACE;
+          case ':':
+               if(next < end && *next == '=')
+               {
+                    next++;
+                    return ASSIGNMENT;
+               }
+               return COLON;
+          case '.': return PERIOD;
+          case ',': return COMMA;
+          case ';': return SEMICOLON;
+          case '*': return MULTIPLY;
+          case '/': return DIVIDE;
+          case '+': return ADD;
+          case '-': return SUBTRACT;
+          case '=': return EQUALS;
+          case '<':
+               if(next < end && *next == '>')
+               {
+                    next++;
+                    return LESSGREATER;
+               }
+               if(next < end && *next == '=')
+               {
+                    next++;
+                    return LEQUAL;
+               }
+               return LESS;
+          case '>':
+               if(next < end && *next == '=')
+               {
+                    next++;
+                    return GEQUAL;
+               }
+               return GREATER;
+          case '&': return AND;
+          case '|': return OR;
+     }
+
+     cout << "ERROR: " << lineNumber << ": Lexer: Unexpected token (" << c << ") \n";
+     exit(1);
+}
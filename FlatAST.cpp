@@ -0,0 +1,331 @@
+#include "FlatAST.h"
+#include "Builtins.h"
+
+using namespace std;
+
+/*********************
+ * FLAT TREE
+ * *******************/
+
+uint32_t FlatTree::Add(FlatKind kind, node* original)
+{
+     kinds.push_back((uint8_t)kind);
+     first.push_back((uint32_t)operands.size());
+     lines.push_back(original->lineNumber);
+     types.push_back(original->type);
+     return (uint32_t)(kinds.size() - 1);
+}
+
+/*********************
+ * FLATTENER
+ * *******************/
+
+Flattener::Flattener(node* astRoot):astRoot(astRoot){}
+
+FlatTree* Flattener::Flatten()
+{
+     FlatTree* tree = new FlatTree();
+     nodeFlattener flattener(tree);
+     tree->root = flattener.flatten(astRoot);
+
+     //The tree is never added to again, so give back what the arrays grew past
+     tree->kinds.shrink_to_fit();
+     tree->first.shrink_to_fit();
+     tree->operands.shrink_to_fit();
+     tree->lines.shrink_to_fit();
+     tree->types.shrink_to_fit();
+     return tree;
+}
+
+/*********************
+ * NODE FLATTENER
+ * *******************/
+
+nodeFlattener::nodeFlattener(FlatTree* tree):tree(tree), result(FLAT_NONE){}
+
+uint32_t nodeFlattener::flatten(node* Node)
+{
+     if(Node == NULL)
+          return FLAT_NONE;
+     Node->accept(this);
+     return result;
+}
+
+vector<uint32_t> nodeFlattener::flattenAll(NodeList* Nodes)
+{
+     vector<uint32_t> indices;
+     for(int i = 0; i < Nodes->size(); i++)
+          indices.push_back(flatten((*Nodes)[i]));
+     return indices;
+}
+
+uint32_t nodeFlattener::functionIndex(funDec* FunDec)
+{
+     map<funDec*, uint32_t>::iterator itr = functionIndices.find(FunDec);
+     if(itr != functionIndices.end())
+          return itr->second;
+
+     FlatFunction function;
+     function.body = FLAT_NONE;
+     function.frameSize = FunDec->frameSize;
+     function.paramSlots = (uint32_t)tree->operands.size();
+     for(int i = 0; i < FunDec->paramSlots.size(); i++)
+          tree->operands.push_back(FunDec->paramSlots[i]);
+
+     uint32_t index = (uint32_t)tree->functions.size();
+     tree->functions.push_back(function);
+     functionIndices[FunDec] = index;
+     return index;
+}
+
+uint32_t nodeFlattener::recordIndex(RecType* record)
+{
+     map<RecType*, uint32_t>::iterator itr = recordIndices.find(record);
+     if(itr != recordIndices.end())
+          return itr->second;
+
+     uint32_t index = (uint32_t)tree->records.size();
+     tree->records.push_back(record);
+     recordIndices[record] = index;
+     return index;
+}
+
+/*********
+ * VISITS
+ * *******/
+
+void nodeFlattener::visitProgram(program* prog)
+{
+     result = flatten(prog->Node);
+}
+void nodeFlattener::visitBreak(NBreak* Break)
+{
+     result = tree->Add(FLAT_BREAK, Break);
+}
+void nodeFlattener::visitNil(NNil* Nil)
+{
+     result = tree->Add(FLAT_NIL, Nil);
+}
+void nodeFlattener::visitID(NId* id)
+{
+     result = tree->Add(FLAT_VAR, id);
+     tree->operands.push_back(id->depth);
+     tree->operands.push_back(id->slot);
+}
+void nodeFlattener::visitTyID(NTyId* tyid){}
+void nodeFlattener::visitIntLit(NIntLit* intLit)
+{
+     result = tree->Add(FLAT_INT, intLit);
+     tree->operands.push_back((uint32_t)intLit->val);
+}
+void nodeFlattener::visitStrLit(NStrLit* strLit)
+{
+     //Literals were pooled during semantic analysis, so equal ones share an index
+     StringObject* literal = strLit->value.GetStringObject();
+     map<StringObject*, uint32_t>::iterator itr = stringIndices.find(literal);
+     uint32_t index;
+     if(itr == stringIndices.end())
+     {
+          index = (uint32_t)tree->strings.size();
+          tree->strings.push_back(literal);
+          stringIndices[literal] = index;
+     }
+     else
+          index = itr->second;
+
+     result = tree->Add(FLAT_STRING, strLit);
+     tree->operands.push_back(index);
+}
+void nodeFlattener::visitSubscript(subscript* Subscript)
+{
+     uint32_t array = flatten(Subscript->lValue);
+     uint32_t index = flatten(Subscript->exp);
+     result = tree->Add(FLAT_SUBSCRIPT, Subscript);
+     tree->operands.push_back(array);
+     tree->operands.push_back(index);
+}
+void nodeFlattener::visitFieldExp(fieldExp* FieldExp)
+{
+     uint32_t record = flatten(FieldExp->lValue);
+     result = tree->Add(FLAT_FIELD, FieldExp);
+     tree->operands.push_back(record);
+     tree->operands.push_back(FieldExp->slot);
+}
+void nodeFlattener::visitSeqExp(seqExp* SeqExp)
+{
+     vector<uint32_t> exps = flattenAll(SeqExp->exps);
+     result = tree->Add(FLAT_SEQ, SeqExp);
+     tree->operands.push_back((uint32_t)exps.size());
+     tree->operands.insert(tree->operands.end(), exps.begin(), exps.end());
+}
+void nodeFlattener::visitNegation(negation* neg)
+{
+     uint32_t operand = flatten(neg->operand);
+     result = tree->Add(FLAT_NEGATE, neg);
+     tree->operands.push_back(operand);
+}
+void nodeFlattener::visitCallExp(callExp* CallExp)
+{
+     vector<uint32_t> args = flattenAll(CallExp->exps);
+     if(CallExp->builtin != NULL)
+     {
+          result = tree->Add(FLAT_BUILTIN, CallExp);
+          tree->operands.push_back(CallExp->builtin->kind);
+     }
+     else
+     {
+          uint32_t function = functionIndex(CallExp->function);
+          result = tree->Add(CallExp->tail ? FLAT_TAIL_CALL : FLAT_CALL, CallExp);
+          tree->operands.push_back(function);
+          tree->operands.push_back(((NId*)(CallExp->id))->depth);
+     }
+     tree->operands.push_back((uint32_t)args.size());
+     tree->operands.insert(tree->operands.end(), args.begin(), args.end());
+}
+void nodeFlattener::visitInfixExp(infixExp* InfixExp)
+{
+     uint32_t left = flatten(InfixExp->leftNode);
+     uint32_t right = flatten(InfixExp->rightNode);
+     result = tree->Add(FLAT_INFIX, InfixExp);
+     tree->operands.push_back(InfixExp->operation);
+     tree->operands.push_back(left);
+     tree->operands.push_back(right);
+}
+void nodeFlattener::visitArrCreate(arrCreate* ArrCreate)
+{
+     uint32_t size = flatten(ArrCreate->subscriptExp);
+     uint32_t initial = flatten(ArrCreate->postExp);
+     result = tree->Add(FLAT_ARRAY, ArrCreate);
+     tree->operands.push_back(size);
+     tree->operands.push_back(initial);
+     tree->operands.push_back(ArrCreate->ints ? 1 : 0);
+}
+void nodeFlattener::visitRecCreate(recCreate* RecCreate)
+{
+     vector<uint32_t> values = flattenAll(RecCreate->fields);
+     result = tree->Add(FLAT_RECORD, RecCreate);
+     tree->operands.push_back(recordIndex(RecCreate->record));
+     tree->operands.push_back((uint32_t)values.size());
+     for(int i = 0; i < values.size(); i++)
+     {
+          tree->operands.push_back(((fieldCreate*)(*(RecCreate->fields))[i])->slot);
+          tree->operands.push_back(values[i]);
+     }
+}
+void nodeFlattener::visitFieldCreate(fieldCreate* FieldCreate)
+{
+     //Only its value is a node of its own; the record takes its slot
+     result = flatten(FieldCreate->exp);
+}
+void nodeFlattener::visitAssignment(assignment* Assign)
+{
+     if(dynamic_cast<subscript*>(Assign->lVal) != NULL)
+     {
+          subscript* Subscript = (subscript*)Assign->lVal;
+          uint32_t array = flatten(Subscript->lValue);
+          uint32_t index = flatten(Subscript->exp);
+          uint32_t value = flatten(Assign->exp);
+          result = tree->Add(FLAT_ASSIGN_ELEMENT, Assign);
+          tree->operands.push_back(array);
+          tree->operands.push_back(index);
+          tree->operands.push_back(value);
+
+          //Bounds errors are reported on the index's line
+          tree->lines[result] = Subscript->exp->lineNumber;
+     }
+     else if(dynamic_cast<fieldExp*>(Assign->lVal) != NULL)
+     {
+          fieldExp* FieldExp = (fieldExp*)Assign->lVal;
+          uint32_t record = flatten(FieldExp->lValue);
+          uint32_t value = flatten(Assign->exp);
+          result = tree->Add(FLAT_ASSIGN_FIELD, Assign);
+          tree->operands.push_back(record);
+          tree->operands.push_back(FieldExp->slot);
+          tree->operands.push_back(value);
+
+          //Nil errors are reported on the field expression's line
+          tree->lines[result] = FieldExp->lineNumber;
+     }
+     else
+     {
+          NId* id = (NId*)Assign->lVal;
+          uint32_t value = flatten(Assign->exp);
+          result = tree->Add(FLAT_ASSIGN_VAR, Assign);
+          tree->operands.push_back(id->depth);
+          tree->operands.push_back(id->slot);
+          tree->operands.push_back(value);
+     }
+}
+void nodeFlattener::visitIfThenElse(ifThenElse* iTE)
+{
+     uint32_t condition = flatten(iTE->ifExp);
+     uint32_t thenExp = flatten(iTE->thenExp);
+     uint32_t elseExp = flatten(iTE->elseExp);
+     result = tree->Add(FLAT_IF, iTE);
+     tree->operands.push_back(condition);
+     tree->operands.push_back(thenExp);
+     tree->operands.push_back(elseExp);
+}
+void nodeFlattener::visitWhileExp(whileExp* While)
+{
+     uint32_t condition = flatten(While->condition);
+     uint32_t body = flatten(While->action);
+     result = tree->Add(FLAT_WHILE, While);
+     tree->operands.push_back(condition);
+     tree->operands.push_back(body);
+}
+void nodeFlattener::visitForExp(forExp* forEx)
+{
+     uint32_t initial = flatten(forEx->assign);
+     uint32_t limit = flatten(forEx->condition);
+     uint32_t body = flatten(forEx->action);
+     result = tree->Add(FLAT_FOR, forEx);
+     tree->operands.push_back(((NId*)(forEx->id))->slot);
+     tree->operands.push_back(initial);
+     tree->operands.push_back(limit);
+     tree->operands.push_back(body);
+}
+void nodeFlattener::visitLetExp(letExp* LetExp)
+{
+     //Functions become entries of their own; only variables are run by the let
+     vector<uint32_t> slots;
+     vector<uint32_t> initializers;
+     for(int i = 0; i < LetExp->decs->size(); i++)
+     {
+          decc* dec = (decc*)(*(LetExp->decs))[i];
+          if(dec->kind == D_FUNC)
+               flatten(dec);
+          else if(dec->kind == D_VAR)
+          {
+               slots.push_back(((NId*)(dec->id))->slot);
+               initializers.push_back(flatten(((varDec*)dec)->exp));
+          }
+     }
+     vector<uint32_t> exps = flattenAll(LetExp->exps);
+
+     result = tree->Add(FLAT_LET, LetExp);
+     tree->operands.push_back(LetExp->frameSize);
+     tree->operands.push_back((uint32_t)slots.size());
+     for(int i = 0; i < slots.size(); i++)
+     {
+          tree->operands.push_back(slots[i]);
+          tree->operands.push_back(initializers[i]);
+     }
+     tree->operands.push_back((uint32_t)exps.size());
+     tree->operands.insert(tree->operands.end(), exps.begin(), exps.end());
+}
+void nodeFlattener::visitDec(decc* Dec){}
+void nodeFlattener::visitTyDec(tyDec* TyDec){}
+void nodeFlattener::visitTyDef(tyDef* TyDef){}
+void nodeFlattener::visitRefTy(refTy* RefTy){}
+void nodeFlattener::visitArrTy(arrTy* ArrTy){}
+void nodeFlattener::visitRecTy(recTy* RecTy){}
+void nodeFlattener::visitFieldDec(fieldDec* FieldDec){}
+void nodeFlattener::visitFunDec(funDec* FunDec)
+{
+     //Flattening the body can add functions, so it's done before indexing them
+     uint32_t function = functionIndex(FunDec);
+     uint32_t body = flatten(FunDec->exp);
+     tree->functions[function].body = body;
+}
+void nodeFlattener::visitVarDec(varDec* VarDec){}
@@ -0,0 +1,288 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      FlatAST.h
+     Purpose:       A compact copy of an analyzed AST: every node is a one byte
+                    kind and a run of 32-bit operands in one contiguous array,
+                    children are referred to by index instead of by pointer, and
+                    line numbers and types sit in side tables. Once a program is
+                    flattened, the pointer tree can be thrown away.
+
+*/
+
+/** @defgroup FLAT Flat AST
+ *  The AST as tags and indices into contiguous arrays.
+ *  @{
+ */
+
+#ifndef FLAT_AST
+#define FLAT_AST
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include "ast.h"
+#include "SymbolTable.h"
+
+using namespace std;
+
+//Stands in for a missing child, like an if without an else
+#define FLAT_NONE 0xFFFFFFFFu
+
+/**
+ * @brief What a flat node is. Each kind's operands, in order, are listed next to
+ * it; "node" operands are indices of other flat nodes.
+ *
+ */
+enum FlatKind
+{
+     FLAT_NIL,            //
+     FLAT_BREAK,          //
+     FLAT_INT,            //value
+     FLAT_STRING,         //index into strings
+     FLAT_VAR,            //depth, slot
+     FLAT_SUBSCRIPT,      //array node, index node
+     FLAT_FIELD,          //record node, slot
+     FLAT_SEQ,            //count, count expression nodes
+     FLAT_NEGATE,         //operand node
+     FLAT_CALL,           //index into functions, depth, count, count argument nodes
+     FLAT_TAIL_CALL,      //the same as FLAT_CALL
+     FLAT_BUILTIN,        //BuiltinKind, count, count argument nodes
+     FLAT_INFIX,          //InfixOperation, left node, right node
+     FLAT_ARRAY,          //size node, initial value node, whether the elements are ints
+     FLAT_RECORD,         //index into records, count, count (slot, value node) pairs
+     FLAT_ASSIGN_VAR,     //depth, slot, value node
+     FLAT_ASSIGN_FIELD,   //record node, slot, value node
+     FLAT_ASSIGN_ELEMENT, //array node, index node, value node
+     FLAT_IF,             //condition node, then node, else node or FLAT_NONE
+     FLAT_WHILE,          //condition node, body node
+     FLAT_FOR,            //slot, initial value node, limit node, body node
+     FLAT_LET             //frame size, count, count (slot, initializer node) pairs, count, count body nodes
+};
+
+/**
+ * @brief A Tiger function, with the frame layout needed to call it.
+ *
+ */
+class FlatFunction
+{
+     public:
+          /**
+           * @brief The node for the function's body.
+           *
+           */
+          uint32_t body;
+
+          /**
+           * @brief Number of slots in a frame for the function.
+           *
+           */
+          int frameSize;
+
+          /**
+           * @brief Where the parameters' slots start in operands, one per parameter.
+           *
+           */
+          uint32_t paramSlots;
+};
+
+/**
+ * @brief A whole program as flat nodes.
+ *
+ */
+class FlatTree
+{
+     public:
+          /**
+           * @brief Adds a node with no operands yet; they are appended to operands
+           * right after.
+           *
+           * @param kind What the node is.
+           * @param original The node it is flattened from, for its line and type.
+           * @return uint32_t The new node's index.
+           */
+          uint32_t Add(FlatKind kind, node* original);
+
+          /**
+           * @brief The kind of every node.
+           *
+           */
+          vector<uint8_t> kinds;
+
+          /**
+           * @brief Where every node's operands start in operands.
+           *
+           */
+          vector<uint32_t> first;
+
+          /**
+           * @brief Every node's operands, one node's after another.
+           *
+           */
+          vector<uint32_t> operands;
+
+          /**
+           * @brief The line every node came from, for runtime errors.
+           *
+           */
+          vector<int> lines;
+
+          /**
+           * @brief The type semantic analysis gave every node.
+           *
+           */
+          vector<Type*> types;
+
+          /**
+           * @brief Every function, called by index.
+           *
+           */
+          vector<FlatFunction> functions;
+
+          /**
+           * @brief The pooled string literals.
+           *
+           */
+          vector<StringObject*> strings;
+
+          /**
+           * @brief Every record type created somewhere.
+           *
+           */
+          vector<RecType*> records;
+
+          /**
+           * @brief The node for the whole program.
+           *
+           */
+          uint32_t root;
+};
+
+/**
+ * @brief Flattens a semantically valid AST.
+ *
+ */
+class Flattener
+{
+     public:
+          /**
+           * @brief Construct a new flattener for an analyzed AST.
+           *
+           * @param astRoot The root of the AST; must have already passed semantic analysis.
+           */
+          Flattener(node* astRoot);
+
+          /**
+           * @brief Flattens the whole tree.
+           *
+           * @return FlatTree* The flat tree, which refers to nothing in the AST;
+           * owned by the caller.
+           */
+          FlatTree* Flatten();
+
+          /**
+           * @brief The AST to flatten.
+           *
+           */
+          node* astRoot;
+};
+
+/**
+ * @brief A node visitor that appends each node it visits to a flat tree, after
+ * its children.
+ *
+ */
+class nodeFlattener : public nodeVisitor
+{
+     public:
+          /**
+           * @brief Construct a new visitor filling in a tree.
+           *
+           */
+          nodeFlattener(FlatTree* tree);
+
+          /**
+           * @brief Flattens a node and everything below it.
+           *
+           * @return uint32_t The index of the node, or FLAT_NONE for NULL.
+           */
+          uint32_t flatten(node* Node);
+
+          /**
+           * @brief Flattens a list of nodes.
+           *
+           * @return vector<uint32_t> Their indices, in order.
+           */
+          vector<uint32_t> flattenAll(NodeList* Nodes);
+
+          /**
+           * @brief The index of a function, giving it one the first time it is seen;
+           * its body is filled in when its declaration is reached.
+           *
+           */
+          uint32_t functionIndex(funDec* FunDec);
+
+          /**
+           * @brief The index of a record type, giving it one the first time it is seen.
+           *
+           */
+          uint32_t recordIndex(RecType* record);
+
+          //Visitor functions
+          void visitProgram(program* prog) override;
+          void visitBreak(NBreak* Break) override;
+          void visitNil(NNil* Nil) override;
+          void visitID(NId* id) override;
+          void visitTyID(NTyId* tyid) override;
+          void visitSubscript(subscript* Subscript) override;
+          void visitFieldExp(fieldExp* FieldExp) override;
+          void visitSeqExp(seqExp*) override;
+          void visitNegation(negation*) override;
+          void visitCallExp(callExp*) override;
+          void visitIntLit(NIntLit*) override;
+          void visitStrLit(NStrLit*) override;
+          void visitInfixExp(infixExp*) override;
+          void visitArrCreate(arrCreate*) override;
+          void visitRecCreate(recCreate*) override;
+          void visitFieldCreate(fieldCreate*) override;
+          void visitAssignment(assignment*) override;
+          void visitIfThenElse(ifThenElse*) override;
+          void visitWhileExp(whileExp*) override;
+          void visitForExp(forExp*) override;
+          void visitLetExp(letExp*) override;
+          void visitDec(decc*) override;
+          void visitTyDec(tyDec*) override;
+          void visitTyDef(tyDef*) override;
+          void visitRefTy(refTy*) override;
+          void visitArrTy(arrTy*) override;
+          void visitRecTy(recTy*) override;
+          void visitFieldDec(fieldDec*) override;
+          void visitFunDec(funDec*) override;
+          void visitVarDec(varDec*) override;
+
+          /**
+           * @brief The tree being filled in.
+           *
+           */
+          FlatTree* tree;
+
+          /**
+           * @brief The index of the node just flattened.
+           *
+           */
+          uint32_t result;
+
+          /**
+           * @brief Indices already given to functions and record types.
+           *
+           */
+          map<funDec*, uint32_t> functionIndices;
+          map<RecType*, uint32_t> recordIndices;
+
+          /**
+           * @brief Indices already given to string literals.
+           *
+           */
+          map<StringObject*, uint32_t> stringIndices;
+};
+/** @} */
+#endif
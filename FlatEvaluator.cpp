@@ -0,0 +1,377 @@
+#include <iostream>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include "FlatEvaluator.h"
+#include "Builtins.h"
+
+using namespace std;
+
+/*********************
+ * FLAT EVALUATOR
+ * *******************/
+
+FlatEvaluator::FlatEvaluator(FlatTree* tree):tree(tree)
+{
+     //The builtins are called by kind, so their scope's frame holds nothing
+     frame = frames.Push(NULL, 0);
+}
+
+void FlatEvaluator::Run()
+{
+     //Nothing else refers to the pooled literals once the AST is gone
+     for(int i = 0; i < tree->strings.size(); i++)
+          held.push_back(Value(tree->strings[i]));
+
+     //Leave a margin of the native stack for everything that isn't a Tiger call
+     char marker;
+     struct rlimit limit;
+     nativeStackBase = &marker;
+     nativeStackBudget = 6 << 20;
+     if(getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+          nativeStackBudget = limit.rlim_cur - (limit.rlim_cur / 8) - (256 << 10);
+
+     eval(tree->root);
+}
+
+void FlatEvaluator::pollCollector()
+{
+     if(collector != NULL)
+          collector->Poll(frame, &held);
+}
+
+void FlatEvaluator::pushArguments(const uint32_t* args, uint32_t count)
+{
+     for(uint32_t i = 0; i < count; i++)
+          held.push_back(eval(args[i]));
+}
+
+void FlatEvaluator::bindParameters(Frame* funcFrame, const FlatFunction &function, uint32_t args)
+{
+     size_t base = held.size() - args;
+     const uint32_t* slots = &tree->operands[function.paramSlots];
+     for(uint32_t i = 0; i < args; i++)
+          funcFrame->slots[slots[i]] = held[base + i];
+     held.resize(base);
+}
+
+Value FlatEvaluator::call(uint32_t function, Frame* declaring, uint32_t args)
+{
+     char marker;
+     if((size_t)(nativeStackBase - &marker) > nativeStackBudget)
+     {
+          cout << "ERROR: Runtime: Stack overflow." << endl;
+          exit(4);
+     }
+
+     //The function's frame links to the one it was declared in, so it sees the
+     // variables around its declaration
+     Frame* funcFrame = frames.Push(declaring, tree->functions[function].frameSize, frame);
+     bindParameters(funcFrame, tree->functions[function], args);
+
+     Frame* callerFrame = frame;
+     frame = funcFrame;
+     Value result = eval(tree->functions[function].body);
+
+     //Run any tail calls the body left in the same frame, until one returns
+     while(tailCall != FLAT_NONE)
+     {
+          const FlatFunction &next = tree->functions[tailCall];
+          tailCall = FLAT_NONE;
+          frames.Resize(next.frameSize);
+          funcFrame->parent = tailFrame;
+          bindParameters(funcFrame, next, tailArgs);
+          result = eval(next.body);
+     }
+
+     frame = callerFrame;
+     frames.Pop();
+     return result;
+}
+
+ArrayObject* FlatEvaluator::element(uint32_t array, uint32_t indexNode, int &index, int line)
+{
+     //Keep the array reachable while the index is worked out
+     Value arr = eval(array);
+     held.push_back(arr);
+     index = eval(indexNode).GetInt();
+     held.pop_back();
+
+     if(!arr.GetArray()->InBounds(index))
+     {
+          cout << "ERROR " << line << ": Runtime: Array access out of bounds." << endl;
+          exit(4);
+     }
+     return arr.GetArray();
+}
+
+RecordObject* FlatEvaluator::record(uint32_t recordNode, int line)
+{
+     Value rec = eval(recordNode);
+     if(rec.kind != V_REC)
+     {
+          cout << "ERROR " << line << ": Runtime: Field access on nil record." << endl;
+          exit(4);
+     }
+     return rec.GetRecord();
+}
+
+Value FlatEvaluator::eval(uint32_t index)
+{
+     const uint32_t* ops = &tree->operands[tree->first[index]];
+     switch((FlatKind)tree->kinds[index])
+     {
+          case FLAT_NIL:
+               return Value::Nil();
+          case FLAT_BREAK:
+               breaking = true;
+               return Value();
+          case FLAT_INT:
+               return Value((int)ops[0]);
+          case FLAT_STRING:
+               return Value(tree->strings[ops[0]]);
+          case FLAT_VAR:
+               return frame->Lookup(ops[0], ops[1]);
+          case FLAT_SUBSCRIPT:
+          {
+               //Out of bounds indices are reported on the index's line
+               int element;
+               ArrayObject* arr = this->element(ops[0], ops[1], element, tree->lines[ops[1]]);
+               return arr->Get(element);
+          }
+          case FLAT_FIELD:
+               return *record(ops[0], tree->lines[index])->GetValue(ops[1]);
+          case FLAT_SEQ:
+          {
+               Value result;
+               for(uint32_t i = 0; i < ops[0]; i++)
+               {
+                    result = eval(ops[1 + i]);
+                    if(breaking)
+                         break;
+               }
+               return result;
+          }
+          case FLAT_NEGATE:
+               return Value(intNegate(eval(ops[0]).GetInt()));
+          case FLAT_CALL:
+               pushArguments(ops + 3, ops[2]);
+               return call(ops[0], frame->Ancestor(ops[1]), ops[2]);
+          case FLAT_TAIL_CALL:
+               //Left for the call running the current function, which runs it in
+               // place of this one once everything in between is done
+               pushArguments(ops + 3, ops[2]);
+               tailCall = ops[0];
+               tailFrame = frame->Ancestor(ops[1]);
+               tailArgs = ops[2];
+               return Value();
+          case FLAT_BUILTIN:
+          {
+               //The arguments stay held while the builtin runs
+               pushArguments(ops + 2, ops[1]);
+               size_t base = held.size() - ops[1];
+               Value args[BUILTIN_MAX_PARAMS];
+               for(uint32_t i = 0; i < ops[1]; i++)
+                    args[i] = held[base + i];
+               pollCollector();
+               Value result = builtins[ops[0]].function(args, tree->lines[index]);
+               held.resize(base);
+               return result;
+          }
+          case FLAT_INFIX:
+          {
+               Value left = eval(ops[1]);
+
+               //& and | don't evaluate the right side when the left decides them
+               if(ops[0] == INFIX_AND && left.GetInt() == 0)
+                    return Value(0);
+               if(ops[0] == INFIX_OR && left.GetInt() != 0)
+                    return Value(1);
+
+               //Keep a string, array or record on the left reachable while the right runs
+               bool hold = left.GetObject() != NULL;
+               if(hold)
+                    held.push_back(left);
+               Value right = eval(ops[2]);
+               if(hold)
+                    held.pop_back();
+               return infix(ops[0], left, right, tree->lines[index]);
+          }
+          case FLAT_ARRAY:
+          {
+               int size = eval(ops[0]).GetInt();
+               Value initial = eval(ops[1]);
+               held.push_back(initial);
+               pollCollector();
+               held.pop_back();
+               return Value(new ArrayObject(size, initial, ops[2] != 0));
+          }
+          case FLAT_RECORD:
+          {
+               //Evaluate every field first, held until the record has them
+               size_t base = held.size();
+               for(uint32_t i = 0; i < ops[1]; i++)
+                    held.push_back(eval(ops[3 + 2 * i]));
+               pollCollector();
+               RecordObject* rec = new RecordObject(tree->records[ops[0]]);
+               for(uint32_t i = 0; i < ops[1]; i++)
+                    *rec->GetValue(ops[2 + 2 * i]) = held[base + i];
+               held.resize(base);
+               return Value(rec);
+          }
+          case FLAT_ASSIGN_VAR:
+          {
+               Value value = eval(ops[2]);
+               frame->Lookup(ops[0], ops[1]) = value;
+               return Value();
+          }
+          case FLAT_ASSIGN_FIELD:
+          {
+               //The record is found before the value is evaluated
+               RecordObject* rec = record(ops[0], tree->lines[index]);
+               held.push_back(Value(rec));
+               Value value = eval(ops[2]);
+               held.pop_back();
+               *rec->GetValue(ops[1]) = value;
+               return Value();
+          }
+          case FLAT_ASSIGN_ELEMENT:
+          {
+               //Array elements may be unboxed, so they're stored through the array
+               // once its index is known to be in bounds
+               int element;
+               ArrayObject* arr = this->element(ops[0], ops[1], element, tree->lines[index]);
+               held.push_back(Value(arr));
+               Value value = eval(ops[2]);
+               held.pop_back();
+               arr->Set(element, value);
+               return Value();
+          }
+          case FLAT_IF:
+               if(eval(ops[0]).GetInt() != 0)
+                    return eval(ops[1]);
+               if(ops[2] != FLAT_NONE)
+                    return eval(ops[2]);
+               return Value();
+          case FLAT_WHILE:
+               while(eval(ops[0]).GetInt() != 0)
+               {
+                    eval(ops[1]);
+                    if(breaking)
+                    {
+                         breaking = false;
+                         break;
+                    }
+               }
+               return Value();
+          case FLAT_FOR:
+          {
+               //The variable gets a frame of its own; the limit is worked out outside it
+               Value initial = eval(ops[1]);
+               Frame* forFrame = frames.Push(frame, 1);
+               Value* var = &(forFrame->slots[ops[0]]);
+               *var = initial;
+               int limit = eval(ops[2]).GetInt();
+               frame = forFrame;
+
+               //Run the loop from the initial value up to and including the limit,
+               // stopping there rather than stepping past it, which overflows when
+               // the limit is INT_MAX
+               for(int i = var->GetInt(); i <= limit; i++)
+               {
+                    *var = Value(i);
+                    eval(ops[3]);
+                    if(breaking)
+                    {
+                         breaking = false;
+                         break;
+                    }
+                    if(i == limit)
+                         break;
+               }
+
+               frame = forFrame->parent;
+               frames.Pop();
+               return Value();
+          }
+          case FLAT_LET:
+          {
+               frame = frames.Push(frame, ops[0]);
+
+               //Functions are already bound to their calls, so only variables run
+               uint32_t decs = ops[1];
+               for(uint32_t i = 0; i < decs; i++)
+                    frame->slots[ops[2 + 2 * i]] = eval(ops[3 + 2 * i]);
+
+               const uint32_t* body = ops + 2 + 2 * decs;
+               Value result;
+               for(uint32_t i = 0; i < body[0]; i++)
+               {
+                    result = eval(body[1 + i]);
+                    if(breaking)
+                         break;
+               }
+
+               frame = frame->parent;
+               frames.Pop();
+               return result;
+          }
+     }
+     return Value();
+}
+
+Value FlatEvaluator::infix(uint32_t operation, Value left, Value right, int line)
+{
+     //Semantic analysis already picked the operation for the operands' types
+     switch((InfixOperation)operation)
+     {
+          case INFIX_INT_ADD:
+               return Value(intAdd(left.GetInt(), right.GetInt()));
+          case INFIX_INT_SUBTRACT:
+               return Value(intSubtract(left.GetInt(), right.GetInt()));
+          case INFIX_INT_MULTIPLY:
+               return Value(intMultiply(left.GetInt(), right.GetInt()));
+          case INFIX_INT_DIVIDE:
+               //Division by zero is an error, and INT_MIN / -1 would trap
+               if(right.GetInt() == 0)
+               {
+                    cout << "ERROR " << line << ": Runtime: Division by zero." << endl;
+                    exit(4);
+               }
+               if(right.GetInt() == -1)
+                    return Value(intNegate(left.GetInt()));
+               return Value(left.GetInt() / right.GetInt());
+          case INFIX_INT_EQ:
+               return Value(left.GetInt() == right.GetInt() ? 1 : 0);
+          case INFIX_INT_NEQ:
+               return Value(left.GetInt() != right.GetInt() ? 1 : 0);
+          case INFIX_INT_LT:
+               return Value(left.GetInt() < right.GetInt() ? 1 : 0);
+          case INFIX_INT_LEQ:
+               return Value(left.GetInt() <= right.GetInt() ? 1 : 0);
+          case INFIX_INT_GT:
+               return Value(left.GetInt() > right.GetInt() ? 1 : 0);
+          case INFIX_INT_GEQ:
+               return Value(left.GetInt() >= right.GetInt() ? 1 : 0);
+          case INFIX_STR_EQ:
+               return Value(left.GetStringObject()->Equals(right.GetStringObject()) ? 1 : 0);
+          case INFIX_STR_NEQ:
+               return Value(left.GetStringObject()->Equals(right.GetStringObject()) ? 0 : 1);
+          case INFIX_STR_LT:
+               return Value(left.GetStringObject()->Compare(right.GetStringObject()) < 0 ? 1 : 0);
+          case INFIX_STR_LEQ:
+               return Value(left.GetStringObject()->Compare(right.GetStringObject()) <= 0 ? 1 : 0);
+          case INFIX_STR_GT:
+               return Value(left.GetStringObject()->Compare(right.GetStringObject()) > 0 ? 1 : 0);
+          case INFIX_STR_GEQ:
+               return Value(left.GetStringObject()->Compare(right.GetStringObject()) >= 0 ? 1 : 0);
+          case INFIX_REF_EQ:
+               return Value(left == right ? 1 : 0);
+          case INFIX_REF_NEQ:
+               return Value(left == right ? 0 : 1);
+          case INFIX_AND:
+          case INFIX_OR:
+               //The left side didn't decide it, so the right one does
+               return Value(right.GetInt() != 0 ? 1 : 0);
+     }
+     return Value();
+}
@@ -0,0 +1,180 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      FlatEvaluator.h
+     Purpose:       Runs a flat AST directly: one switch on each node's kind
+                    instead of a virtual visit, reading children as indices
+                    into the tree's contiguous arrays.
+
+*/
+
+/** @defgroup FLATEVAL Flat Evaluator
+ *  Switch-dispatched evaluation of the flat AST.
+ *  @{
+ */
+
+#ifndef FLAT_EVALUATOR
+#define FLAT_EVALUATOR
+
+#include <vector>
+#include "FlatAST.h"
+#include "SymbolTable.h"
+#include "GarbageCollector.h"
+
+using namespace std;
+
+/**
+ * @brief Evaluates a flat tree recursively, returning each node's value rather
+ * than storing it on the node.
+ *
+ */
+class FlatEvaluator
+{
+     public:
+          /**
+           * @brief Construct a new evaluator with the frame for the default Tiger scope.
+           *
+           * @param tree The program to run.
+           */
+          FlatEvaluator(FlatTree* tree);
+
+          /**
+           * @brief Runs the whole program.
+           *
+           */
+          void Run();
+
+          /**
+           * @brief Evaluates a node and everything below it.
+           *
+           * @param index The node.
+           * @return Value Its value, or an empty value for one without any.
+           */
+          Value eval(uint32_t index);
+
+          /**
+           * @brief Calls a Tiger function, then any tail calls it leaves behind.
+           *
+           * @param function Index of the function.
+           * @param declaring The frame the function was declared in.
+           * @param args Number of arguments on top of held.
+           * @return Value What the last function run returned.
+           */
+          Value call(uint32_t function, Frame* declaring, uint32_t args);
+
+          /**
+           * @brief Takes arguments off the top of held and puts them in a function's
+           * parameter slots.
+           *
+           */
+          void bindParameters(Frame* funcFrame, const FlatFunction &function, uint32_t args);
+
+          /**
+           * @brief Evaluates the arguments of a call onto held, where they stay
+           * reachable until they are used.
+           *
+           */
+          void pushArguments(const uint32_t* args, uint32_t count);
+
+          /**
+           * @brief Finds the array and index a subscript refers to, stopping the
+           * program if the index is out of bounds. The array is held while the index
+           * is evaluated.
+           *
+           * @param index Set to the element's index.
+           * @param line Where to report an out of bounds index.
+           * @return ArrayObject* The array.
+           */
+          ArrayObject* element(uint32_t array, uint32_t indexNode, int &index, int line);
+
+          /**
+           * @brief Evaluates a record, stopping the program if it's nil.
+           *
+           * @param line Where to report a nil record.
+           */
+          RecordObject* record(uint32_t recordNode, int line);
+
+          /**
+           * @brief The result of a binary operator on two evaluated operands.
+           *
+           */
+          Value infix(uint32_t operation, Value left, Value right, int line);
+
+          /**
+           * @brief Lets the garbage collector run if it's due.
+           *
+           */
+          void pollCollector();
+
+          /**
+           * @brief The program being run.
+           *
+           */
+          FlatTree* tree;
+
+          /**
+           * @brief Frees strings, arrays and records that are no longer reachable,
+           * or NULL to never free them.
+           *
+           */
+          GarbageCollector* collector = NULL;
+
+          /**
+           * @brief Values in use that aren't in any frame: the string literals, and
+           * operands and arguments waiting on the rest of their expression.
+           *
+           */
+          vector<Value> held;
+
+          /**
+           * @brief Frame of the innermost scope being run.
+           *
+           */
+          Frame* frame;
+
+          /**
+           * @brief Where every frame comes from, reused as scopes are left.
+           *
+           */
+          FrameStack frames;
+
+          /**
+           * @brief Whether a break is unwinding to its loop.
+           *
+           */
+          bool breaking = false;
+
+          /**
+           * @brief A function called in tail position, left for the call running the
+           * current function to run in its own frame, or FLAT_NONE if there isn't one.
+           * Its arguments are on top of held.
+           *
+           */
+          uint32_t tailCall = FLAT_NONE;
+
+          /**
+           * @brief The frame the pending tail call's function was declared in.
+           *
+           */
+          Frame* tailFrame = NULL;
+
+          /**
+           * @brief Number of arguments the pending tail call left on held.
+           *
+           */
+          uint32_t tailArgs = 0;
+
+          /**
+           * @brief Where the native stack was when the program started; eval
+           * recurses on it, so calls stop short of overrunning it.
+           *
+           */
+          char* nativeStackBase = NULL;
+
+          /**
+           * @brief Bytes of the native stack calls may use.
+           *
+           */
+          size_t nativeStackBudget = 0;
+};
+/** @} */
+#endif
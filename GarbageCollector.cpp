@@ -0,0 +1,282 @@
+#include <chrono>
+#include <algorithm>
+#include "GarbageCollector.h"
+
+using namespace std;
+
+GCSettings::GCSettings():initialHeap(GC_DEFAULT_HEAP), growth(GC_DEFAULT_GROWTH), stats(false){}
+
+/*********************
+ * ROOT FINDER
+ * *******************/
+
+void nodeGCRoots::gather(node* Node)
+{
+     if(Node == NULL)
+          return;
+     nodes.push_back(Node);
+     Node->accept(this);
+}
+void nodeGCRoots::visitProgram(program* prog)
+{
+     gather(prog->Node);
+}
+void nodeGCRoots::visitBreak(NBreak* Break){}
+void nodeGCRoots::visitNil(NNil* Nil){}
+void nodeGCRoots::visitID(NId* id){}
+void nodeGCRoots::visitTyID(NTyId* tyid){}
+void nodeGCRoots::visitIntLit(NIntLit* intLit){}
+void nodeGCRoots::visitStrLit(NStrLit* strLit){}
+void nodeGCRoots::visitSubscript(subscript* Subscript)
+{
+     gather(Subscript->lValue);
+     gather(Subscript->exp);
+}
+void nodeGCRoots::visitFieldExp(fieldExp* FieldExp)
+{
+     gather(FieldExp->lValue);
+}
+void nodeGCRoots::visitSeqExp(seqExp* SeqExp)
+{
+     for(int i = 0; i < SeqExp->exps->size(); i++)
+          gather((*(SeqExp->exps))[i]);
+}
+void nodeGCRoots::visitNegation(negation* neg)
+{
+     gather(neg->operand);
+}
+void nodeGCRoots::visitCallExp(callExp* CallExp)
+{
+     for(int i = 0; i < CallExp->exps->size(); i++)
+          gather((*(CallExp->exps))[i]);
+}
+void nodeGCRoots::visitInfixExp(infixExp* InfixExp)
+{
+     gather(InfixExp->leftNode);
+     gather(InfixExp->rightNode);
+}
+void nodeGCRoots::visitArrCreate(arrCreate* ArrCreate)
+{
+     gather(ArrCreate->subscriptExp);
+     gather(ArrCreate->postExp);
+}
+void nodeGCRoots::visitRecCreate(recCreate* RecCreate)
+{
+     for(int i = 0; i < RecCreate->fields->size(); i++)
+          gather((*(RecCreate->fields))[i]);
+}
+void nodeGCRoots::visitFieldCreate(fieldCreate* FieldCreate)
+{
+     gather(FieldCreate->exp);
+}
+void nodeGCRoots::visitAssignment(assignment* Assign)
+{
+     gather(Assign->lVal);
+     gather(Assign->exp);
+}
+void nodeGCRoots::visitIfThenElse(ifThenElse* iTE)
+{
+     gather(iTE->ifExp);
+     gather(iTE->thenExp);
+     gather(iTE->elseExp);
+}
+void nodeGCRoots::visitWhileExp(whileExp* While)
+{
+     gather(While->condition);
+     gather(While->action);
+}
+void nodeGCRoots::visitForExp(forExp* forEx)
+{
+     gather(forEx->assign);
+     gather(forEx->condition);
+     gather(forEx->action);
+}
+void nodeGCRoots::visitLetExp(letExp* LetExp)
+{
+     for(int i = 0; i < LetExp->decs->size(); i++)
+          gather((*(LetExp->decs))[i]);
+     for(int i = 0; i < LetExp->exps->size(); i++)
+          gather((*(LetExp->exps))[i]);
+}
+void nodeGCRoots::visitDec(decc* Dec){}
+void nodeGCRoots::visitTyDec(tyDec* TyDec){}
+void nodeGCRoots::visitTyDef(tyDef* TyDef){}
+void nodeGCRoots::visitRefTy(refTy* RefTy){}
+void nodeGCRoots::visitArrTy(arrTy* ArrTy){}
+void nodeGCRoots::visitRecTy(recTy* RecTy){}
+void nodeGCRoots::visitFieldDec(fieldDec* FieldDec){}
+void nodeGCRoots::visitFunDec(funDec* FunDec)
+{
+     gather(FunDec->exp);
+}
+void nodeGCRoots::visitVarDec(varDec* VarDec)
+{
+     gather(VarDec->exp);
+}
+
+/*********************
+ * GARBAGE COLLECTOR
+ * *******************/
+
+GarbageCollector::GarbageCollector(node* astRoot, const GCSettings &settings)
+:settings(settings), threshold(settings.initialHeap), collections(0), totalPause(0), longestPause(0),
+bytesReclaimed(0), objectsReclaimed(0)
+{
+     nodeGCRoots roots;
+     roots.gather(astRoot);
+     nodes = roots.nodes;
+}
+
+GarbageCollector::~GarbageCollector()
+{
+     while(HeapObject::newest != NULL)
+          delete HeapObject::newest;
+}
+
+void GarbageCollector::Poll(Frame* current, vector<Value>* values)
+{
+     if(HeapObject::liveBytes >= threshold)
+          Collect(current, values);
+}
+
+void GarbageCollector::Collect(Frame* current, vector<Value>* values)
+{
+     chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+     //Mark from every frame in use and every value held by a node or waiting on a stack
+     for(Frame* frame = current; frame != NULL; frame = frame->caller)
+     {
+          for(int i = 0; i < frame->size; i++)
+               mark(frame->slots[i].GetObject());
+     }
+     for(int i = 0; i < nodes.size(); i++)
+          mark(nodes[i]->value.GetObject());
+     if(values != NULL)
+     {
+          for(int i = 0; i < values->size(); i++)
+               mark((*values)[i].GetObject());
+     }
+     sweep(start);
+}
+
+void GarbageCollector::PollWords(void* const* words, size_t count)
+{
+     if(HeapObject::liveBytes >= threshold)
+          CollectWords(words, count);
+}
+
+void GarbageCollector::CollectWords(void* const* words, size_t count)
+{
+     chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+     //Word blocks are referred to by their first word, everything else by itself
+     addresses.clear();
+     for(HeapObject* object = HeapObject::newest; object != NULL; object = object->next)
+     {
+          WordBlock* block = dynamic_cast<WordBlock*>(object);
+          addresses.push_back(make_pair(block != NULL ? (void*)block->Words() : (void*)object, object));
+     }
+     sort(addresses.begin(), addresses.end());
+
+     //Mark from the words in use and every value held by a node, then from the
+     // words of every block reached, until there are none left to scan
+     markWords(words, count);
+     for(int i = 0; i < nodes.size(); i++)
+          mark(nodes[i]->value.GetObject());
+     while(!blocks.empty())
+     {
+          WordBlock* block = blocks.back();
+          blocks.pop_back();
+          markWords(block->Words(), block->count);
+     }
+     addresses.clear();
+     sweep(start);
+}
+
+void GarbageCollector::sweep(chrono::steady_clock::time_point start)
+{
+     //Sweep whatever wasn't reached, and get the rest ready for next time
+     size_t bytesBefore = HeapObject::liveBytes;
+     size_t objectsBefore = HeapObject::liveObjects;
+     HeapObject* object = HeapObject::newest;
+     while(object != NULL)
+     {
+          HeapObject* next = object->next;
+          if(object->marked)
+               object->marked = false;
+          else
+               delete object;
+          object = next;
+     }
+     bytesReclaimed += bytesBefore - HeapObject::liveBytes;
+     objectsReclaimed += objectsBefore - HeapObject::liveObjects;
+
+     //Let the heap grow in proportion to what survived before collecting again
+     threshold = (size_t)(HeapObject::liveBytes * settings.growth);
+     if(threshold < settings.initialHeap)
+          threshold = settings.initialHeap;
+
+     double pause = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+     collections++;
+     totalPause += pause;
+     if(pause > longestPause)
+          longestPause = pause;
+}
+
+void GarbageCollector::PrintStats(ostream &out)
+{
+     out << "GC: " << collections << " collections, " << totalPause << " ms total pause, "
+          << longestPause << " ms longest pause" << endl;
+     out << "GC: " << bytesReclaimed << " bytes reclaimed in " << objectsReclaimed << " objects, "
+          << HeapObject::liveBytes << " bytes in " << HeapObject::liveObjects << " objects still live" << endl;
+}
+
+void GarbageCollector::mark(HeapObject* object)
+{
+     if(object == NULL || object->marked)
+          return;
+     object->marked = true;
+     gray.push_back(object);
+
+     //Trace with an explicit list so long chains of records don't overflow the stack
+     while(!gray.empty())
+     {
+          HeapObject* next = gray.back();
+          gray.pop_back();
+          size_t traced = gray.size();
+          next->Trace(gray);
+
+          //Keep only the children not already marked, marking them as they go on
+          size_t kept = traced;
+          for(size_t i = traced; i < gray.size(); i++)
+          {
+               if(!gray[i]->marked)
+               {
+                    gray[i]->marked = true;
+                    gray[kept++] = gray[i];
+               }
+          }
+          gray.resize(kept);
+     }
+}
+
+void GarbageCollector::markWords(void* const* words, size_t count)
+{
+     for(size_t i = 0; i < count; i++)
+     {
+          vector<pair<void*, HeapObject*> >::iterator found =
+               lower_bound(addresses.begin(), addresses.end(), make_pair(words[i], (HeapObject*)NULL));
+          if(found == addresses.end() || found->first != words[i] || found->second->marked)
+               continue;
+
+          //Strings know what they refer to; blocks have to be scanned like the roots
+          WordBlock* block = dynamic_cast<WordBlock*>(found->second);
+          if(block == NULL)
+               mark(found->second);
+          else
+          {
+               block->marked = true;
+               blocks.push_back(block);
+          }
+     }
+}
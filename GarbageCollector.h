@@ -0,0 +1,255 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      GarbageCollector.h
+     Purpose:       A precise mark-and-sweep collector for the strings, arrays
+                    and records the tree-walking interpreter makes at runtime.
+                    The bytecode VM and closure engine don't keep what kind a
+                    value is, so for them it scans words conservatively.
+
+*/
+
+/** @defgroup GC Garbage Collector
+ *  Frees runtime heap objects the program can no longer reach.
+ *  @{
+ */
+
+#ifndef GARBAGE_COLLECTOR
+#define GARBAGE_COLLECTOR
+
+#include <vector>
+#include <chrono>
+#include <iostream>
+#include "ast.h"
+#include "SymbolTable.h"
+
+using namespace std;
+
+//Bytes of heap objects allowed before the first collection
+#define GC_DEFAULT_HEAP (1024 * 1024)
+
+//How many times what survived a collection the heap may grow to before the next one
+#define GC_DEFAULT_GROWTH 2.0
+
+/**
+ * @brief When the collector runs and whether it reports on itself.
+ *
+ */
+class GCSettings
+{
+     public:
+          /**
+           * @brief Construct the default settings.
+           *
+           */
+          GCSettings();
+
+          /**
+           * @brief Bytes of heap objects allowed before the first collection, and
+           * the least allowed after any other.
+           *
+           */
+          size_t initialHeap;
+
+          /**
+           * @brief How many times what survived a collection the heap may grow to
+           * before the next one.
+           *
+           */
+          double growth;
+
+          /**
+           * @brief Whether to report collections, pause times and bytes reclaimed
+           * on stderr when the program ends.
+           *
+           */
+          bool stats;
+};
+
+/**
+ * @brief Finds every expression node in the tree. Nodes hold the values of
+ * expressions still being evaluated, so their values are roots.
+ *
+ */
+class nodeGCRoots : public nodeVisitor
+{
+     public:
+          /**
+           * @brief Adds a node and everything below it.
+           *
+           */
+          void gather(node* Node);
+
+          //Visitor functions
+          void visitProgram(program* prog) override;
+          void visitBreak(NBreak* Break) override;
+          void visitNil(NNil* Nil) override;
+          void visitID(NId* id) override;
+          void visitTyID(NTyId* tyid) override;
+          void visitSubscript(subscript* Subscript) override;
+          void visitFieldExp(fieldExp* FieldExp) override;
+          void visitSeqExp(seqExp*) override;
+          void visitNegation(negation*) override;
+          void visitCallExp(callExp*) override;
+          void visitIntLit(NIntLit*) override;
+          void visitStrLit(NStrLit*) override;
+          void visitInfixExp(infixExp*) override;
+          void visitArrCreate(arrCreate*) override;
+          void visitRecCreate(recCreate*) override;
+          void visitFieldCreate(fieldCreate*) override;
+          void visitAssignment(assignment*) override;
+          void visitIfThenElse(ifThenElse*) override;
+          void visitWhileExp(whileExp*) override;
+          void visitForExp(forExp*) override;
+          void visitLetExp(letExp*) override;
+          void visitDec(decc*) override;
+          void visitTyDec(tyDec*) override;
+          void visitTyDef(tyDef*) override;
+          void visitRefTy(refTy*) override;
+          void visitArrTy(arrTy*) override;
+          void visitRecTy(recTy*) override;
+          void visitFieldDec(fieldDec*) override;
+          void visitFunDec(funDec*) override;
+          void visitVarDec(varDec*) override;
+
+          /**
+           * @brief Every node found so far.
+           *
+           */
+          vector<node*> nodes;
+};
+
+/**
+ * @brief Frees heap objects that can't be reached from any frame in use or any
+ * node's value. Only runs when the interpreter polls it, at points where every
+ * value it is working with is in one of those places.
+ *
+ */
+class GarbageCollector
+{
+     public:
+          /**
+           * @brief Construct a new collector for a program.
+           *
+           * @param astRoot The root of the AST being interpreted.
+           * @param settings When to collect and whether to report.
+           */
+          GarbageCollector(node* astRoot, const GCSettings &settings);
+
+          /**
+           * @brief Frees every heap object left once the program is done.
+           *
+           */
+          ~GarbageCollector();
+
+          /**
+           * @brief Collects if the heap has grown past its limit.
+           *
+           * @param current The frame currently in use.
+           * @param values Results waiting to be used, if the evaluator keeps any
+           * outside of nodes.
+           */
+          void Poll(Frame* current, vector<Value>* values = NULL);
+
+          /**
+           * @brief Marks everything reachable and frees the rest.
+           *
+           * @param current The frame currently in use.
+           * @param values Results waiting to be used, if the evaluator keeps any
+           * outside of nodes.
+           */
+          void Collect(Frame* current, vector<Value>* values = NULL);
+
+          /**
+           * @brief Collects if the heap has grown past its limit, for engines whose
+           * values don't say whether they're pointers.
+           *
+           * @param words The words in use, frames and operands alike.
+           * @param count Number of words.
+           */
+          void PollWords(void* const* words, size_t count);
+
+          /**
+           * @brief Marks everything reachable from words that might be pointers and
+           * frees the rest. A word keeps an object if it's the address the engine
+           * refers to the object by; ints that happen to look like one only keep
+           * garbage a little longer.
+           *
+           * @param words The words in use, frames and operands alike.
+           * @param count Number of words.
+           */
+          void CollectWords(void* const* words, size_t count);
+
+          /**
+           * @brief Reports collections, pause times and bytes reclaimed.
+           *
+           */
+          void PrintStats(ostream &out);
+
+          /**
+           * @brief Marks an object and, through the gray list, everything it reaches.
+           *
+           */
+          void mark(HeapObject* object);
+
+          /**
+           * @brief Marks every object a run of words might point to, leaving word
+           * blocks on the block list to be scanned in turn.
+           *
+           */
+          void markWords(void* const* words, size_t count);
+
+          /**
+           * @brief Frees every object left unmarked and works out when to collect next.
+           *
+           * @param start When the collection started, for its pause time.
+           */
+          void sweep(chrono::steady_clock::time_point start);
+
+          /**
+           * @brief When to collect and whether to report.
+           *
+           */
+          GCSettings settings;
+
+          /**
+           * @brief Every expression node, whose values are roots.
+           *
+           */
+          vector<node*> nodes;
+
+          /**
+           * @brief Objects marked but not yet traced.
+           *
+           */
+          vector<HeapObject*> gray;
+
+          /**
+           * @brief Every object by the address engines refer to it by, sorted, while
+           * words are being scanned.
+           *
+           */
+          vector<pair<void*, HeapObject*> > addresses;
+
+          /**
+           * @brief Word blocks marked but not yet scanned.
+           *
+           */
+          vector<WordBlock*> blocks;
+          /**
+           * @brief Live bytes at which the next collection happens.
+           *
+           */
+          size_t threshold;
+
+          /**
+           * @brief What the collector has done so far.
+           *
+           */
+          int collections;
+          double totalPause;
+          double longestPause;
+          size_t bytesReclaimed;
+          size_t objectsReclaimed;
+};
+/** @} */
+#endif
@@ -1,13 +1,95 @@
+#include <sys/resource.h>
 #include "Interpreter.h"
+#include "Bytecode.h"
+#include "VirtualMachine.h"
+#include "ClosureCompiler.h"
+#include "TraceJIT.h"
+#include "Builtins.h"
 
 using namespace std;
 
-Interpreter::Interpreter(node* astRoot):astRoot(astRoot){}
+Interpreter::Interpreter(node* astRoot, EngineKind engine, bool jit, GCSettings gc, size_t stackLimit)
+:astRoot(astRoot), engine(engine), jit(jit), gc(gc), stackLimit(stackLimit){}
 
 void Interpreter::Interpret()
 {
+     if(engine == ENGINE_VM)
+     {
+          BytecodeCompiler compiler(astRoot);
+          BytecodeProgram* program = compiler.Compile();
+          VirtualMachine vm(program);
+          GarbageCollector collector(astRoot, gc);
+          vm.collector = &collector;
+          vm.Run();
+          cout.flush();
+          if(gc.stats)
+               collector.PrintStats(cerr);
+          delete program;
+          return;
+     }
+     if(engine == ENGINE_CLOSURE)
+     {
+          ClosureCompiler compiler(astRoot);
+          ClosureProgram* program = compiler.Compile();
+          GarbageCollector collector(astRoot, gc);
+          program->collector = &collector;
+          program->Run();
+          cout.flush();
+          if(gc.stats)
+               collector.PrintStats(cerr);
+          delete program;
+          return;
+     }
+     if(engine == ENGINE_STACK)
+     {
+          StackEvaluator evaluator(stackLimit);
+          GarbageCollector collector(astRoot, gc);
+          evaluator.collector = &collector;
+          evaluator.Run(astRoot);
+          if(gc.stats)
+          {
+               cout.flush();
+               collector.PrintStats(cerr);
+          }
+          return;
+     }
+     if(engine == ENGINE_FLAT)
+     {
+          //Nothing refers back to the AST once it's flattened, so its arena goes now
+          Flattener flattener(astRoot);
+          FlatTree* tree = flattener.Flatten();
+          node::arena->Release();
+          astRoot = NULL;
+
+          FlatEvaluator evaluator(tree);
+          GarbageCollector collector(NULL, gc);
+          evaluator.collector = &collector;
+          evaluator.Run();
+          if(gc.stats)
+          {
+               cout.flush();
+               collector.PrintStats(cerr);
+          }
+          delete tree;
+          return;
+     }
+
      nodeInterpreter interpreter;
+     if(jit)
+     {
+          interpreter.jit = new MethodJIT();
+          interpreter.tracer = new TraceJIT();
+     }
+     GarbageCollector collector(astRoot, gc);
+     interpreter.collector = &collector;
      interpreter.evaluate(astRoot);
+     delete interpreter.jit;
+     delete interpreter.tracer;
+     if(gc.stats)
+     {
+          cout.flush();
+          collector.PrintStats(cerr);
+     }
 }
 
 /*********************
@@ -16,7 +98,16 @@ void Interpreter::Interpret()
 
 nodeInterpreter::nodeInterpreter()
 {
-     table.DefaultTigerTable();
+     //The builtins are called by name, so their scope's frame holds nothing
+     frame = frames.Push(NULL, 0);
+
+     //Leave a margin of the native stack for everything that isn't a Tiger call
+     char marker;
+     struct rlimit limit;
+     nativeStackBase = &marker;
+     nativeStackBudget = 6 << 20;
+     if(getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+          nativeStackBudget = limit.rlim_cur - (limit.rlim_cur / 8) - (256 << 10);
 }
 
 void nodeInterpreter::evaluate(node* Node)
@@ -24,34 +115,81 @@ void nodeInterpreter::evaluate(node* Node)
      Node->accept(this);
 }
 
-bool nodeInterpreter::isNonZero(Value* val)
+bool nodeInterpreter::isNonZero(Value val)
 {
-     IntValue* intVal = (IntValue*) (val);
-     if(intVal->GetValue() != 0)
+     if(val.GetInt() != 0)
           return true;
      else
           return false;
 }
 
+Value* nodeInterpreter::locate(node* lValue)
+{
+     if(dynamic_cast<fieldExp*>(lValue) != NULL)
+          return field((fieldExp*)lValue);
+     NId* id = (NId*)lValue;
+     return &(frame->Lookup(id->depth, id->slot));
+}
+
+ArrayObject* nodeInterpreter::element(subscript* Subscript, int &index)
+{
+     //Get the array from left hand side
+     evaluate(Subscript->lValue);
+     ArrayObject* arr = Subscript->lValue->value.GetArray();
+
+     //Get the int result of the subscript
+     evaluate(Subscript->exp);
+     index = Subscript->exp->value.GetInt();
+
+     //Make sure the array has an element there
+     if(!arr->InBounds(index))
+     {
+          cout << "ERROR " << Subscript->exp->lineNumber << ": Runtime: Array access out of bounds." << endl;
+          exit(4);
+     }
+     return arr;
+}
+
+Value* nodeInterpreter::field(fieldExp* FieldExp)
+{
+     //Get the record
+     evaluate(FieldExp->lValue);
+     if(FieldExp->lValue->value.kind != V_REC)
+     {
+          cout << "ERROR " << FieldExp->lineNumber << ": Runtime: Field access on nil record." << endl;
+          exit(4);
+     }
+
+     //Find its member
+     return FieldExp->lValue->value.GetRecord()->GetValue(FieldExp->slot);
+}
+
 
-void nodeInterpreter::Print(IntValue* value)
+void nodeInterpreter::pollCollector()
 {
-     cout << value->GetValue();
+     if(collector != NULL)
+          collector->Poll(frame, &held);
 }
 
-void nodeInterpreter::Print(StringValue* value)
+
+void nodeInterpreter::pushArguments(callExp* CallExp)
 {
-     cout << value->GetValue();
+     for(int i = 0; i < CallExp->exps->size(); i++)
+     {
+          evaluate((*(CallExp->exps))[i]);
+          held.push_back((*(CallExp->exps))[i]->value);
+     }
 }
 
-IntValue* nodeInterpreter::Not(IntValue* value)
+void nodeInterpreter::bindParameters(Frame* funcFrame, funDec* FunDec, callExp* CallExp)
 {
-     if(value->GetValue() == 0)
-          return new IntValue(1);
-     else
-          return new IntValue(0);
+     size_t base = held.size() - CallExp->exps->size();
+     for(int i = 0; i < CallExp->exps->size(); i++)
+          funcFrame->slots[FunDec->paramSlots[i]] = held[base + i];
+     held.resize(base);
 }
 
+
 /*********
  * VISITS
  * *******/
@@ -66,11 +204,11 @@ void nodeInterpreter::visitBreak(NBreak* Break)
 }
 void nodeInterpreter::visitNil(NNil* Nil)
 {
-     Nil->value = new RecordValue();
+     Nil->value = Value::Nil();
 }
 void nodeInterpreter::visitID(NId* id)
 {
-     id->value = ((VarSymbol*)(table.LookupSymbol(id->name)))->val;
+     id->value = frame->Lookup(id->depth, id->slot);
 }
 void nodeInterpreter::visitTyID(NTyId* tyid)
 {
@@ -78,43 +216,21 @@ void nodeInterpreter::visitTyID(NTyId* tyid)
 }
 void nodeInterpreter::visitIntLit(NIntLit* intLit)
 {
-     intLit->value = new IntValue(intLit->val);
+     intLit->value = Value(intLit->val);
 }
 void nodeInterpreter::visitStrLit(NStrLit* strLit)
 {
-     strLit->value = new StringValue(strLit->val);
+     //Semantic analysis already gave the literal its pooled string
 }
 void nodeInterpreter::visitSubscript(subscript* Subscript)
 {
-     //Get the ArrayValue from left hand side
-     evaluate(Subscript->lValue);
-     ArrayValue* arr = (ArrayValue*)(Subscript->lValue->value);
-
-     //Get the int result of the subscript
-     evaluate(Subscript->exp);
-     IntValue* index = (IntValue*)(Subscript->exp->value);
-
-     //cout << "Getting index: " << index->GetValue() << endl;
-
-     //Get the value in the array at the desired location
-     int intIndex = index->GetValue();
-     //cout << "Subscripting at index " << intIndex  << " on line " << Subscript->lineNumber << endl;
-     Subscript->value = arr->GetValue(intIndex);
-     if(Subscript->value == NULL)
-     {
-          cout << "ERROR " << Subscript->exp->lineNumber << ": Runtime: Array access out of bounds." << endl;
-          exit(4);
-     }
+     int index;
+     ArrayObject* arr = element(Subscript, index);
+     Subscript->value = arr->Get(index);
 }
 void nodeInterpreter::visitFieldExp(fieldExp* FieldExp)
 {
-     //Get the value for the Record type
-     evaluate(FieldExp->lValue);
-     RecordValue* rec = (RecordValue*)(FieldExp->lValue->value);
-
-     //Get the current value of its member
-     string name =((NId*)(FieldExp->ID))->name;
-     FieldExp->value = rec->GetValue(name);
+     FieldExp->value = *field(FieldExp);
 }
 void nodeInterpreter::visitSeqExp(seqExp* SeqExp)
 {
@@ -137,343 +253,203 @@ void nodeInterpreter::visitSeqExp(seqExp* SeqExp)
 void nodeInterpreter::visitNegation(negation* neg)
 {
      evaluate(neg->operand);
-     IntValue* intVal = (IntValue*)(neg->operand->value);
-     neg->value = new IntValue(-1*(intVal->GetValue()));
+     neg->value = Value(intNegate(neg->operand->value.GetInt()));
 }
 void nodeInterpreter::visitCallExp(callExp* CallExp)
 {
      //Evaluate the contents of the call expression first
-     vector<node*>* passedParameters = CallExp->exps;
-     for(int i = 0; i < passedParameters->size(); i++)
-     {
-          evaluate((*passedParameters)[i]);
-     }
-
-     string name = ((NId*)(CallExp->id))->name;
-     if(name == "print")
-     {
-          Print((StringValue*)(*passedParameters)[0]->value);
-     } 
-     else if(name == "printi")
+     NodeList* passedParameters = CallExp->exps;
+     pushArguments(CallExp);
+     size_t base = held.size() - passedParameters->size();
+
+     //Semantic analysis bound the call to its function, or to the native code for a builtin
+     NId* id = (NId*)(CallExp->id);
+     funDec* FunDec = CallExp->function;
+     if(CallExp->builtin != NULL)
      {
-          Print((IntValue*)(*passedParameters)[0]->value);
-     } 
-     else if(name == "not")
-     {
-          CallExp->value = Not((IntValue*)(*passedParameters)[0]->value);
+          //The arguments stay held while the builtin runs
+          Value args[BUILTIN_MAX_PARAMS];
+          for(int i = 0; i < passedParameters->size(); i++)
+               args[i] = held[base + i];
+          pollCollector();
+          CallExp->value = CallExp->builtin->function(args, CallExp->lineNumber);
+          held.resize(base);
      } 
      else //It's a normal function call
      {
-          //create new scope for function
-          Scope* funcScope = new Scope(table.top, S_FUNC);
-          table.PushScope(funcScope);
-
-          //Build symbols for each parameter
-          vector< pair <string,Type*>> funcParams = functionParams[name];
-          for(int i = 0; i < passedParameters->size(); i++)
-          { 
-               VarSymbol* var = new VarSymbol(funcParams[i].first, SYM_VAR, funcParams[i].second, ((*passedParameters)[i])->value);
-               funcScope->AddSymbol(var);
+          //Hot integer-only functions run as native code instead
+          JITEntry entry = (jit != NULL) ? jit->Lookup(FunDec) : NULL;
+          if(entry != NULL)
+          {
+               int args[6] = {0, 0, 0, 0, 0, 0};
+               for(int i = 0; i < passedParameters->size(); i++)
+                    args[i] = held[base + i].GetInt();
+               held.resize(base);
+               CallExp->value = Value(entry(args[0], args[1], args[2], args[3], args[4], args[5]));
+               return;
           }
 
-          //Get the pair from the function map
-          map<string,node*>::iterator itr = functionExpressions.find(name);
-          evaluate(itr->second);
-          if(itr->second->value != NULL)
-               CallExp->value = itr->second->value->Copy();
-          delete itr->second->value;
-
-          //Pop scope and kill it when done
-          delete table.PopScope();
-     }   
-}
-void nodeInterpreter::visitInfixExp(infixExp* InfixExp) {
-     //Evaluate the LEFT expression first
-     evaluate(InfixExp->leftNode);
-
-     //Test for the short circuit expressions & and |
-     if(InfixExp->op == OP_AND && ((IntValue*)(InfixExp->leftNode->value))->GetValue() == 0)
-    {
-         InfixExp->value = new IntValue(0);
-    }
-    else if(InfixExp->op == OP_OR && ((IntValue*)(InfixExp->leftNode->value))->GetValue() != 0)
-    {
-         InfixExp->value = new IntValue(1);
-    }
-
+          //The function lives in the frame it was declared in, which its own
+          // frame links to so it sees the variables around its declaration
+          Frame* declaringFrame = frame->Ancestor(id->depth);
 
-     evaluate(InfixExp->rightNode);
+          //A call in tail position is left for the call running this function,
+          // which runs it in place of this one once everything in between is done;
+          // its arguments stay held until then
+          if(CallExp->tail)
+          {
+               tailCall = CallExp;
+               tailFrame = declaringFrame;
+               return;
+          }
 
-     //Welcome to IF/ELSE city, home of the bad code
-     
-     //Honestly I could have used a switch here but
-     // a core design feature of my interpreter
-     // is bad design so
-    if(InfixExp->op == OP_ADD)
-    {
-          IntValue* leftVal = (IntValue*)(InfixExp->leftNode->value);
-          IntValue* rightVal = (IntValue*)(InfixExp->rightNode->value); 
-          InfixExp->value = new IntValue(leftVal->GetValue()+rightVal->GetValue());
-    } else if(InfixExp->op == OP_SUBTRACT)
-    {
-
-    
-               IntValue* leftVal = (IntValue*)(InfixExp->leftNode->value);
-               IntValue* rightVal = (IntValue*)(InfixExp->rightNode->value); 
-               InfixExp->value = new IntValue(leftVal->GetValue()-rightVal->GetValue());
-    } else if(InfixExp->op == OP_MULTIPLY)
-    {
-
-    
-               IntValue* leftVal = (IntValue*)(InfixExp->leftNode->value);
-               IntValue* rightVal = (IntValue*)(InfixExp->rightNode->value); 
-               InfixExp->value = new IntValue(leftVal->GetValue()*rightVal->GetValue());
-    } else if(InfixExp->op == OP_DIVIDE)
-    {
-
-    
-               IntValue* leftVal = (IntValue*)(InfixExp->leftNode->value);
-               IntValue* rightVal = (IntValue*)(InfixExp->rightNode->value); 
-               InfixExp->value = new IntValue(leftVal->GetValue()/rightVal->GetValue());
-    } else if(InfixExp->op == OP_EQ)
-    {
-               if(InfixExp->leftNode->type->GetActualType()->name == "string")
-               {
-                    StringValue* leftVal = (StringValue*)(InfixExp->leftNode->value);
-                    StringValue* rightVal = (StringValue*)(InfixExp->rightNode->value); 
-                    if(leftVal->GetValue() == rightVal->GetValue())
-                         InfixExp->value = new IntValue(1);
-                    else
-                         InfixExp->value = new IntValue(0);
-               }
-               else if(InfixExp->leftNode->type->GetActualType()->name == "int")
-               {
-                    IntValue* leftVal = (IntValue*)(InfixExp->leftNode->value);
-                    IntValue* rightVal = (IntValue*)(InfixExp->rightNode->value); 
-                    if(leftVal->GetValue() == rightVal->GetValue())
-                         InfixExp->value = new IntValue(1);
-                    else
-                         InfixExp->value = new IntValue(0);
-               }
-               else //Else, they must be array or record types
-               {
-                    if(InfixExp->leftNode->value->kind == V_ARR && InfixExp->rightNode->value->kind == V_ARR)
-                    {
-                         if(InfixExp->leftNode->value == InfixExp->rightNode->value)
-                              InfixExp->value = new IntValue(1);
-                         else
-                              InfixExp->value = new IntValue(0);
-                    }
-                    else if(InfixExp->leftNode->value->kind == V_REC && InfixExp->rightNode->value->kind == V_REC)
-                    {
-                         if(InfixExp->leftNode->value == InfixExp->rightNode->value)
-                              InfixExp->value = new IntValue(1);
-                         else
-                              InfixExp->value = new IntValue(0);
-                    }
-                    else
-                         cout << "Braden is Bad at Programming: Value type mismatch on line " << InfixExp->lineNumber << endl;
-               }
+          char marker;
+          if((size_t)(nativeStackBase - &marker) > nativeStackBudget)
+          {
+               cout << "ERROR: Runtime: Stack overflow." << endl;
+               exit(4);
+          }
 
-    } else if(InfixExp->op == OP_NEQ)
-    {
-               if(InfixExp->leftNode->type->GetActualType()->name == "string")
-               {
-                    StringValue* leftVal = (StringValue*)(InfixExp->leftNode->value);
-                    StringValue* rightVal = (StringValue*)(InfixExp->rightNode->value); 
-                    if(leftVal->GetValue() != rightVal->GetValue())
-                         InfixExp->value = new IntValue(1);
-                    else
-                         InfixExp->value = new IntValue(0);
-               }
-               else if(InfixExp->leftNode->type->GetActualType()->name == "int")
-               {
-                    IntValue* leftVal = (IntValue*)(InfixExp->leftNode->value);
-                    IntValue* rightVal = (IntValue*)(InfixExp->rightNode->value); 
-                    if(leftVal->GetValue() != rightVal->GetValue())
-                         InfixExp->value = new IntValue(1);
-                    else
-                         InfixExp->value = new IntValue(0);
-               }
-               else
-               {
-                    if(InfixExp->leftNode->value->kind == V_ARR && InfixExp->rightNode->value->kind == V_ARR)
-                    {
-                         if(InfixExp->leftNode->value == InfixExp->rightNode->value)
-                              InfixExp->value = new IntValue(0);
-                         else
-                              InfixExp->value = new IntValue(1);
-                    }
-                    else if(InfixExp->leftNode->value->kind == V_REC && InfixExp->rightNode->value->kind == V_REC)
-                    {
-                         if(InfixExp->leftNode->value == InfixExp->rightNode->value)
-                              InfixExp->value = new IntValue(0);
-                         else
-                              InfixExp->value = new IntValue(1);
-                    }
-                    else
-                         cout << "Braden is Bad at Programming: Value type mismatch on line " << InfixExp->lineNumber << endl;
-               }
+          Frame* funcFrame = frames.Push(declaringFrame, FunDec->frameSize, frame);
+          bindParameters(funcFrame, FunDec, CallExp);
 
-    }else if(InfixExp->op == OP_LT)
-    {
-               if(InfixExp->leftNode->type->GetActualType()->name == "string")
-               {
-                    StringValue* leftVal = (StringValue*)(InfixExp->leftNode->value);
-                    StringValue* rightVal = (StringValue*)(InfixExp->rightNode->value); 
-                    if(leftVal->GetValue() < rightVal->GetValue())
-                         InfixExp->value = new IntValue(1);
-                    else
-                         InfixExp->value = new IntValue(0);
-               }
-               else if(InfixExp->leftNode->type->GetActualType()->name == "int")
-               {
-                    IntValue* leftVal = (IntValue*)(InfixExp->leftNode->value);
-                    IntValue* rightVal = (IntValue*)(InfixExp->rightNode->value); 
-                    if(leftVal->GetValue() < rightVal->GetValue())
-                         InfixExp->value = new IntValue(1);
-                    else
-                         InfixExp->value = new IntValue(0);
-               }
-               else
-               {
-                    cout << "Ah shit I screwed up the typing somewhere." << endl;
-               }
+          //Run the body in the new frame
+          Frame* callerFrame = frame;
+          frame = funcFrame;
+          evaluate(FunDec->exp);
 
-    }else if(InfixExp->op == OP_LEQ)
-    {
-               if(InfixExp->leftNode->type->GetActualType()->name == "string")
-               {
-                    StringValue* leftVal = (StringValue*)(InfixExp->leftNode->value);
-                    StringValue* rightVal = (StringValue*)(InfixExp->rightNode->value); 
-                    if(leftVal->GetValue() <= rightVal->GetValue())
-                         InfixExp->value = new IntValue(1);
-                    else
-                         InfixExp->value = new IntValue(0);
-               }
-               else if(InfixExp->leftNode->type->GetActualType()->name == "int")
-               {
-                    IntValue* leftVal = (IntValue*)(InfixExp->leftNode->value);
-                    IntValue* rightVal = (IntValue*)(InfixExp->rightNode->value); 
-                    if(leftVal->GetValue() <= rightVal->GetValue())
-                         InfixExp->value = new IntValue(1);
-                    else
-                         InfixExp->value = new IntValue(0);
-               }
-               else
-               {
-                    cout << "Ah shit I screwed up the typing somewhere." << endl;
-               }
+          //Run any tail calls the body left in the same frame, until one returns
+          while(tailCall != NULL)
+          {
+               callExp* next = tailCall;
+               tailCall = NULL;
+               FunDec = next->function;
+               frames.Resize(FunDec->frameSize);
+               funcFrame->parent = tailFrame;
+               bindParameters(funcFrame, FunDec, next);
+               evaluate(FunDec->exp);
+          }
+          CallExp->value = FunDec->exp->value;
 
-    }else if(InfixExp->op == OP_GT)
-    {
-               if(InfixExp->leftNode->type->GetActualType()->name == "string")
-               {
-                    StringValue* leftVal = (StringValue*)(InfixExp->leftNode->value);
-                    StringValue* rightVal = (StringValue*)(InfixExp->rightNode->value); 
-                    if(leftVal->GetValue() > rightVal->GetValue())
-                         InfixExp->value = new IntValue(1);
-                    else
-                         InfixExp->value = new IntValue(0);
-               }
-               else if(InfixExp->leftNode->type->GetActualType()->name == "int")
-               {
-                    IntValue* leftVal = (IntValue*)(InfixExp->leftNode->value);
-                    IntValue* rightVal = (IntValue*)(InfixExp->rightNode->value); 
-                    if(leftVal->GetValue() > rightVal->GetValue())
-                         InfixExp->value = new IntValue(1);
-                    else
-                         InfixExp->value = new IntValue(0);
-               }
-               else
-               {
-                    cout << "Ah shit I screwed up the typing somewhere." << endl;
-               }
+          //Return to the caller's frame and give this one back when done
+          frame = callerFrame;
+          frames.Pop();
+     }   
+}
+void nodeInterpreter::visitInfixExp(infixExp* InfixExp)
+{
+     //Evaluate the LEFT expression first, holding on to its value in case the
+     // right one runs this same node again through recursion
+     evaluate(InfixExp->leftNode);
+     Value left = InfixExp->leftNode->value;
 
-    } else if(InfixExp->op == OP_GEQ)
-    {
-               if(InfixExp->leftNode->type->GetActualType()->name == "string")
-               {
-                    StringValue* leftVal = (StringValue*)(InfixExp->leftNode->value);
-                    StringValue* rightVal = (StringValue*)(InfixExp->rightNode->value); 
-                    if(leftVal->GetValue() >= rightVal->GetValue())
-                         InfixExp->value = new IntValue(1);
-                    else
-                         InfixExp->value = new IntValue(0);
-               }
-               else if(InfixExp->leftNode->type->GetActualType()->name == "int")
-               {
-                    IntValue* leftVal = (IntValue*)(InfixExp->leftNode->value);
-                    IntValue* rightVal = (IntValue*)(InfixExp->rightNode->value); 
-                    if(leftVal->GetValue() >= rightVal->GetValue())
-                         InfixExp->value = new IntValue(1);
-                    else
-                         InfixExp->value = new IntValue(0);
-               }
-               else
-               {
-                    cout << "Ah shit I screwed up the typing somewhere." << endl;
-               }
+     //& and | don't evaluate the right side when the left decides them
+     if(InfixExp->operation == INFIX_AND && left.GetInt() == 0)
+     {
+          InfixExp->value = Value(0);
+          return;
+     }
+     if(InfixExp->operation == INFIX_OR && left.GetInt() != 0)
+     {
+          InfixExp->value = Value(1);
+          return;
+     }
 
-    }else if(InfixExp->op == OP_NEQ)
-    {
-               if(InfixExp->leftNode->type->GetActualType()->name == "string")
-               {
-                    StringValue* leftVal = (StringValue*)(InfixExp->leftNode->value);
-                    StringValue* rightVal = (StringValue*)(InfixExp->rightNode->value); 
-                    if(leftVal->GetValue() != rightVal->GetValue())
-                         InfixExp->value = new IntValue(1);
-                    else
-                         InfixExp->value = new IntValue(0);
-               }
-               else if(InfixExp->leftNode->type->GetActualType()->name == "int")
-               {
-                    IntValue* leftVal = (IntValue*)(InfixExp->leftNode->value);
-                    IntValue* rightVal = (IntValue*)(InfixExp->rightNode->value); 
-                    if(leftVal->GetValue() != rightVal->GetValue())
-                         InfixExp->value = new IntValue(1);
-                    else
-                         InfixExp->value = new IntValue(0);
-               }
-               else
-               {
-                    cout << "Ah shit I screwed up the typing somewhere." << endl;
-               }
+     //Keep a string, array or record on the left reachable while the right runs
+     bool hold = left.GetObject() != NULL;
+     if(hold)
+          held.push_back(left);
+     evaluate(InfixExp->rightNode);
+     if(hold)
+          held.pop_back();
+     Value right = InfixExp->rightNode->value;
 
-    }else if(InfixExp->op == OP_AND)
-    {
-               IntValue* leftVal = (IntValue*)(InfixExp->leftNode->value);
-               IntValue* rightVal = (IntValue*)(InfixExp->rightNode->value); 
-               if(leftVal->GetValue() != 0 && rightVal->GetValue() != 0)
-               {
-                    InfixExp->value =  new IntValue(1);
-               }
-               else
-                    InfixExp->value = new IntValue(0);
-    }else if(InfixExp->op == OP_OR)
-    {
-               IntValue* leftVal = (IntValue*)(InfixExp->leftNode->value);
-               IntValue* rightVal = (IntValue*)(InfixExp->rightNode->value); 
-               if(leftVal->GetValue() != 0 || rightVal->GetValue() != 0)
+     //Semantic analysis already picked the operation for the operands' types
+     switch(InfixExp->operation)
+     {
+          case INFIX_INT_ADD:
+               InfixExp->value = Value(intAdd(left.GetInt(), right.GetInt()));
+               break;
+          case INFIX_INT_SUBTRACT:
+               InfixExp->value = Value(intSubtract(left.GetInt(), right.GetInt()));
+               break;
+          case INFIX_INT_MULTIPLY:
+               InfixExp->value = Value(intMultiply(left.GetInt(), right.GetInt()));
+               break;
+          case INFIX_INT_DIVIDE:
+               //Division by zero is an error, and INT_MIN / -1 would trap
+               if(right.GetInt() == 0)
                {
-                    InfixExp->value =  new IntValue(1);
+                    cout << "ERROR " << InfixExp->lineNumber << ": Runtime: Division by zero." << endl;
+                    exit(4);
                }
+               if(right.GetInt() == -1)
+                    InfixExp->value = Value(intNegate(left.GetInt()));
                else
-                    InfixExp->value = new IntValue(0);
-    }
+                    InfixExp->value = Value(left.GetInt() / right.GetInt());
+               break;
+          case INFIX_INT_EQ:
+               InfixExp->value = Value(left.GetInt() == right.GetInt() ? 1 : 0);
+               break;
+          case INFIX_INT_NEQ:
+               InfixExp->value = Value(left.GetInt() != right.GetInt() ? 1 : 0);
+               break;
+          case INFIX_INT_LT:
+               InfixExp->value = Value(left.GetInt() < right.GetInt() ? 1 : 0);
+               break;
+          case INFIX_INT_LEQ:
+               InfixExp->value = Value(left.GetInt() <= right.GetInt() ? 1 : 0);
+               break;
+          case INFIX_INT_GT:
+               InfixExp->value = Value(left.GetInt() > right.GetInt() ? 1 : 0);
+               break;
+          case INFIX_INT_GEQ:
+               InfixExp->value = Value(left.GetInt() >= right.GetInt() ? 1 : 0);
+               break;
+          case INFIX_STR_EQ:
+               InfixExp->value = Value(left.GetStringObject()->Equals(right.GetStringObject()) ? 1 : 0);
+               break;
+          case INFIX_STR_NEQ:
+               InfixExp->value = Value(left.GetStringObject()->Equals(right.GetStringObject()) ? 0 : 1);
+               break;
+          case INFIX_STR_LT:
+               InfixExp->value = Value(left.GetStringObject()->Compare(right.GetStringObject()) < 0 ? 1 : 0);
+               break;
+          case INFIX_STR_LEQ:
+               InfixExp->value = Value(left.GetStringObject()->Compare(right.GetStringObject()) <= 0 ? 1 : 0);
+               break;
+          case INFIX_STR_GT:
+               InfixExp->value = Value(left.GetStringObject()->Compare(right.GetStringObject()) > 0 ? 1 : 0);
+               break;
+          case INFIX_STR_GEQ:
+               InfixExp->value = Value(left.GetStringObject()->Compare(right.GetStringObject()) >= 0 ? 1 : 0);
+               break;
+          case INFIX_REF_EQ:
+               InfixExp->value = Value(left == right ? 1 : 0);
+               break;
+          case INFIX_REF_NEQ:
+               InfixExp->value = Value(left == right ? 0 : 1);
+               break;
+          case INFIX_AND:
+          case INFIX_OR:
+               //The left side didn't decide it, so the right one does
+               InfixExp->value = Value(right.GetInt() != 0 ? 1 : 0);
+               break;
+     }
 }
 
 void nodeInterpreter::visitArrCreate(arrCreate* ArrCreate)
 {
      //Get the subscript size
      evaluate(ArrCreate->subscriptExp);
-     int size = ((IntValue*)(ArrCreate->subscriptExp->value))->GetValue();
+     int size = ArrCreate->subscriptExp->value.GetInt();
 
      //Get the value for the post expression
      evaluate(ArrCreate->postExp);
 
      //Create the new array value
-     ArrCreate->value = new ArrayValue(size, ArrCreate->postExp->value->Copy());
+     pollCollector();
+     ArrCreate->value = Value(new ArrayObject(size, ArrCreate->postExp->value, ArrCreate->ints));
 }
 
 /**
@@ -483,21 +459,25 @@ void nodeInterpreter::visitArrCreate(arrCreate* ArrCreate)
  */
 void nodeInterpreter::visitRecCreate(recCreate* RecCreate)
 {
-     //For every field, create a value pair of id -> value
-     map<string,Value*> valPairs;
+     //Hold each field's value as soon as it's evaluated; a recursive call in a
+     // later field runs these same nodes again and overwrites their values
+     size_t base = held.size();
      for(int i = 0; i < RecCreate->fields->size(); i++)
      {
-          fieldCreate* FieldCreate = (fieldCreate*)(*(RecCreate->fields))[i];
-          string name =((NId*)(FieldCreate->id))->name;
-          evaluate(FieldCreate);
-
-          valPairs.insert(pair<string,Value*>(name, FieldCreate->value));
-
+          evaluate((*(RecCreate->fields))[i]);
+          held.push_back((*(RecCreate->fields))[i]->value);
      }
 
-     //Create a new record value with it
-     RecordValue* recVal = new RecordValue(valPairs);
-     RecCreate->value = recVal;
+     //Then create the record and put each value in its field's slot
+     pollCollector();
+     RecordObject* record = new RecordObject(RecCreate->record);
+     for(int i = 0; i < RecCreate->fields->size(); i++)
+     {
+          fieldCreate* FieldCreate = (fieldCreate*)(*(RecCreate->fields))[i];
+          *record->GetValue(FieldCreate->slot) = held[base + i];
+     }
+     held.resize(base);
+     RecCreate->value = Value(record);
 }
 
 void nodeInterpreter::visitFieldCreate(fieldCreate* FieldCreate)
@@ -508,22 +488,36 @@ void nodeInterpreter::visitFieldCreate(fieldCreate* FieldCreate)
 
 void nodeInterpreter::visitAssignment(assignment* Assign)
 {
-     //Calculate all of the nodes for the LValue to get the reference
-     // to whatever variable value is on the LHS
-     evaluate(Assign->lVal);
-     //delete(Assign->lVal->value);
+     //Array elements may be unboxed, so they're stored through the array once
+     // its index is known to be in bounds
+     if(dynamic_cast<subscript*>(Assign->lVal) != NULL)
+     {
+          int index;
+          ArrayObject* arr = element((subscript*)Assign->lVal, index);
+          evaluate(Assign->exp);
+          arr->Set(index, Assign->exp->value);
+          return;
+     }
 
-     //Set it equal to a copy of the rhs+
-     evaluate(Assign->exp);
+     //Calculate all of the nodes for the LValue to find where the variable
+     // or field on the LHS is stored
+     Value* target = locate(Assign->lVal);
 
-     
-     Assign->lVal->value->SetValue(Assign->exp->value->Copy());
+     //Set it to the rhs; arrays and records are shared, not copied
+     evaluate(Assign->exp);
+     *target = Assign->exp->value;
 }
 void nodeInterpreter::visitIfThenElse(ifThenElse* iTE)
 {
      //If the condition evaluates to non-zero...
      evaluate(iTE->ifExp);
-     if(isNonZero(iTE->ifExp->value))
+     bool tookThen = isNonZero(iTE->ifExp->value);
+
+     //Let the tracer know which way it went if a loop is being recorded
+     if(tracer != NULL && tracer->recording != NULL)
+          tracer->RecordBranch(iTE, tookThen);
+
+     if(tookThen)
      {
           //Evaluate it and set the exp equal to the then's result
           evaluate(iTE->thenExp);
@@ -544,10 +538,14 @@ void nodeInterpreter::visitWhileExp(whileExp* While)
 {
      while(true)
      {
-          //Wipe the old one if it was there
-          if(While->condition->value != NULL)
+          //Once the loop is hot, iterations may run as a native trace instead
+          if(tracer != NULL)
           {
-               delete(While->condition->value);
+               TraceStatus status = tracer->Enter(this, While, NULL);
+               if(status == TRACE_DONE)
+                    break;
+               if(status == TRACE_RESUMED)
+                    continue;
           }
 
           //Evaluate the condition
@@ -575,26 +573,38 @@ void nodeInterpreter::visitWhileExp(whileExp* While)
 
 void nodeInterpreter::visitForExp(forExp* forEx)
 {
-     //Create a new scope for the new variable
-     Scope* forScope = new Scope(table.top, S_FOR);
-     table.PushScope(forScope);
-
-     //Create a symbol for the variable and add it to the scope
-     string name = ((NId*)(forEx->id))->name;
+     //Create a new frame for the new variable
      evaluate(forEx->assign);
-     VarSymbol* var = new VarSymbol(name, SYM_VAR, forEx->assign->type, forEx->assign->value);
-     forScope->AddSymbol(var);
+     Frame* forFrame = frames.Push(frame, 1);
+     Value* var = &(forFrame->slots[((NId*)(forEx->id))->slot]);
+     *var = forEx->assign->value;
 
      //Determine the value of the condition
      evaluate(forEx->condition);
+     frame = forFrame;
 
-     //Run the loop for the difference between the initial and condition
-     IntValue* initial = (IntValue*) var->val;
-     int limit = ((IntValue*) (forEx->condition->value))->GetValue();
-     for(int i = initial->GetValue(); i < limit; i++)
+     //Run the loop from the initial value up to and including the limit
+     int limit = forEx->condition->value.GetInt();
+     for(int i = var->GetInt(); i <= limit; i++)
      {
           //Update the variable's value in case the loop exps use it
-          ((IntValue*)var->val)->SetValue(i);
+          *var = Value(i);
+
+          //Once the loop is hot, iterations may run as a native trace instead
+          if(tracer != NULL)
+          {
+               TraceStatus status = tracer->Enter(this, forEx, &limit);
+               if(status == TRACE_DONE)
+                    break;
+               if(status == TRACE_RESUMED)
+               {
+                    //The trace may have moved the variable on several iterations
+                    i = var->GetInt();
+                    if(i == limit)
+                         break;
+                    continue;
+               }
+          }
 
           evaluate(forEx->action);
           if(breakCalled)
@@ -602,21 +612,29 @@ void nodeInterpreter::visitForExp(forExp* forEx)
                breakCalled = false;
                break;
           }
+
+          //Stop at the limit rather than stepping past it, which overflows when
+          // the limit is INT_MAX
+          if(i == limit)
+               break;
      }
 
-     //Pop the scope once done
-     delete (table.PopScope());
+     //Leave the frame once done
+     frame = forFrame->parent;
+     frames.Pop();
 }
 void nodeInterpreter::visitLetExp(letExp* LetExp)
 {
-     Scope* letScope = new Scope(table.top, S_LET);
-     table.PushScope(letScope);
-     //Evaluate all of the variable declarations
+     frame = frames.Push(frame, LetExp->frameSize);
+
+     //Evaluate all of the variable declarations; calls are bound to their
+     // functions already, so those need nothing at run time
      //cout << endl << endl << "NUMBER OF DECLARATIONS: " << LetExp->decs->size() << endl << endl;
      for(int i = 0; i < LetExp->decs->size(); i++)
      {
-          evaluate((*(LetExp->decs))[i]);
-          
+          decc* dec = (decc*)(*(LetExp->decs))[i];
+          if(dec->kind == D_VAR)
+               evaluate(dec);
      }
      
      //Evaluate all of the body expressions in order
@@ -625,18 +643,19 @@ void nodeInterpreter::visitLetExp(letExp* LetExp)
           evaluate((*(LetExp->exps))[i]);
      }
 
-     //Value of LetExp is value of the last body expression
-     Value* lastVal = (*(LetExp->exps))[LetExp->exps->size()-1]->value;
-     if(lastVal != NULL)
-          LetExp->value = lastVal ->Copy();
+     //Value of LetExp is value of the last body expression, unless that was a
+     // tail call still waiting to be run
+     if(tailCall == NULL)
+          LetExp->value = (*(LetExp->exps))[LetExp->exps->size()-1]->value;
 
-     delete (table.PopScope());
+     frame = frame->parent;
+     frames.Pop();
 }
 void nodeInterpreter::visitDec(decc* Dec)
 {}
 void nodeInterpreter::visitTyDec(tyDec* TyDec)
 {
-     table.top->AddType(TyDec->type);
+     
 }
 
 void nodeInterpreter::visitTyDef(tyDef* TyDef)
@@ -665,29 +684,16 @@ void nodeInterpreter::visitFieldDec(fieldDec* FieldDec)
 
 void nodeInterpreter::visitFunDec(funDec* FunDec)
 {
-     //Get the name and type that go with the func
-     string name = ((NId*)(FunDec->id))->name;
 
-     //Get the params
-     vector<pair<string,Type*> > params = FunDec->getParams();
-     
-     //Make an entry in the function map for it
-     functionExpressions.insert(pair<string,node*>(name, FunDec->exp));
-     functionParams.insert(pair<string,vector< pair<string,Type*> > >(name, params));
 }
 
 void nodeInterpreter::visitVarDec(varDec* VarDec)
 {
-     //Get the name and type that go with the variable
-     string name = ((NId*)(VarDec->id))->name;
-     Type* varType = VarDec->type;
-
      //Evaluate whatever it's initialized to
      evaluate(VarDec->exp);
 
-     //Create a new symbol and drop it on the table
-     Symbol* varSym = new VarSymbol(name, SYM_VAR, varType, VarDec->exp->value);
-     table.top->AddSymbol(varSym);
+     //Drop the value in the variable's slot
+     frame->slots[((NId*)(VarDec->id))->slot] = VarDec->exp->value;
 
      
      
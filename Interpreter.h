@@ -17,14 +17,36 @@
  *  @{
  */
 
+#ifndef INTERPRETER
+#define INTERPRETER
+
 #include <vector>
 #include <map>
 #include "ast.h"
 #include "SemanticAnalyzer.h"
 #include "SymbolTable.h"
+#include "MethodJIT.h"
+#include "GarbageCollector.h"
+#include "StackEvaluator.h"
+#include "FlatEvaluator.h"
+
+class TraceJIT;
 
 using namespace std;
 
+/**
+ * @brief The ways a program can be executed.
+ * 
+ */
+enum EngineKind
+{
+     ENGINE_TREE,   //Walk the AST directly
+     ENGINE_VM,     //Compile to bytecode and run it on the virtual machine
+     ENGINE_CLOSURE, //Compile to pre-bound closures and call them
+     ENGINE_STACK,  //Walk the AST with an explicit continuation stack instead of recursion
+     ENGINE_FLAT    //Flatten the AST into contiguous arrays, free it, and walk those
+};
+
 /**
  * @brief Given a semantically valid AST, will interpretand execute Tiger code.
  * 
@@ -35,8 +57,13 @@ class Interpreter{
            * @brief Creates a new Interpreter with a reference to a Tiger AST.
            * 
            * @param astRoot 
+           * @param engine Which engine executes the program.
+           * @param jit Whether the tree-walker may compile hot functions and loops to native code.
+           * @param gc When the tree-walker collects garbage and whether it reports on it.
+           * @param stackLimit Bytes the explicit stack evaluator's stacks and frames may take.
            */
-          Interpreter(node* astRoot);
+          Interpreter(node* astRoot, EngineKind engine = ENGINE_TREE, bool jit = true, GCSettings gc = GCSettings(),
+               size_t stackLimit = STACK_DEFAULT_LIMIT);
 
           /**
            * @brief Begins interpretation of the Tiger AST.
@@ -49,6 +76,30 @@ class Interpreter{
            * 
            */
           node* astRoot;
+
+          /**
+           * @brief Which engine executes the program.
+           * 
+           */
+          EngineKind engine;
+
+          /**
+           * @brief Whether the tree-walker may compile hot functions and loops to native code.
+           * 
+           */
+          bool jit;
+
+          /**
+           * @brief When the tree-walker collects garbage and whether it reports on it.
+           * 
+           */
+          GCSettings gc;
+
+          /**
+           * @brief Bytes the explicit stack evaluator's stacks and frames may take.
+           * 
+           */
+          size_t stackLimit;
 };
 
 /**
@@ -58,8 +109,8 @@ class Interpreter{
 class nodeInterpreter : public nodeVisitor{
      public:
           /**
-           * @brief Construct a new node Interpreter object with the default Tiger
-           * symbol table.
+           * @brief Construct a new node Interpreter object with the frame for the
+           * default Tiger scope.
            * 
            */
           nodeInterpreter();
@@ -79,6 +130,60 @@ class nodeInterpreter : public nodeVisitor{
            */
           bool breakCalled = false;
 
+          /**
+           * @brief Compiles hot integer-only functions, or NULL to interpret everything.
+           * 
+           */
+          MethodJIT* jit = NULL;
+
+          /**
+           * @brief Compiles hot loops, or NULL to interpret every iteration.
+           * 
+           */
+          TraceJIT* tracer = NULL;
+
+          /**
+           * @brief Frees strings, arrays and records that are no longer reachable.
+           * Polled wherever one may be made, or NULL to never free them.
+           * 
+           */
+          GarbageCollector* collector = NULL;
+
+          /**
+           * @brief Values still needed while later expressions are evaluated, kept
+           * reachable for the collector: left operands of infix expressions, record
+           * fields and call arguments.
+           * 
+           */
+          vector<Value> held;
+
+          /**
+           * @brief A call in tail position whose arguments have been evaluated onto
+           * held, left for the call running the current function to take over in
+           * its own frame, or NULL if there isn't one.
+           * 
+           */
+          callExp* tailCall = NULL;
+
+          /**
+           * @brief The frame the pending tail call's function was declared in.
+           * 
+           */
+          Frame* tailFrame = NULL;
+
+          /**
+           * @brief Where the native stack was when the interpreter was made; visits
+           * recurse on it, so calls stop short of overrunning it.
+           * 
+           */
+          char* nativeStackBase = NULL;
+
+          /**
+           * @brief Bytes of the native stack calls may use.
+           * 
+           */
+          size_t nativeStackBudget = 0;
+
 
 
           /*******************
@@ -91,37 +196,62 @@ class nodeInterpreter : public nodeVisitor{
            * @return true If the value is anything other than 0.
            * @return false If the value is zero.
            */
-          bool isNonZero(Value*);
-
-
+          bool isNonZero(Value);
 
+          /**
+           * @brief Finds where an lvalue's value is stored, so it can be assigned to.
+           * 
+           * @param lValue An identifier or field expression.
+           * @return Value* The variable or record field.
+           */
+          Value* locate(node* lValue);
 
+          /**
+           * @brief Finds the array and index a subscript refers to, stopping the
+           * program if the index is out of bounds.
+           * 
+           * @param index Set to the element's index.
+           * @return ArrayObject* The array.
+           */
+          ArrayObject* element(subscript* Subscript, int &index);
 
-          /************************
-           * BUILT IN FUNCTIONS
-           * *********************/
+          /**
+           * @brief Finds the record field a field expression refers to, stopping the
+           * program if the record is nil.
+           * 
+           * @return Value* The field.
+           */
+          Value* field(fieldExp* FieldExp);
 
           /**
-           * @brief Prints an integer value to std out. Used for builtin printi function.
+           * @brief Lets the garbage collector run if it's due. Only called where every
+           * value in use is in a frame, on a node or held.
            * 
-           * @param value The integer value to print.
            */
-          void Print(IntValue* value);
+          void pollCollector();
 
           /**
-           * @brief Prints a string value to std out. Used for builtin print function.
+           * @brief Evaluates a call's arguments onto held, each as soon as it's
+           * evaluated, since a recursive call in a later argument runs the earlier
+           * ones' nodes again.
            * 
-           * @param value The string value to print.
+           * @param CallExp The call.
            */
-          void Print(StringValue* value);
+          void pushArguments(callExp* CallExp);
 
           /**
-           * @brief Returns 1 value if 0, and returns 0 value for anything else. 
-           * Used for builtin not function.
+           * @brief Takes a call's arguments off the top of held and puts them in its
+           * function's parameter slots.
            * 
-           * @return IntValue* Integer value to not.
+           * @param funcFrame The frame the function will run in.
+           * @param FunDec The function being called.
+           * @param CallExp The call, whose arguments are on top of held.
            */
-          IntValue* Not(IntValue*);
+          void bindParameters(Frame* funcFrame, funDec* FunDec, callExp* CallExp);
+
+
+
+
 
            //Visitor functions
           void visitProgram(program* prog) override;
@@ -156,22 +286,17 @@ class nodeInterpreter : public nodeVisitor{
           void visitVarDec(varDec*) override;
 
           /**
-           * @brief Symbol table used during interpretation to track values and symbols.
-           * 
-           */
-          SymbolTable table;
-
-          /**
-           * @brief Contains the body and name of all user defined functions.
+           * @brief Frame of the innermost scope being run. Variables and functions
+           * are found from it by the depth and slot semantic analysis gave them.
            * 
            */
-          map<string, node*> functionExpressions;
+          Frame* frame;
 
           /**
-           * @brief Contains the name and all function parameters for user defined function.
-           * Utilized during callExp to make new scope with identifiers.
+           * @brief Where every frame comes from, reused as scopes are left.
            * 
            */
-          map<string, vector < pair<string,Type*> > > functionParams; //Parallel to function expressions
+          FrameStack frames;
 };
-/** @} */
\ No newline at end of file
+/** @} */
+#endif
\ No newline at end of file
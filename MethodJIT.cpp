@@ -0,0 +1,855 @@
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include "MethodJIT.h"
+#include "Builtins.h"
+
+#ifdef JIT_SUPPORTED
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+//Smallest block of executable memory to ask the system for
+#define JIT_BLOCK_SIZE (1 << 20)
+
+/*********************
+ * RUNTIME HELPERS
+ * *******************/
+
+//Compiled code checks rsp against this on entry so deep recursion fails cleanly
+static uintptr_t jitStackLimit = 0;
+
+static void jitStackOverflow()
+{
+     cout << "ERROR: Runtime: Stack overflow." << endl;
+     exit(4);
+}
+
+static void jitDivisionByZero(int lineNumber)
+{
+     cout << "ERROR " << lineNumber << ": Runtime: Division by zero." << endl;
+     exit(4);
+}
+
+/*********************
+ * X86 ASSEMBLER
+ * *******************/
+
+void X86Assembler::byte(int b)
+{
+     code.push_back((unsigned char)b);
+}
+
+void X86Assembler::bytes(int b1, int b2)
+{
+     byte(b1);
+     byte(b2);
+}
+
+void X86Assembler::bytes(int b1, int b2, int b3)
+{
+     byte(b1);
+     byte(b2);
+     byte(b3);
+}
+
+void X86Assembler::int32(int value)
+{
+     for(int i = 0; i < 4; i++)
+          byte((value >> (8 * i)) & 0xFF);
+}
+
+void X86Assembler::int64(intptr_t value)
+{
+     for(int i = 0; i < 8; i++)
+          byte((value >> (8 * i)) & 0xFF);
+}
+
+int X86Assembler::jump()
+{
+     byte(0xE9);
+     int32(0);
+     return here() - 4;
+}
+
+int X86Assembler::jumpIf(int condition)
+{
+     bytes(0x0F, condition);
+     int32(0);
+     return here() - 4;
+}
+
+void X86Assembler::patch(int position)
+{
+     patchTo(position, here());
+}
+
+void X86Assembler::patchTo(int position, int target)
+{
+     int displacement = target - (position + 4);
+     for(int i = 0; i < 4; i++)
+          code[position + i] = (displacement >> (8 * i)) & 0xFF;
+}
+
+int X86Assembler::here()
+{
+     return code.size();
+}
+
+//Slots grow down from rbp, one quadword each
+void X86Assembler::loadSlot(int slot)
+{
+     bytes(0x8B, 0x85);
+     int32(-8 * (slot + 1));
+}
+
+void X86Assembler::storeSlot(int slot)
+{
+     bytes(0x89, 0x85);
+     int32(-8 * (slot + 1));
+}
+
+void X86Assembler::addStack(int amount)
+{
+     bytes(0x48, 0x81, 0xC4);
+     int32(amount);
+}
+
+void X86Assembler::callAbsolute(void* target)
+{
+     bytes(0x48, 0xB8);
+     int64((intptr_t)target);
+     bytes(0xFF, 0xD0);
+}
+
+/*********************
+ * CODE HEAP
+ * *******************/
+
+CodeHeap::CodeHeap():blockUsed(0){}
+
+CodeHeap::~CodeHeap()
+{
+#ifdef JIT_SUPPORTED
+     for(int i = 0; i < blocks.size(); i++)
+          munmap(blocks[i].first, blocks[i].second);
+#endif
+}
+
+void* CodeHeap::Install(const vector<unsigned char> &code)
+{
+#ifdef JIT_SUPPORTED
+     if(blocks.empty() || blockUsed + code.size() > blocks.back().second)
+     {
+          size_t size = JIT_BLOCK_SIZE;
+          while(size < code.size())
+               size *= 2;
+          void* block = mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+          if(block == MAP_FAILED)
+               return NULL;
+          blocks.push_back(pair<unsigned char*, size_t>((unsigned char*)block, size));
+          blockUsed = 0;
+     }
+
+     unsigned char* address = blocks.back().first + blockUsed;
+     memcpy(address, &code[0], code.size());
+     blockUsed += (code.size() + 15) & ~15;
+     return address;
+#else
+     return NULL;
+#endif
+}
+
+/*********************
+ * NODE METHOD JIT
+ * *******************/
+
+nodeMethodJIT::nodeMethodJIT(MethodJIT* jit)
+:jit(jit), supported(true), depth(0), frameSlots(0), nextSlot(0){}
+
+bool nodeMethodJIT::compileFunction(funDec* FunDec)
+{
+     //Only functions of ints to int whose arguments all fit in registers
+     if(FunDec->params->size() > 6 || !isIntType(FunDec->returnType->type))
+          return false;
+     map<Atom, int> paramScope;
+     for(int i = 0; i < FunDec->params->size(); i++)
+     {
+          fieldDec* param = (fieldDec*)(*(FunDec->params))[i];
+          if(!isIntType(param->type))
+               return false;
+          paramScope[((NId*)(param->id))->name] = allocateSlot();
+     }
+     scopes.push_back(paramScope);
+
+     //push rbp; mov rbp, rsp
+     as.byte(0x55);
+     as.bytes(0x48, 0x89, 0xE5);
+
+     //Bail out before the native stack runs out
+     as.bytes(0x48, 0xB8);
+     as.int64((intptr_t)&jitStackLimit);
+     as.bytes(0x48, 0x3B, 0x20);
+     int stackOk = as.jumpIf(0x80 | 0x3);
+     as.callAbsolute((void*)jitStackOverflow);
+     as.patch(stackOk);
+
+     //sub rsp, frame size (patched once every local is known)
+     as.bytes(0x48, 0x81, 0xEC);
+     int frameSizePosition = as.here();
+     as.int32(0);
+
+     //Spill the register arguments into their slots
+     static const int paramStores[6][3] = {
+          {0x00, 0x89, 0xBD}, {0x00, 0x89, 0xB5}, {0x00, 0x89, 0x95},
+          {0x00, 0x89, 0x8D}, {0x44, 0x89, 0x85}, {0x44, 0x89, 0x8D}
+     };
+     for(int i = 0; i < FunDec->params->size(); i++)
+     {
+          if(paramStores[i][0] != 0)
+               as.byte(paramStores[i][0]);
+          as.bytes(paramStores[i][1], paramStores[i][2]);
+          as.int32(-8 * (i + 1));
+     }
+
+     compile(FunDec->exp);
+
+     //leave; ret
+     as.byte(0xC9);
+     as.byte(0xC3);
+
+     //Keep rsp 16-byte aligned
+     int frameBytes = ((frameSlots * 8) + 15) & ~15;
+     for(int i = 0; i < 4; i++)
+          as.code[frameSizePosition + i] = (frameBytes >> (8 * i)) & 0xFF;
+
+     scopes.pop_back();
+     return supported;
+}
+
+void nodeMethodJIT::compile(node* Node)
+{
+     if(supported)
+          Node->accept(this);
+}
+
+bool nodeMethodJIT::isIntType(Type* type)
+{
+     //Can't use GetActualType() here since it looks through arrays to their elements
+     while(dynamic_cast<RefType*>(type) != NULL)
+          type = ((RefType*)type)->ref;
+     return type != NULL && type->name == ATOM_INT;
+}
+
+void nodeMethodJIT::compileOperands(infixExp* InfixExp)
+{
+     //A literal on the right goes straight into ecx: mov ecx, imm32
+     compile(InfixExp->leftNode);
+     if(dynamic_cast<NIntLit*>(InfixExp->rightNode) != NULL)
+     {
+          as.byte(0xB9);
+          as.int32(((NIntLit*)(InfixExp->rightNode))->val);
+          return;
+     }
+     push();
+     compile(InfixExp->rightNode);
+     as.bytes(0x89, 0xC1);
+     pop();
+}
+
+int nodeMethodJIT::conditionCode(int op)
+{
+     switch(op)
+     {
+          case OP_EQ: return CC_E;
+          case OP_NEQ: return CC_NE;
+          case OP_LT: return CC_L;
+          case OP_LEQ: return CC_LE;
+          case OP_GT: return CC_G;
+          default: return CC_GE;
+     }
+}
+
+bool nodeMethodJIT::constantValue(node* Node, int &result)
+{
+     if(dynamic_cast<NIntLit*>(Node) != NULL)
+     {
+          result = ((NIntLit*)Node)->val;
+          return true;
+     }
+     if(dynamic_cast<negation*>(Node) != NULL)
+     {
+          if(!constantValue(((negation*)Node)->operand, result))
+               return false;
+          result = intNegate(result);
+          return true;
+     }
+     if(dynamic_cast<infixExp*>(Node) == NULL)
+          return false;
+
+     infixExp* InfixExp = (infixExp*) Node;
+     int left, right;
+     if(!constantValue(InfixExp->leftNode, left) || !constantValue(InfixExp->rightNode, right))
+          return false;
+     switch(InfixExp->op)
+     {
+          case OP_ADD: result = intAdd(left, right); return true;
+          case OP_SUBTRACT: result = intSubtract(left, right); return true;
+          case OP_MULTIPLY: result = intMultiply(left, right); return true;
+          case OP_DIVIDE:
+               //Leave the error for run time
+               if(right == 0 || right == -1)
+                    return false;
+               result = left / right;
+               return true;
+          case OP_AND: result = (left != 0 && right != 0) ? 1 : 0; return true;
+          case OP_OR: result = (left != 0 || right != 0) ? 1 : 0; return true;
+          case OP_EQ: result = left == right; return true;
+          case OP_NEQ: result = left != right; return true;
+          case OP_LT: result = left < right; return true;
+          case OP_LEQ: result = left <= right; return true;
+          case OP_GT: result = left > right; return true;
+          default: result = left >= right; return true;
+     }
+}
+
+void nodeMethodJIT::reject()
+{
+     supported = false;
+}
+
+void nodeMethodJIT::push()
+{
+     as.byte(0x50);
+     depth++;
+}
+
+void nodeMethodJIT::pop()
+{
+     as.byte(0x58);
+     depth--;
+}
+
+void nodeMethodJIT::callHelper(void* target)
+{
+     if(depth % 2 != 0)
+          as.addStack(-8);
+     as.callAbsolute(target);
+     if(depth % 2 != 0)
+          as.addStack(8);
+}
+
+int nodeMethodJIT::allocateSlot()
+{
+     int slot = nextSlot++;
+     if(nextSlot > frameSlots)
+          frameSlots = nextSlot;
+     return slot;
+}
+
+int nodeMethodJIT::lookup(Atom name)
+{
+     for(int i = scopes.size()-1; i >= 0; i--)
+     {
+          map<Atom, int>::iterator itr = scopes[i].find(name);
+          if(itr != scopes[i].end())
+               return itr->second;
+     }
+     return -1;
+}
+
+/*********
+ * VISITS
+ * *******/
+
+void nodeMethodJIT::visitProgram(program* Program)
+{
+     reject();
+}
+void nodeMethodJIT::visitBreak(NBreak* Break)
+{
+     if(loops.empty())
+     {
+          reject();
+          return;
+     }
+
+     //Drop anything pushed since the loop started; the code after the break is unreachable
+     JITLoop& loop = loops.back();
+     if(depth > loop.depth)
+          as.addStack(8 * (depth - loop.depth));
+     loop.breakJumps.push_back(as.jump());
+}
+void nodeMethodJIT::visitNil(NNil* Nil)
+{
+     reject();
+}
+void nodeMethodJIT::visitID(NId* id)
+{
+     //Anything other than a parameter or local lives in the interpreter's environment
+     int slot = lookup(id->name);
+     if(slot < 0)
+     {
+          reject();
+          return;
+     }
+     as.loadSlot(slot);
+}
+void nodeMethodJIT::visitTyID(NTyId* tyid)
+{
+     reject();
+}
+void nodeMethodJIT::visitSubscript(subscript* Subscript)
+{
+     reject();
+}
+void nodeMethodJIT::visitFieldExp(fieldExp* FieldExp)
+{
+     reject();
+}
+void nodeMethodJIT::visitSeqExp(seqExp* SeqExp)
+{
+     //mov eax, 0 for the empty sequence
+     if(SeqExp->exps->size() == 0)
+     {
+          as.byte(0xB8);
+          as.int32(0);
+     }
+     for(int i = 0; i < SeqExp->exps->size(); i++)
+          compile((*(SeqExp->exps))[i]);
+}
+void nodeMethodJIT::visitNegation(negation* neg)
+{
+     compile(neg->operand);
+     as.bytes(0xF7, 0xD8);
+}
+void nodeMethodJIT::visitCallExp(callExp* CallExp)
+{
+     NodeList* args = CallExp->exps;
+
+     if(CallExp->builtin != NULL && CallExp->builtin->kind == BUILTIN_NOT)
+     {
+          //test eax, eax; sete al; movzx eax, al
+          compile((*args)[0]);
+          as.bytes(0x85, 0xC0);
+          as.bytes(0x0F, 0x90 | CC_E, 0xC0);
+          as.bytes(0x0F, 0xB6, 0xC0);
+          return;
+     }
+     if(CallExp->builtin != NULL)
+     {
+          reject();
+          return;
+     }
+
+     int entryIndex = jit->Reference(CallExp->function);
+     if(entryIndex < 0)
+     {
+          reject();
+          return;
+     }
+
+     for(int i = 0; i < args->size(); i++)
+     {
+          compile((*args)[i]);
+          push();
+     }
+
+     //Pop the arguments back off into rdi, rsi, rdx, rcx, r8, r9
+     static const int argumentPops[6][2] = {
+          {0x00, 0x5F}, {0x00, 0x5E}, {0x00, 0x5A}, {0x00, 0x59}, {0x41, 0x58}, {0x41, 0x59}
+     };
+     for(int i = args->size()-1; i >= 0; i--)
+     {
+          if(argumentPops[i][0] != 0)
+               as.byte(argumentPops[i][0]);
+          as.byte(argumentPops[i][1]);
+          depth--;
+     }
+
+     //A tail call leaves this function's frame and jumps to the callee, which
+     // returns straight to our caller: mov rax, &entries[i]; leave; jmp [rax]
+     if(CallExp->tail)
+     {
+          as.bytes(0x48, 0xB8);
+          as.int64((intptr_t)&(jit->entries[entryIndex]));
+          as.byte(0xC9);
+          as.bytes(0xFF, 0x20);
+          return;
+     }
+
+     //Call through the entry table: mov rax, &entries[i]; call [rax]
+     if(depth % 2 != 0)
+          as.addStack(-8);
+     as.bytes(0x48, 0xB8);
+     as.int64((intptr_t)&(jit->entries[entryIndex]));
+     as.bytes(0xFF, 0x10);
+     if(depth % 2 != 0)
+          as.addStack(8);
+}
+void nodeMethodJIT::visitIntLit(NIntLit* intLit)
+{
+     as.byte(0xB8);
+     as.int32(intLit->val);
+}
+void nodeMethodJIT::visitStrLit(NStrLit* strLit)
+{
+     reject();
+}
+void nodeMethodJIT::visitInfixExp(infixExp* InfixExp)
+{
+     if(!isIntType(InfixExp->leftNode->type) || !isIntType(InfixExp->rightNode->type))
+     {
+          reject();
+          return;
+     }
+
+     //Short circuit operators only evaluate the right side when they have to
+     if(InfixExp->op == OP_AND || InfixExp->op == OP_OR)
+     {
+          compile(InfixExp->leftNode);
+          as.bytes(0x85, 0xC0);
+          int shortJump = as.jumpIf(0x80 | (InfixExp->op == OP_AND ? CC_E : CC_NE));
+          compile(InfixExp->rightNode);
+          as.bytes(0x85, 0xC0);
+          as.bytes(0x0F, 0x90 | CC_NE, 0xC0);
+          as.bytes(0x0F, 0xB6, 0xC0);
+          int endJump = as.jump();
+          as.patch(shortJump);
+          as.byte(0xB8);
+          as.int32(InfixExp->op == OP_AND ? 0 : 1);
+          as.patch(endJump);
+          return;
+     }
+
+     //Expressions of nothing but literals are worked out now
+     int folded;
+     if(constantValue(InfixExp, folded))
+     {
+          as.byte(0xB8);
+          as.int32(folded);
+          return;
+     }
+
+     compileOperands(InfixExp);
+     int condition = -1;
+     switch(InfixExp->op)
+     {
+          case OP_ADD:
+               as.bytes(0x01, 0xC8);
+               break;
+          case OP_SUBTRACT:
+               as.bytes(0x29, 0xC8);
+               break;
+          case OP_MULTIPLY:
+               as.bytes(0x0F, 0xAF, 0xC1);
+               break;
+          case OP_DIVIDE:
+          {
+               //Division by zero is an error, and INT_MIN / -1 would trap
+               as.bytes(0x85, 0xC9);
+               int nonZero = as.jumpIf(0x80 | CC_NE);
+               as.byte(0xBF);
+               as.int32(InfixExp->lineNumber);
+               callHelper((void*)jitDivisionByZero);
+               as.patch(nonZero);
+               as.bytes(0x83, 0xF9, 0xFF);
+               int normal = as.jumpIf(0x80 | CC_NE);
+               as.bytes(0xF7, 0xD8);
+               int end = as.jump();
+               as.patch(normal);
+               as.byte(0x99);
+               as.bytes(0xF7, 0xF9);
+               as.patch(end);
+               break;
+          }
+          default:
+               condition = conditionCode(InfixExp->op);
+               break;
+     }
+
+     //cmp eax, ecx; setcc al; movzx eax, al
+     if(condition >= 0)
+     {
+          as.bytes(0x39, 0xC8);
+          as.bytes(0x0F, 0x90 | condition, 0xC0);
+          as.bytes(0x0F, 0xB6, 0xC0);
+     }
+}
+void nodeMethodJIT::visitArrCreate(arrCreate* ArrCreate)
+{
+     reject();
+}
+void nodeMethodJIT::visitRecCreate(recCreate* RecCreate)
+{
+     reject();
+}
+void nodeMethodJIT::visitFieldCreate(fieldCreate* FieldCreate)
+{
+     reject();
+}
+void nodeMethodJIT::visitAssignment(assignment* Assign)
+{
+     if(dynamic_cast<NId*>(Assign->lVal) == NULL)
+     {
+          reject();
+          return;
+     }
+     int slot = lookup(((NId*)(Assign->lVal))->name);
+     if(slot < 0)
+     {
+          reject();
+          return;
+     }
+     compile(Assign->exp);
+     as.storeSlot(slot);
+}
+void nodeMethodJIT::visitIfThenElse(ifThenElse* iTE)
+{
+     compile(iTE->ifExp);
+     as.bytes(0x85, 0xC0);
+     int elseJump = as.jumpIf(0x80 | CC_E);
+     compile(iTE->thenExp);
+     if(iTE->elseExp == NULL)
+     {
+          as.patch(elseJump);
+          return;
+     }
+     int endJump = as.jump();
+     as.patch(elseJump);
+     compile(iTE->elseExp);
+     as.patch(endJump);
+}
+void nodeMethodJIT::visitWhileExp(whileExp* While)
+{
+     JITLoop loop;
+     loop.depth = depth;
+     loops.push_back(loop);
+
+     int top = as.here();
+     compile(While->condition);
+     as.bytes(0x85, 0xC0);
+     int exitJump = as.jumpIf(0x80 | CC_E);
+     compile(While->action);
+     as.patchTo(as.jump(), top);
+     as.patch(exitJump);
+
+     for(int i = 0; i < loops.back().breakJumps.size(); i++)
+          as.patch(loops.back().breakJumps[i]);
+     loops.pop_back();
+}
+void nodeMethodJIT::visitForExp(forExp* forEx)
+{
+     //The loop variable and the limit get their own slots in a new scope
+     int savedSlot = nextSlot;
+     int varSlot = allocateSlot();
+     int limitSlot = allocateSlot();
+     compile(forEx->assign);
+     as.storeSlot(varSlot);
+     compile(forEx->condition);
+     as.storeSlot(limitSlot);
+
+     map<Atom, int> forScope;
+     forScope[((NId*)(forEx->id))->name] = varSlot;
+     scopes.push_back(forScope);
+     JITLoop loop;
+     loop.depth = depth;
+     loops.push_back(loop);
+
+     //Skip the loop entirely if it starts past the limit: cmp eax, [limit]; jg exit
+     as.loadSlot(varSlot);
+     as.bytes(0x3B, 0x85);
+     as.int32(-8 * (limitSlot + 1));
+     int skipJump = as.jumpIf(0x80 | CC_G);
+
+     //Test against the limit before bumping so the variable never overflows
+     int top = as.here();
+     compile(forEx->action);
+     as.loadSlot(varSlot);
+     as.bytes(0x3B, 0x85);
+     as.int32(-8 * (limitSlot + 1));
+     int exitJump = as.jumpIf(0x80 | CC_GE);
+     as.bytes(0xFF, 0x85);
+     as.int32(-8 * (varSlot + 1));
+     as.patchTo(as.jump(), top);
+     as.patch(skipJump);
+     as.patch(exitJump);
+
+     for(int i = 0; i < loops.back().breakJumps.size(); i++)
+          as.patch(loops.back().breakJumps[i]);
+     loops.pop_back();
+     scopes.pop_back();
+     nextSlot = savedSlot;
+}
+void nodeMethodJIT::visitLetExp(letExp* LetExp)
+{
+     map<Atom, int> letScope;
+     scopes.push_back(letScope);
+     int savedSlot = nextSlot;
+
+     for(int i = 0; i < LetExp->decs->size(); i++)
+          compile((*(LetExp->decs))[i]);
+
+     if(LetExp->exps->size() == 0)
+     {
+          as.byte(0xB8);
+          as.int32(0);
+     }
+     for(int i = 0; i < LetExp->exps->size(); i++)
+          compile((*(LetExp->exps))[i]);
+
+     scopes.pop_back();
+     nextSlot = savedSlot;
+}
+void nodeMethodJIT::visitDec(decc* Dec)
+{
+     reject();
+}
+void nodeMethodJIT::visitTyDec(tyDec* TyDec)
+{
+     //Types only matter to semantic analysis
+}
+void nodeMethodJIT::visitTyDef(tyDef* TyDef)
+{
+     reject();
+}
+void nodeMethodJIT::visitRefTy(refTy* RefTy)
+{
+     reject();
+}
+void nodeMethodJIT::visitArrTy(arrTy* ArrTy)
+{
+     reject();
+}
+void nodeMethodJIT::visitRecTy(recTy* RecTy)
+{
+     reject();
+}
+void nodeMethodJIT::visitFieldDec(fieldDec* FieldDec)
+{
+     reject();
+}
+void nodeMethodJIT::visitFunDec(funDec* FunDec)
+{
+     //Nested functions would need the enclosing frame
+     reject();
+}
+void nodeMethodJIT::visitVarDec(varDec* VarDec)
+{
+     if(!isIntType(VarDec->id->type))
+     {
+          reject();
+          return;
+     }
+     compile(VarDec->exp);
+
+     //The name only comes into scope after its initializer
+     int slot = allocateSlot();
+     as.storeSlot(slot);
+     scopes.back()[((NId*)(VarDec->id))->name] = slot;
+}
+
+/*********************
+ * METHOD JIT
+ * *******************/
+
+MethodJIT::MethodJIT():entryCount(0)
+{
+     entries = new void*[JIT_MAX_FUNCTIONS];
+
+#ifdef JIT_SUPPORTED
+     //Leave a margin of the native stack for the interpreter and helpers
+     char marker;
+     size_t budget = 6 << 20;
+     struct rlimit limit;
+     if(getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+          budget = limit.rlim_cur - (limit.rlim_cur / 4);
+     jitStackLimit = (uintptr_t)&marker - budget;
+#endif
+}
+
+MethodJIT::~MethodJIT()
+{
+     delete[] entries;
+}
+
+JITFunction* MethodJIT::Declare(funDec* FunDec)
+{
+     map<funDec*, JITFunction>::iterator itr = functions.find(FunDec);
+     if(itr == functions.end())
+     {
+          JITFunction function = {FunDec, 0, JIT_UNTRIED, -1};
+          itr = functions.insert(pair<funDec*, JITFunction>(FunDec, function)).first;
+     }
+     return &(itr->second);
+}
+
+JITEntry MethodJIT::Lookup(funDec* FunDec)
+{
+#ifdef JIT_SUPPORTED
+     JITFunction& function = *Declare(FunDec);
+     if(function.state == JIT_COMPILED)
+          return (JITEntry)entries[function.entryIndex];
+     if(function.state == JIT_REJECTED || ++function.calls < JIT_HOT_CALLS)
+          return NULL;
+     if(compileGroup(&function))
+          return (JITEntry)entries[function.entryIndex];
+#endif
+     return NULL;
+}
+
+int MethodJIT::Reference(funDec* FunDec)
+{
+     JITFunction& function = *Declare(FunDec);
+     if(function.state == JIT_REJECTED)
+          return -1;
+
+     if(function.entryIndex < 0)
+     {
+          if(entryCount >= JIT_MAX_FUNCTIONS)
+               return -1;
+          function.entryIndex = entryCount++;
+     }
+     if(function.state == JIT_UNTRIED)
+     {
+          function.state = JIT_PENDING;
+          pending.push_back(&function);
+     }
+     return function.entryIndex;
+}
+
+bool MethodJIT::compileGroup(JITFunction* function)
+{
+     //Callees are queued as they're referenced, so this compiles everything the
+     // function can reach before any of it runs
+     pending.clear();
+     if(Reference(function->FunDec) < 0)
+     {
+          function->state = JIT_REJECTED;
+          return false;
+     }
+
+     bool compiled = true;
+     for(int i = 0; i < pending.size() && compiled; i++)
+     {
+          nodeMethodJIT generator(this);
+          compiled = generator.compileFunction(pending[i]->FunDec);
+          if(compiled)
+          {
+               void* address = heap.Install(generator.as.code);
+               compiled = address != NULL;
+               entries[pending[i]->entryIndex] = address;
+          }
+     }
+
+     //One unsupported function sinks the whole group, but only the function
+     // that got hot is given up on; the rest can try again on their own
+     for(int i = 0; i < pending.size(); i++)
+          pending[i]->state = compiled ? JIT_COMPILED : JIT_UNTRIED;
+     if(!compiled)
+          function->state = JIT_REJECTED;
+     pending.clear();
+     return compiled;
+}
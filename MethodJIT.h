@@ -0,0 +1,483 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      MethodJIT.h
+     Purpose:       Compiles hot integer-only Tiger functions to native x86-64
+                    code so the tree-walking interpreter can call them directly.
+
+*/
+
+/** @defgroup JIT Method JIT
+ *  Native code for integer-only functions.
+ *  @{
+ */
+
+#ifndef METHOD_JIT
+#define METHOD_JIT
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include "ast.h"
+#include "SymbolTable.h"
+
+using namespace std;
+
+//Only x86-64 with System V calling conventions is supported; everywhere else
+// every function simply stays in the interpreter
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define JIT_SUPPORTED
+#endif
+
+//Number of calls before a function is compiled
+#define JIT_HOT_CALLS 2
+
+//Most functions that can ever be compiled
+#define JIT_MAX_FUNCTIONS 4096
+
+//x86 condition codes, as used by jcc (0x80 | cc) and setcc (0x90 | cc);
+// flipping the low bit negates a condition
+#define CC_E  0x4
+#define CC_NE 0x5
+#define CC_L  0xC
+#define CC_GE 0xD
+#define CC_LE 0xE
+#define CC_G  0xF
+
+/**
+ * @brief A compiled function. Unused trailing arguments are ignored.
+ *
+ */
+typedef int (*JITEntry)(int, int, int, int, int, int);
+
+/**
+ * @brief Where a function stands with the JIT.
+ *
+ */
+enum JITState
+{
+     JIT_UNTRIED,   //Still running in the interpreter
+     JIT_PENDING,   //Being compiled along with a function that calls it
+     JIT_COMPILED,  //Has native code
+     JIT_REJECTED   //Uses something the JIT can't handle
+};
+
+/**
+ * @brief Everything the JIT tracks for a single function.
+ *
+ */
+class JITFunction
+{
+     public:
+          /**
+           * @brief The function's declaration.
+           *
+           */
+          funDec* FunDec;
+
+          /**
+           * @brief Calls made through the interpreter so far.
+           *
+           */
+          int calls;
+
+          /**
+           * @brief Where the function stands with the JIT.
+           *
+           */
+          JITState state;
+
+          /**
+           * @brief Index of the function's slot in the entry table, or -1.
+           *
+           */
+          int entryIndex;
+};
+
+/**
+ * @brief Emits x86-64 machine code into a growable buffer.
+ *
+ */
+class X86Assembler
+{
+     public:
+          /**
+           * @brief Appends raw bytes and little-endian immediates.
+           *
+           */
+          void byte(int b);
+          void bytes(int b1, int b2);
+          void bytes(int b1, int b2, int b3);
+          void int32(int value);
+          void int64(intptr_t value);
+
+          /**
+           * @brief Emits a jmp, or a jcc on an x86 condition code (0x80 | cc), with a
+           * 32-bit displacement to be patched later.
+           *
+           * @return int Position of the displacement, for patching.
+           */
+          int jump();
+          int jumpIf(int condition);
+
+          /**
+           * @brief Points a jump displacement at the current position.
+           *
+           * @param position Position returned by jump() or jumpIf().
+           */
+          void patch(int position);
+
+          /**
+           * @brief Points a jump displacement at an earlier position.
+           *
+           */
+          void patchTo(int position, int target);
+
+          /**
+           * @brief Current end of the code.
+           *
+           */
+          int here();
+
+          /**
+           * @brief Loads or stores eax from a frame slot.
+           *
+           */
+          void loadSlot(int slot);
+          void storeSlot(int slot);
+
+          /**
+           * @brief Adds to rsp (add rsp, imm32); negative to make room.
+           *
+           */
+          void addStack(int amount);
+
+          /**
+           * @brief Calls an absolute address, through rax.
+           *
+           */
+          void callAbsolute(void* target);
+
+          /**
+           * @brief The machine code.
+           *
+           */
+          vector<unsigned char> code;
+};
+
+/**
+ * @brief A loop being compiled, for breaks to leave.
+ *
+ */
+class JITLoop
+{
+     public:
+          /**
+           * @brief Values pushed on the native stack when the loop started.
+           *
+           */
+          int depth;
+
+          /**
+           * @brief Jumps to patch to the loop's exit.
+           *
+           */
+          vector<int> breakJumps;
+};
+
+/**
+ * @brief Executable memory that finished machine code is copied into.
+ *
+ */
+class CodeHeap
+{
+     public:
+          /**
+           * @brief Construct an empty heap; memory is mapped on first use.
+           *
+           */
+          CodeHeap();
+
+          /**
+           * @brief Unmap all executable memory.
+           *
+           */
+          ~CodeHeap();
+
+          /**
+           * @brief Copies finished machine code into executable memory.
+           *
+           * @return void* Where the code now lives, or NULL if memory ran out.
+           */
+          void* Install(const vector<unsigned char> &code);
+
+          /**
+           * @brief Executable memory blocks.
+           *
+           */
+          vector< pair<unsigned char*, size_t> > blocks;
+
+          /**
+           * @brief Bytes used in the newest block.
+           *
+           */
+          size_t blockUsed;
+};
+
+class MethodJIT;
+
+/**
+ * @brief A node visitor that emits native code for a function body, giving up
+ * as soon as it reaches anything it doesn't support.
+ *
+ */
+class nodeMethodJIT : public nodeVisitor
+{
+     public:
+          /**
+           * @brief Construct a new code generator for one function.
+           *
+           * @param jit The JIT that owns the function, used to resolve calls.
+           */
+          nodeMethodJIT(MethodJIT* jit);
+
+          /**
+           * @brief Generates the whole function.
+           *
+           * @param FunDec The function to compile.
+           * @return true If every part of the function was supported.
+           */
+          bool compileFunction(funDec* FunDec);
+
+          /**
+           * @brief Generates code that leaves an expression's value in eax.
+           *
+           */
+          void compile(node* Node);
+
+          /**
+           * @brief Whether a type is int.
+           *
+           */
+          bool isIntType(Type* type);
+
+          /**
+           * @brief Generates the operands of a binary operator, leaving the left
+           * in eax and the right in ecx.
+           *
+           */
+          void compileOperands(infixExp* InfixExp);
+
+          /**
+           * @brief The x86 condition code that matches a comparison operator.
+           *
+           */
+          int conditionCode(int op);
+
+          /**
+           * @brief Works out an expression made only of integer literals.
+           *
+           * @param Node The expression.
+           * @param result Set to its value.
+           * @return true If the expression is constant.
+           */
+          bool constantValue(node* Node, int &result);
+
+          /**
+           * @brief Gives up on the function.
+           *
+           */
+          void reject();
+
+          /**
+           * @brief Pushes or pops rax, keeping count so calls stay aligned.
+           *
+           */
+          void push();
+          void pop();
+
+          /**
+           * @brief Calls a helper, with the stack aligned the way the ABI wants.
+           *
+           */
+          void callHelper(void* target);
+
+          /**
+           * @brief Reserves a new slot in the frame.
+           *
+           */
+          int allocateSlot();
+
+          /**
+           * @brief Finds the slot of a parameter or local, or -1.
+           *
+           */
+          int lookup(Atom name);
+
+          //Visitor functions
+          void visitProgram(program* prog) override;
+          void visitBreak(NBreak* Break) override;
+          void visitNil(NNil* Nil) override;
+          void visitID(NId* id) override;
+          void visitTyID(NTyId* tyid) override;
+          void visitSubscript(subscript* Subscript) override;
+          void visitFieldExp(fieldExp* FieldExp) override;
+          void visitSeqExp(seqExp*) override;
+          void visitNegation(negation*) override;
+          void visitCallExp(callExp*) override;
+          void visitIntLit(NIntLit*) override;
+          void visitStrLit(NStrLit*) override;
+          void visitInfixExp(infixExp*) override;
+          void visitArrCreate(arrCreate*) override;
+          void visitRecCreate(recCreate*) override;
+          void visitFieldCreate(fieldCreate*) override;
+          void visitAssignment(assignment*) override;
+          void visitIfThenElse(ifThenElse*) override;
+          void visitWhileExp(whileExp*) override;
+          void visitForExp(forExp*) override;
+          void visitLetExp(letExp*) override;
+          void visitDec(decc*) override;
+          void visitTyDec(tyDec*) override;
+          void visitTyDef(tyDef*) override;
+          void visitRefTy(refTy*) override;
+          void visitArrTy(arrTy*) override;
+          void visitRecTy(recTy*) override;
+          void visitFieldDec(fieldDec*) override;
+          void visitFunDec(funDec*) override;
+          void visitVarDec(varDec*) override;
+
+          /**
+           * @brief The JIT the function belongs to.
+           *
+           */
+          MethodJIT* jit;
+
+          /**
+           * @brief The function's code.
+           *
+           */
+          X86Assembler as;
+
+          /**
+           * @brief False once anything unsupported has been seen.
+           *
+           */
+          bool supported;
+
+          /**
+           * @brief Values currently pushed on the native stack.
+           *
+           */
+          int depth;
+
+          /**
+           * @brief Slots used by the frame so far.
+           *
+           */
+          int frameSlots;
+
+          /**
+           * @brief Next free slot.
+           *
+           */
+          int nextSlot;
+
+          /**
+           * @brief Parameters and locals in scope, innermost last.
+           *
+           */
+          vector< map<Atom, int> > scopes;
+
+          /**
+           * @brief Loops being compiled, innermost last.
+           *
+           */
+          vector<JITLoop> loops;
+};
+
+/**
+ * @brief Compiles integer-only functions once they get hot, and hands their
+ * native code back to the interpreter.
+ *
+ */
+class MethodJIT
+{
+     public:
+          /**
+           * @brief Construct a new JIT with no executable memory yet.
+           *
+           */
+          MethodJIT();
+
+          /**
+           * @brief Release the entry table.
+           *
+           */
+          ~MethodJIT();
+
+          /**
+           * @brief Finds what the JIT knows about a function, making it known the
+           * first time it's asked about.
+           *
+           * @param FunDec The function's declaration.
+           */
+          JITFunction* Declare(funDec* FunDec);
+
+          /**
+           * @brief Counts a call, compiling the function if it just got hot.
+           *
+           * @param FunDec The function being called, as bound by semantic analysis.
+           * @return JITEntry The function's native code, or NULL to interpret it.
+           */
+          JITEntry Lookup(funDec* FunDec);
+
+          /**
+           * @brief Finds the function a call inside compiled code refers to,
+           * queuing it to be compiled along with its caller.
+           *
+           * @param FunDec The callee, as bound by semantic analysis.
+           * @return int Index of the callee's entry slot, or -1 if it can't be compiled.
+           */
+          int Reference(funDec* FunDec);
+
+          /**
+           * @brief Compiles a function and everything it calls.
+           *
+           * @param function The function to compile.
+           * @return true If all of them compiled.
+           */
+          bool compileGroup(JITFunction* function);
+
+          /**
+           * @brief Functions by declaration.
+           *
+           */
+          map<funDec*, JITFunction> functions;
+
+          /**
+           * @brief Functions waiting to be compiled with the current group.
+           *
+           */
+          vector<JITFunction*> pending;
+
+          /**
+           * @brief Native entry point of every compiled function. Compiled code calls
+           * through this table so callees can be filled in after their callers.
+           *
+           */
+          void** entries;
+
+          /**
+           * @brief Number of entry slots handed out.
+           *
+           */
+          int entryCount;
+
+          /**
+           * @brief Where compiled functions live.
+           *
+           */
+          CodeHeap heap;
+};
+/** @} */
+#endif
@@ -0,0 +1,183 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "Output.h"
+
+using namespace std;
+
+OutputBuffer* output = NULL;
+
+//Two characters for every number from 00 to 99, so integers are converted two digits at a time
+static const char digitPairs[] =
+     "0001020304050607080910111213141516171819"
+     "2021222324252627282930313233343536373839"
+     "4041424344454647484950515253545556575859"
+     "6061626364656667686970717273747576777879"
+     "8081828384858687888990919293949596979899";
+
+/*********************
+ * OUTPUT BUFFER
+ * *******************/
+
+OutputBuffer::OutputBuffer(int fd, OutputMode mode):fd(fd), mode(mode), failed(false)
+{
+     setp(buffer, buffer + OUTPUT_BUFFER_SIZE);
+}
+
+OutputBuffer::~OutputBuffer()
+{
+     Flush();
+}
+
+void OutputBuffer::Write(const char* chars, size_t length)
+{
+     if(length <= (size_t)(epptr() - pptr()))
+     {
+          memcpy(pptr(), chars, length);
+          pbump(length);
+          return;
+     }
+
+     //Doesn't fit, so the buffer has to go out first; writev sends both at once
+     if(mode == OUTPUT_WRITEV)
+     {
+          writeOut(chars, length);
+          return;
+     }
+     writeOut(NULL, 0);
+     if(length >= OUTPUT_BUFFER_SIZE)
+          writeOut(chars, length);
+     else
+     {
+          memcpy(pptr(), chars, length);
+          pbump(length);
+     }
+}
+
+void OutputBuffer::WriteInt(int value)
+{
+     //Ten digits and a sign at most
+     if(epptr() - pptr() < 11)
+          writeOut(NULL, 0);
+
+     char digits[11];
+     char* end = digits + sizeof(digits);
+     char* first = end;
+     unsigned int magnitude = (value < 0) ? 0u - (unsigned int)value : (unsigned int)value;
+     while(magnitude >= 100)
+     {
+          const char* pair = digitPairs + (magnitude % 100) * 2;
+          magnitude /= 100;
+          *--first = pair[1];
+          *--first = pair[0];
+     }
+     if(magnitude >= 10)
+     {
+          const char* pair = digitPairs + magnitude * 2;
+          *--first = pair[1];
+          *--first = pair[0];
+     }
+     else
+          *--first = (char)('0' + magnitude);
+     if(value < 0)
+          *--first = '-';
+
+     memcpy(pptr(), first, end - first);
+     pbump(end - first);
+}
+
+void OutputBuffer::Flush()
+{
+     writeOut(NULL, 0);
+}
+
+int OutputBuffer::overflow(int c)
+{
+     if(c == EOF)
+          return 0;
+     if(pptr() == epptr())
+          writeOut(NULL, 0);
+     *pptr() = (char)c;
+     pbump(1);
+     return c;
+}
+
+streamsize OutputBuffer::xsputn(const char* s, streamsize n)
+{
+     Write(s, n);
+     return n;
+}
+
+int OutputBuffer::sync()
+{
+     writeOut(NULL, 0);
+     return 0;
+}
+
+void OutputBuffer::writeOut(const char* chars, size_t length)
+{
+     struct iovec pieces[2];
+     int count = 0;
+     if(pptr() > pbase())
+     {
+          pieces[count].iov_base = pbase();
+          pieces[count].iov_len = pptr() - pbase();
+          count++;
+     }
+     if(length > 0)
+     {
+          pieces[count].iov_base = (void*)chars;
+          pieces[count].iov_len = length;
+          count++;
+     }
+     setp(buffer, buffer + OUTPUT_BUFFER_SIZE);
+
+     //The kernel may take less than everything, so carry on from wherever it stopped
+     int next = 0;
+     while(next < count && !failed)
+     {
+          ssize_t written;
+          if(count - next == 1)
+               written = write(fd, pieces[next].iov_base, pieces[next].iov_len);
+          else
+               written = writev(fd, pieces + next, count - next);
+          if(written < 0)
+          {
+               if(errno != EINTR)
+                    failed = true;
+               continue;
+          }
+          while(next < count && (size_t)written >= pieces[next].iov_len)
+          {
+               written -= pieces[next].iov_len;
+               next++;
+          }
+          if(next < count)
+          {
+               pieces[next].iov_base = (char*)pieces[next].iov_base + written;
+               pieces[next].iov_len -= written;
+          }
+     }
+}
+
+/*********************
+ * INSTALLATION
+ * *******************/
+
+static streambuf* originalOutput = NULL;
+
+static void flushOutputAtExit()
+{
+     //Give std::cout its own buffer back, so nothing uses this one once it's gone
+     output->Flush();
+     cout.rdbuf(originalOutput);
+}
+
+void InstallOutput(OutputMode mode)
+{
+     output = new OutputBuffer(STDOUT_FILENO, mode);
+     originalOutput = cout.rdbuf(output);
+     atexit(flushOutputAtExit);
+}
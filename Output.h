@@ -0,0 +1,146 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      Output.h
+     Purpose:       Buffers everything the program writes to standard output in
+                    one large block and hands it to the kernel only when it is
+                    full, when the program flushes, reads input or exits.
+
+*/
+
+/** @defgroup OUTPUT Output
+ *  Buffered standard output for print and printi.
+ *  @{
+ */
+
+#ifndef OUTPUT
+#define OUTPUT
+
+#include <streambuf>
+#include <iostream>
+
+using namespace std;
+
+//Bytes of output held before they are written out
+#define OUTPUT_BUFFER_SIZE (256 * 1024)
+
+/**
+ * @brief How the buffer is handed to the kernel when a write doesn't fit in it.
+ *
+ */
+enum OutputMode
+{
+     /**
+      * @brief Write out what's buffered, then copy the new output in, or write it
+      * straight out if it's larger than the buffer.
+      *
+      */
+     OUTPUT_WRITE,
+
+     /**
+      * @brief Write out what's buffered and the new output together with one
+      * writev() call, never copying the new output.
+      *
+      */
+     OUTPUT_WRITEV
+};
+
+/**
+ * @brief A large buffer in front of a file descriptor. std::cout is pointed at
+ * it so errors and everything else come out in order with print and printi,
+ * which write to it directly instead of going through iostream formatting.
+ *
+ */
+class OutputBuffer : public streambuf
+{
+     public:
+          /**
+           * @brief Construct a new, empty buffer.
+           *
+           * @param fd File descriptor to write to.
+           * @param mode How to write output that doesn't fit.
+           */
+          OutputBuffer(int fd, OutputMode mode);
+
+          /**
+           * @brief Writes out anything still buffered.
+           *
+           */
+          ~OutputBuffer();
+
+          /**
+           * @brief Adds characters to the output.
+           *
+           * @param chars The first character.
+           * @param length Number of characters.
+           */
+          void Write(const char* chars, size_t length);
+
+          /**
+           * @brief Adds an integer to the output in decimal.
+           *
+           * @param value The integer.
+           */
+          void WriteInt(int value);
+
+          /**
+           * @brief Hands everything buffered to the kernel.
+           *
+           */
+          void Flush();
+
+     protected:
+          //Stream buffer functions, used by std::cout
+          int overflow(int c) override;
+          streamsize xsputn(const char* s, streamsize n) override;
+          int sync() override;
+
+     private:
+          /**
+           * @brief Writes out what's buffered followed by more output, retrying
+           * until the kernel has taken all of it.
+           *
+           * @param chars More output to write after the buffer, or NULL.
+           * @param length Number of characters of more output.
+           */
+          void writeOut(const char* chars, size_t length);
+
+          /**
+           * @brief File descriptor to write to.
+           *
+           */
+          int fd;
+
+          /**
+           * @brief How to write output that doesn't fit.
+           *
+           */
+          OutputMode mode;
+
+          /**
+           * @brief Set once a write fails, after which output is thrown away.
+           *
+           */
+          bool failed;
+
+          /**
+           * @brief The buffer itself.
+           *
+           */
+          char buffer[OUTPUT_BUFFER_SIZE];
+};
+
+/**
+ * @brief The buffer in front of standard output, or NULL until it is installed.
+ *
+ */
+extern OutputBuffer* output;
+
+/**
+ * @brief Makes the standard output buffer, points std::cout at it and has it
+ * written out when the program exits.
+ *
+ * @param mode How to write output that doesn't fit.
+ */
+void InstallOutput(OutputMode mode);
+/** @} */
+#endif
@@ -41,7 +41,9 @@ void nodeSAChecker::throwError(const int &lineNumber,const string &errorMessage)
 
 bool nodeSAChecker::isArrayType(Type* type)
 {
-     if(type->GetActualKind() == T_ARR)
+     //Declaring an array of an alias rewrites the kind of the builtin type at the
+     // bottom of it, so int can read as T_ARR; look at what the type really is
+     if(dynamic_cast<ArrType*>(resolveAliases(type)) != NULL)
           return true;
      else
           return false;
@@ -49,15 +51,12 @@ bool nodeSAChecker::isArrayType(Type* type)
 
 bool nodeSAChecker::isArray(node* Node)
 {
-     if(Node->type->GetActualKind() == T_ARR)
-          return true;
-     else
-          return false;
+     return isArrayType(Node->type);
 }
 
 bool nodeSAChecker::isInteger(node* Node)
 {
-     if(Node->type->GetActualType()->name == "int")
+     if(Node->type->GetActualType()->name == ATOM_INT)
           return true;
      else
           return false;
@@ -65,7 +64,7 @@ bool nodeSAChecker::isInteger(node* Node)
 
 bool nodeSAChecker::isUnit(node* Node)
 {
-     if(Node->type->GetActualType()->name == "unit")
+     if(Node->type->GetActualType()->name == ATOM_UNIT)
           return true;
      else
           return false;
@@ -79,6 +78,15 @@ bool nodeSAChecker::isRecordType(Type* type)
           return false;
 }
 
+Type* nodeSAChecker::resolveAliases(Type* type)
+{
+     //Aliasing an alias of int or string marks the builtin type itself T_REF,
+     // so kind alone can't tell which types really have a ref to follow
+     while(dynamic_cast<RefType*>(type) != NULL)
+          type = ((RefType*)type)->ref;
+     return type;
+}
+
 bool nodeSAChecker::isRecord(node* Node)
 {
      if(Node->type->GetActualKind() == T_REC)
@@ -97,8 +105,8 @@ bool nodeSAChecker::sameType(node* left, node* right)
 
 bool nodeSAChecker::legalArguments(FuncSymbol* func, callExp* CallExp)
 {
-     vector< pair<string,Type*> > args = func->args;
-     vector<node*>* calledArgs =  CallExp->exps; 
+     vector< pair<Atom,Type*> > args = func->args;
+     NodeList* calledArgs =  CallExp->exps; 
 
      //For every argument, see if we can find a matching type entry for them  
      for(int i = 0; i < args.size(); i++)
@@ -107,8 +115,8 @@ bool nodeSAChecker::legalArguments(FuncSymbol* func, callExp* CallExp)
           //cout << "Passed argument type name: " << (*calledArgs)[i]->type->name << endl;
           if(!(args[i].second->GetActualType()->name == (*calledArgs)[i]->type->GetActualType()->name))
           {
-               throwError(CallExp->lineNumber, "Function argument type mismatch for function '" + func->name + ". Positional argument " + to_string(i) + " expecting type '" + args[i].second->name 
-               + "' but received type '" + (*calledArgs)[i]->type->name + "'.");
+               throwError(CallExp->lineNumber, "Function argument type mismatch for function '" + *func->name + ". Positional argument " + to_string(i) + " expecting type '" + *args[i].second->name 
+               + "' but received type '" + *(*calledArgs)[i]->type->name + "'.");
           }
      }
 
@@ -117,7 +125,7 @@ bool nodeSAChecker::legalArguments(FuncSymbol* func, callExp* CallExp)
 
 bool nodeSAChecker::isAssignableTo(node* Node, Type* type)
 {
-     Type* unitType = table.LookupType("unit");
+     Type* unitType = table.LookupType(ATOM_UNIT);
      switch(Node->type->kind)
      {
           case T_REF:
@@ -142,6 +150,38 @@ bool nodeSAChecker::isAssignableTo(node* Node, Type* type)
           return false;
 }
 
+void nodeSAChecker::markTailCalls(node* Node, int lets)
+{
+     if(dynamic_cast<callExp*>(Node) != NULL)
+     {
+          //Builtins have no frame to take over, and a function declared in one of
+          // the lets would lose its frame when the let is left
+          callExp* CallExp = (callExp*)Node;
+          NId* id = (NId*)(CallExp->id);
+          if(CallExp->function != NULL && id->depth >= lets)
+               CallExp->tail = true;
+     }
+     else if(dynamic_cast<ifThenElse*>(Node) != NULL)
+     {
+          ifThenElse* iTE = (ifThenElse*)Node;
+          markTailCalls(iTE->thenExp, lets);
+          if(iTE->elseExp != NULL)
+               markTailCalls(iTE->elseExp, lets);
+     }
+     else if(dynamic_cast<seqExp*>(Node) != NULL)
+     {
+          seqExp* SeqExp = (seqExp*)Node;
+          if(SeqExp->exps->size() != 0)
+               markTailCalls(SeqExp->exps->back(), lets);
+     }
+     else if(dynamic_cast<letExp*>(Node) != NULL)
+     {
+          letExp* LetExp = (letExp*)Node;
+          if(LetExp->exps->size() != 0)
+               markTailCalls(LetExp->exps->back(), lets + 1);
+     }
+}
+
 /*************
  * visits
  * **********/
@@ -152,30 +192,38 @@ void nodeSAChecker::visitProgram(program* Program)
 }
 void nodeSAChecker::visitBreak(NBreak* Break)
 {
-     Scope* scope = table.PopScope();
-     //If there was no scope at all or the current scope source was a let or function...
-     if(scope == NULL || (scope->source == S_LET || scope->source == S_FUNC))
+     //Walk outwards until we hit a loop; lets are see-through, but a function
+     // body (or running out of scopes) means there's no loop to break out of
+     Scope* scope = table.top;
+     while(scope != NULL && scope->source == S_LET)
+          scope = scope->last;
+     if(scope == NULL || scope->source == S_FUNC)
      {
           throwError(Break->lineNumber, "'Break' called outside of WHILE or FOR expression.");
      }
 
-     Break->type = table.LookupType("unit");
+     Break->type = table.LookupType(ATOM_UNIT);
 }
 void nodeSAChecker::visitNil(NNil* Nil)
 {
-    Nil->type = table.LookupType("unit");
+    Nil->type = table.LookupType(ATOM_UNIT);
 }
 //Only called when scope has to be verified for an ID
 void nodeSAChecker::visitID(NId* id)
 {
      //Check if it exists anywhere in the program
-     Symbol* sym = table.LookupSymbol(id->name);
+     int depth;
+     Symbol* sym = table.LookupSymbol(id->name, depth);
      if(sym == NULL)
      {
-          throwError(id->lineNumber, "No such symbol with name '" + id->name + "' found in current scope.");
+          throwError(id->lineNumber, "No such symbol with name '" + *id->name + "' found in current scope.");
      }
 
      id->type = sym->type;
+
+     //Remember where it lives so the interpreter never has to search by name
+     id->depth = depth;
+     id->slot = sym->slot;
 }
 //Only called when scope has to be verified for an ID
 void nodeSAChecker::visitTyID(NTyId* tyid)
@@ -183,14 +231,14 @@ void nodeSAChecker::visitTyID(NTyId* tyid)
      Type* ty = table.LookupType(tyid->name);
      if(ty == NULL)
      {
-          throwError(tyid->lineNumber, "No such type with name '" + tyid->name + "' found in current scope.");
+          throwError(tyid->lineNumber, "No such type with name '" + *tyid->name + "' found in current scope.");
      }
 
      tyid->type = ty;
 }
 void nodeSAChecker::visitIntLit(NIntLit* intLit)
 {
-     Type* ty = table.LookupType("int");
+     Type* ty = table.LookupType(ATOM_INT);
      if(ty == NULL)
      {
           throwError(intLit->lineNumber, "Int type missing from table?");
@@ -199,12 +247,22 @@ void nodeSAChecker::visitIntLit(NIntLit* intLit)
 }
 void nodeSAChecker::visitStrLit(NStrLit* strLit)
 {
-     Type* ty = table.LookupType("string");
+     Type* ty = table.LookupType(ATOM_STRING);
      if(ty == NULL)
      {
           throwError(strLit->lineNumber, "String type missing from table?");
      }
      strLit->type = ty;
+
+     //Literals are made once here and pooled, so evaluating one never allocates
+     map<Atom, StringObject*>::iterator pooled = literals.find(strLit->val);
+     if(pooled == literals.end())
+     {
+          StringObject* literal = new StringObject(*strLit->val);
+          literal->GetHash();
+          pooled = literals.insert(pair<Atom, StringObject*>(strLit->val, literal)).first;
+     }
+     strLit->value = Value(pooled->second);
 }
 void nodeSAChecker::visitSubscript(subscript* Subscript)
 {
@@ -214,7 +272,9 @@ void nodeSAChecker::visitSubscript(subscript* Subscript)
      check(Subscript->exp);
      if(!isInteger(Subscript->exp))
           throwError(Subscript->exp->lineNumber, "Invalid type. Subscript expression evaluate to int.");
-     Subscript->type = Subscript->lValue->type->GetActualType();
+     //An element has the type the array was declared with; GetActualType() would
+     // look through that to the innermost element of an array of arrays
+     Subscript->type = ((ArrType*) resolveAliases(Subscript->lValue->type))->ref;
 }
 void nodeSAChecker::visitFieldExp(fieldExp* FieldExp)
 {
@@ -224,16 +284,17 @@ void nodeSAChecker::visitFieldExp(fieldExp* FieldExp)
           throwError(FieldExp->lValue->lineNumber, "Cannot access member on non-record type.");
      
      //Then make sure this is even a member of that type
-     RecType* typ = (RecType*) FieldExp->lValue->type;
+     RecType* typ = (RecType*) FieldExp->lValue->type->GetActualType();
      NId* id = (NId*) FieldExp->ID;
      //If the record type actually has a member with this name...
      if(typ->hasMember(id->name))
      {
-          pair<string,Type*> result = typ->getFieldPair(id->name);
+          pair<Atom,Type*> result = typ->getFieldPair(id->name);
           FieldExp->type = result.second;
+          FieldExp->slot = typ->fieldSlot(id->name);
      }
      else
-          throwError(FieldExp->lineNumber, "Record type '" + typ->name + "' has no member named " + id->name);
+          throwError(FieldExp->lineNumber, "Record type '" + *typ->name + "' has no member named " + *id->name);
 }
 
 void nodeSAChecker::visitSeqExp(seqExp* SeqExp)
@@ -249,7 +310,7 @@ void nodeSAChecker::visitSeqExp(seqExp* SeqExp)
           SeqExp->type = (*(SeqExp->exps))[SeqExp->exps->size()-1]->type;
      }
      else
-          SeqExp->type = table.LookupType("unit");
+          SeqExp->type = table.LookupType(ATOM_UNIT);
 }
 
 void nodeSAChecker::visitNegation(negation* neg)
@@ -258,22 +319,26 @@ void nodeSAChecker::visitNegation(negation* neg)
      if(!isInteger(neg->operand))
           throwError(neg->lineNumber, "Negation operand must be of type int.");
      else
-          neg->type = table.LookupType("int");
+          neg->type = table.LookupType(ATOM_INT);
 }
 
 void nodeSAChecker::visitCallExp(callExp* CallExp)
 {
      //Verify the symbol for the function exists
-     Symbol* sym = table.LookupSymbol(((NId*) CallExp->id)->name);
+     NId* id = (NId*) CallExp->id;
+     Symbol* sym = table.LookupSymbol(id->name, id->depth);
      if(sym == NULL)
-          throwError(CallExp->lineNumber, "No function with name '" + ((NId*) CallExp->id)->name + "' found.");
+          throwError(CallExp->lineNumber, "No function with name '" + *id->name + "' found.");
      
      //Verify that it's even a function name
      if(sym->kind != SYM_FUNC)
-          throwError(CallExp->lineNumber, "'" + ((NId*) CallExp->id)->name + "' is not a function identifier.");
+          throwError(CallExp->lineNumber, "'" + *id->name + "' is not a function identifier.");
+     id->slot = sym->slot;
 
      //Make sure # of arguments match
      FuncSymbol* fsym = (FuncSymbol*) sym;
+     CallExp->function = fsym->declaration;
+     CallExp->builtin = fsym->builtin;
      if(CallExp->exps->size() != fsym->args.size())
           throwError(CallExp->lineNumber, "Incorrect number of arguments to function call. Expecting " + fsym->args.size());
      
@@ -321,7 +386,30 @@ void nodeSAChecker::visitInfixExp(infixExp* InfixExp) {
                break;
     }
 
-     InfixExp->type = table.LookupType("int");
+     //Pick the operation for these operands now, so the interpreter never has to
+     // look at their types; ints and strings compare by value, anything else by identity
+     Atom operandType = resolveAliases(InfixExp->leftNode->type)->name;
+     bool isInt = operandType == ATOM_INT;
+     bool isStr = operandType == ATOM_STRING;
+     bool ordering = InfixExp->op == OP_LT || InfixExp->op == OP_LEQ || InfixExp->op == OP_GT || InfixExp->op == OP_GEQ;
+     if(ordering && !isInt && !isStr)
+          throwError(InfixExp->lineNumber, "Only int and string operands can be ordered.");
+     switch (InfixExp->op) {
+          case OP_ADD:      InfixExp->operation = INFIX_INT_ADD; break;
+          case OP_SUBTRACT: InfixExp->operation = INFIX_INT_SUBTRACT; break;
+          case OP_MULTIPLY: InfixExp->operation = INFIX_INT_MULTIPLY; break;
+          case OP_DIVIDE:   InfixExp->operation = INFIX_INT_DIVIDE; break;
+          case OP_AND:      InfixExp->operation = INFIX_AND; break;
+          case OP_OR:       InfixExp->operation = INFIX_OR; break;
+          case OP_EQ:       InfixExp->operation = isInt ? INFIX_INT_EQ : (isStr ? INFIX_STR_EQ : INFIX_REF_EQ); break;
+          case OP_NEQ:      InfixExp->operation = isInt ? INFIX_INT_NEQ : (isStr ? INFIX_STR_NEQ : INFIX_REF_NEQ); break;
+          case OP_LT:       InfixExp->operation = isInt ? INFIX_INT_LT : INFIX_STR_LT; break;
+          case OP_LEQ:      InfixExp->operation = isInt ? INFIX_INT_LEQ : INFIX_STR_LEQ; break;
+          case OP_GT:       InfixExp->operation = isInt ? INFIX_INT_GT : INFIX_STR_GT; break;
+          case OP_GEQ:      InfixExp->operation = isInt ? INFIX_INT_GEQ : INFIX_STR_GEQ; break;
+     }
+
+     InfixExp->type = table.LookupType(ATOM_INT);
 }
 
 void nodeSAChecker::visitArrCreate(arrCreate* ArrCreate)
@@ -330,20 +418,20 @@ void nodeSAChecker::visitArrCreate(arrCreate* ArrCreate)
      check(ArrCreate->tyId);
      /*Type* ty = table.LookupType(((NTyId*) ArrCreate->tyId)->name);
      if(ty == NULL)
-          throwError(ArrCreate->lineNumber, "No type with name '" + ((NTyId*) ArrCreate->tyId)->name + "' found.");
+          throwError(ArrCreate->lineNumber, "No type with name '" + *((NTyId*) ArrCreate->tyId)->name + "' found.");
      */
      ArrCreate->type = ArrCreate->tyId->type;
 
      //Verify that the type is even an array type
      if(!isArrayType(ArrCreate->type))
-          throwError(ArrCreate->lineNumber, "Type '" + ArrCreate->type->name + "' is not an array type.");
+          throwError(ArrCreate->lineNumber, "Type '" + *ArrCreate->type->name + "' is not an array type.");
      
 
 
      //Check the size subscript
      check(ArrCreate->subscriptExp);
      if(!isInteger(ArrCreate->subscriptExp))
-          throwError(ArrCreate->lineNumber, "Subscript cannot be of type '" + ArrCreate->subscriptExp->type->name + "'; must evaluate to integer type.");
+          throwError(ArrCreate->lineNumber, "Subscript cannot be of type '" + *ArrCreate->subscriptExp->type->name + "'; must evaluate to integer type.");
      
      //Make sure the exp it fills with is okay
      check(ArrCreate->postExp);
@@ -352,6 +440,9 @@ void nodeSAChecker::visitArrCreate(arrCreate* ArrCreate)
      if(!sameType(ArrCreate->tyId, ArrCreate->postExp))
           throwError(ArrCreate->lineNumber, "Array type and initializing expression type differ.");
 
+     //Arrays of ints get their elements unboxed
+     ArrType* arrType = (ArrType*) resolveAliases(ArrCreate->type);
+     ArrCreate->ints = resolveAliases(arrType->ref)->name == ATOM_INT;
 }
 
 void nodeSAChecker::visitRecCreate(recCreate* RecCreate)
@@ -359,32 +450,34 @@ void nodeSAChecker::visitRecCreate(recCreate* RecCreate)
      //Verify type exists in scope first, then set its type
      Type* ty = table.LookupType(((NTyId*) RecCreate->tyId)->name);
      if(ty == NULL)
-          throwError(RecCreate->lineNumber, "No type with name '" + ((NTyId*) RecCreate->tyId)->name + "' found.");
+          throwError(RecCreate->lineNumber, "No type with name '" + *((NTyId*) RecCreate->tyId)->name + "' found.");
      RecCreate->type = ty;
 
      //Verify that it's even a record type
      if(!isRecordType(ty))
-          throwError(RecCreate->lineNumber, "Type '" + ty->name + "' is not a record type.");
+          throwError(RecCreate->lineNumber, "Type '" + *ty->name + "' is not a record type.");
      
      //Verify that all of its fields are semantically correct
-     RecType* rectype = (RecType*) ty;
+     RecType* rectype = (RecType*) ty->GetActualType();
+     RecCreate->record = rectype;
      for(int i = 0; i < RecCreate->fields->size(); i++)
      {
           fieldCreate* fieldNode = (fieldCreate*)((*RecCreate->fields)[i]);
 
           //Make sure the record even has the field that the fieldCreate is using
           if(!rectype->hasMember(((NId*)fieldNode->id)->name))
-               throwError(fieldNode->lineNumber, "Record of type '" + rectype->name + "' has no field with name '" + ((NId*)fieldNode->id)->name + "'.");
+               throwError(fieldNode->lineNumber, "Record of type '" + *rectype->name + "' has no field with name '" + *((NId*)fieldNode->id)->name + "'.");
 
           //Get the field
           check(fieldNode); //Verify the types of each field node
-          pair<string,Type*> field = rectype->getFieldPair(((NId*)fieldNode->id)->name);
+          pair<Atom,Type*> field = rectype->getFieldPair(((NId*)fieldNode->id)->name);
           fieldNode->id->type = field.second; //Set the type here cause I can't in the fieldCreate node itself
+          fieldNode->slot = rectype->fieldSlot(field.first);
           
 
           //Make sure types match for fields to value
           if(!isAssignableTo(fieldNode->id, field.second))
-               throwError(fieldNode->lineNumber, "Field assigned type of '" + fieldNode->type->name + "'; expected '" + ty->name + "'");
+               throwError(fieldNode->lineNumber, "Field assigned type of '" + *fieldNode->type->name + "'; expected '" + *ty->name + "'");
           
           fieldNode->type = fieldNode->id->type;
     
@@ -403,9 +496,9 @@ void nodeSAChecker::visitAssignment(assignment* Assign)
      check(Assign->lVal);
      check(Assign->exp);
      if(!isAssignableTo(Assign->lVal, Assign->exp->type->GetActualType()))
-          throwError(Assign->lVal->lineNumber, "Left operand of type '" + Assign->lVal->type->name + "' does not match assigned type of '" + Assign->exp->type->name + "'.");
+          throwError(Assign->lVal->lineNumber, "Left operand of type '" + *Assign->lVal->type->name + "' does not match assigned type of '" + *Assign->exp->type->name + "'.");
 
-     Assign->type = table.LookupType("unit");
+     Assign->type = table.LookupType(ATOM_UNIT);
 }
 
 void nodeSAChecker::visitIfThenElse(ifThenElse* iTE)
@@ -413,7 +506,7 @@ void nodeSAChecker::visitIfThenElse(ifThenElse* iTE)
      //Make sure condition is intp 
      check(iTE->ifExp);
      if(!isInteger(iTE->ifExp))
-          throwError(iTE->ifExp->lineNumber, "Result of expression is of type '" + iTE->ifExp->type->name + "', not of type 'int'.");
+          throwError(iTE->ifExp->lineNumber, "Result of expression is of type '" + *iTE->ifExp->type->name + "', not of type 'int'.");
      
      //Run check of else block
      check(iTE->thenExp);
@@ -424,13 +517,13 @@ void nodeSAChecker::visitIfThenElse(ifThenElse* iTE)
           //Have to make sure the else and then expressions match type
           check(iTE->elseExp);
           if(!sameType(iTE->thenExp,iTE->elseExp))
-               throwError(iTE->lineNumber, "Else expression is of type '" + iTE->elseExp->type->name + "'; must match Then expression of type '" + iTE->thenExp->type->name + "'.");
+               throwError(iTE->lineNumber, "Else expression is of type '" + *iTE->elseExp->type->name + "'; must match Then expression of type '" + *iTE->thenExp->type->name + "'.");
      }
      else
      {
           //Else, we have to make sure the then is unit type
           if(!isUnit(iTE->thenExp))
-               throwError(iTE->lineNumber, "Then expression is of type '" + iTE->thenExp->type->name + "'; must be of type 'unit' if there is no else block.");
+               throwError(iTE->lineNumber, "Then expression is of type '" + *iTE->thenExp->type->name + "'; must be of type 'unit' if there is no else block.");
      }
 
      //Set overall expression type to Then's type
@@ -441,7 +534,7 @@ void nodeSAChecker::visitWhileExp(whileExp* While)
 {
      check(While->condition);
      if(!isInteger(While->condition))
-          throwError(While->condition->lineNumber, "While condition is of type '" + While->condition->type->name + "'; must be of type 'int'");
+          throwError(While->condition->lineNumber, "While condition is of type '" + *While->condition->type->name + "'; must be of type 'int'");
 
      //Add a new scope for within the loop
      table.PushScope(new Scope(table.top, S_WHILE));
@@ -450,8 +543,12 @@ void nodeSAChecker::visitWhileExp(whileExp* While)
      //Throw error if body isn't unit
      if(!isUnit(While->action))
      {
-          throwError(While->action->lineNumber, "Body of while condition evaluates to type '" + While->action->type->name + "'; must be of type 'unit.'");
+          throwError(While->action->lineNumber, "Body of while condition evaluates to type '" + *While->action->type->name + "'; must be of type 'unit.'");
      }
+
+     //Pop the loop scope when done
+     table.PopScope();
+     While->type = table.LookupType(ATOM_UNIT);
 }
 
 void nodeSAChecker::visitForExp(forExp* forEx)
@@ -470,7 +567,7 @@ void nodeSAChecker::visitForExp(forExp* forEx)
      check(forEx->assign);
      
      if(!isInteger(forEx->assign))
-          throwError(forEx->assign->lineNumber, "Loop initial expression is of type '" + forEx->assign->type->name + "'; ID must be assigned type 'int'.");
+          throwError(forEx->assign->lineNumber, "Loop initial expression is of type '" + *forEx->assign->type->name + "'; ID must be assigned type 'int'.");
 
      //Set the type of the identifier now that it's been verified
      forEx->id->type = forEx->assign->type;
@@ -478,16 +575,22 @@ void nodeSAChecker::visitForExp(forExp* forEx)
      //Make sure the condition expression is an int type
      check(forEx->condition);
      if(!isInteger(forEx->condition))
-          throwError(forEx->condition->lineNumber, "Loop condition is of type '" + forEx->id->type->name + "'; Condition must be type 'int'.");
+          throwError(forEx->condition->lineNumber, "Loop condition is of type '" + *forEx->id->type->name + "'; Condition must be type 'int'.");
 
      //Create a new scope with the loop variable in it and push it
      Scope* loopScope = new Scope(table.top, S_FOR);
-     loopScope->AddSymbol(new VarSymbol(((NId*)forEx->id)->name, SYM_VAR, table.LookupType("int"), true));
+     VarSymbol* var = new VarSymbol(((NId*)forEx->id)->name, SYM_VAR, table.LookupType(ATOM_INT), true);
+     loopScope->AddSymbol(var);
+     ((NId*)forEx->id)->depth = 0;
+     ((NId*)forEx->id)->slot = var->slot;
      table.PushScope(loopScope);
 
      //Check the actions for validation
      check(forEx->action); 
-     forEx->type = table.LookupType("unit");
+     forEx->type = table.LookupType(ATOM_UNIT);
+
+     //Pop the loop scope when done
+     table.PopScope();
 }
 
 void nodeSAChecker::visitLetExp(letExp* LetExp)
@@ -504,7 +607,7 @@ void nodeSAChecker::visitLetExp(letExp* LetExp)
           if(dec->kind == D_TY)
           {
                //See if the ID is unique in the current scope
-               string typeName = ((NTyId*)dec->id)->name;
+               Atom typeName = ((NTyId*)dec->id)->name;
                Type* unique = letScope->LookupType(typeName);
                //If it's not unique, that might be okay
                if(!(unique==NULL))
@@ -516,7 +619,7 @@ void nodeSAChecker::visitLetExp(letExp* LetExp)
                          //If the last dec is type a declaration & the type name matches this one
                          if(previousDec->kind == D_TY && ((NId*)(previousDec->id))->name == typeName)
                          {
-                              throwError(dec->id->lineNumber, "Type with name '" + unique->name + "' already exists in scope.");
+                              throwError(dec->id->lineNumber, "Type with name '" + *unique->name + "' already exists in scope.");
                          } 
                     }       
                }
@@ -530,8 +633,7 @@ void nodeSAChecker::visitLetExp(letExp* LetExp)
                refTy* RefTy; //C++ is annoying
                arrTy* ArrTy;
                recTy* RecTy;
-               Type* tempRecType;
-               map<string,Type*>* fields;
+               map<Atom,Type*>* fields;
                switch(TyDef->kind)
                {
                     case DEF_REF:
@@ -552,23 +654,20 @@ void nodeSAChecker::visitLetExp(letExp* LetExp)
                     case DEF_REC:
                          RecTy = (recTy*) TyDef;
 
-                         fields = new map<string,Type*>();
-                         tempRecType = new Type(((NTyId*)(dec->id))->name, T_REC);
-                         letScope->AddType(tempRecType);
+                         //Register the real record type before its fields are checked,
+                         // so self-referencing fields (e.g. a list's tail) point at the
+                         // finished type rather than a placeholder with no fields
+                         fields = new map<Atom,Type*>();
+                         ty = new RecType(((NTyId*)(dec->id))->name, T_REC, fields);
+                         letScope->AddType(ty);
                          for(int i = 0; i < RecTy->fieldDecs->size(); i++)
                          {
                               fieldDec* field = (fieldDec*) (*(RecTy->fieldDecs))[i];
                               check(field);
-                              pair<string,Type*> fieldPair = field->FieldToPair();
+                              pair<Atom,Type*> fieldPair = field->FieldToPair();
                               
                               fields->insert(fieldPair);
                          }
-                         letScope->RemoveType(tempRecType); // //Kill the temporary type
-
-                         ty = new RecType(((NTyId*)(dec->id))->name, T_REC, fields); //Use its definition's kind to make a temporary type
-                         
-                         ty->name = ((NTyId*)(dec->id))->name;
-                         ty->kind = T_REC;
                          
                          break;
                     default:
@@ -605,7 +704,10 @@ void nodeSAChecker::visitLetExp(letExp* LetExp)
 
                FuncSymbol* sym = new FuncSymbol(((NId*)FunDec->id)->name, SYM_FUNC, FunDec->type, FunDec->getParams()); //Use its definition's kind to make a temporary type
                //Get params works here because all the type should have been set before
+               sym->declaration = FunDec;
                letScope->AddSymbol(sym);
+               ((NId*)FunDec->id)->depth = 0;
+               ((NId*)FunDec->id)->slot = sym->slot;
           }
      }
 
@@ -623,6 +725,14 @@ void nodeSAChecker::visitLetExp(letExp* LetExp)
      {
           check((*(LetExp->exps))[i]);
      }
+     if(LetExp->exps->size() > 0)
+          LetExp->type = (*(LetExp->exps))[LetExp->exps->size()-1]->type;
+     else
+          LetExp->type = table.LookupType(ATOM_UNIT);
+     LetExp->frameSize = letScope->frameSize;
+
+     //Pop the let scope when done
+     table.PopScope();
 }
 
 void nodeSAChecker::visitDec(decc* Dec)
@@ -679,12 +789,27 @@ void nodeSAChecker::visitFunDec(funDec* FunDec)
      funcScope -> last = table.top;
      table.PushScope(funcScope);
 
+     //Parameters fill the first slots of the function's frame, which calls
+     // lay out straight from the declaration
+     FunDec->paramSlots.clear();
+     for(int i = 0; i < FunDec->params->size(); i++)
+     {
+          NId* param = (NId*)(((fieldDec*)(*(FunDec->params))[i])->id);
+          param->depth = 0;
+          param->slot = funcScope->LookupSymbol(param->name)->slot;
+          FunDec->paramSlots.push_back(param->slot);
+     }
+     FunDec->frameSize = funcScope->frameSize;
+
      //Verify all of its expressions are valid within the new scope
      check(FunDec->exp);
 
      //Make sure body type and return type match
      if(!isAssignableTo(FunDec->exp, FunDec->returnType->type))
-          throwError(FunDec->lineNumber, "Type mismatch. Function body returns type '" + FunDec->exp->type->name + "' but returnType is '" + FunDec->returnType->type->name + "'.");
+          throwError(FunDec->lineNumber, "Type mismatch. Function body returns type '" + *FunDec->exp->type->name + "' but returnType is '" + *FunDec->returnType->type->name + "'.");
+
+     //Let the interpreter know which calls can reuse this function's frame
+     markTailCalls(FunDec->exp, 0);
 
      //Pop the function scope when done
      table.PopScope();
@@ -700,7 +825,7 @@ void nodeSAChecker::visitVarDec(varDec* VarDec)
      VarSymbol* sym = (VarSymbol*)currentScope->LookupSymbol(((NId*)VarDec->id)->name);
      if((!(sym == NULL)) && (sym->type == VarDec->tyId->type)) //If the symbol is in the current scope already AND the types match
      {
-          throwError(VarDec->lineNumber, "Symbol with name '" + sym->name + "' already exists in scope.");
+          throwError(VarDec->lineNumber, "Symbol with name '" + *sym->name + "' already exists in scope.");
      }
 
      //Set the identifier to the type
@@ -712,11 +837,14 @@ void nodeSAChecker::visitVarDec(varDec* VarDec)
      //Make sure the expression and ID's type match
      //if(!sameType(VarDec->exp, VarDec->id))
      if(!isAssignableTo(VarDec->id, VarDec->exp->type))
-          throwError(VarDec->lineNumber, "Type mismatch; identifer of type '" + VarDec->id->type->name + "' assigned type '" + VarDec->exp->type->name + "'.");
+          throwError(VarDec->lineNumber, "Type mismatch; identifer of type '" + *VarDec->id->type->name + "' assigned type '" + *VarDec->exp->type->name + "'.");
 
      //We can add it in now, and let it shadow other variables
-     string name = ((NId*)(VarDec->id))->name;
-     currentScope->AddSymbol(new VarSymbol(name, SYM_VAR, VarDec->tyId->type));
+     Atom name = ((NId*)(VarDec->id))->name;
+     VarSymbol* var = new VarSymbol(name, SYM_VAR, VarDec->tyId->type);
+     currentScope->AddSymbol(var);
+     ((NId*)VarDec->id)->depth = 0;
+     ((NId*)VarDec->id)->slot = var->slot;
 }
 
 void nodeSAChecker::checkFunctionSignature(funDec* FunDec)
@@ -106,6 +106,14 @@ class nodeSAChecker : public nodeVisitor {
       */
      bool isRecordType(Type*);
 
+     /**
+      * @brief Follows aliases down to the type they name. Unlike GetActualType(),
+      * arrays are left as they are rather than followed to their elements.
+      * 
+      * @return Type* The type with no aliases left.
+      */
+     Type* resolveAliases(Type*);
+
      /**
       * @brief Returns true if the passed in node's current type is
       * an array type.
@@ -190,6 +198,16 @@ class nodeSAChecker : public nodeVisitor {
       */
      void checkFunctionSignature(funDec* FunDec);
 
+     /**
+      * @brief Marks the calls whose value a function body returns directly,
+      * following both branches of ifs, the last expression of sequences and
+      * the body of lets.
+      * 
+      * @param Node An expression in tail position.
+      * @param lets Number of lets between the expression and the function's frame.
+      */
+     void markTailCalls(node* Node, int lets);
+
      //Visitor functions
      void visitProgram(program* prog) override;
      void visitBreak(NBreak* Break) override;
@@ -228,6 +246,13 @@ class nodeSAChecker : public nodeVisitor {
       * 
       */
      SymbolTable table;
+
+     /**
+      * @brief One string object for each distinct literal, shared by every
+      * node spelling it.
+      * 
+      */
+     map<Atom, StringObject*> literals;
 };
 /** @} */
 #endif
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "SourceFile.h"
+
+using namespace std;
+
+//Bytes read at a time from a file that can't be mapped
+#define SOURCE_READ_SIZE (64 * 1024)
+
+/*********************
+ * SOURCE FILE
+ * *******************/
+
+SourceFile::SourceFile():text(NULL), length(0), mapped(0){}
+
+SourceFile::~SourceFile()
+{
+     if(mapped != 0)
+          munmap(text, mapped);
+     else
+          free(text);
+}
+
+bool SourceFile::Open(const char* fileName)
+{
+     int fd = open(fileName, O_RDONLY);
+     if(fd < 0)
+          return false;
+
+     struct stat info;
+     if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode) || info.st_size == 0)
+     {
+          bool success = read(fd);
+          close(fd);
+          return success;
+     }
+
+     //Views refer into the source with 32-bit offsets
+     size_t size = (size_t)info.st_size;
+     if(size > UINT32_MAX - 2)
+     {
+          close(fd);
+          return false;
+     }
+
+     //Reserve room for the file and the NULs after it, then map the file over the
+     // start. What's past the end of the file reads as zeros either way, and pages
+     // the scanner writes to are copied rather than written back.
+     long page = sysconf(_SC_PAGESIZE);
+     size_t total = (size + 2 + page - 1) & ~(size_t)(page - 1);
+     void* reserved = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+     if(reserved == MAP_FAILED)
+     {
+          close(fd);
+          return false;
+     }
+     if(mmap(reserved, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+     {
+          munmap(reserved, total);
+          bool success = read(fd);
+          close(fd);
+          return success;
+     }
+     close(fd);
+
+     //It's scanned once, front to back
+     madvise(reserved, total, MADV_SEQUENTIAL);
+     text = (char*)reserved;
+     length = size;
+     mapped = total;
+     return true;
+}
+
+bool SourceFile::read(int fd)
+{
+     size_t capacity = SOURCE_READ_SIZE;
+     text = (char*)malloc(capacity);
+     length = 0;
+     while(true)
+     {
+          //Always leave room for the NULs
+          if(capacity - length < SOURCE_READ_SIZE + 2)
+          {
+               capacity *= 2;
+               text = (char*)realloc(text, capacity);
+          }
+          ssize_t count = ::read(fd, text + length, SOURCE_READ_SIZE);
+          if(count < 0)
+               return false;
+          if(count == 0)
+               break;
+          length += (size_t)count;
+     }
+     if(length > UINT32_MAX - 2)
+          return false;
+     text[length] = '\0';
+     text[length + 1] = '\0';
+     return true;
+}
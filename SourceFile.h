@@ -0,0 +1,124 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      SourceFile.h
+     Purpose:       The program's source, mapped into memory whole so the lexer
+                    scans it in place. Tokens refer back into the mapping by
+                    offset and length instead of being copied out of it.
+
+*/
+
+/** @defgroup SOURCE Source File
+ *  Memory-mapped source input.
+ *  @{
+ */
+
+#ifndef SOURCE_FILE
+#define SOURCE_FILE
+
+#include <stddef.h>
+#include <stdint.h>
+
+using namespace std;
+
+/**
+ * @brief Some characters of the source, by where they start and how many there
+ * are. Only good while the source file they came from is open.
+ *
+ */
+struct SourceView
+{
+     uint32_t offset;
+     uint32_t length;
+};
+
+/**
+ * @brief A source file mapped into memory, followed by the two NUL bytes a
+ * scanner needs to find the end of it. Files that can't be mapped, like pipes,
+ * are read into memory instead.
+ *
+ */
+class SourceFile
+{
+     public:
+          /**
+           * @brief Construct a source file with nothing open yet.
+           *
+           */
+          SourceFile();
+
+          /**
+           * @brief Unmaps or frees the source.
+           *
+           */
+          ~SourceFile();
+
+          /**
+           * @brief Maps a file, or reads it in if it can't be mapped.
+           *
+           * @param fileName The file's path.
+           * @return true If the whole file is in memory.
+           * @return false If it couldn't be opened or read, or is too large for views
+           * to refer into.
+           */
+          bool Open(const char* fileName);
+
+          /**
+           * @brief The source's characters, followed by two NULs. The scanner may
+           * write into them while it runs, but only on a private copy of the file.
+           *
+           */
+          char* Text(){return text;}
+
+          /**
+           * @brief Number of characters in the source, not counting the NULs.
+           *
+           */
+          size_t Length(){return length;}
+
+          /**
+           * @brief Where a view's characters start.
+           *
+           */
+          const char* Chars(SourceView view){return text + view.offset;}
+
+          /**
+           * @brief The view of some characters of the source.
+           *
+           * @param chars The first character, which must be in the source.
+           * @param count Number of characters.
+           */
+          SourceView View(const char* chars, size_t count)
+          {
+               SourceView view;
+               view.offset = (uint32_t)(chars - text);
+               view.length = (uint32_t)count;
+               return view;
+          }
+
+     private:
+          /**
+           * @brief Reads a file that couldn't be mapped into memory from malloc.
+           *
+           */
+          bool read(int fd);
+
+          /**
+           * @brief The characters and their two NULs.
+           *
+           */
+          char* text;
+
+          /**
+           * @brief Number of characters.
+           *
+           */
+          size_t length;
+
+          /**
+           * @brief Bytes mapped, or 0 if the text was read into memory from malloc.
+           *
+           */
+          size_t mapped;
+};
+/** @} */
+#endif
@@ -0,0 +1,733 @@
+#include <typeinfo>
+#include "StackEvaluator.h"
+#include "Builtins.h"
+
+using namespace std;
+
+Continuation::Continuation(node* Node, size_t values):Node(Node), step(0), index(0), limit(0), frame(NULL), values(values){}
+
+/*********************
+ * STACK EVALUATOR
+ * *******************/
+
+StackEvaluator::StackEvaluator(size_t limit):frameBytes(0), limit(limit)
+{
+     //The builtins are called by name, so their scope's frame holds nothing
+     frame = frames.Push(NULL, 0);
+}
+
+void StackEvaluator::Run(node* root)
+{
+     descend(root);
+     while(!stack.empty())
+          stack.back().Node->accept(this);
+}
+
+bool StackEvaluator::descend(node* Node)
+{
+     //Small expressions that can't call, allocate or break go straight on the
+     // value stack, skipping the continuations and the trips through Run's
+     // dispatch they would otherwise take for every node in them
+     Value value;
+     if(evaluateSimple(Node, value, STACK_SIMPLE_DEPTH))
+     {
+          values.push_back(value);
+          return true;
+     }
+     stack.push_back(Continuation(Node, values.size()));
+     checkLimit(Node);
+     return false;
+}
+
+bool StackEvaluator::evaluateSimple(node* Node, Value &value, int depth)
+{
+     //Comparing type_info addresses is much cheaper than a dynamic_cast, which
+     // mostly fails here; if a type ever had two, the node would only be
+     // evaluated the slow way
+     const type_info* kind = &typeid(*Node);
+     if(kind == &typeid(NId))
+     {
+          value = frame->Lookup(((NId*)Node)->depth, ((NId*)Node)->slot);
+          return true;
+     }
+     if(kind == &typeid(NIntLit))
+     {
+          value = Value(((NIntLit*)Node)->val);
+          return true;
+     }
+     if(depth == 0)
+          return false;
+
+     //Operands are tried left to right, so whatever runs before one turns out not
+     // to be simple would have run first anyway, and has no effects to repeat
+     if(kind == &typeid(seqExp) && ((seqExp*)Node)->exps->size() == 1)
+     {
+          //Just an expression in parentheses
+          return evaluateSimple((*(((seqExp*)Node)->exps))[0], value, depth - 1);
+     }
+     if(kind == &typeid(negation))
+     {
+          if(!evaluateSimple(((negation*)Node)->operand, value, depth - 1))
+               return false;
+          value = Value(intNegate(value.GetInt()));
+          return true;
+     }
+     if(kind == &typeid(infixExp))
+     {
+          infixExp* InfixExp = (infixExp*)Node;
+          Value left, right;
+          if(!evaluateSimple(InfixExp->leftNode, left, depth - 1))
+               return false;
+          if(InfixExp->operation == INFIX_AND && left.GetInt() == 0)
+               value = Value(0);
+          else if(InfixExp->operation == INFIX_OR && left.GetInt() != 0)
+               value = Value(1);
+          else if(!evaluateSimple(InfixExp->rightNode, right, depth - 1))
+               return false;
+          else
+               value = infix(InfixExp, left, right);
+          return true;
+     }
+     return false;
+}
+
+void StackEvaluator::finish(Value value)
+{
+     stack.pop_back();
+     values.push_back(value);
+}
+
+void StackEvaluator::finish()
+{
+     stack.pop_back();
+}
+
+Frame* StackEvaluator::enterFrame(Frame* parent, int size, Frame* caller)
+{
+     stack.back().frame = frame;
+     frame = frames.Push(parent, size, caller);
+     frameBytes += sizeof(Frame) + size * sizeof(Value);
+     checkLimit(stack.back().Node);
+     return frame;
+}
+
+void StackEvaluator::leaveFrame()
+{
+     frameBytes -= sizeof(Frame) + frame->size * sizeof(Value);
+     frame = stack.back().frame;
+     stack.back().frame = NULL;
+     frames.Pop();
+}
+
+void StackEvaluator::checkLimit(node* Node)
+{
+     size_t used = stack.size() * sizeof(Continuation) + values.size() * sizeof(Value) + frameBytes;
+     if(used > limit)
+     {
+          cout << "ERROR " << Node->lineNumber << ": Runtime: Stack depth exceeded." << endl;
+          exit(4);
+     }
+}
+
+Value StackEvaluator::pop()
+{
+     Value value = values.back();
+     values.pop_back();
+     return value;
+}
+
+ArrayObject* StackEvaluator::element(subscript* Subscript, size_t base)
+{
+     //The array and index are on the value stack, in that order
+     ArrayObject* arr = values[base].GetArray();
+     if(!arr->InBounds(values[base + 1].GetInt()))
+     {
+          cout << "ERROR " << Subscript->exp->lineNumber << ": Runtime: Array access out of bounds." << endl;
+          exit(4);
+     }
+     return arr;
+}
+
+Value* StackEvaluator::locate(node* lValue, size_t base)
+{
+     if(typeid(*lValue) == typeid(fieldExp))
+     {
+          fieldExp* FieldExp = (fieldExp*)lValue;
+          if(values[base].kind != V_REC)
+          {
+               cout << "ERROR " << FieldExp->lineNumber << ": Runtime: Field access on nil record." << endl;
+               exit(4);
+          }
+          return values[base].GetRecord()->GetValue(FieldExp->slot);
+     }
+     NId* id = (NId*)lValue;
+     return &(frame->Lookup(id->depth, id->slot));
+}
+
+Value StackEvaluator::infix(infixExp* InfixExp, Value left, Value right)
+{
+     //Semantic analysis already picked the operation for the operands' types
+     switch(InfixExp->operation)
+     {
+          case INFIX_INT_ADD:
+               return Value(intAdd(left.GetInt(), right.GetInt()));
+          case INFIX_INT_SUBTRACT:
+               return Value(intSubtract(left.GetInt(), right.GetInt()));
+          case INFIX_INT_MULTIPLY:
+               return Value(intMultiply(left.GetInt(), right.GetInt()));
+          case INFIX_INT_DIVIDE:
+               //Division by zero is an error, and INT_MIN / -1 would trap
+               if(right.GetInt() == 0)
+               {
+                    cout << "ERROR " << InfixExp->lineNumber << ": Runtime: Division by zero." << endl;
+                    exit(4);
+               }
+               if(right.GetInt() == -1)
+                    return Value(intNegate(left.GetInt()));
+               return Value(left.GetInt() / right.GetInt());
+          case INFIX_INT_EQ:
+               return Value(left.GetInt() == right.GetInt() ? 1 : 0);
+          case INFIX_INT_NEQ:
+               return Value(left.GetInt() != right.GetInt() ? 1 : 0);
+          case INFIX_INT_LT:
+               return Value(left.GetInt() < right.GetInt() ? 1 : 0);
+          case INFIX_INT_LEQ:
+               return Value(left.GetInt() <= right.GetInt() ? 1 : 0);
+          case INFIX_INT_GT:
+               return Value(left.GetInt() > right.GetInt() ? 1 : 0);
+          case INFIX_INT_GEQ:
+               return Value(left.GetInt() >= right.GetInt() ? 1 : 0);
+          case INFIX_STR_EQ:
+               return Value(left.GetStringObject()->Equals(right.GetStringObject()) ? 1 : 0);
+          case INFIX_STR_NEQ:
+               return Value(left.GetStringObject()->Equals(right.GetStringObject()) ? 0 : 1);
+          case INFIX_STR_LT:
+               return Value(left.GetStringObject()->Compare(right.GetStringObject()) < 0 ? 1 : 0);
+          case INFIX_STR_LEQ:
+               return Value(left.GetStringObject()->Compare(right.GetStringObject()) <= 0 ? 1 : 0);
+          case INFIX_STR_GT:
+               return Value(left.GetStringObject()->Compare(right.GetStringObject()) > 0 ? 1 : 0);
+          case INFIX_STR_GEQ:
+               return Value(left.GetStringObject()->Compare(right.GetStringObject()) >= 0 ? 1 : 0);
+          case INFIX_REF_EQ:
+               return Value(left == right ? 1 : 0);
+          case INFIX_REF_NEQ:
+               return Value(left == right ? 0 : 1);
+          case INFIX_AND:
+          case INFIX_OR:
+               //The left side didn't decide it, so the right one does
+               return Value(right.GetInt() != 0 ? 1 : 0);
+     }
+     return Value();
+}
+
+void StackEvaluator::pollCollector()
+{
+     if(collector != NULL)
+          collector->Poll(frame, &values);
+}
+
+/*********
+ * VISITS
+ * *******/
+
+void StackEvaluator::visitProgram(program* Program)
+{
+     if(stack.back().step == 0)
+     {
+          stack.back().step = 1;
+          descend(Program->Node);
+     }
+     else
+          finish();
+}
+void StackEvaluator::visitBreak(NBreak* Break)
+{
+     //Unwind to the innermost loop, leaving any frames entered on the way
+     stack.pop_back();
+     while(true)
+     {
+          Continuation &here = stack.back();
+          bool loop = typeid(*here.Node) == typeid(whileExp) || typeid(*here.Node) == typeid(forExp);
+          if(here.frame != NULL)
+               leaveFrame();
+          if(loop)
+          {
+               values.resize(here.values);
+               finish(Value());
+               return;
+          }
+          stack.pop_back();
+     }
+}
+void StackEvaluator::visitNil(NNil* Nil)
+{
+     finish(Value::Nil());
+}
+void StackEvaluator::visitID(NId* id)
+{
+     finish(frame->Lookup(id->depth, id->slot));
+}
+void StackEvaluator::visitTyID(NTyId* tyid)
+{
+     finish();
+}
+void StackEvaluator::visitIntLit(NIntLit* intLit)
+{
+     finish(Value(intLit->val));
+}
+void StackEvaluator::visitStrLit(NStrLit* strLit)
+{
+     //Semantic analysis already gave the literal its pooled string
+     finish(strLit->value);
+}
+void StackEvaluator::visitSubscript(subscript* Subscript)
+{
+     Continuation &here = stack.back();
+     if(here.step == 0)
+     {
+          here.step = 1;
+          if(!descend(Subscript->lValue))
+               return;
+     }
+     if(here.step == 1)
+     {
+          here.step = 2;
+          if(!descend(Subscript->exp))
+               return;
+     }
+     Value value = element(Subscript, here.values)->Get(values[here.values + 1].GetInt());
+     values.resize(here.values);
+     finish(value);
+}
+void StackEvaluator::visitFieldExp(fieldExp* FieldExp)
+{
+     Continuation &here = stack.back();
+     if(here.step == 0)
+     {
+          here.step = 1;
+          if(!descend(FieldExp->lValue))
+               return;
+     }
+     Value field = *locate(FieldExp, here.values);
+     values.resize(here.values);
+     finish(field);
+}
+void StackEvaluator::visitSeqExp(seqExp* SeqExp)
+{
+     //The value of a sequence is the value of its last expression
+     Continuation &here = stack.back();
+     int count = SeqExp->exps->size();
+     if(count == 0)
+     {
+          finish(Value());
+          return;
+     }
+     while(here.index < count)
+     {
+          if(here.index > 0)
+               pop();
+          if(!descend((*(SeqExp->exps))[here.index++]))
+               return;
+     }
+     finish();
+}
+void StackEvaluator::visitNegation(negation* neg)
+{
+     if(stack.back().step == 0)
+     {
+          stack.back().step = 1;
+          if(!descend(neg->operand))
+               return;
+     }
+     finish(Value(intNegate(pop().GetInt())));
+}
+void StackEvaluator::visitCallExp(callExp* CallExp)
+{
+     Continuation &here = stack.back();
+     NodeList* passedParameters = CallExp->exps;
+
+     //Once the body is done, its value is the call's, so just leave its frame
+     if(here.step == 1)
+     {
+          leaveFrame();
+          finish();
+          return;
+     }
+
+     //Evaluate the arguments one at a time
+     while(here.index < passedParameters->size())
+     {
+          if(!descend((*passedParameters)[here.index++]))
+               return;
+     }
+
+     //Semantic analysis bound the call to its function, or to the native code for a builtin
+     NId* id = (NId*)(CallExp->id);
+     funDec* FunDec = CallExp->function;
+     if(CallExp->builtin != NULL)
+     {
+          //The arguments stay on the value stack, where the collector sees them,
+          // until the builtin is done with them
+          size_t base = here.values;
+          pollCollector();
+          Value result = CallExp->builtin->function(&values[base], CallExp->lineNumber);
+          values.resize(base);
+          finish(result);
+     }
+     else //It's a normal function call
+     {
+          //The function lives in the frame it was declared in, which its own
+          // frame links to so it sees the variables around its declaration
+          Frame* declaringFrame = frame->Ancestor(id->depth);
+
+          //A call in tail position takes over the frame of the call running this
+          // function, once everything in between is dropped
+          if(CallExp->tail)
+          {
+               vector<Value> arguments(values.begin() + here.values, values.end());
+               stack.pop_back();
+               while(typeid(*stack.back().Node) != typeid(callExp))
+               {
+                    if(stack.back().frame != NULL)
+                         leaveFrame();
+                    stack.pop_back();
+               }
+               frameBytes += (FunDec->frameSize - frame->size) * sizeof(Value);
+               frames.Resize(FunDec->frameSize);
+               frame->parent = declaringFrame;
+               for(int i = 0; i < arguments.size(); i++)
+                    frame->slots[FunDec->paramSlots[i]] = arguments[i];
+               values.resize(stack.back().values);
+               descend(FunDec->exp);
+               return;
+          }
+
+          //Move the arguments off the value stack into the parameters' slots, and
+          // run the body in the new frame
+          here.step = 1;
+          Frame* funcFrame = enterFrame(declaringFrame, FunDec->frameSize, frame);
+          for(int i = 0; i < passedParameters->size(); i++)
+               funcFrame->slots[FunDec->paramSlots[i]] = values[here.values + i];
+          values.resize(here.values);
+          descend(FunDec->exp);
+     }
+}
+void StackEvaluator::visitInfixExp(infixExp* InfixExp)
+{
+     Continuation &here = stack.back();
+     if(here.step == 0)
+     {
+          here.step = 1;
+          if(!descend(InfixExp->leftNode))
+               return;
+     }
+     if(here.step == 1)
+     {
+          //& and | don't evaluate the right side when the left decides them
+          int leftVal = values.back().GetInt();
+          if(InfixExp->operation == INFIX_AND && leftVal == 0)
+          {
+               pop();
+               finish(Value(0));
+               return;
+          }
+          if(InfixExp->operation == INFIX_OR && leftVal != 0)
+          {
+               pop();
+               finish(Value(1));
+               return;
+          }
+          here.step = 2;
+          if(!descend(InfixExp->rightNode))
+               return;
+     }
+     Value right = pop();
+     Value left = pop();
+     finish(infix(InfixExp, left, right));
+}
+void StackEvaluator::visitArrCreate(arrCreate* ArrCreate)
+{
+     Continuation &here = stack.back();
+     if(here.step == 0)
+     {
+          here.step = 1;
+          descend(ArrCreate->subscriptExp);
+     }
+     else if(here.step == 1)
+     {
+          here.step = 2;
+          descend(ArrCreate->postExp);
+     }
+     else
+     {
+          pollCollector();
+          Value initial = pop();
+          int size = pop().GetInt();
+          finish(Value(new ArrayObject(size, initial, ArrCreate->ints)));
+     }
+}
+void StackEvaluator::visitRecCreate(recCreate* RecCreate)
+{
+     //Evaluate every field's expression first
+     Continuation &here = stack.back();
+     if(here.index < RecCreate->fields->size())
+     {
+          fieldCreate* FieldCreate = (fieldCreate*)(*(RecCreate->fields))[here.index++];
+          descend(FieldCreate->exp);
+          return;
+     }
+
+     //Then create the record and put each value in its field's slot
+     pollCollector();
+     RecordObject* record = new RecordObject(RecCreate->record);
+     for(int i = 0; i < RecCreate->fields->size(); i++)
+     {
+          fieldCreate* FieldCreate = (fieldCreate*)(*(RecCreate->fields))[i];
+          *record->GetValue(FieldCreate->slot) = values[here.values + i];
+     }
+     values.resize(here.values);
+     finish(Value(record));
+}
+void StackEvaluator::visitFieldCreate(fieldCreate* FieldCreate)
+{
+     if(stack.back().step == 0)
+     {
+          stack.back().step = 1;
+          descend(FieldCreate->exp);
+     }
+     else
+          finish();
+}
+void StackEvaluator::visitAssignment(assignment* Assign)
+{
+     //Evaluate the array and index, or the record, the LHS needs first. How many
+     // of them there are is worked out once, on the first visit, and kept in limit.
+     Continuation &here = stack.back();
+     node* lVal = Assign->lVal;
+     if(here.step == 0)
+     {
+          if(typeid(*lVal) == typeid(subscript))
+               here.limit = 2;
+          else if(typeid(*lVal) == typeid(fieldExp))
+               here.limit = 1;
+     }
+
+     while(here.step < here.limit)
+     {
+          node* operand = here.limit == 1 ? ((fieldExp*)lVal)->lValue : ((subscript*)lVal)->lValue;
+          if(here.step == 1)
+               operand = ((subscript*)lVal)->exp;
+          here.step++;
+          if(!descend(operand))
+               return;
+     }
+     if(here.step == here.limit)
+     {
+          //Make sure the element or field exists before evaluating the RHS
+          if(here.limit == 2)
+               element((subscript*)lVal, here.values);
+          else if(here.limit == 1)
+               locate(lVal, here.values);
+          here.step++;
+          if(!descend(Assign->exp))
+               return;
+     }
+
+     //Set it to the rhs; arrays and records are shared, not copied, and
+     // array elements may be unboxed so they're stored through the array
+     Value result = pop();
+     if(here.limit == 2)
+          values[here.values].GetArray()->Set(values[here.values + 1].GetInt(), result);
+     else if(here.limit == 1)
+          *locate(lVal, here.values) = result;
+     else
+          frame->Lookup(((NId*)lVal)->depth, ((NId*)lVal)->slot) = result;
+     values.resize(here.values);
+     finish(Value());
+}
+void StackEvaluator::visitIfThenElse(ifThenElse* iTE)
+{
+     Continuation &here = stack.back();
+     if(here.step == 0)
+     {
+          here.step = 1;
+          if(!descend(iTE->ifExp))
+               return;
+     }
+     if(here.step == 1)
+     {
+          //Take whichever branch the condition picks, if there is one
+          node* branch = pop().GetInt() != 0 ? iTE->thenExp : iTE->elseExp;
+          if(branch == NULL)
+          {
+               finish(Value());
+               return;
+          }
+          here.step = 2;
+          if(!descend(branch))
+               return;
+     }
+     finish();
+}
+void StackEvaluator::visitWhileExp(whileExp* While)
+{
+     Continuation &here = stack.back();
+     while(true)
+     {
+          if(here.step == 1)
+          {
+               //Stop once the condition is zero
+               if(pop().GetInt() == 0)
+               {
+                    finish(Value());
+                    return;
+               }
+               here.step = 2;
+               if(!descend(While->action))
+                    return;
+          }
+
+          //Drop the last iteration's value, if any, and test again
+          if(here.step == 2)
+               pop();
+          here.step = 1;
+          if(!descend(While->condition))
+               return;
+     }
+}
+void StackEvaluator::visitForExp(forExp* forEx)
+{
+     Continuation &here = stack.back();
+     int slot = ((NId*)(forEx->id))->slot;
+     if(here.step == 0)
+     {
+          here.step = 1;
+          descend(forEx->assign);
+     }
+     else if(here.step == 1)
+     {
+          here.step = 2;
+          descend(forEx->condition);
+     }
+     else if(here.step == 2)
+     {
+          //Run the loop from the initial value up to and including the limit
+          here.limit = pop().GetInt();
+          here.index = pop().GetInt();
+          if(here.index > here.limit)
+          {
+               finish(Value());
+               return;
+          }
+
+          //Give the variable a frame of its own
+          here.step = 3;
+          Frame* forFrame = enterFrame(frame, 1);
+          forFrame->slots[slot] = Value(here.index);
+          descend(forEx->action);
+     }
+     else
+     {
+          pop();
+          if(here.index >= here.limit)
+          {
+               leaveFrame();
+               finish(Value());
+               return;
+          }
+          here.index++;
+          frame->slots[slot] = Value(here.index);
+          descend(forEx->action);
+     }
+}
+void StackEvaluator::visitLetExp(letExp* LetExp)
+{
+     Continuation &here = stack.back();
+     NodeList* decs = LetExp->decs;
+     if(here.step == 0)
+     {
+          //Calls are bound to their functions already, so only variables need
+          // anything done with them
+          enterFrame(frame, LetExp->frameSize);
+          here.step = 1;
+     }
+     else if(here.step == 1)
+     {
+          //Find the next variable declaration and evaluate what it's initialized to
+          while(here.index < decs->size() && ((decc*)(*decs)[here.index])->kind != D_VAR)
+               here.index++;
+          if(here.index < decs->size())
+          {
+               here.step = 2;
+               descend(((varDec*)(*decs)[here.index])->exp);
+          }
+          else
+          {
+               here.step = 3;
+               here.index = 0;
+          }
+     }
+     else if(here.step == 2)
+     {
+          //Drop the value in the variable's slot
+          varDec* VarDec = (varDec*)(*decs)[here.index];
+          frame->slots[((NId*)(VarDec->id))->slot] = pop();
+          here.index++;
+          here.step = 1;
+     }
+     else
+     {
+          //Evaluate all of the body expressions in order
+          int count = LetExp->exps->size();
+          if(here.index < count)
+          {
+               if(here.index > 0)
+                    pop();
+               descend((*(LetExp->exps))[here.index++]);
+               return;
+          }
+
+          //Value of LetExp is value of the last body expression
+          if(count == 0)
+               values.push_back(Value());
+          leaveFrame();
+          finish();
+     }
+}
+void StackEvaluator::visitDec(decc* Dec)
+{
+     finish();
+}
+void StackEvaluator::visitTyDec(tyDec* TyDec)
+{
+     finish();
+}
+void StackEvaluator::visitTyDef(tyDef* TyDef)
+{
+     finish();
+}
+void StackEvaluator::visitRefTy(refTy* RefTy)
+{
+     finish();
+}
+void StackEvaluator::visitArrTy(arrTy* ArrTy)
+{
+     finish();
+}
+void StackEvaluator::visitRecTy(recTy* RecTy)
+{
+     finish();
+}
+void StackEvaluator::visitFieldDec(fieldDec* FieldDec)
+{
+     finish();
+}
+void StackEvaluator::visitFunDec(funDec* FunDec)
+{
+     finish();
+}
+void StackEvaluator::visitVarDec(varDec* VarDec)
+{
+     finish();
+}
@@ -0,0 +1,287 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      StackEvaluator.h
+     Purpose:       Walks the AST like the tree-walking interpreter, but keeps
+                    what is left to do in a continuation stack on the heap
+                    instead of the C++ call stack, so recursion is only limited
+                    by how much memory it is allowed.
+
+*/
+
+/** @defgroup STACK Explicit Stack Evaluator
+ *  Tree-walking with a heap-growable control stack.
+ *  @{
+ */
+
+#ifndef STACK_EVALUATOR
+#define STACK_EVALUATOR
+
+#include <vector>
+#include "ast.h"
+#include "SymbolTable.h"
+#include "GarbageCollector.h"
+
+using namespace std;
+
+//Bytes of continuations, pending values and frames allowed before the program is stopped
+#define STACK_DEFAULT_LIMIT (256 * 1024 * 1024)
+
+//How deep the operations in an expression evaluated without continuations may nest
+#define STACK_SIMPLE_DEPTH 8
+
+/**
+ * @brief A node partway through being evaluated: which of its steps comes next
+ * and whatever it has to remember between them.
+ *
+ */
+class Continuation
+{
+     public:
+          /**
+           * @brief Construct a continuation that has not taken any steps yet.
+           *
+           * @param Node The node to evaluate.
+           * @param values Height of the value stack when it starts.
+           */
+          Continuation(node* Node, size_t values);
+
+          /**
+           * @brief The node being evaluated.
+           *
+           */
+          node* Node;
+
+          /**
+           * @brief The next step to take. Every node starts at 0.
+           *
+           */
+          int step;
+
+          /**
+           * @brief Which child, declaration or iteration the node is on.
+           *
+           */
+          int index;
+
+          /**
+           * @brief The upper bound of a for loop.
+           *
+           */
+          int limit;
+
+          /**
+           * @brief The frame to go back to once the node is done, or NULL if it
+           * hasn't entered one of its own.
+           *
+           */
+          Frame* frame;
+
+          /**
+           * @brief Height of the value stack when the node started, which a break
+           * cuts it back to.
+           *
+           */
+          size_t values;
+};
+
+/**
+ * @brief A node visitor that evaluates one step of the node on top of the
+ * continuation stack each visit. Children are evaluated by pushing them rather
+ * than recursing, and every expression leaves its result on the value stack.
+ *
+ */
+class StackEvaluator : public nodeVisitor
+{
+     public:
+          /**
+           * @brief Construct a new evaluator with the frame for the default Tiger scope.
+           *
+           * @param limit Bytes of continuations, values and frames allowed.
+           */
+          StackEvaluator(size_t limit);
+
+          /**
+           * @brief Evaluates a program to completion.
+           *
+           * @param root The root of the AST.
+           */
+          void Run(node* root);
+
+          /**
+           * @brief Pushes a node to be evaluated next, stopping the program if the
+           * stack has outgrown its limit. Simple expressions are evaluated right
+           * away instead.
+           *
+           * @return bool True if the node's value is already on the value stack, so
+           * the caller can carry on without going back through the dispatch loop.
+           */
+          bool descend(node* Node);
+
+          /**
+           * @brief Evaluates a node on the C++ stack if it's only variables, int
+           * constants, negations, infix operations and parentheses, nested no deeper
+           * than a limit.
+           *
+           * @param value Set to the node's value.
+           * @param depth How much deeper the operations may nest.
+           * @return bool False if the node isn't simple; anything it reached before
+           * finding out had no effect, and will be evaluated again.
+           */
+          bool evaluateSimple(node* Node, Value &value, int depth);
+
+          /**
+           * @brief Pops the node on top, leaving a value in its place.
+           *
+           */
+          void finish(Value value);
+
+          /**
+           * @brief Pops the node on top, whose value is already on the value stack.
+           *
+           */
+          void finish();
+
+          /**
+           * @brief Makes a new frame current for the node on top, remembering the
+           * one to go back to.
+           *
+           * @param parent The frame of the enclosing scope.
+           * @param size Number of slots.
+           * @param caller The frame current when it's entered, if not the parent.
+           * @return Frame* The new frame.
+           */
+          Frame* enterFrame(Frame* parent, int size, Frame* caller = NULL);
+
+          /**
+           * @brief Gives back the current frame and goes back to the one the node
+           * on top entered it from.
+           *
+           */
+          void leaveFrame();
+
+          /**
+           * @brief Stops the program with a runtime error if the continuations,
+           * values and frames in use take more than the limit.
+           *
+           * @param Node The node being evaluated, for the line number.
+           */
+          void checkLimit(node* Node);
+
+          /**
+           * @brief Takes the value on top of the value stack off it.
+           *
+           */
+          Value pop();
+
+          /**
+           * @brief Finds the array a subscript refers to, stopping the program if
+           * the index is out of bounds.
+           *
+           * @param Subscript The subscript expression.
+           * @param base Where the array and index it was evaluated to start on the
+           * value stack.
+           * @return ArrayObject* The array.
+           */
+          ArrayObject* element(subscript* Subscript, size_t base);
+
+          /**
+           * @brief Finds where an lvalue's value is stored, stopping the program if
+           * the record is nil.
+           *
+           * @param lValue An identifier or field expression.
+           * @param base Where the record it was evaluated to starts on the value stack.
+           * @return Value* The variable or record field.
+           */
+          Value* locate(node* lValue, size_t base);
+
+          /**
+           * @brief The result of a binary operator on two evaluated operands.
+           *
+           */
+          Value infix(infixExp* InfixExp, Value left, Value right);
+
+          /**
+           * @brief Lets the garbage collector run if it's due. Only called where every
+           * value in use is in a frame, on a node or on the value stack.
+           *
+           */
+          void pollCollector();
+
+          //Visitor functions
+          void visitProgram(program* prog) override;
+          void visitBreak(NBreak* Break) override;
+          void visitNil(NNil* Nil) override;
+          void visitID(NId* id) override;
+          void visitTyID(NTyId* tyid) override;
+          void visitSubscript(subscript* Subscript) override;
+          void visitFieldExp(fieldExp* FieldExp) override;
+          void visitSeqExp(seqExp*) override;
+          void visitNegation(negation*) override;
+          void visitCallExp(callExp*) override;
+          void visitIntLit(NIntLit*) override;
+          void visitStrLit(NStrLit*) override;
+          void visitInfixExp(infixExp*) override;
+          void visitArrCreate(arrCreate*) override;
+          void visitRecCreate(recCreate*) override;
+          void visitFieldCreate(fieldCreate*) override;
+          void visitAssignment(assignment*) override;
+          void visitIfThenElse(ifThenElse*) override;
+          void visitWhileExp(whileExp*) override;
+          void visitForExp(forExp*) override;
+          void visitLetExp(letExp*) override;
+          void visitDec(decc*) override;
+          void visitTyDec(tyDec*) override;
+          void visitTyDef(tyDef*) override;
+          void visitRefTy(refTy*) override;
+          void visitArrTy(arrTy*) override;
+          void visitRecTy(recTy*) override;
+          void visitFieldDec(fieldDec*) override;
+          void visitFunDec(funDec*) override;
+          void visitVarDec(varDec*) override;
+
+          /**
+           * @brief Nodes partway through being evaluated, innermost last.
+           *
+           */
+          vector<Continuation> stack;
+
+          /**
+           * @brief Results of evaluated expressions waiting to be used by the
+           * nodes that evaluated them.
+           *
+           */
+          vector<Value> values;
+
+          /**
+           * @brief Frame of the innermost scope being run.
+           *
+           */
+          Frame* frame;
+
+          /**
+           * @brief Where every frame comes from, reused as scopes are left.
+           *
+           */
+          FrameStack frames;
+
+          /**
+           * @brief Bytes taken by frames that are in use.
+           *
+           */
+          size_t frameBytes;
+
+          /**
+           * @brief Bytes of continuations, values and frames allowed.
+           *
+           */
+          size_t limit;
+
+          /**
+           * @brief Frees strings, arrays and records that are no longer reachable,
+           * or NULL to never free them.
+           *
+           */
+          GarbageCollector* collector = NULL;
+};
+/** @} */
+#endif
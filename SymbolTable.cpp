@@ -1,7 +1,11 @@
 #include <map>
 #include <string>
 #include <iostream>
+#include <string.h>
+#include <stdlib.h>
+#include <new>
 #include "SymbolTable.h"
+#include "Builtins.h"
 
 using namespace std;
 
@@ -51,45 +55,63 @@ void SymbolTable::DefaultTigerTable()
      Scope* defScope = new Scope(top, S_LET);
 
      //Add default types
-     Type* i = new Type("int",T_PRIM);
+     Type* i = new Type(ATOM_INT,T_PRIM);
      defScope->AddType(i);
-     Type* s = new Type("string",T_PRIM);
+     Type* s = new Type(ATOM_STRING,T_PRIM);
      defScope->AddType(s);
-     Type* u = new Type("unit",T_PRIM);
+     Type* u = new Type(ATOM_UNIT,T_PRIM);
      defScope->AddType(u);
 
-     //Add print function
-     vector< pair<string,Type*> > printMap;
-     printMap.push_back(pair<string,Type*>("s", s)); 
-     defScope->AddSymbol(new FuncSymbol("print", SYM_FUNC, u, printMap));
-
-     //Add integer print function
-     vector< pair<string,Type*> > iPrintMap;
-     iPrintMap.push_back(pair<string,Type*>("i", i)); 
-     defScope->AddSymbol(new FuncSymbol("printi", SYM_FUNC, u, iPrintMap));
-
-     //Add not function
-     vector< pair<string,Type*> > notMap;
-     notMap.push_back(pair<string,Type*>("i", i)); 
-     defScope->AddSymbol(new FuncSymbol("not", SYM_FUNC, i, notMap));
+     //Add the standard library, each function bound to the native code that runs it
+     for(int b = 0; b < BUILTIN_COUNT; b++)
+     {
+          vector< pair<Atom,Type*> > params;
+          for(int p = 0; p < builtins[b].numParams; p++)
+          {
+               const char* paramName = builtins[b].params[p][0];
+               const char* paramType = builtins[b].params[p][1];
+               params.push_back(pair<Atom,Type*>(Intern(paramName, strlen(paramName)), defScope->LookupType(Intern(paramType, strlen(paramType)))));
+          }
+          Atom name = Intern(builtins[b].name, strlen(builtins[b].name));
+          Atom result = Intern(builtins[b].result, strlen(builtins[b].result));
+          FuncSymbol* function = new FuncSymbol(name, SYM_FUNC, defScope->LookupType(result), params);
+          function->builtin = &builtins[b];
+          defScope->AddSymbol(function);
+     }
 
      //Add this to the top of the stack
      this->PushScope(defScope);
 }
-Symbol* SymbolTable::LookupSymbol(const string &id)
+Symbol* SymbolTable::LookupSymbol(Atom id)
+{
+     Scope* currentScope = top;
+     while(currentScope != NULL)
+     {
+          Symbol* symb = currentScope->LookupSymbol(id);
+          if(symb != NULL)
+               return symb;
+          currentScope = currentScope->last;
+     }
+
+     return NULL;
+}
+Symbol* SymbolTable::LookupSymbol(Atom id, int &depth)
 {
+     depth = 0;
      Scope* currentScope = top;
      while(currentScope != NULL)
      {
           Symbol* symb = currentScope->LookupSymbol(id);
           if(symb != NULL)
                return symb;
+          if(currentScope->HasFrame())
+               depth++;
           currentScope = currentScope->last;
      }
 
      return NULL;
 }
-Type* SymbolTable::LookupType(const string &id)
+Type* SymbolTable::LookupType(Atom id)
 {
      Scope* currentScope = top;
      while(currentScope != NULL)
@@ -129,40 +151,34 @@ Scope::Scope()
      last = NULL;
      source = S_LET;
 }
-Scope::Scope(map<string,Symbol*> decs, map<string,Type*> types, ScopeType source)
+Scope::Scope(map<Atom,Symbol*> decs, map<Atom,Type*> types, ScopeType source)
 :decs(decs),types(types),source(source)
 {
      last = NULL;
 }
 Scope::Scope(Scope* last, ScopeType source):last(last),source(source){}
-Scope::Scope(Scope* last, map<string,Symbol*> decs, map<string,Type*> types, ScopeType source)
+Scope::Scope(Scope* last, map<Atom,Symbol*> decs, map<Atom,Type*> types, ScopeType source)
 :last(last),decs(decs),types(types),source(source)
  {
 
  }
-Symbol* Scope::LookupSymbol(const string &id)
+Symbol* Scope::LookupSymbol(Atom id)
 {
-     map<string,Symbol*>::iterator itr;
-     for (itr = decs.begin(); itr != decs.end(); ++itr) { 
-          if(itr->first == id)
-               return itr->second;
-    } 
-
-    return NULL;
+     map<Atom,Symbol*>::iterator itr = decs.find(id);
+     if(itr == decs.end())
+          return NULL;
+     return itr->second;
 }
-Type* Scope::LookupType(const string &id)
+Type* Scope::LookupType(Atom id)
 {
-     map<string,Type*>::iterator itr;
-     for (itr = types.begin(); itr != types.end(); ++itr) { 
-          if(itr->first == id)
-               return itr->second;
-    } 
-
-    return NULL;
+     map<Atom,Type*>::iterator itr = types.find(id);
+     if(itr == types.end())
+          return NULL;
+     return itr->second;
 }
 bool Scope::AddSymbol(Symbol* symbol)
 {
-     pair<map<string,Symbol*>::iterator,bool> result = decs.insert(pair<string,Symbol*>(symbol->name, symbol));
+     pair<map<Atom,Symbol*>::iterator,bool> result = decs.insert(pair<Atom,Symbol*>(symbol->name, symbol));
      //If there's already a symbol for it in the table...
      if(result.second == false)
      {
@@ -180,17 +196,21 @@ bool Scope::AddSymbol(Symbol* symbol)
                //Wipe the other symbol since it's basically irrelevant now,
                // then insert this new one
                decs.erase(symbol->name);
-               decs.insert(pair<string,Symbol*>(symbol->name, symbol));
+               decs.insert(pair<Atom,Symbol*>(symbol->name, symbol));
+               symbol->slot = frameSize++;
                return true;
           }
      }
 
      else
+     {
+          symbol->slot = frameSize++;
           return true;
+     }
 }
 bool Scope::AddType(Type* type)
 {
-     pair<map<string,Type*>::iterator,bool> result = types.insert(pair<string,Type*>(type->name, type));
+     pair<map<Atom,Type*>::iterator,bool> result = types.insert(pair<Atom,Type*>(type->name, type));
      //If there's already a symbol for it in the table...
      if(result.second == false)
      {
@@ -208,10 +228,15 @@ bool Scope::RemoveType(Type* type)
           return true;
 }
 
+bool Scope::HasFrame()
+{
+     return source != S_WHILE;
+}
+
 void Scope::Print()
 {
      //Print symbols
-     map<string,Symbol*>::iterator symItr;
+     map<Atom,Symbol*>::iterator symItr;
      cout << "-SYMBOLS-" << endl << endl;
      for (symItr = decs.begin(); symItr != decs.end(); ++symItr) 
      { 
@@ -221,7 +246,7 @@ void Scope::Print()
      cout << endl;
 
     //Print Types
-     map<string,Type*>::iterator tyItr;
+     map<Atom,Type*>::iterator tyItr;
      cout << "-TYPES-" << endl << endl;
      for (tyItr = types.begin(); tyItr != types.end(); ++tyItr) 
      { 
@@ -235,22 +260,22 @@ void Scope::Print()
  * SYMBOLS
  * *******/
 Symbol::~Symbol(){}
-Symbol::Symbol(const string &name, SymbolKind kind):name(name), kind(kind){}
+Symbol::Symbol(Atom name, SymbolKind kind):name(name), kind(kind), slot(-1){}
 void Symbol::Print()
 {
-     cout << name << " (<" << type->name << ">)";
+     cout << *name << " (<" << *type->name << ">)";
 }
 
 /************
  * VAR SYMBOL
  * **********/
 
-VarSymbol::VarSymbol(const string &name, SymbolKind kind, Type* type, bool readOnly):Symbol(name,kind)
+VarSymbol::VarSymbol(Atom name, SymbolKind kind, Type* type, bool readOnly):Symbol(name,kind)
 {
      this->type = type;
      this->readOnly = readOnly;
 }
-VarSymbol::VarSymbol(const string &name, SymbolKind kind, Type* type, Value* val, bool readOnly)
+VarSymbol::VarSymbol(Atom name, SymbolKind kind, Type* type, Value* val, bool readOnly)
 :Symbol(name,kind), val(val)
 {
      this->type = type;
@@ -258,20 +283,20 @@ VarSymbol::VarSymbol(const string &name, SymbolKind kind, Type* type, Value* val
 }
 void VarSymbol::Print()
 {
-     cout << name << " (<" << type->name << ">)";
+     cout << *name << " (<" << *type->name << ">)";
 }
 
-FuncSymbol::FuncSymbol(const string &name, SymbolKind kind, Type* type, vector< pair<string,Type*> > args):
-Symbol(name,kind), args(args)
+FuncSymbol::FuncSymbol(Atom name, SymbolKind kind, Type* type, vector< pair<Atom,Type*> > args):
+Symbol(name,kind), args(args), declaration(NULL), builtin(NULL)
 {
      this->type = type;
 }
 void FuncSymbol::Print()
 {
-     cout << type->name << " " << name << " (";
+     cout << *type->name << " " << *name << " (";
      for(int i = 0; i < args.size(); i++)
      {
-          cout << args[i].first << " : <" << args[i].second->name << "> , ";
+          cout << *args[i].first << " : <" << *args[i].second->name << "> , ";
      }
 
      cout << ")";
@@ -283,7 +308,7 @@ Scope* FuncSymbol::CreateScopeFromParams()
      scope->source = S_FUNC;
      for(int i = 0; i < args.size(); i++)
      {
-          pair<string,Type*> param = args[i];
+          pair<Atom,Type*> param = args[i];
           scope->AddSymbol(new VarSymbol(param.first, SYM_VAR, param.second));
      }
 
@@ -294,7 +319,7 @@ Scope* FuncSymbol::CreateScopeFromParams()
  * TYPES
  * ******/
 
-Type::Type(const string &name, TypeKind kind):name(name), kind(kind){}
+Type::Type(Atom name, TypeKind kind):name(name), kind(kind){}
 Type::~Type(){}
 bool Type::Equals(Type* rhs)
 {
@@ -349,8 +374,8 @@ bool Type::Equals(Type* rhs)
                //actualType2 = &rhs;
 
 
-          cout << "Set left actual type to " << actualType1->name << endl;
-          cout << "Set right actual type to " << actualType2->name << endl;
+          cout << "Set left actual type to " << *actualType1->name << endl;
+          cout << "Set right actual type to " << *actualType2->name << endl;
           //This should set either side to either int or string
           if(actualType1->name == actualType2->name)
                return true;
@@ -363,7 +388,7 @@ bool Type::Equals(Type* rhs)
 
 Type* Type::GetActualType()
 {
-     if(name == "int" || name == "string")
+     if(name == ATOM_INT || name == ATOM_STRING)
      {
           return this;
      }
@@ -384,7 +409,7 @@ Type* Type::GetActualType()
 
 TypeKind Type::GetActualKind()
 {
-     if(name == "int" || name == "string")
+     if(name == ATOM_INT || name == ATOM_STRING)
      {
           return this->kind;
      }
@@ -405,10 +430,10 @@ TypeKind Type::GetActualKind()
 }
 void Type::Print()
 {
-     cout << name;
+     cout << *name;
 }
-RefType::RefType(const string &name, TypeKind kind):Type(name,kind){}
-RefType::RefType(const string &name, TypeKind kind, Type* ref):Type(name,kind), ref(ref)
+RefType::RefType(Atom name, TypeKind kind):Type(name,kind){}
+RefType::RefType(Atom name, TypeKind kind, Type* ref):Type(name,kind), ref(ref)
 {
      //Store the kind of the kind of reference
      // since it's important to note what kind of type the
@@ -422,10 +447,10 @@ RefType::RefType(const string &name, TypeKind kind, Type* ref):Type(name,kind),
 }
 void RefType::Print()
 {
-     cout << name << " (ref to " << ref->name << ")";
+     cout << *name << " (ref to " << *ref->name << ")";
 }
-ArrType::ArrType(const string &name, TypeKind kind):Type(name,kind){}
-ArrType::ArrType(const string &name, TypeKind kind, Type* ref):Type(name,kind), ref(ref)
+ArrType::ArrType(Atom name, TypeKind kind):Type(name,kind){}
+ArrType::ArrType(Atom name, TypeKind kind, Type* ref):Type(name,kind), ref(ref)
 {
      //Store the kind of the kind of reference
      // since it's important to note what kind of type the
@@ -438,251 +463,501 @@ ArrType::ArrType(const string &name, TypeKind kind, Type* ref):Type(name,kind),
 }
 void ArrType::Print()
 {
-     cout << name << " (array of " << ref->name << ")";
+     cout << *name << " (array of " << *ref->name << ")";
 }
-RecType::RecType(const string &name, TypeKind kind):Type(name,kind){}
-RecType::RecType(const string &name, TypeKind kind, map<string,Type*>* fields):Type(name,kind),fields(fields)
+RecType::RecType(Atom name, TypeKind kind):Type(name,kind){}
+RecType::RecType(Atom name, TypeKind kind, map<Atom,Type*>* fields):Type(name,kind),fields(fields)
 {
 }
 void RecType::Print()
 {
-     cout << name;
+     cout << *name;
 }
-bool RecType::hasMember(const string &name)
+bool RecType::hasMember(Atom name)
 {
-     map<string,Type*>::iterator itr = fields->find(name);
+     map<Atom,Type*>::iterator itr = fields->find(name);
      if(itr == fields->end())
           return false;
      else 
           return true;
 }
-pair<string,Type*> RecType::getFieldPair(const string &name)
+pair<Atom,Type*> RecType::getFieldPair(Atom name)
 {
-     map<string,Type*>::iterator itr = fields->find(name);
+     map<Atom,Type*>::iterator itr = fields->find(name);
      if(itr == fields->end())
           cout << "WARNING: getFieldPair() found no field with such a name.\n";
      return *itr;
 
 }
+int RecType::fieldSlot(Atom name)
+{
+     if(slots.size() != fields->size())
+     {
+          slots.clear();
+          int slot = 0;
+          for(map<Atom,Type*>::iterator itr = fields->begin(); itr != fields->end(); itr++)
+               slots[itr->first] = slot++;
+     }
+     map<Atom,int>::iterator itr = slots.find(name);
+     if(itr == slots.end())
+          return -1;
+     return itr->second;
+}
 
 /*********
  * VALUES
  * *******/
 
-Value::Value(){}
-void Value::Print(){cout << "(no value)";};
-Value* Value::Copy(){return NULL;}
-bool Value::operator==(Value* other)
+Value::Value():kind(V_UNIT), integer(0){}
+Value::Value(int val):kind(V_INT), integer(val){}
+Value::Value(StringObject* val):kind(V_STR), str(val){}
+Value::Value(ArrayObject* val):kind(V_ARR), arr(val){}
+Value::Value(RecordObject* val):kind(V_REC), rec(val){}
+Value Value::Nil()
+{
+     Value nil;
+     nil.kind = V_NIL;
+     return nil;
+}
+int Value::GetInt(){return integer;}
+int* Value::GetAddress(){return &integer;}
+StringObject* Value::GetStringObject(){return str;}
+ArrayObject* Value::GetArray(){return arr;}
+RecordObject* Value::GetRecord(){return rec;}
+HeapObject* Value::GetObject()
+{
+     if(kind == V_STR)
+          return str;
+     else if(kind == V_ARR)
+          return arr;
+     else if(kind == V_REC)
+          return rec;
+     else
+          return NULL;
+}
+void Value::Print()
+{
+     if(kind == V_INT)
+          cout << integer;
+     else if(kind == V_STR)
+          cout.write(str->GetChars(), str->GetLength());
+     else if(kind == V_ARR)
+          arr->Print();
+     else if(kind == V_REC)
+          rec->Print();
+     else if(kind == V_NIL)
+          cout << "nil";
+     else
+          cout << "(no value)";
+}
+bool Value::operator==(const Value &other)
 {
-     if(this->kind == other->kind)
+     if(kind != other.kind)
+          return false;
+     if(kind == V_INT)
+          return integer == other.integer;
+     else if(kind == V_STR)
+          return str->Equals(other.str);
+     else if(kind == V_ARR)
+          return arr == other.arr;
+     else if(kind == V_REC)
+          return rec == other.rec;
+     else
           return true;
+}
+
+HeapObject* HeapObject::newest = NULL;
+size_t HeapObject::liveBytes = 0;
+size_t HeapObject::liveObjects = 0;
+
+HeapObject::HeapObject():marked(false), bytes(0), previous(NULL), next(newest)
+{
+     if(newest != NULL)
+          newest->previous = this;
+     newest = this;
+     liveObjects++;
+}
+HeapObject::~HeapObject()
+{
+     if(previous != NULL)
+          previous->next = next;
      else
-          return false;
+          newest = next;
+     if(next != NULL)
+          next->previous = previous;
+     liveObjects--;
+     liveBytes -= bytes;
 }
+void HeapObject::Trace(vector<HeapObject*> &objects){}
+void HeapObject::Account(size_t size)
+{
+     bytes += size;
+     liveBytes += size;
+}
+
+StringObject::StringObject(const string &val):hash(0), left(NULL), right(NULL), viewed(NULL)
+{
+     allocate(val.size());
+     memcpy(chars, val.data(), length);
+}
+StringObject::StringObject(const char* chars, int length):hash(0), left(NULL), right(NULL), viewed(NULL)
+{
+     allocate(length);
+     memcpy(this->chars, chars, length);
+}
+StringObject::StringObject(StringObject* left, StringObject* right):hash(0), left(NULL), right(NULL), viewed(NULL)
+{
+     int total = left->length + right->length;
+     if(total <= STRING_INLINE_SIZE)
+     {
+          allocate(total);
+          memcpy(chars, left->GetChars(), left->length);
+          memcpy(chars + left->length, right->GetChars(), right->length);
+          return;
+     }
 
-/**
- * @brief Copies the passed value and sets its own value to match.
- * 
- * @param other The value to copy.
- */
-void Value::SetValue(Value* other)
+     //Just remember the halves; the characters are only put together once needed
+     chars = NULL;
+     length = total;
+     this->left = left;
+     this->right = right;
+     Account(sizeof(StringObject));
+}
+StringObject::StringObject(StringObject* whole, int first, int length):hash(0), left(NULL), right(NULL), viewed(NULL)
 {
-     if(kind == V_INT) //Int value
+     if(length <= STRING_INLINE_SIZE)
      {
-          IntValue* newInt = ((IntValue*)((IntValue*)other)->Copy());
-          ((IntValue*)this)->SetValue(newInt->GetValue());
-          delete newInt;
+          allocate(length);
+          memcpy(chars, whole->GetChars() + first, length);
+          return;
      }
-     else if(kind == V_STR) //String value
+
+     //Look straight into the flat string that owns the characters, never another view
+     const char* wholeChars = whole->GetChars();
+     viewed = (whole->viewed != NULL) ? whole->viewed : whole;
+     chars = (char*)wholeChars + first;
+     this->length = length;
+     Account(sizeof(StringObject));
+}
+StringObject::~StringObject()
+{
+     if(chars != NULL && chars != inlineChars && viewed == NULL)
+          delete[] chars;
+}
+void StringObject::Trace(vector<HeapObject*> &objects)
+{
+     if(left != NULL)
      {
-          StringValue* newString = ((StringValue*)((StringValue*)other)->Copy());
-          ((StringValue*)this)->SetValue(newString->GetValue());
-          delete newString;
+          objects.push_back(left);
+          objects.push_back(right);
      }
-     else if(kind == V_ARR) //Array value
+     if(viewed != NULL)
+          objects.push_back(viewed);
+}
+void StringObject::allocate(int length)
+{
+     this->length = length;
+     if(length <= STRING_INLINE_SIZE)
      {
-          ArrayValue* newArray = ((ArrayValue*)((ArrayValue*)other)->Copy());
-          ((ArrayValue*)this)->SetValue(newArray->GetArray());
-          delete newArray;
+          chars = inlineChars;
+          Account(sizeof(StringObject));
      }
-     else //Record value
+     else
      {
-          RecordValue* newRecord = ((RecordValue*)((RecordValue*)other)->Copy());
-          ((RecordValue*)this)->SetValue(newRecord->GetRecord());
-          delete newRecord;
+          chars = new char[length];
+          Account(sizeof(StringObject) + length);
      }
 }
+void StringObject::flatten()
+{
+     char* buffer = new char[length];
+     char* end = buffer;
 
-IntValue::IntValue(int val){ this->val = val; kind = V_INT;}
-int IntValue::GetValue(){return val;}
-void IntValue::SetValue(const int &inVal){val = inVal;}
-void IntValue::SetValue(IntValue* otherValue){val = otherValue->GetValue();}
-void IntValue::Print(){cout << GetValue();}
-Value* IntValue::Copy(){return new IntValue(GetValue());}
-bool IntValue::operator==(Value* other)
+     //Pieces are copied left to right, with the right halves waiting on a stack
+     vector<StringObject*> pending;
+     pending.push_back(this);
+     while(!pending.empty())
+     {
+          StringObject* piece = pending.back();
+          pending.pop_back();
+          if(piece->chars == NULL)
+          {
+               pending.push_back(piece->right);
+               pending.push_back(piece->left);
+          }
+          else
+          {
+               memcpy(end, piece->chars, piece->length);
+               end += piece->length;
+          }
+     }
+
+     //The halves aren't needed anymore, so they can be collected if nothing else uses them
+     chars = buffer;
+     left = NULL;
+     right = NULL;
+     Account(length);
+}
+const char* StringObject::GetChars()
 {
-     IntValue* intVal = (IntValue*) other;
-     if(intVal->val == this->val)
+     if(chars == NULL)
+          flatten();
+     return chars;
+}
+int StringObject::GetLength(){return length;}
+size_t StringObject::GetHash()
+{
+     if(hash == 0)
+     {
+          //FNV-1a, kept away from 0 so 0 can mean not worked out yet
+          const char* chars = GetChars();
+          size_t h = (size_t)14695981039346656037ULL;
+          for(int i = 0; i < length; i++)
+               h = (h ^ (unsigned char)chars[i]) * (size_t)1099511628211ULL;
+          hash = (h == 0) ? 1 : h;
+     }
+     return hash;
+}
+bool StringObject::Equals(StringObject* other)
+{
+     if(this == other)
           return true;
-     else
+     if(length != other->length)
           return false;
+     if(hash != 0 && other->hash != 0 && hash != other->hash)
+          return false;
+     return memcmp(GetChars(), other->GetChars(), length) == 0;
+}
+int StringObject::Compare(StringObject* other)
+{
+     if(this == other)
+          return 0;
+     int shorter = (length < other->length) ? length : other->length;
+     int result = memcmp(GetChars(), other->GetChars(), shorter);
+     if(result != 0)
+          return result;
+     return length - other->length;
 }
 
-StringValue::StringValue(const string &val):val(val){kind = V_STR;}
-string StringValue::GetValue(){return val;}
-void StringValue::SetValue(const string &inVal){val = inVal;}
-void StringValue::SetValue(StringValue* otherValue){val = otherValue->GetValue();}
-void StringValue::Print(){cout << GetValue();}
-Value* StringValue::Copy(){return new StringValue(GetValue());}
-bool StringValue::operator ==(Value* other)
+ArrayObject::ArrayObject(const int &size, Value val, bool ints):ints(ints), size(size), initial(val)
 {
-     StringValue* str = (StringValue*) other;
-     if(str->val == this->val)
-          return true;
+     //No chunk is allocated until it's written to
+     int chunks = (size + ARRAY_CHUNK_MASK) >> ARRAY_CHUNK_BITS;
+     if(ints)
+          integers.resize(chunks);
      else
-          return false;
+          this->val.resize(chunks);
+     Account(sizeof(ArrayObject) + chunks * sizeof(vector<Value>));
 }
-
-ArrayValue::ArrayValue(const int &size, Value* val)
+bool ArrayObject::InBounds(const int &index)
 {
-     kind = V_ARR; 
-     for(int i = 0; i < size; i++)
+     //A negative index wraps around to well past any size
+     return (unsigned)index < (unsigned)size;
+}
+Value ArrayObject::Get(const int &index)
+{
+     int chunk = index >> ARRAY_CHUNK_BITS;
+     if(ints)
      {
-          //cout << "PUSHED BACK" << endl;
-          this->val.push_back(val->Copy());
+          if(integers[chunk].empty())
+               return initial;
+          return Value(integers[chunk][index & ARRAY_CHUNK_MASK]);
      }
+     if(val[chunk].empty())
+          return initial;
+     return val[chunk][index & ARRAY_CHUNK_MASK];
 }
-ArrayValue::ArrayValue(vector<Value*> val):val(val){}
-
-Value* ArrayValue::GetValue(const int &index)
+void ArrayObject::Set(const int &index, Value value)
 {
-     //If the value exceeds the bounds of the array...
-     if(index < 0 || index >= this->val.size() )
+     int chunk = index >> ARRAY_CHUNK_BITS;
+     if(ints)
      {
-          //Throw a runtime error
-          //cout << "ERROR: Runtime: Array access out of bounds." << endl;
-          //exit(4);
-          return NULL;
+          if(integers[chunk].empty())
+               materialize(chunk);
+          integers[chunk][index & ARRAY_CHUNK_MASK] = value.GetInt();
      }
-     return val[index];}
-vector<Value*> ArrayValue::GetArray(){return val;}
-void ArrayValue::SetValue(const int &index, Value* val)
-{
-     //If the value exceeds the bounds of the array...
-     if(index < 0 || index >= this->val.size() )
+     else
      {
-          //Throw a runtime error
-          cout << "ERROR: Runtime: Array access out of bounds." << endl;
-          exit(4);
+          if(val[chunk].empty())
+               materialize(chunk);
+          val[chunk][index & ARRAY_CHUNK_MASK] = value;
      }
-          
-     delete this->val[index];
-     this->val[index] = val->Copy();
 }
-void ArrayValue::SetValue(vector<Value*> val){this->val = val;}
-void ArrayValue::Print()
+int* ArrayObject::GetIntAddress(const int &index)
 {
-     for(int i = 0; i < val.size()-1; i++)
-     {
-          val[i]->Print();
-          cout << ", ";
-     }
-     
-     val[val.size()-1]->Print();
+     int chunk = index >> ARRAY_CHUNK_BITS;
+     if(integers[chunk].empty())
+          materialize(chunk);
+     return &integers[chunk][index & ARRAY_CHUNK_MASK];
 }
-Value* ArrayValue::Copy()
+int ArrayObject::Size(){return size;}
+void ArrayObject::Print()
 {
-     vector<Value*> newValues;
-     for(int i = 0; i < val.size(); i++)
+     for(int i = 0; i < Size(); i++)
      {
-          newValues.push_back(val[i]->Copy());
+          if(i > 0)
+               cout << ", ";
+          Get(i).Print();
      }
-
-     return new ArrayValue(newValues);
 }
-bool ArrayValue::operator==(Value* other)
+void ArrayObject::Trace(vector<HeapObject*> &objects)
 {
-     ArrayValue* arr = (ArrayValue*) other;
-     if(val.size() == arr->val.size())
+     //Elements of an array of ints never refer to anything
+     HeapObject* object = initial.GetObject();
+     if(object != NULL)
+          objects.push_back(object);
+     for(int chunk = 0; chunk < val.size(); chunk++)
      {
-          for(int i = 0; i < val.size(); i++)
+          for(int i = 0; i < val[chunk].size(); i++)
           {
-               if(!(val[i] == arr->val[i]))
-               {
-                    return false;
-               }
+               object = val[chunk][i].GetObject();
+               if(object != NULL)
+                    objects.push_back(object);
           }
-          return true;
      }
-     else
-          return false;
 }
-RecordValue::RecordValue(){kind = V_REC;}
-RecordValue::RecordValue(map<string,Value*> val):val(val){kind = V_REC;}
-Value* RecordValue::GetValue(const string &member)
+void ArrayObject::materialize(const int &chunk)
 {
-     map<string,Value*>::iterator itr = val.find(member);
-     if(itr == val.end())
+     //The last chunk only holds what's left of the array
+     int count = size - (chunk << ARRAY_CHUNK_BITS);
+     if(count > ARRAY_CHUNK_SIZE)
+          count = ARRAY_CHUNK_SIZE;
+     if(ints)
      {
-          cout << "Wait...RecordValue couldn't find member?" << endl;
-          exit(4);
-     }
-     return (itr->second)->Copy();
+          integers[chunk].assign(count, initial.GetInt());
+          Account(count * sizeof(int));
      }
-void RecordValue::SetValue(const string &key, Value* inValue)
-{
-     //First, yoink out the value we want
-     map<string,Value*>::iterator itr = val.find(key);
-     if(itr == val.end())
+     else
      {
-          cout << "Wait...RecordValue couldn't find member?" << endl;
-          exit(4);
+          val[chunk].assign(count, initial);
+          Account(count * sizeof(Value));
      }
+}
 
-     //Kill the old value, and replace it with the new one
-     delete itr->second;
-     itr->second = (inValue->Copy());
+RecordObject::RecordObject(RecType* type):type(type), val(type->fields->size())
+{
+     Account(sizeof(RecordObject) + this->val.capacity() * sizeof(Value));
 }
-void RecordValue::SetValue(map<string,Value*> val){this->val = val;}
-map<string, Value*> RecordValue::GetRecord(){return val;}
-void RecordValue::Print()
+Value* RecordObject::GetValue(const int &slot){return &val[slot];}
+void RecordObject::Print()
 {
-     for(map<string,Value*>::iterator itr = val.begin(); itr != val.end(); itr++)
+     int slot = 0;
+     for(map<Atom,Type*>::iterator itr = type->fields->begin(); itr != type->fields->end(); itr++)
      {
-          cout << itr->first << " : ";
-          itr->second->Print();
+          cout << *itr->first << " : ";
+          val[slot++].Print();
           cout << ", ";
      }
 }
-Value* RecordValue::Copy()
+void RecordObject::Trace(vector<HeapObject*> &objects)
 {
-     map<string,Value*> newMap;
-
-     for(map<string,Value*>::iterator itr = val.begin(); itr != val.end(); itr++)
+     for(int i = 0; i < val.size(); i++)
      {
-          newMap.insert(pair<string,Value*>(itr->first, itr->second->Copy()));
+          HeapObject* object = val[i].GetObject();
+          if(object != NULL)
+               objects.push_back(object);
      }
+}
 
-     return new RecordValue(newMap);
+void** WordBlock::Make(size_t count)
+{
+     void* memory = malloc(sizeof(WordBlock) + count * sizeof(void*));
+     if(memory == NULL)
+          return NULL;
+     WordBlock* block = new(memory) WordBlock(count);
+     memset(block->Words(), 0, count * sizeof(void*));
+     return block->Words();
+}
+WordBlock::WordBlock(size_t count):count(count)
+{
+     Account(sizeof(WordBlock) + count * sizeof(void*));
+}
+void WordBlock::operator delete(void* memory)
+{
+     free(memory);
 }
 
-bool RecordValue::operator==(Value* other)
+/***************
+ *  FRAME
+ * ************/
+
+Frame* Frame::Ancestor(int depth)
+{
+     Frame* frame = this;
+     for(int i = 0; i < depth; i++)
+          frame = frame->parent;
+     return frame;
+}
+Value& Frame::Lookup(int depth, int slot)
 {
-     RecordValue* rec = (RecordValue*) other;
+     return Ancestor(depth)->slots[slot];
+}
+
+/***************
+ *  FRAME STACK
+ * ************/
 
-     if(rec->val.size() == this->val.size())
+FrameStack::FrameStack():depth(0), chunk(0), used(0){}
+FrameStack::~FrameStack()
+{
+     for(int i = 0; i < frames.size(); i++)
+          delete frames[i];
+     for(int i = 0; i < chunks.size(); i++)
+          delete[] chunks[i];
+}
+Frame* FrameStack::Push(Frame* parent, int size, Frame* caller)
+{
+     if(depth == frames.size())
+          frames.push_back(new Frame());
+     Frame* frame = frames[depth++];
+     frame->parent = parent;
+     frame->caller = (caller != NULL) ? caller : parent;
+     place(frame, size);
+     return frame;
+}
+void FrameStack::Pop()
+{
+     //Everything above where the frame started is free again
+     Frame* frame = frames[--depth];
+     chunk = frame->chunk;
+     used = frame->offset;
+}
+void FrameStack::Resize(int size)
+{
+     Frame* frame = frames[depth-1];
+     chunk = frame->chunk;
+     used = frame->offset;
+     place(frame, size);
+}
+void FrameStack::place(Frame* frame, int size)
+{
+     //Move on to the next block if this one can't fit the frame, making it
+     // (or remaking it bigger) if need be
+     if(chunks.empty() || used + size > chunkSizes[chunk])
      {
-          for(map<string,Value*>::iterator itr = val.begin(); itr != val.end(); itr++)
+          if(!chunks.empty())
+               chunk++;
+          if(chunk == chunks.size())
           {
-               map<string,Value*>::iterator otherRecItr = rec->val.find(itr->first);
-               if(otherRecItr == rec->val.end())
-                    return false;
-               if(!(otherRecItr->second == itr->second))
-                    return false;
+               chunks.push_back(NULL);
+               chunkSizes.push_back(0);
           }
-          return true;
+          if(chunkSizes[chunk] < size || chunks[chunk] == NULL)
+          {
+               delete[] chunks[chunk];
+               chunkSizes[chunk] = (size > FRAME_CHUNK_SLOTS) ? size : FRAME_CHUNK_SLOTS;
+               chunks[chunk] = new Value[chunkSizes[chunk]];
+          }
+          used = 0;
      }
-     else
-          return false;
-          
+
+     frame->slots = chunks[chunk] + used;
+     frame->size = size;
+     frame->chunk = chunk;
+     frame->offset = used;
+     used += size;
+
+     //Slots left over from earlier frames would look like live values to the collector
+     for(int i = 0; i < size; i++)
+          frame->slots[i] = Value();
 }
\ No newline at end of file
@@ -25,6 +25,7 @@
 #include <string>
 #include <iostream>
 #include <vector>
+#include "Atom.h"
 
 using namespace std;
 
@@ -33,6 +34,12 @@ class Scope;
 class Symbol;
 class Type;
 class Value;
+class funDec;
+class HeapObject;
+class Builtin;
+class StringObject;
+class ArrayObject;
+class RecordObject;
 
 /**
  * @brief Table of symbols and types arranged in a scope
@@ -86,7 +93,17 @@ class SymbolTable{
            * 
            * @return Symbol* The symbol, if found; NULL if not found in the table.
            */
-          Symbol* LookupSymbol(const string &);
+          Symbol* LookupSymbol(Atom );
+
+          /**
+           * @brief Searches the scope stack for a function or variable symbol like
+           * LookupSymbol, also counting how many frames out from the current one it
+           * was found in. Scopes that don't get a frame at runtime aren't counted.
+           * @param depth Set to the number of frames between the current one and the symbol's.
+           * @return Symbol* The symbol, if found; NULL if not found in the table.
+           * 
+           */
+          Symbol* LookupSymbol(Atom , int &depth);
 
           /**
            * @brief Searches the entire scope stack for a type by 
@@ -94,7 +111,7 @@ class SymbolTable{
            * 
            * @return Type* The type, if found; NULL if not found in the table.
            */
-          Type* LookupType(const string &);
+          Type* LookupType(Atom );
 
           /**
            * @brief Returns true if the symbol table has no scopes on it.
@@ -183,7 +200,7 @@ class Scope{
            * @param types A map of types to start with.
            * @param source The origin of this scope.
            */
-          Scope(map<string,Symbol*> decs, map<string,Type*> types, ScopeType source);
+          Scope(map<Atom,Symbol*> decs, map<Atom,Type*> types, ScopeType source);
 
           /**
            * @brief Construct a new Scope object with a previous scope, given symbols, types,
@@ -194,7 +211,7 @@ class Scope{
            * @param types A map of types to start with.
            * @param source The origin of this scope.
            */
-          Scope(Scope* last, map<string,Symbol*> decs, map<string,Type*> types, ScopeType source);
+          Scope(Scope* last, map<Atom,Symbol*> decs, map<Atom,Type*> types, ScopeType source);
 
           /**
            * @brief Search for a symbol by name; if found, return it, else, return NULL.
@@ -202,7 +219,7 @@ class Scope{
            * @param id Name of symbol to search for.
            * @return Symbol* The symbol, if found; else, NULL.
            */
-          Symbol* LookupSymbol(const string &id);
+          Symbol* LookupSymbol(Atom id);
 
           /**
            * @brief Search for a type by name; if found, return it, else, return NULL.
@@ -210,7 +227,7 @@ class Scope{
            * @param id Name of type to search for.
            * @return Type* The type, if found; else, NULL.
            */
-          Type* LookupType(const string &id);
+          Type* LookupType(Atom id);
 
           /**
            * @brief Adds a symbol to the current scope. Returns false if
@@ -244,6 +261,15 @@ class Scope{
            */
           bool RemoveType(Type* type);
 
+          /**
+           * @brief Returns true if the scope gets a frame of its own at runtime;
+           * while loops don't, since they declare nothing.
+           * @return true If the scope has a frame.
+           * @return false If the scope shares its enclosing frame.
+           * 
+           */
+          bool HasFrame();
+
           /**
            * @brief Prints all symbols and types in the current scope.
            * 
@@ -260,19 +286,26 @@ class Scope{
            * @brief All variable and function symbols by name.
            * 
            */
-          map<string, Symbol*> decs;
+          map<Atom, Symbol*> decs;
 
           /**
            * @brief All types by name.
            * 
            */
-          map<string, Type*> types;
+          map<Atom, Type*> types;
 
           /**
            * @brief The last scope that this stacks on top of.
            * 
            */
           Scope* last;
+
+          /**
+           * @brief Number of slots handed out to symbols added to this scope; the
+           * size of its frame at runtime.
+           * 
+           */
+          int frameSize = 0;
 };
 
 /************
@@ -316,7 +349,7 @@ class Symbol{
            * @param name The name/identifier for the symbol.
            * @param kind Whether it is a function or variable symbol.
            */
-          Symbol(const string &name, SymbolKind kind);
+          Symbol(Atom name, SymbolKind kind);
 
           /**
            * @brief Prints the name of the symbol.
@@ -328,7 +361,7 @@ class Symbol{
            * @brief The name/identifier for the symbol.
            * 
            */
-          string name;
+          Atom name;
 
           /**
            * @brief The type of a variable symbol, or return type of a function
@@ -343,6 +376,13 @@ class Symbol{
            */
           SymbolKind kind;
 
+          /**
+           * @brief Where the symbol lives in its scope's frame; assigned when it's
+           * added to a scope.
+           * 
+           */
+          int slot;
+
 };
 
 /**
@@ -361,7 +401,7 @@ class VarSymbol : public Symbol {
            * @param readOnly Whether or not the symbol value can be changed at runtime.
            * False by default.
            */
-          VarSymbol(const string &name, SymbolKind kind, Type* type, bool readOnly = false);
+          VarSymbol(Atom name, SymbolKind kind, Type* type, bool readOnly = false);
 
           /**
            * @brief Construct a new Var Symbol object with a name, kind, type,
@@ -374,7 +414,7 @@ class VarSymbol : public Symbol {
            * @param readOnly Whether or not the symbol value can be changed at runtime.
            * False by default.
            */
-          VarSymbol(const string &name, SymbolKind kind, Type* type, Value* val, bool readOnly = false);
+          VarSymbol(Atom name, SymbolKind kind, Type* type, Value* val, bool readOnly = false);
           
           /**
            * @brief Prints the name and type of the symbol.
@@ -411,7 +451,7 @@ class FuncSymbol : public Symbol{
            * @param type Return type of the function.
            * @param args Name->Type pairs for each of its formal parameters. 
            */
-          FuncSymbol(const string &name, SymbolKind kind, Type* type, vector< pair<string,Type*> > args);
+          FuncSymbol(Atom name, SymbolKind kind, Type* type, vector< pair<Atom,Type*> > args);
           
           /**
            * @brief Prints out the function name, return types, and all formal parameters.
@@ -431,7 +471,20 @@ class FuncSymbol : public Symbol{
            * @brief Name->Type pairs for each formal parameter.
            * 
            */
-          vector< pair<string,Type*> > args;
+          vector< pair<Atom,Type*> > args;
+
+          /**
+           * @brief The function's declaration, or NULL for a builtin.
+           * 
+           */
+          funDec* declaration;
+
+          /**
+           * @brief The native function a builtin runs, or NULL for a function
+           * declared in the program.
+           * 
+           */
+          Builtin* builtin;
 };
 
 /*****************
@@ -483,7 +536,7 @@ class Type{
            * @param name The name/identifier for the type.
            * @param kind The kind of type this is.
            */
-          Type(const string &name, TypeKind kind);
+          Type(Atom name, TypeKind kind);
           
           /**
            * @brief Destroy the Type object
@@ -532,7 +585,7 @@ class Type{
            * @brief The name of this type.
            * 
            */
-          string name;
+          Atom name;
 
           /**
            * @brief The kind of this type, either primitive, reference,
@@ -554,7 +607,7 @@ class RefType : public Type{
            * @param name The name/identifier for the type.
            * @param kind The kind of type this is.
            */
-          RefType(const string &name, TypeKind kind);
+          RefType(Atom name, TypeKind kind);
 
           /**
            * @brief Construct a new reference type with given name, kind
@@ -564,7 +617,7 @@ class RefType : public Type{
            * @param kind The kind of type this is.
            * @param ref The type that this type references.
            */
-          RefType(const string &name, TypeKind kind, Type* ref);
+          RefType(Atom name, TypeKind kind, Type* ref);
           
           /**
            * @brief Prints the type name and the type it references.
@@ -592,7 +645,7 @@ class ArrType : public Type{
            * @param name The name/identifier for the type.
            * @param kind The kind of type this is.
            */
-          ArrType(const string &name, TypeKind kind);
+          ArrType(Atom name, TypeKind kind);
 
           /**
            * @brief Construct a new array type with a given name, kind,
@@ -602,7 +655,7 @@ class ArrType : public Type{
            * @param kind The kind of type this is.
            * @param ref The type that this is an array of.
            */
-          ArrType(const string &name, TypeKind kind, Type* ref);
+          ArrType(Atom name, TypeKind kind, Type* ref);
 
           /**
            * @brief Prints the name of the type and type it is an array of.
@@ -629,7 +682,7 @@ class RecType : public Type{
            * @param name The name/identifier for the type.
            * @param kind The kind of type this is.
            */
-          RecType(const string &name, TypeKind kind);
+          RecType(Atom name, TypeKind kind);
 
           /**
            * @brief Construct a new RecordType with a given name, kind,
@@ -639,7 +692,7 @@ class RecType : public Type{
            * @param kind The kind of type this is.
            * @param fields Collection of Name->Type pairs for each field.
            */
-          RecType(const string &name, TypeKind kind, map<string,Type*>* fields);
+          RecType(Atom name, TypeKind kind, map<Atom,Type*>* fields);
           
           /**
            * @brief Prints the name of the record only, because I'm lazy.
@@ -651,7 +704,7 @@ class RecType : public Type{
            * @brief Collection of Name->Type pairs for each field.
            * 
            */
-          map< string,Type*>* fields;
+          map<Atom,Type*>* fields;
 
           /**
            * @brief True if the record type has a field with a given name.
@@ -660,15 +713,31 @@ class RecType : public Type{
            * @return true If the record type has a field with the given name
            * @return false If the record type does not have a field with the given name
            */
-          bool hasMember(const string &name);
+          bool hasMember(Atom name);
 
           /**
            * @brief Returns a Name->Type pair for a field with a given name.
            * 
            * @param name The name of the field to pull out.
-           * @return pair<string,Type*> The Name->Type pair for the found field.
+           * @return pair<Atom,Type*> The Name->Type pair for the found field.
+           */
+          pair<Atom,Type*> getFieldPair(Atom name);
+
+          /**
+           * @brief Returns where a field is in the slots of a record of this type.
+           * Fields take slots in the order the field map keeps them.
+           * 
+           * @param name The name of the field.
+           * @return int The field's slot, or -1 if there is no such field.
+           */
+          int fieldSlot(Atom name);
+
+     private:
+          /**
+           * @brief Slot of each field, worked out the first time one is asked for.
+           * 
            */
-          pair<string,Type*> getFieldPair(const string &name);
+          map<Atom,int> slots;
 };
 
 /***********
@@ -676,11 +745,17 @@ class RecType : public Type{
  * ********/
 
 /**
- * @brief The kind of value that this is, either an integer, string,
- * record, array, or break (technically has no meaning).
+ * @brief The kind of value that this is. Ints, nil and functions are held in the
+ * value itself; strings, arrays and records point to an object on the heap.
  * 
  */
 enum ValueType{
+     /**
+      * @brief No value, such as the result of a unit expression.
+      * 
+      */
+     V_UNIT,
+
      /**
       * @brief An integer value.
       * 
@@ -706,25 +781,71 @@ enum ValueType{
      V_REC,
 
      /**
-      * @brief A break value, special to break nodes and possibly unused.
+      * @brief The nil record.
       * 
       */
-     V_BREAK
+     V_NIL
 };
 
 /**
- * @brief A value for a symbol; could be an integer, array, record, or string. And technically
- * a break.
+ * @brief Tiger int arithmetic. It is done through unsigned so overflow wraps
+ * rather than being undefined, the same in every engine, the JITs' constant
+ * folding and the C the backend emits.
+ * 
+ */
+inline int intAdd(int left, int right){return (int)((unsigned)left + (unsigned)right);}
+inline int intSubtract(int left, int right){return (int)((unsigned)left - (unsigned)right);}
+inline int intMultiply(int left, int right){return (int)((unsigned)left * (unsigned)right);}
+inline int intNegate(int operand){return (int)(0u - (unsigned)operand);}
+
+/**
+ * @brief A value for a symbol or node; small enough to be passed around and stored
+ * by value. Ints and nil live inside it, so working with them never allocates.
  * 
  */
 class Value {
      public:
           /**
-           * @brief Construct a new Value object
+           * @brief Construct a value holding nothing.
            * 
            */
           Value();
 
+          /**
+           * @brief Construct an integer value.
+           * @param val The integer.
+           * 
+           */
+          explicit Value(int val);
+
+          /**
+           * @brief Construct a string value.
+           * @param val The string object it refers to.
+           * 
+           */
+          Value(StringObject* val);
+
+          /**
+           * @brief Construct an array value.
+           * @param val The array object it refers to.
+           * 
+           */
+          Value(ArrayObject* val);
+
+          /**
+           * @brief Construct a record value.
+           * @param val The record object it refers to.
+           * 
+           */
+          Value(RecordObject* val);
+
+          /**
+           * @brief Returns the nil record.
+           * @return Value Nil.
+           * 
+           */
+          static Value Nil();
+
           /**
            * @brief The kind of value.
            * 
@@ -732,332 +853,655 @@ class Value {
           ValueType kind;
 
           /**
-           * @brief Prints nothing for the base type.
+           * @brief Returns the integer held by an int value.
+           * @return int The integer.
            * 
            */
-          virtual void Print();
+          int GetInt();
+
+          /**
+           * @brief Returns where an int value keeps its integer, so native code can
+           * read and write it in place.
+           * @return int* Address of the contained integer.
+           * 
+           */
+          int* GetAddress();
 
           /**
-           * @brief Copies the current value depending on its ValueType and returns
-           * the resulting value.
+           * @brief Returns the object a string value refers to.
+           * @return StringObject* The string object.
            * 
-           * @return Value* 
            */
-          virtual Value* Copy();
+          StringObject* GetStringObject();
 
           /**
-           * @brief Changes the internal value of this value to match the passed value.
+           * @brief Returns the object an array value refers to.
+           * @return ArrayObject* The array object.
            * 
-           * @param other Value to match.
            */
-          void SetValue(Value* other);
+          ArrayObject* GetArray();
 
           /**
-           * @brief Returns true if values are equal.
+           * @brief Returns the object a record value refers to.
+           * @return RecordObject* The record object.
            * 
+           */
+          RecordObject* GetRecord();
+
+          /**
+           * @brief Returns the heap object a string, array or record value refers to.
+           * @return HeapObject* The object, or NULL for values that live inline.
+           * 
+           */
+          HeapObject* GetObject();
+
+          /**
+           * @brief Prints the value.
+           * 
+           */
+          void Print();
+
+          /**
+           * @brief Returns true if values are equal: ints and strings by contents,
+           * arrays and records by identity.
            * @param other Value to compare against.
            * @return true If the values are equal.
            * @return false If the values aren't equal.
+           * 
            */
-          virtual bool operator==(Value* other);
+          bool operator==(const Value &other);
 
+     private:
+          /**
+           * @brief The integer, or the object the value refers to, depending on kind.
+           * 
+           */
+          union
+          {
+               int integer;
+               StringObject* str;
+               ArrayObject* arr;
+               RecordObject* rec;
+          };
 };
 
 /**
- * @brief An integer value type.
+ * @brief Anything a value can point to on the heap. Every one made is kept on a
+ * list so the garbage collector can find and free the ones no longer reachable.
  * 
  */
-class IntValue : public Value
+class HeapObject
 {
      public:
           /**
-           * @brief Construct a new IntValue object initialized to a given value.
+           * @brief Construct a new HeapObject and put it on the list of all of them.
            * 
-           * @param val Value to begin with.
            */
-          IntValue(int val);
+          HeapObject();
 
           /**
-           * @brief Returns the value of this current IntValue.
+           * @brief Destroy the HeapObject, taking it off the list.
            * 
-           * @return int The value contained in this IntValue.
            */
-          int GetValue();
+          virtual ~HeapObject();
 
           /**
-           * @brief Sets the integer value to a new one.
+           * @brief Pushes every object this one refers to.
+           * @param objects Where to push them.
            * 
-           * @param inVal New value for this object.
            */
-          void SetValue(const int &inVal);
+          virtual void Trace(vector<HeapObject*> &objects);
 
           /**
-           * @brief Set the integer value of this object to match another IntValue.
+           * @brief Records how many bytes the object takes up; called once the
+           * derived object knows its size.
+           * @param size Bytes used by the object and what it owns.
            * 
-           * @param otherValue The other value to match.
            */
-          void SetValue(IntValue* otherValue);
+          void Account(size_t size);
 
           /**
-           * @brief Prints the current value on this object.
+           * @brief Set while the garbage collector finds the object reachable.
            * 
            */
-          void Print() override;
+          bool marked;
 
           /**
-           * @brief Returns a copy of this value.
+           * @brief Bytes used by the object and what it owns.
            * 
-           * @return Value* A new copy of this value.
            */
-          Value* Copy() override;
+          size_t bytes;
 
           /**
-           * @brief Returns true if values are equal.
+           * @brief Neighbours on the list of every heap object.
            * 
-           * @param other Value to compare against.
-           * @return true If the values are equal.
-           * @return false If the values aren't equal.
            */
-          bool operator==(Value* other) override;
+          HeapObject* previous;
+          HeapObject* next;
+
+          /**
+           * @brief The most recently made heap object, heading the list.
+           * 
+           */
+          static HeapObject* newest;
 
-     private:
           /**
-           * @brief The true integer value of this object.
+           * @brief Bytes used by every heap object still around.
            * 
            */
-          int val;
+          static size_t liveBytes;
 
+          /**
+           * @brief Number of heap objects still around.
+           * 
+           */
+          static size_t liveObjects;
 };
+
+//Characters a string keeps inside its own object. Shorter strings are always
+// copied flat, since a rope node or view would take more room than they do.
+#define STRING_INLINE_SIZE 24
+
 /**
- * @brief A string value type.
+ * @brief The heap object behind a string value. Never changed once made, so
+ * values share it and only ever copy the pointer. A string is one of:
+ * 
+ * - flat, owning its characters, inside the object if they're short;
+ * - a view of characters in a flat string, made by substring();
+ * - a rope, the concatenation of two other strings, made by concat().
+ * 
+ * A rope only gets characters of its own when something needs them all in one
+ * place, like printing or comparing it, and then drops its halves. The length
+ * is always known and the hash is kept once worked out.
  * 
  */
-class StringValue : public Value
+class StringObject : public HeapObject
 {
      public:
           /**
-           * @brief Construct a new StringValue object initialized to a given value.
+           * @brief Construct a new flat StringObject holding a given string.
+           * @param val The string.
            * 
-           * @param val Value to begin with.
            */
-          StringValue(const string &val);
+          StringObject(const string &val);
 
           /**
-           * @brief Returns the value of this current StringValue.
+           * @brief Construct a new flat StringObject holding a run of characters.
+           * @param chars The first character.
+           * @param length Number of characters.
            * 
-           * @return string The value contained in this StringValue.
            */
-          string GetValue();
+          StringObject(const char* chars, int length);
 
           /**
-           * @brief Sets the string value to a new one.
+           * @brief Construct a new StringObject holding two strings one after the
+           * other; a rope unless the result is short.
+           * @param left The first string.
+           * @param right The string after it.
            * 
-           * @param inVal New value for this object.
            */
-          void SetValue(const string &inVal);
+          StringObject(StringObject* left, StringObject* right);
 
           /**
-           * @brief Set the string value of this object to match another StringValue.
+           * @brief Construct a new StringObject holding part of another; a view
+           * into it unless the part is short. A rope is flattened first.
+           * @param whole The string to take part of.
+           * @param first Index of the first character.
+           * @param length Number of characters.
            * 
-           * @param otherValue The other value to match.
            */
-          void SetValue(StringValue* otherValue);
+          StringObject(StringObject* whole, int first, int length);
 
           /**
-           * @brief Prints the current value on this object.
+           * @brief Destroy the StringObject, freeing its characters if it owns
+           * them and they didn't fit inside it.
            * 
            */
-          void Print() override;
+          ~StringObject();
 
           /**
-           * @brief Returns a copy of this value.
+           * @brief Pushes the halves of a rope, or the string a view looks into.
+           * @param objects Where to push them.
            * 
-           * @return Value* A new copy of this value.
            */
-          Value* Copy() override;
+          void Trace(vector<HeapObject*> &objects) override;
 
           /**
-           * @brief Returns true if values are equal.
+           * @brief Returns the characters, flattening a rope the first time. They
+           * aren't followed by a terminating zero.
+           * @return const char* The first character.
            * 
-           * @param other Value to compare against.
-           * @return true If the values are equal.
-           * @return false If the values aren't equal.
            */
-          bool operator==(Value* other) override;
+          const char* GetChars();
+
+          /**
+           * @brief Returns the number of characters.
+           * @return int The length.
+           * 
+           */
+          int GetLength();
+
+          /**
+           * @brief Returns a hash of the characters, working it out the first time.
+           * @return size_t The hash; never 0.
+           * 
+           */
+          size_t GetHash();
+
+          /**
+           * @brief Returns true if both strings hold the same characters. Checks
+           * identity, length and any hashes already known before the characters.
+           * @param other String to compare against.
+           * 
+           */
+          bool Equals(StringObject* other);
+
+          /**
+           * @brief Orders two strings by their characters, as unsigned bytes.
+           * @param other String to compare against.
+           * @return int Less than, equal to or greater than 0 as this string is
+           * before, the same as or after the other.
+           * 
+           */
+          int Compare(StringObject* other);
 
      private:
           /**
-           * @brief The true string value of this object.
+           * @brief Sets aside room for the characters, inside the object if they fit.
+           * 
+           */
+          void allocate(int length);
+
+          /**
+           * @brief Copies every piece of a rope into one buffer, without
+           * recursing so long chains of concatenations can't overflow the stack.
+           * 
+           */
+          void flatten();
+
+          /**
+           * @brief The characters: inlineChars for short strings, a buffer of its
+           * own, a place in the viewed string's, or NULL for an unflattened rope.
+           * 
+           */
+          char* chars;
+
+          /**
+           * @brief Number of characters.
+           * 
+           */
+          int length;
+
+          /**
+           * @brief Hash of the characters, or 0 until it's needed.
            * 
            */
-          string val; 
+          size_t hash;
+
+          /**
+           * @brief The halves of a rope, until it's flattened.
+           * 
+           */
+          StringObject* left;
+          StringObject* right;
+
+          /**
+           * @brief The flat string a view looks into, or NULL if it isn't one.
+           * 
+           */
+          StringObject* viewed;
+
+          /**
+           * @brief Where short strings keep their characters.
+           * 
+           */
+          char inlineChars[STRING_INLINE_SIZE];
 };
 
+//Elements in each chunk of an array, as a power of two
+#define ARRAY_CHUNK_BITS 12
+#define ARRAY_CHUNK_SIZE (1 << ARRAY_CHUNK_BITS)
+#define ARRAY_CHUNK_MASK (ARRAY_CHUNK_SIZE - 1)
+
 /**
- * @brief An array value type, filled with reference to other values.
+ * @brief The heap object behind an array value. Elements are kept in fixed-size
+ * chunks that are only allocated the first time one of their elements is written;
+ * until then every element in a chunk is the array's initial value. Arrays of ints
+ * keep their elements unboxed in contiguous chunks of ints; everything else keeps
+ * a Value per element.
  * 
  */
-class ArrayValue : public Value
+class ArrayObject : public HeapObject
 {
      public:
           /**
-           * @brief Construct a new ArrayValue with a given size and value to initialize
+           * @brief Construct a new ArrayObject with a given size and value to initialize
            * the entire array with.
-           * 
            * @param size Size of array.
-           * @param val Value to initialize the whole array with.
+           * @param val Value to initialize the whole array with; an array or record
+           * is shared by every element, as Tiger requires.
+           * @param ints Whether the element type is int, so the elements can be unboxed.
+           * 
            */
-          ArrayValue(const int &size, Value* val);
+          ArrayObject(const int &size, Value val, bool ints);
 
           /**
-           * @brief Construct a new Array Value object with a given set of values; does
-           * not deep copy the array.
+           * @brief Returns true if an index is within the array.
+           * @param index The index to check.
            * 
-           * @param val 
            */
-          ArrayValue(vector<Value*> val);
+          bool InBounds(const int &index);
 
           /**
-           * @brief Get the value at a designated index.
+           * @brief Get the element at a designated index, which must be in bounds.
+           * @param index The index of the element.
+           * @return Value The element.
            * 
-           * @param index The index of the value.
-           * @return Value* Value at given index.
            */
-          Value* GetValue(const int &index);
+          Value Get(const int &index);
 
           /**
-           * @brief Get the vector of values contained in this array; does not
-           * copy the inner values.
+           * @brief Set the element at a designated index, which must be in bounds.
+           * @param index The index of the element.
+           * @param value The new value.
            * 
-           * @return vector<Value*> Vector of values contained in this array.
            */
-          vector<Value*> GetArray();
+          void Set(const int &index, Value value);
 
           /**
-           * @brief Sets a value at a given index.
+           * @brief Returns where an element of an array of ints is stored, for compiled
+           * code to load and store directly. Since it may be stored to, its chunk is
+           * allocated if it hasn't been already.
+           * @param index The index of the element, which must be in bounds.
+           * @return int* The element.
            * 
-           * @param index Index of value to change.
-           * @param val New value to go into index.
            */
-          void SetValue(const int &index, Value* val);
+          int* GetIntAddress(const int &index);
 
           /**
-           * @brief Sets the array of values to a new one; does not delete all reference
-           * to values contained in the array.
+           * @brief Returns the number of elements.
+           * @return int Size of the array.
            * 
-           * @param val The vector of values to replace the old one.
            */
-          void SetValue(vector<Value*> val);
+          int Size();
 
           /**
            * @brief Prints all values in the array.
            * 
            */
-          void Print() override;
+          void Print();
 
           /**
-           * @brief Deep copies the values in the array and returns a new ArrayValue.
+           * @brief Pushes the objects the elements refer to.
+           * @param objects Where to push them.
            * 
-           * @return Value* A new value with copied values.
            */
-          Value* Copy() override;
+          void Trace(vector<HeapObject*> &objects) override;
 
+     private:
           /**
-           * @brief Returns true if values are equal.
+           * @brief Allocates a chunk, filling it with the initial value.
+           * @param chunk Which chunk.
+           * 
+           */
+          void materialize(const int &chunk);
+
+          /**
+           * @brief Whether the elements are kept in integers rather than val.
+           * 
+           */
+          bool ints;
+
+          /**
+           * @brief Number of elements.
+           * 
+           */
+          int size;
+
+          /**
+           * @brief The value of every element in a chunk that hasn't been allocated.
+           * 
+           */
+          Value initial;
+
+          /**
+           * @brief Chunks of elements of an array of ints; empty until allocated.
+           * 
+           */
+          vector< vector<int> > integers;
+
+          /**
+           * @brief Chunks of elements of any other array; empty until allocated.
+           * 
+           */
+          vector< vector<Value> > val;
+};
+
+/**
+ * @brief The heap object behind a record value, with a slot for each field of its type.
+ * 
+ */
+class RecordObject : public HeapObject
+{
+     public:
+          /**
+           * @brief Construct a RecordObject with every field unset.
+           * @param type The record's type, which decides how many slots it has.
+           * 
+           */
+          RecordObject(RecType* type);
+
+          /**
+           * @brief Returns a record's field given its slot.
+           * @param slot Where the field is, from RecType::fieldSlot().
+           * @return Value* The field.
+           * 
+           */
+          Value* GetValue(const int &slot);
+
+          /**
+           * @brief Prints all field names and values for the record.
+           * 
+           */
+          void Print();
+
+          /**
+           * @brief Pushes the objects the fields refer to.
+           * @param objects Where to push them.
            * 
-           * @param other Value to compare against.
-           * @return true If the values are equal.
-           * @return false If the values aren't equal.
            */
-          inline bool operator==(Value* other);
+          void Trace(vector<HeapObject*> &objects) override;
 
      private:
           /**
-           * @brief Collection of all values in this array.
+           * @brief The record's type, for the names of its fields.
+           * 
+           */
+          RecType* type;
+
+          /**
+           * @brief Values of all fields, by slot.
            * 
            */
-          vector<Value*> val; 
+          vector<Value> val;
 };
 
 /**
- * @brief A record value, with Name->Value pairs for each record field.
+ * @brief The heap object behind an array or record in the bytecode VM and the
+ * closure engine, which keep them as bare runs of words laid out however they
+ * like. The words follow the object in the same allocation, and those engines
+ * only ever refer to the block by its first word.
  * 
  */
-class RecordValue : public Value
+class WordBlock : public HeapObject
 {
      public:
           /**
-           * @brief Construct a blank RecordValue object; mostly used for NIL.
+           * @brief Makes a block of zeroed words.
+           * @param count Number of words.
+           * @return void** The first word, or NULL if there isn't the memory for it.
            * 
            */
-          RecordValue();
+          static void** Make(size_t count);
 
           /**
-           * @brief Construct a RecordValue with a collection field values.
+           * @brief Returns the first word.
            * 
-           * @param val Name->Value pairs for each field.
            */
-          RecordValue(map<string,Value*> val);
+          void** Words(){return (void**)(this + 1);}
 
           /**
-           * @brief Returns the value for a record's field given a name.
+           * @brief Frees the block along with its words.
            * 
-           * @param member Name of the field.
-           * @return Value* The value for the named field.
            */
-          Value* GetValue(const string &member);
+          void operator delete(void* memory);
 
           /**
-           * @brief Get the map of Name->Value pairs for this record.
+           * @brief Number of words.
            * 
-           * @return map<string,Value*> Map of Name->Value pairs for all fields of this record.
            */
-          map<string,Value*> GetRecord();
+          size_t count;
 
+     private:
           /**
-           * @brief Set value of a named field.
+           * @brief Construct the header of a block, once Make() has the room for it.
            * 
-           * @param key Name of the field.
-           * @param inValue New value for the field.
            */
-          void SetValue(const string &key, Value* inValue);
+          WordBlock(size_t count);
+};
 
+//Slots in each block a frame stack carves frames out of
+#define FRAME_CHUNK_SLOTS 4096
+
+/**
+ * @brief The runtime counterpart of a scope: the values of everything it declares,
+ * by slot, and a link to the frame of the scope it's nested in. Frames are made
+ * and reused by a FrameStack.
+ * 
+ */
+class Frame{
+     public:
           /**
-           * @brief Changes the map of Name->Value pairs to a new one; does not
-           * delete all old values
+           * @brief Returns the frame a given number of links out from this one.
+           * @param depth Number of links to follow.
+           * @return Frame* The frame found.
            * 
-           * @param val New map of fields
            */
-          void SetValue(map<string, Value*> val);
+          Frame* Ancestor(int depth);
 
           /**
-           * @brief Prints all field names and values for the record.
+           * @brief Returns the slot for a resolved variable.
+           * @param depth Number of frames out from this one it was declared in.
+           * @param slot Its slot in that frame.
+           * @return Value& The slot's contents.
            * 
            */
-          void Print() override;
+          Value& Lookup(int depth, int slot);
 
           /**
-           * @brief Deep copies this record and its fields and returns the new RecordValue.
+           * @brief The frame of the enclosing scope.
            * 
-           * @return Value* The new copied RecordValue.
            */
-          Value* Copy() override;
+          Frame* parent;
 
           /**
-           * @brief Returns true if values are equal.
+           * @brief The frame that was current when this one was entered. Following
+           * these from the current frame reaches every frame still in use.
            * 
-           * @param other Value to compare against.
-           * @return true If the values are equal.
-           * @return false If the values aren't equal.
            */
-          inline bool operator==(Value* other);
+          Frame* caller;
+
+          /**
+           * @brief Values of everything declared in the scope.
+           * 
+           */
+          Value* slots;
+
+          /**
+           * @brief Number of slots.
+           * 
+           */
+          int size;
+
+          /**
+           * @brief Which of its stack's blocks the slots are in, and where.
+           * 
+           */
+          int chunk;
+          int offset;
+};
+
+/**
+ * @brief Hands out frames in last in, first out order. Slots come from large
+ * blocks that are kept for reuse and never move, so pointers to them stay good
+ * while their frame is in use.
+ * 
+ */
+class FrameStack{
+     public:
+          /**
+           * @brief Construct a new, empty FrameStack.
+           * 
+           */
+          FrameStack();
+
+          /**
+           * @brief Frees every frame and block.
+           * 
+           */
+          ~FrameStack();
+
+          /**
+           * @brief Makes a new frame on top with every slot empty.
+           * @param parent The frame of the enclosing scope; NULL for the outermost one.
+           * @param size Number of slots.
+           * @param caller The frame current when this one is entered, if not the parent.
+           * @return Frame* The new frame.
+           * 
+           */
+          Frame* Push(Frame* parent, int size, Frame* caller = NULL);
+
+          /**
+           * @brief Gives back the frame on top.
+           * 
+           */
+          void Pop();
+
+          /**
+           * @brief Changes the number of slots in the frame on top, emptying them all.
+           * @param size The new number of slots.
+           * 
+           */
+          void Resize(int size);
 
      private:
           /**
-           * @brief Map of name->value pairs for all fields.
+           * @brief Points the frame on top at enough empty slots, starting at the
+           * top of the current block or at the next one if it won't fit.
+           * 
+           */
+          void place(Frame* frame, int size);
+
+          /**
+           * @brief Every frame made so far; the first depth of them are in use.
+           * 
+           */
+          vector<Frame*> frames;
+          int depth;
+
+          /**
+           * @brief Blocks of slots and how many each holds.
+           * 
+           */
+          vector<Value*> chunks;
+          vector<int> chunkSizes;
+
+          /**
+           * @brief The block the top frame's slots are in, and how much of it is used.
            * 
            */
-          map<string, Value*> val; 
+          int chunk;
+          int used;
 };
 /** @} */
 #endif
\ No newline at end of file
@@ -0,0 +1,453 @@
+#include <iostream>
+#include <stdlib.h>
+#include "TraceJIT.h"
+#include "Interpreter.h"
+#include "Builtins.h"
+#include "Output.h"
+
+using namespace std;
+
+/*********************
+ * RUNTIME HELPERS
+ * *******************/
+
+//Returns where an element's int lives, failing the same way the interpreter does
+static int* traceArrayElement(ArrayObject* array, int index, int lineNumber)
+{
+     if(!array->InBounds(index))
+     {
+          cout << "ERROR " << lineNumber << ": Runtime: Array access out of bounds." << endl;
+          exit(4);
+     }
+     return array->GetIntAddress(index);
+}
+
+static void tracePrinti(int value)
+{
+     output->WriteInt(value);
+}
+
+/*********************
+ * TRACE LOOP
+ * *******************/
+
+TraceLoop::TraceLoop():loop(NULL), iterations(0), compiles(0), blacklisted(false), entry(NULL){}
+
+/*********************
+ * NODE TRACE COMPILER
+ * *******************/
+
+nodeTraceCompiler::nodeTraceCompiler(TraceLoop* trace)
+:nodeMethodJIT(NULL), trace(trace), statementNode(NULL), exitJumps(TRACE_EXIT_SIDE){}
+
+bool nodeTraceCompiler::compileLoop()
+{
+     //push rbp; mov rbp, rsp; push rbx; keep rsp 16-byte aligned; mov rbx, rdi
+     as.byte(0x55);
+     as.bytes(0x48, 0x89, 0xE5);
+     as.byte(0x53);
+     as.addStack(-8);
+     as.bytes(0x48, 0x89, 0xFB);
+
+     int top = as.here();
+     if(dynamic_cast<whileExp*>(trace->loop) != NULL)
+     {
+          whileExp* While = (whileExp*) trace->loop;
+          compileGuard(While->condition, true, TRACE_EXIT_DONE);
+          compileStatement(While->action);
+     }
+     else
+     {
+          //The interpreter enters with the variable already set for this iteration
+          forExp* forEx = (forExp*) trace->loop;
+          compileStatement(forEx->action);
+
+          //mov rax, var; mov ecx, [rax]; mov rdx, limit; cmp ecx, [rdx]; jge done; inc dword [rax]
+          loadPointer(0, variableSlot((NId*)(forEx->id), false));
+          as.bytes(0x8B, 0x08);
+          loadPointer(2, variableSlot(NULL, false));
+          as.bytes(0x3B, 0x0A);
+          exitJumps[TRACE_EXIT_DONE].push_back(as.jumpIf(0x80 | CC_GE));
+          as.bytes(0xFF, 0x00);
+     }
+     as.patchTo(as.jump(), top);
+
+     //Every exit returns its own code through the shared epilogue
+     vector<int> epilogueJumps;
+     for(int code = 0; code < exitJumps.size(); code++)
+     {
+          if(exitJumps[code].empty())
+               continue;
+          for(int i = 0; i < exitJumps[code].size(); i++)
+               as.patch(exitJumps[code][i]);
+          as.byte(0xB8);
+          as.int32(code);
+          epilogueJumps.push_back(as.jump());
+     }
+     for(int i = 0; i < epilogueJumps.size(); i++)
+          as.patch(epilogueJumps[i]);
+
+     //lea rsp, [rbp-8]; pop rbx; pop rbp; ret
+     as.bytes(0x48, 0x8D, 0x65);
+     as.byte(0xF8);
+     as.byte(0x5B);
+     as.byte(0x5D);
+     as.byte(0xC3);
+     return supported;
+}
+
+void nodeTraceCompiler::compileStatement(node* Node)
+{
+     statementNode = Node;
+     compile(Node);
+}
+
+void nodeTraceCompiler::compileGuard(node* condition, bool expected, int exitCode)
+{
+     //Comparisons between ints can test and leave in one step
+     infixExp* InfixExp = dynamic_cast<infixExp*>(condition);
+     if(InfixExp != NULL && InfixExp->op >= OP_EQ
+          && isIntType(InfixExp->leftNode->type) && isIntType(InfixExp->rightNode->type))
+     {
+          int folded;
+          if(constantValue(InfixExp, folded))
+          {
+               if((folded != 0) != expected)
+                    jumpToExit(exitCode);
+               return;
+          }
+
+          compileOperands(InfixExp);
+          as.bytes(0x39, 0xC8);
+          int condition = conditionCode(InfixExp->op);
+          if(exitJumps.size() <= exitCode)
+               exitJumps.resize(exitCode + 1);
+          exitJumps[exitCode].push_back(as.jumpIf(0x80 | (expected ? condition ^ 1 : condition)));
+          return;
+     }
+
+     compile(condition);
+     as.bytes(0x85, 0xC0);
+     if(exitJumps.size() <= exitCode)
+          exitJumps.resize(exitCode + 1);
+     exitJumps[exitCode].push_back(as.jumpIf(0x80 | (expected ? CC_E : CC_NE)));
+}
+
+void nodeTraceCompiler::jumpToExit(int exitCode)
+{
+     if(exitJumps.size() <= exitCode)
+          exitJumps.resize(exitCode + 1);
+     exitJumps[exitCode].push_back(as.jump());
+}
+
+int nodeTraceCompiler::variableSlot(NId* id, bool array)
+{
+     //Nothing in a traced loop opens a frame, so every name resolves from the loop's
+     int depth = (id != NULL) ? id->depth : -1;
+     int slot = (id != NULL) ? id->slot : -1;
+     vector<TraceVariable>& variables = trace->variables;
+     for(int i = 0; i < variables.size(); i++)
+     {
+          if(variables[i].depth == depth && variables[i].slot == slot && variables[i].array == array)
+               return i;
+     }
+     TraceVariable variable = {depth, slot, array};
+     variables.push_back(variable);
+     return variables.size()-1;
+}
+
+void nodeTraceCompiler::loadPointer(int reg, int slot)
+{
+     as.bytes(0x48, 0x8B, 0x83 | (reg << 3));
+     as.int32(8 * slot);
+}
+
+void nodeTraceCompiler::compileElement(subscript* Subscript)
+{
+     //Only int arrays named directly by a variable
+     if(dynamic_cast<NId*>(Subscript->lValue) == NULL || !isIntType(Subscript->type))
+     {
+          reject();
+          return;
+     }
+     int slot = variableSlot((NId*)(Subscript->lValue), true);
+
+     //traceArrayElement(array, index, line): mov esi, eax; mov rdi, array; mov edx, line
+     compile(Subscript->exp);
+     as.bytes(0x89, 0xC6);
+     loadPointer(7, slot);
+     as.byte(0xBA);
+     as.int32(Subscript->exp->lineNumber);
+     callHelper((void*)traceArrayElement);
+}
+
+/*********
+ * VISITS
+ * *******/
+
+void nodeTraceCompiler::visitID(NId* id)
+{
+     if(!isIntType(id->type))
+     {
+          reject();
+          return;
+     }
+
+     //mov rax, slot; mov eax, [rax]
+     loadPointer(0, variableSlot(id, false));
+     as.bytes(0x8B, 0x00);
+}
+void nodeTraceCompiler::visitSubscript(subscript* Subscript)
+{
+     compileElement(Subscript);
+     as.bytes(0x8B, 0x00);
+}
+void nodeTraceCompiler::visitSeqExp(seqExp* SeqExp)
+{
+     if(SeqExp->exps->size() == 0)
+     {
+          as.byte(0xB8);
+          as.int32(0);
+     }
+
+     //Only sequences run as statements can be resumed partway through
+     bool statement = (SeqExp == statementNode);
+     for(int i = 0; i < SeqExp->exps->size(); i++)
+     {
+          if(statement)
+          {
+               path.push_back(pair<seqExp*, int>(SeqExp, i));
+               compileStatement((*(SeqExp->exps))[i]);
+               path.pop_back();
+          }
+          else
+               compile((*(SeqExp->exps))[i]);
+     }
+}
+void nodeTraceCompiler::visitCallExp(callExp* CallExp)
+{
+     if(CallExp->builtin == NULL)
+          reject();
+     else if(CallExp->builtin->kind == BUILTIN_NOT)
+          nodeMethodJIT::visitCallExp(CallExp);
+     else if(CallExp->builtin->kind == BUILTIN_PRINTI)
+     {
+          //mov edi, eax
+          compile((*(CallExp->exps))[0]);
+          as.bytes(0x89, 0xC7);
+          callHelper((void*)tracePrinti);
+     }
+     else
+          reject();
+}
+void nodeTraceCompiler::visitAssignment(assignment* Assign)
+{
+     if(dynamic_cast<subscript*>(Assign->lVal) != NULL)
+     {
+          //The element is found before the value is worked out, as the interpreter does
+          compileElement((subscript*) Assign->lVal);
+          push();
+          compile(Assign->exp);
+          as.byte(0x59);
+          depth--;
+          as.bytes(0x89, 0x01);
+     }
+     else if(dynamic_cast<NId*>(Assign->lVal) != NULL && isIntType(Assign->lVal->type))
+     {
+          //mov rcx, slot; mov [rcx], eax
+          compile(Assign->exp);
+          loadPointer(1, variableSlot((NId*)(Assign->lVal), false));
+          as.bytes(0x89, 0x01);
+     }
+     else
+          reject();
+}
+void nodeTraceCompiler::visitIfThenElse(ifThenElse* iTE)
+{
+     bool statement = (iTE == statementNode);
+     BranchPolicy policy = BRANCH_BOTH;
+     map<ifThenElse*, BranchPolicy>::iterator itr = trace->branches.find(iTE);
+     if(statement && itr != trace->branches.end())
+          policy = itr->second;
+
+     if(policy == BRANCH_BOTH)
+     {
+          compile(iTE->ifExp);
+          as.bytes(0x85, 0xC0);
+          int elseJump = as.jumpIf(0x80 | CC_E);
+          if(statement)
+               compileStatement(iTE->thenExp);
+          else
+               compile(iTE->thenExp);
+          int endJump = as.jump();
+          as.patch(elseJump);
+          if(iTE->elseExp != NULL)
+          {
+               if(statement)
+                    compileStatement(iTE->elseExp);
+               else
+                    compile(iTE->elseExp);
+          }
+          as.patch(endJump);
+          return;
+     }
+
+     //Follow the recorded branch, leaving the trace if the condition disagrees
+     TraceExit exit;
+     exit.branch = iTE;
+     exit.expectedThen = (policy == BRANCH_THEN);
+     exit.path = path;
+     exit.count = 0;
+     trace->exits.push_back(exit);
+     compileGuard(iTE->ifExp, exit.expectedThen, TRACE_EXIT_SIDE + trace->exits.size()-1);
+
+     node* taken = exit.expectedThen ? iTE->thenExp : iTE->elseExp;
+     if(taken != NULL)
+          compileStatement(taken);
+}
+void nodeTraceCompiler::visitWhileExp(whileExp* While)
+{
+     //Only innermost loops are traced
+     reject();
+}
+void nodeTraceCompiler::visitForExp(forExp* forEx)
+{
+     reject();
+}
+void nodeTraceCompiler::visitLetExp(letExp* LetExp)
+{
+     reject();
+}
+void nodeTraceCompiler::visitBreak(NBreak* Break)
+{
+     jumpToExit(TRACE_EXIT_BREAK);
+}
+
+/*********************
+ * TRACE JIT
+ * *******************/
+
+TraceJIT::TraceJIT():recording(NULL){}
+
+TraceStatus TraceJIT::Enter(nodeInterpreter* interpreter, node* loop, int* limit)
+{
+#ifndef JIT_SUPPORTED
+     return TRACE_NONE;
+#endif
+     map<node*, TraceLoop>::iterator itr = loops.find(loop);
+     if(itr == loops.end())
+     {
+          itr = loops.insert(pair<node*, TraceLoop>(loop, TraceLoop())).first;
+          itr->second.loop = loop;
+     }
+     TraceLoop* trace = &(itr->second);
+
+     //Coming back around after a recorded iteration means the trace is complete
+     if(recording != NULL)
+     {
+          TraceLoop* recorded = recording;
+          recording = NULL;
+          if(recorded == trace)
+               compile(trace);
+     }
+
+     if(trace->blacklisted)
+          return TRACE_NONE;
+     if(trace->entry == NULL)
+     {
+          if(++trace->iterations >= TRACE_HOT_LOOP)
+          {
+               trace->branches.clear();
+               recording = trace;
+          }
+          return TRACE_NONE;
+     }
+
+     //Variables are looked up fresh every time, and must still hold what the trace expects
+     vector<void*> slots(trace->variables.size());
+     for(int i = 0; i < trace->variables.size(); i++)
+     {
+          TraceVariable& variable = trace->variables[i];
+          if(variable.depth < 0)
+          {
+               if(limit == NULL)
+                    return TRACE_NONE;
+               slots[i] = limit;
+               continue;
+          }
+
+          Value& value = interpreter->frame->Lookup(variable.depth, variable.slot);
+          if(value.kind != (variable.array ? V_ARR : V_INT))
+               return TRACE_NONE;
+          slots[i] = variable.array ? (void*)value.GetArray() : (void*)value.GetAddress();
+     }
+
+     int code = trace->entry(slots.empty() ? NULL : &slots[0]);
+     if(code < TRACE_EXIT_SIDE)
+          return TRACE_DONE;
+
+     //Finish the iteration in the interpreter, and cover both sides of a branch
+     // once it keeps leaving the trace
+     TraceExit exit = trace->exits[code - TRACE_EXIT_SIDE];
+     bool hot = ++(trace->exits[code - TRACE_EXIT_SIDE].count) >= TRACE_HOT_EXIT;
+     TraceStatus status = resume(interpreter, exit);
+     if(hot)
+     {
+          trace->branches[exit.branch] = BRANCH_BOTH;
+          compile(trace);
+     }
+     return status;
+}
+
+void TraceJIT::RecordBranch(ifThenElse* branch, bool tookThen)
+{
+     //Keep the first direction seen if the same if runs more than once
+     if(recording->branches.find(branch) == recording->branches.end())
+          recording->branches[branch] = tookThen ? BRANCH_THEN : BRANCH_ELSE;
+}
+
+void TraceJIT::compile(TraceLoop* trace)
+{
+     trace->entry = NULL;
+     if(trace->compiles >= TRACE_MAX_COMPILES)
+     {
+          trace->blacklisted = true;
+          return;
+     }
+     trace->compiles++;
+     trace->variables.clear();
+     trace->exits.clear();
+
+     nodeTraceCompiler generator(trace);
+     if(!generator.compileLoop())
+     {
+          trace->blacklisted = true;
+          return;
+     }
+     trace->entry = (TraceEntry)heap.Install(generator.as.code);
+     if(trace->entry == NULL)
+          trace->blacklisted = true;
+}
+
+TraceStatus TraceJIT::resume(nodeInterpreter* interpreter, const TraceExit &exit)
+{
+     //The condition has already been tested, so go straight to the other branch
+     node* other = exit.expectedThen ? exit.branch->elseExp : exit.branch->thenExp;
+     if(other != NULL)
+          interpreter->evaluate(other);
+
+     //Then run whatever was left of each sequence around the if
+     for(int level = exit.path.size()-1; level >= 0 && !interpreter->breakCalled; level--)
+     {
+          seqExp* SeqExp = exit.path[level].first;
+          for(int i = exit.path[level].second + 1; i < SeqExp->exps->size() && !interpreter->breakCalled; i++)
+               interpreter->evaluate((*(SeqExp->exps))[i]);
+     }
+
+     if(interpreter->breakCalled)
+     {
+          interpreter->breakCalled = false;
+          return TRACE_DONE;
+     }
+     return TRACE_RESUMED;
+}
@@ -0,0 +1,367 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      TraceJIT.h
+     Purpose:       Records the path hot while/for loops take through their
+                    bodies and compiles it to native x86-64 code, handing
+                    control back to the tree-walker when the path changes.
+
+*/
+
+/** @defgroup TRACE Tracing JIT
+ *  Native code for hot loops.
+ *  @{
+ */
+
+#ifndef TRACE_JIT
+#define TRACE_JIT
+
+#include <string>
+#include <vector>
+#include <map>
+#include "ast.h"
+#include "SymbolTable.h"
+#include "MethodJIT.h"
+
+using namespace std;
+
+//Iterations a loop runs in the interpreter before its path is recorded
+#define TRACE_HOT_LOOP 32
+
+//Times a side exit is taken before the trace is recompiled to cover both branches
+#define TRACE_HOT_EXIT 16
+
+//Most times a single loop is compiled before it is left to the interpreter
+#define TRACE_MAX_COMPILES 8
+
+class nodeInterpreter;
+
+/**
+ * @brief A compiled loop. Takes the addresses of every variable it uses and
+ * returns which exit it left by.
+ *
+ */
+typedef int (*TraceEntry)(void** slots);
+
+/**
+ * @brief How a loop came back from the tracer.
+ *
+ */
+enum TraceStatus
+{
+     TRACE_NONE,    //The tracer didn't run; interpret the iteration as usual
+     TRACE_RESUMED, //The trace left partway and the interpreter finished the iteration
+     TRACE_DONE     //The loop is finished
+};
+
+/**
+ * @brief What a trace does at an if.
+ *
+ */
+enum BranchPolicy
+{
+     BRANCH_THEN,   //Follow the then branch, leaving the trace otherwise
+     BRANCH_ELSE,   //Follow the else branch, leaving the trace otherwise
+     BRANCH_BOTH    //Compile both branches
+};
+
+/**
+ * @brief Exit codes every trace can return, ahead of its side exits.
+ *
+ */
+enum TraceExitCode
+{
+     TRACE_EXIT_DONE,
+     TRACE_EXIT_BREAK,
+     TRACE_EXIT_SIDE
+};
+
+/**
+ * @brief A guard in a trace, and how the interpreter picks up when it fails.
+ *
+ */
+class TraceExit
+{
+     public:
+          /**
+           * @brief The if whose condition went the other way.
+           *
+           */
+          ifThenElse* branch;
+
+          /**
+           * @brief The branch the trace expected to take.
+           *
+           */
+          bool expectedThen;
+
+          /**
+           * @brief The sequences the if sits in, innermost last, with its position in each.
+           *
+           */
+          vector< pair<seqExp*, int> > path;
+
+          /**
+           * @brief Times this exit has been taken.
+           *
+           */
+          int count;
+};
+
+/**
+ * @brief A variable a trace reads or writes, re-resolved each time the trace is entered.
+ *
+ */
+class TraceVariable
+{
+     public:
+          /**
+           * @brief Frames out from the loop's that the variable was declared in;
+           * -1 for a for loop's limit.
+           *
+           */
+          int depth;
+
+          /**
+           * @brief The variable's slot in that frame.
+           *
+           */
+          int slot;
+
+          /**
+           * @brief Whether the variable holds an array of ints rather than an int.
+           *
+           */
+          bool array;
+};
+
+/**
+ * @brief Everything the tracer knows about a single loop.
+ *
+ */
+class TraceLoop
+{
+     public:
+          /**
+           * @brief Construct a cold loop.
+           *
+           */
+          TraceLoop();
+
+          /**
+           * @brief The whileExp or forExp.
+           *
+           */
+          node* loop;
+
+          /**
+           * @brief Iterations run in the interpreter so far.
+           *
+           */
+          int iterations;
+
+          /**
+           * @brief Times the loop has been compiled.
+           *
+           */
+          int compiles;
+
+          /**
+           * @brief Set once the loop can't or shouldn't be traced.
+           *
+           */
+          bool blacklisted;
+
+          /**
+           * @brief Branches taken while recording, and those since widened to both sides.
+           *
+           */
+          map<ifThenElse*, BranchPolicy> branches;
+
+          /**
+           * @brief The native code, or NULL.
+           *
+           */
+          TraceEntry entry;
+
+          /**
+           * @brief Variables in the order the trace expects their slots.
+           *
+           */
+          vector<TraceVariable> variables;
+
+          /**
+           * @brief Side exits, by exit code minus TRACE_EXIT_SIDE.
+           *
+           */
+          vector<TraceExit> exits;
+};
+
+/**
+ * @brief Emits native code for one recorded loop. Reuses the method JIT's
+ * expression code, but reaches variables through the slot table the trace is
+ * entered with and turns recorded branches into guards.
+ *
+ */
+class nodeTraceCompiler : public nodeMethodJIT
+{
+     public:
+          /**
+           * @brief Construct a new trace compiler for a loop.
+           *
+           * @param trace The loop and what was recorded about it.
+           */
+          nodeTraceCompiler(TraceLoop* trace);
+
+          /**
+           * @brief Generates the whole loop.
+           *
+           * @return true If everything in the loop was supported.
+           */
+          bool compileLoop();
+
+          /**
+           * @brief Generates a node whose value isn't used, such as an element of
+           * the loop body. Only these can become guards the interpreter resumes from.
+           *
+           */
+          void compileStatement(node* Node);
+
+          /**
+           * @brief Generates a check that leaves the trace unless a condition comes
+           * out the way it was recorded.
+           *
+           * @param condition The if's condition.
+           * @param expected Whether it was true when recorded.
+           * @param exitCode Exit code to return if it isn't.
+           */
+          void compileGuard(node* condition, bool expected, int exitCode);
+
+          /**
+           * @brief Emits a jump to the exit stub that returns a code.
+           *
+           */
+          void jumpToExit(int exitCode);
+
+          /**
+           * @brief Index of a variable's slot, adding it if it's new.
+           *
+           * @param id The variable, or NULL for a for loop's limit.
+           * @param array Whether it holds an array of ints.
+           */
+          int variableSlot(NId* id, bool array);
+
+          /**
+           * @brief Loads a slot's pointer into a register: mov reg, [rbx + 8 * slot].
+           *
+           * @param reg 0 for rax, 1 for rcx, 2 for rdx, 7 for rdi.
+           */
+          void loadPointer(int reg, int slot);
+
+          /**
+           * @brief Leaves the address of an array element in rax, checking its bounds.
+           *
+           */
+          void compileElement(subscript* Subscript);
+
+          //Visitor functions that differ from the method JIT
+          void visitID(NId* id) override;
+          void visitSubscript(subscript* Subscript) override;
+          void visitSeqExp(seqExp*) override;
+          void visitCallExp(callExp*) override;
+          void visitAssignment(assignment*) override;
+          void visitIfThenElse(ifThenElse*) override;
+          void visitWhileExp(whileExp*) override;
+          void visitForExp(forExp*) override;
+          void visitLetExp(letExp*) override;
+          void visitBreak(NBreak* Break) override;
+
+          /**
+           * @brief The loop being compiled.
+           *
+           */
+          TraceLoop* trace;
+
+          /**
+           * @brief The node most recently compiled as a statement.
+           *
+           */
+          node* statementNode;
+
+          /**
+           * @brief Sequences around the node being compiled, innermost last.
+           *
+           */
+          vector< pair<seqExp*, int> > path;
+
+          /**
+           * @brief Jumps to patch to each exit stub, by exit code.
+           *
+           */
+          vector< vector<int> > exitJumps;
+};
+
+/**
+ * @brief Counts loop iterations, records hot loops, and runs their traces.
+ *
+ */
+class TraceJIT
+{
+     public:
+          /**
+           * @brief Construct a new tracer with nothing recorded.
+           *
+           */
+          TraceJIT();
+
+          /**
+           * @brief Called at the top of every loop iteration. Runs the loop natively
+           * once it is hot and compiled.
+           *
+           * @param interpreter The interpreter running the loop.
+           * @param loop The whileExp or forExp.
+           * @param limit A for loop's limit, or NULL for a while loop.
+           * @return TraceStatus What the loop should do next.
+           */
+          TraceStatus Enter(nodeInterpreter* interpreter, node* loop, int* limit);
+
+          /**
+           * @brief Called by the interpreter at every if while a loop is being recorded.
+           *
+           * @param branch The if.
+           * @param tookThen Whether its condition was true.
+           */
+          void RecordBranch(ifThenElse* branch, bool tookThen);
+
+          /**
+           * @brief Compiles a recorded loop, blacklisting it if that fails.
+           *
+           */
+          void compile(TraceLoop* trace);
+
+          /**
+           * @brief Finishes an iteration in the interpreter after a side exit.
+           *
+           * @return TraceStatus TRACE_DONE if the rest of the iteration broke out of the loop.
+           */
+          TraceStatus resume(nodeInterpreter* interpreter, const TraceExit &exit);
+
+          /**
+           * @brief The loop being recorded, or NULL.
+           *
+           */
+          TraceLoop* recording;
+
+          /**
+           * @brief Every loop seen so far.
+           *
+           */
+          map<node*, TraceLoop> loops;
+
+          /**
+           * @brief Where traces live.
+           *
+           */
+          CodeHeap heap;
+};
+/** @} */
+#endif
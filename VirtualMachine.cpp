@@ -0,0 +1,513 @@
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include "VirtualMachine.h"
+#include "Builtins.h"
+#include "Output.h"
+
+using namespace std;
+
+//Most slots the stack may grow to before a runaway recursion is reported
+#define VM_MAX_STACK (1 << 26)
+
+VMWord callBuiltin(int kind, VMWord* args, int lineNumber)
+{
+     VMWord result;
+     result.p = NULL;
+     switch(kind)
+     {
+          case BUILTIN_PRINT:
+          {
+               StringObject* s = (StringObject*)args[0].p;
+               output->Write(s->GetChars(), s->GetLength());
+               break;
+          }
+          case BUILTIN_PRINTI:
+               output->WriteInt(args[0].i);
+               break;
+          case BUILTIN_FLUSH:
+               output->Flush();
+               break;
+          case BUILTIN_GETCHAR:
+               result.p = new StringObject(builtinGetchar());
+               break;
+          case BUILTIN_ORD:
+          {
+               StringObject* s = (StringObject*)args[0].p;
+               result.i = builtinOrd(s->GetChars(), s->GetLength());
+               break;
+          }
+          case BUILTIN_CHR:
+               result.p = new StringObject(builtinChr(args[0].i, lineNumber));
+               break;
+          case BUILTIN_SIZE:
+               result.i = ((StringObject*)args[0].p)->GetLength();
+               break;
+          case BUILTIN_SUBSTRING:
+          {
+               StringObject* s = (StringObject*)args[0].p;
+               builtinSubstringRange(s->GetLength(), args[1].i, args[2].i, lineNumber);
+               if(args[2].i == s->GetLength())
+                    result.p = s;
+               else
+                    result.p = new StringObject(s, args[1].i, args[2].i);
+               break;
+          }
+          case BUILTIN_CONCAT:
+          {
+               //Strings are never changed in place, so an empty side means the other can be shared
+               StringObject* left = (StringObject*)args[0].p;
+               StringObject* right = (StringObject*)args[1].p;
+               if(left->GetLength() == 0)
+                    result.p = right;
+               else if(right->GetLength() == 0)
+                    result.p = left;
+               else
+                    result.p = new StringObject(left, right);
+               break;
+          }
+          case BUILTIN_NOT:
+               result.i = args[0].i == 0 ? 1 : 0;
+               break;
+          case BUILTIN_EXIT:
+               builtinExit(args[0].i);
+               break;
+     }
+     return result;
+}
+
+VirtualMachine::VirtualMachine(BytecodeProgram* program):program(program), collector(NULL){}
+
+void VirtualMachine::throwError(const int &lineNumber, const string &errorMessage)
+{
+     cout << "ERROR " << lineNumber << ": Runtime: " << errorMessage << endl;
+     exit(4);
+}
+
+void VirtualMachine::thread(void** handlers)
+{
+     //Lay the functions out back to back
+     vector<int> offsets;
+     for(int i = 0; i < program->functions.size(); i++)
+     {
+          offsets.push_back(code.size());
+          vector<intptr_t>& body = program->functions[i]->code;
+          code.insert(code.end(), body.begin(), body.end());
+     }
+
+     //The code won't move from here on, so it's safe to take addresses into it
+     functions.resize(program->functions.size());
+     for(int i = 0; i < program->functions.size(); i++)
+     {
+          BytecodeFunction* function = program->functions[i];
+          functions[i].entry = &code[offsets[i]];
+          functions[i].numParams = function->numParams;
+          functions[i].frameSize = function->frameSize;
+          functions[i].maxStack = function->maxStack;
+     }
+
+     for(int i = 0; i < program->functions.size(); i++)
+     {
+          int pc = offsets[i];
+          int end = pc + program->functions[i]->code.size();
+          while(pc < end)
+          {
+               int op = code[pc];
+               if(opJumpOperand[op] >= 0)
+               {
+                    intptr_t& target = code[pc + 1 + opJumpOperand[op]];
+                    target = (intptr_t)(&code[offsets[i] + target]);
+               }
+               if(op == BC_CALL)
+                    code[pc+1] = (intptr_t)(&functions[code[pc+1]]);
+               if(handlers != NULL)
+                    code[pc] = (intptr_t)handlers[op];
+               pc += 1 + opOperandCount[op];
+          }
+     }
+}
+
+void VirtualMachine::reserveStack(int needed, VMWord* &sp, VMWord* &bp)
+{
+     int top = sp - &stack[0];
+     if(top + needed <= stack.size())
+          return;
+
+     int size = stack.size();
+     while(size < top + needed)
+          size *= 2;
+     if(size > VM_MAX_STACK)
+     {
+          cout << "ERROR: Runtime: Stack overflow." << endl;
+          exit(4);
+     }
+
+     int base = bp - &stack[0];
+     stack.resize(size);
+     sp = &stack[0] + top;
+     bp = &stack[0] + base;
+}
+
+void VirtualMachine::pollCollector(VMWord* sp)
+{
+     if(collector != NULL)
+          collector->PollWords((void* const*)&stack[0], sp - &stack[0]);
+}
+
+VMWord* VirtualMachine::allocate(size_t count, VMWord* sp, int lineNumber)
+{
+     void** words = WordBlock::Make(count);
+
+     //Free whatever can be before giving up
+     if(words == NULL && collector != NULL)
+     {
+          collector->CollectWords((void* const*)&stack[0], sp - &stack[0]);
+          words = WordBlock::Make(count);
+     }
+     if(words == NULL)
+          throwError(lineNumber, "Out of memory.");
+     return (VMWord*)words;
+}
+
+/*********************
+ * DISPATCH LOOP
+ * *******************/
+
+#ifdef VM_THREADED
+#define TARGET(op) L_##op:
+#define NEXT() goto *((void*)(*pc++))
+#else
+#define TARGET(op) case op:
+#define NEXT() goto dispatch
+#endif
+
+//Jumps read their target as a raw pointer into the threaded code
+#define JUMP() pc = (intptr_t*)(*pc)
+
+#define INT_BINARY(expression) \
+     sp[-2].i = (expression); \
+     sp--; \
+     NEXT();
+
+#define INT_COMPARE(op) INT_BINARY(sp[-2].i op sp[-1].i ? 1 : 0)
+
+#define STRING_COMPARE(op) INT_BINARY(((StringObject*)sp[-2].p)->Compare((StringObject*)sp[-1].p) op 0 ? 1 : 0)
+
+#define STRING_EQUAL(equal, unequal) INT_BINARY(((StringObject*)sp[-2].p)->Equals((StringObject*)sp[-1].p) ? equal : unequal)
+
+#define JUMP_IF_FALSE(op) \
+     sp -= 2; \
+     if(sp[0].i op sp[1].i) \
+          pc++; \
+     else \
+          JUMP(); \
+     NEXT();
+
+void VirtualMachine::Run()
+{
+#ifdef VM_THREADED
+     static void* handlers[BC_NUM_OPCODES] = {
+          &&L_BC_CONST, &&L_BC_STR, &&L_BC_NIL, &&L_BC_POP, &&L_BC_DUP,
+          &&L_BC_LOAD, &&L_BC_STORE, &&L_BC_LOADUP, &&L_BC_STOREUP, &&L_BC_LINK,
+          &&L_BC_ADD, &&L_BC_SUB, &&L_BC_MUL, &&L_BC_DIV, &&L_BC_NEG, &&L_BC_ADDI, &&L_BC_INCL,
+          &&L_BC_LT, &&L_BC_LE, &&L_BC_GT, &&L_BC_GE, &&L_BC_EQ, &&L_BC_NE,
+          &&L_BC_SLT, &&L_BC_SLE, &&L_BC_SGT, &&L_BC_SGE, &&L_BC_SEQ, &&L_BC_SNE,
+          &&L_BC_PEQ, &&L_BC_PNE, &&L_BC_NOT,
+          &&L_BC_JMP, &&L_BC_JZ, &&L_BC_JNZ,
+          &&L_BC_JFLT, &&L_BC_JFLE, &&L_BC_JFGT, &&L_BC_JFGE, &&L_BC_JFEQ, &&L_BC_JFNE,
+          &&L_BC_FORLOOP,
+          &&L_BC_NEWARR, &&L_BC_ALOAD, &&L_BC_ASTORE, &&L_BC_NEWREC, &&L_BC_GETF, &&L_BC_SETF,
+          &&L_BC_CALL, &&L_BC_RET, &&L_BC_PRINT, &&L_BC_PRINTI, &&L_BC_BUILTIN, &&L_BC_HALT
+     };
+     thread(handlers);
+#else
+     thread(NULL);
+#endif
+
+     //Set up the program's own frame at the bottom of the stack
+     stack.resize(1 << 16);
+     VMWord* bp = &stack[0];
+     VMWord* sp = bp;
+     reserveStack(functions[0].frameSize + functions[0].maxStack, sp, bp);
+     memset(bp, 0, functions[0].frameSize * sizeof(VMWord));
+     sp = bp + functions[0].frameSize;
+     intptr_t* pc = functions[0].entry;
+
+#ifdef VM_THREADED
+     NEXT();
+     {
+#else
+dispatch:
+     switch(*pc++)
+     {
+#endif
+          TARGET(BC_CONST)
+               sp->i = (int)(*pc++);
+               sp++;
+               NEXT();
+          TARGET(BC_STR)
+               sp->p = (void*)(*pc++);
+               sp++;
+               NEXT();
+          TARGET(BC_NIL)
+               sp->p = NULL;
+               sp++;
+               NEXT();
+          TARGET(BC_POP)
+               sp--;
+               NEXT();
+          TARGET(BC_DUP)
+               sp[0] = sp[-1];
+               sp++;
+               NEXT();
+          TARGET(BC_LOAD)
+               *sp++ = bp[*pc++];
+               NEXT();
+          TARGET(BC_STORE)
+               bp[*pc++] = *--sp;
+               NEXT();
+          TARGET(BC_LOADUP)
+          {
+               VMWord* frame = bp;
+               for(int hops = pc[0]; hops > 0; hops--)
+                    frame = &stack[0] + frame[0].i;
+               *sp++ = frame[pc[1]];
+               pc += 2;
+               NEXT();
+          }
+          TARGET(BC_STOREUP)
+          {
+               VMWord* frame = bp;
+               for(int hops = pc[0]; hops > 0; hops--)
+                    frame = &stack[0] + frame[0].i;
+               frame[pc[1]] = *--sp;
+               pc += 2;
+               NEXT();
+          }
+          TARGET(BC_LINK)
+          {
+               VMWord* frame = bp;
+               for(int hops = *pc++; hops > 0; hops--)
+                    frame = &stack[0] + frame[0].i;
+               sp->i = frame - &stack[0];
+               sp++;
+               NEXT();
+          }
+
+          //Arithmetic wraps around like the hardware does instead of being undefined
+          TARGET(BC_ADD)
+               INT_BINARY(intAdd(sp[-2].i, sp[-1].i));
+          TARGET(BC_SUB)
+               INT_BINARY(intSubtract(sp[-2].i, sp[-1].i));
+          TARGET(BC_MUL)
+               INT_BINARY(intMultiply(sp[-2].i, sp[-1].i));
+          TARGET(BC_DIV)
+               if(sp[-1].i == 0)
+                    throwError(*pc, "Division by zero.");
+               pc++;
+               if(sp[-1].i == -1)
+               {
+                    INT_BINARY(intNegate(sp[-2].i));
+               }
+               INT_BINARY(sp[-2].i / sp[-1].i);
+          TARGET(BC_NEG)
+               sp[-1].i = intNegate(sp[-1].i);
+               NEXT();
+          TARGET(BC_ADDI)
+               sp[-1].i = intAdd(sp[-1].i, pc[0]);
+               pc++;
+               NEXT();
+          TARGET(BC_INCL)
+               bp[pc[0]].i = intAdd(bp[pc[0]].i, pc[1]);
+               pc += 2;
+               NEXT();
+
+          TARGET(BC_LT)
+               INT_COMPARE(<);
+          TARGET(BC_LE)
+               INT_COMPARE(<=);
+          TARGET(BC_GT)
+               INT_COMPARE(>);
+          TARGET(BC_GE)
+               INT_COMPARE(>=);
+          TARGET(BC_EQ)
+               INT_COMPARE(==);
+          TARGET(BC_NE)
+               INT_COMPARE(!=);
+          TARGET(BC_SLT)
+               STRING_COMPARE(<);
+          TARGET(BC_SLE)
+               STRING_COMPARE(<=);
+          TARGET(BC_SGT)
+               STRING_COMPARE(>);
+          TARGET(BC_SGE)
+               STRING_COMPARE(>=);
+          TARGET(BC_SEQ)
+               STRING_EQUAL(1, 0);
+          TARGET(BC_SNE)
+               STRING_EQUAL(0, 1);
+          TARGET(BC_PEQ)
+               INT_BINARY(sp[-2].p == sp[-1].p ? 1 : 0);
+          TARGET(BC_PNE)
+               INT_BINARY(sp[-2].p != sp[-1].p ? 1 : 0);
+          TARGET(BC_NOT)
+               sp[-1].i = (sp[-1].i == 0) ? 1 : 0;
+               NEXT();
+
+          TARGET(BC_JMP)
+               JUMP();
+               NEXT();
+          TARGET(BC_JZ)
+               if((--sp)->i == 0)
+                    JUMP();
+               else
+                    pc++;
+               NEXT();
+          TARGET(BC_JNZ)
+               if((--sp)->i != 0)
+                    JUMP();
+               else
+                    pc++;
+               NEXT();
+          TARGET(BC_JFLT)
+               JUMP_IF_FALSE(<);
+          TARGET(BC_JFLE)
+               JUMP_IF_FALSE(<=);
+          TARGET(BC_JFGT)
+               JUMP_IF_FALSE(>);
+          TARGET(BC_JFGE)
+               JUMP_IF_FALSE(>=);
+          TARGET(BC_JFEQ)
+               JUMP_IF_FALSE(==);
+          TARGET(BC_JFNE)
+               JUMP_IF_FALSE(!=);
+          TARGET(BC_FORLOOP)
+               if(bp[pc[0]].i < bp[pc[1]].i)
+               {
+                    bp[pc[0]].i++;
+                    pc = (intptr_t*)pc[2];
+               }
+               else
+                    pc += 3;
+               NEXT();
+
+          //Arrays are a length word followed by the elements
+          TARGET(BC_NEWARR)
+          {
+               int size = sp[-2].i;
+               if(size < 0)
+                    throwError(*pc, "Negative array size.");
+               pollCollector(sp);
+               VMWord* array = allocate((size_t)size + 1, sp, *pc++);
+               array[0].i = size;
+               for(int i = 1; i <= size; i++)
+                    array[i] = sp[-1];
+               sp[-2].p = array;
+               sp--;
+               NEXT();
+          }
+          TARGET(BC_ALOAD)
+          {
+               VMWord* array = (VMWord*)sp[-2].p;
+               unsigned index = sp[-1].i;
+               if(index >= (unsigned)array[0].i)
+                    throwError(*pc, "Array access out of bounds.");
+               pc++;
+               sp[-2] = array[index + 1];
+               sp--;
+               NEXT();
+          }
+          TARGET(BC_ASTORE)
+          {
+               VMWord* array = (VMWord*)sp[-3].p;
+               unsigned index = sp[-2].i;
+               if(index >= (unsigned)array[0].i)
+                    throwError(*pc, "Array access out of bounds.");
+               pc++;
+               array[index + 1] = sp[-1];
+               sp -= 3;
+               NEXT();
+          }
+
+          //Records are just their fields, in the order the type lists them
+          TARGET(BC_NEWREC)
+               pollCollector(sp);
+               sp->p = allocate(pc[0] + 1, sp, pc[1]);
+               sp++;
+               pc += 2;
+               NEXT();
+          TARGET(BC_GETF)
+          {
+               VMWord* record = (VMWord*)sp[-1].p;
+               if(record == NULL)
+                    throwError(pc[1], "Field access on nil record.");
+               sp[-1] = record[pc[0]];
+               pc += 2;
+               NEXT();
+          }
+          TARGET(BC_SETF)
+          {
+               VMWord* record = (VMWord*)sp[-2].p;
+               if(record == NULL)
+                    throwError(pc[1], "Field access on nil record.");
+               record[pc[0]] = sp[-1];
+               sp -= 2;
+               pc += 2;
+               NEXT();
+          }
+
+          //The caller has already pushed the static link and arguments,
+          // which become the first slots of the new frame
+          TARGET(BC_CALL)
+          {
+               VMFunction* function = (VMFunction*)(*pc++);
+               VMWord* frame = sp - (function->numParams + 1);
+               reserveStack(function->frameSize + function->maxStack, sp, bp);
+               frame = sp - (function->numParams + 1);
+
+               VMCallFrame call = {pc, (int)(bp - &stack[0])};
+               calls.push_back(call);
+
+               bp = frame;
+               sp = frame + function->numParams + 1;
+               while(sp < frame + function->frameSize)
+                    (sp++)->p = NULL;
+               pc = function->entry;
+               NEXT();
+          }
+          TARGET(BC_RET)
+          {
+               VMWord result = sp[-1];
+               sp = bp;
+               *sp++ = result;
+               VMCallFrame& call = calls.back();
+               bp = &stack[0] + call.bp;
+               pc = call.returnPc;
+               calls.pop_back();
+               NEXT();
+          }
+
+          TARGET(BC_PRINT)
+          {
+               StringObject* s = (StringObject*)(--sp)->p;
+               output->Write(s->GetChars(), s->GetLength());
+               NEXT();
+          }
+          TARGET(BC_PRINTI)
+               output->WriteInt((--sp)->i);
+               NEXT();
+          TARGET(BC_BUILTIN)
+          {
+               //The arguments are still on the stack while the collector runs
+               pollCollector(sp);
+               int numParams = builtins[pc[0]].numParams;
+               sp -= numParams;
+               *sp = callBuiltin(pc[0], sp, pc[1]);
+               sp++;
+               pc += 2;
+               NEXT();
+          }
+          TARGET(BC_HALT)
+               return;
+     }
+}
@@ -0,0 +1,219 @@
+/*
+     Creation Date: 10/18/26
+     Filename:      VirtualMachine.h
+     Purpose:       Executes a BytecodeProgram on an operand stack using a
+                    direct-threaded dispatch loop.
+
+*/
+
+/** @defgroup VM Virtual Machine
+ *  Executes compiled bytecode.
+ *  @{
+ */
+
+#ifndef VIRTUAL_MACHINE
+#define VIRTUAL_MACHINE
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Bytecode.h"
+#include "GarbageCollector.h"
+
+using namespace std;
+
+//GCC and Clang can jump straight to a label address stored in the code,
+// everything else falls back to a switch
+#if defined(__GNUC__)
+#define VM_THREADED
+#endif
+
+/**
+ * @brief A single slot on the VM stack. Tiger is statically typed, so the compiler
+ * always knows whether a slot holds an int or a pointer to a string, array or record
+ * and no tag is needed.
+ *
+ */
+union VMWord
+{
+     /**
+      * @brief An integer value, or a frame index for static links.
+      *
+      */
+     int i;
+
+     /**
+      * @brief A string, array, or record; NULL for nil.
+      *
+      */
+     void* p;
+};
+
+/**
+ * @brief Runs any builtin without an opcode of its own on arguments already
+ * evaluated to words. Strings are the same objects the tree-walking engines
+ * use, but new ones are never freed, like arrays and records.
+ *
+ * @param kind Which builtin, a BuiltinKind.
+ * @param args The arguments, in order.
+ * @param lineNumber Line of the call, to report runtime errors on.
+ * @return VMWord The result, or 0 for builtins returning unit.
+ */
+VMWord callBuiltin(int kind, VMWord* args, int lineNumber);
+
+/**
+ * @brief Everything the VM needs to call a function, resolved once when the code is threaded.
+ *
+ */
+class VMFunction
+{
+     public:
+          /**
+           * @brief First instruction of the function in the threaded code.
+           *
+           */
+          intptr_t* entry;
+
+          /**
+           * @brief Number of formal parameters.
+           *
+           */
+          int numParams;
+
+          /**
+           * @brief Slots in the function's frame, including the static link.
+           *
+           */
+          int frameSize;
+
+          /**
+           * @brief Most operands the function keeps on the stack at once.
+           *
+           */
+          int maxStack;
+};
+
+/**
+ * @brief Where to go back to when a function returns.
+ *
+ */
+class VMCallFrame
+{
+     public:
+          /**
+           * @brief Instruction after the call.
+           *
+           */
+          intptr_t* returnPc;
+
+          /**
+           * @brief Stack index of the caller's frame.
+           *
+           */
+          int bp;
+};
+
+/**
+ * @brief A stack-based virtual machine for compiled Tiger bytecode.
+ *
+ */
+class VirtualMachine
+{
+     public:
+          /**
+           * @brief Construct a new virtual machine for a compiled program.
+           *
+           * @param program The program to run; must outlive the VM.
+           */
+          VirtualMachine(BytecodeProgram* program);
+
+          /**
+           * @brief Runs the program to completion.
+           *
+           */
+          void Run();
+
+          /**
+           * @brief Prints out a runtime error with a line number before exiting with
+           * error code 4.
+           *
+           * @param lineNumber Line number at which the error occurred.
+           * @param errorMessage An informative message about the error.
+           */
+          void throwError(const int &lineNumber, const string &errorMessage);
+
+          /**
+           * @brief Lays every function out into one block of code, swapping opcodes for
+           * handler addresses (when threading) and jump targets and callees for pointers.
+           *
+           * @param handlers Address of the handler for each opcode, or NULL to keep opcodes.
+           */
+          void thread(void** handlers);
+
+          /**
+           * @brief Makes sure the stack has room for a new frame, growing it if needed.
+           *
+           * @param needed Number of slots that must be available past the current top.
+           * @param sp Current top of stack; updated if the stack moves.
+           * @param bp Current frame; updated if the stack moves.
+           */
+          void reserveStack(int needed, VMWord* &sp, VMWord* &bp);
+
+          /**
+           * @brief Collects if the heap has grown past its limit, with everything on
+           * the stack as roots.
+           *
+           * @param sp Current top of stack.
+           */
+          void pollCollector(VMWord* sp);
+
+          /**
+           * @brief Makes a zeroed array or record, collecting and trying again before
+           * stopping the program if there isn't the memory for it.
+           *
+           * @param count Number of words.
+           * @param sp Current top of stack.
+           * @param lineNumber Line to report running out of memory on.
+           * @return VMWord* The first word.
+           */
+          VMWord* allocate(size_t count, VMWord* sp, int lineNumber);
+
+          /**
+           * @brief The program being run.
+           *
+           */
+          BytecodeProgram* program;
+
+          /**
+           * @brief All functions laid out back to back, ready to execute.
+           *
+           */
+          vector<intptr_t> code;
+
+          /**
+           * @brief Call information for each function, indexed like the program's functions.
+           *
+           */
+          vector<VMFunction> functions;
+
+          /**
+           * @brief Frames and operands. Frames are addressed by index so the stack can grow.
+           *
+           */
+          vector<VMWord> stack;
+
+          /**
+           * @brief Return addresses and caller frames for every active call.
+           *
+           */
+          vector<VMCallFrame> calls;
+
+          /**
+           * @brief Frees arrays, records and strings the program can't reach any more.
+           * The VM doesn't know which words are pointers, so it scans every one in use.
+           *
+           */
+          GarbageCollector* collector;
+};
+/** @} */
+#endif
@@ -7,6 +7,8 @@
 
 node::node(const int &lineNumber):lineNumber(lineNumber){} 
 
+Arena* node::arena = NULL;
+
 /********************************************
  * prog node
  * ******************************************/
@@ -28,7 +30,7 @@ void subscript::accept(nodeVisitor* visitor){
 /********************************************
  * fieldExp node
  * ******************************************/
-fieldExp::fieldExp(const int &lineNumber, node* pLValue, node* ID):node(lineNumber), lValue(pLValue),ID(ID){}
+fieldExp::fieldExp(const int &lineNumber, node* pLValue, node* ID):node(lineNumber), lValue(pLValue),ID(ID),slot(-1){}
 
 void fieldExp::accept(nodeVisitor* visitor){
      visitor->visitFieldExp(this);
@@ -37,7 +39,7 @@ void fieldExp::accept(nodeVisitor* visitor){
 /********************************************
  * seqExp node
  * ******************************************/
-seqExp::seqExp(const int &lineNumber, std::vector<node*>* exps):node(lineNumber), exps(exps){}
+seqExp::seqExp(const int &lineNumber, NodeList* exps):node(lineNumber), exps(exps){}
 
 void seqExp::accept(nodeVisitor* visitor){
      visitor->visitSeqExp(this);
@@ -55,7 +57,7 @@ void negation::accept(nodeVisitor* visitor){
 /********************************************
  * callExp node
  * ******************************************/
-callExp::callExp(const int &lineNumber, node* id, std::vector<node*>* exps):node(lineNumber), id(id),exps(exps){}
+callExp::callExp(const int &lineNumber, node* id, NodeList* exps):node(lineNumber), id(id),exps(exps),tail(false),function(NULL),builtin(NULL){}
 
 void callExp::accept(nodeVisitor* visitor){
      visitor->visitCallExp(this);
@@ -64,7 +66,7 @@ void callExp::accept(nodeVisitor* visitor){
 /********************************************
  * inFix node
  * ******************************************/
-infixExp::infixExp(const int &lineNumber, Operator op, node* leftNode, node* rightNode):node(lineNumber), op(op),leftNode(leftNode),rightNode(rightNode){}
+infixExp::infixExp(const int &lineNumber, Operator op, node* leftNode, node* rightNode):node(lineNumber), op(op),operation(INFIX_INT_ADD),leftNode(leftNode),rightNode(rightNode){}
 
 void infixExp::accept(nodeVisitor* visitor){
      visitor->visitInfixExp(this);
@@ -74,7 +76,7 @@ void infixExp::accept(nodeVisitor* visitor){
  * arrCreate node
  * ******************************************/
 arrCreate::arrCreate(const int &lineNumber, node* tyId, node* subscriptExp, node* postExp):
-node(lineNumber), tyId(tyId),subscriptExp(subscriptExp),postExp(postExp){}
+node(lineNumber), tyId(tyId),subscriptExp(subscriptExp),postExp(postExp),ints(false){}
 
 void arrCreate::accept(nodeVisitor* visitor){
      visitor->visitArrCreate(this);
@@ -83,7 +85,7 @@ void arrCreate::accept(nodeVisitor* visitor){
 /********************************************
  * recCreate node
  * ******************************************/
-recCreate::recCreate(const int &lineNumber, node* tyId, std::vector<node*>* fields):node(lineNumber), tyId(tyId),fields(fields){}
+recCreate::recCreate(const int &lineNumber, node* tyId, NodeList* fields):node(lineNumber), tyId(tyId),fields(fields),record(NULL){}
 
 void recCreate::accept(nodeVisitor* visitor){
      visitor->visitRecCreate(this);
@@ -92,7 +94,7 @@ void recCreate::accept(nodeVisitor* visitor){
 /********************************************
  * fieldCreate node
  * ******************************************/
-fieldCreate::fieldCreate(const int &lineNumber, node* id, node* exp):node(lineNumber), id(id),exp(exp){}
+fieldCreate::fieldCreate(const int &lineNumber, node* id, node* exp):node(lineNumber), id(id),exp(exp),slot(-1){}
 
 void fieldCreate::accept(nodeVisitor* visitor){
      visitor->visitFieldCreate(this);
@@ -139,7 +141,7 @@ void forExp::accept(nodeVisitor* visitor){
 /********************************************
  * letExp node
  * ******************************************/
-letExp::letExp(const int &lineNumber, std::vector<node*>* decs, std::vector<node*>* exps):node(lineNumber), decs(decs),exps(exps){}
+letExp::letExp(const int &lineNumber, NodeList* decs, NodeList* exps):node(lineNumber), decs(decs),exps(exps),frameSize(0){}
 
 void letExp::accept(nodeVisitor* visitor){
      visitor->visitLetExp(this);
@@ -218,7 +220,7 @@ void arrTy::accept(nodeVisitor* visitor){
 /********************************************
  * recTy node
  * ******************************************/
-recTy::recTy(const int &lineNumber, std::vector<node*>* fieldDecs):tyDef(lineNumber), fieldDecs(fieldDecs)
+recTy::recTy(const int &lineNumber, NodeList* fieldDecs):tyDef(lineNumber), fieldDecs(fieldDecs)
 {
      kind = DEF_REC;
 }
@@ -236,18 +238,18 @@ void fieldDec::accept(nodeVisitor* visitor){
      visitor->visitFieldDec(this);
 }
 
-pair< string, Type*> fieldDec::FieldToPair()
+pair< Atom, Type*> fieldDec::FieldToPair()
 {
-     string name = ((NId*) id)->name;
+     Atom name = ((NId*) id)->name;
      Type* ty = tyId->type;
-     return pair<string,Type*>(name, ty);
+     return pair<Atom,Type*>(name, ty);
 }
 
 /********************************************
  * funDec node
  * ******************************************/
-funDec::funDec(const int &lineNumber, node* id, std::vector<node*>* params, node* returnType, node* exp):
-decc(lineNumber), params(params),returnType(returnType), exp(exp)
+funDec::funDec(const int &lineNumber, node* id, NodeList* params, node* returnType, node* exp):
+decc(lineNumber), params(params),returnType(returnType), exp(exp), frameSize(0), paramSlots(ArenaAllocator<int>(arena))
 {
      this->id = id;
      kind = D_FUNC;
@@ -257,14 +259,14 @@ void funDec::accept(nodeVisitor* visitor){
      visitor->visitFunDec(this);
 }
 
-vector< pair<string,Type*> > funDec::getParams()
+vector< pair<Atom,Type*> > funDec::getParams()
 {
-     vector< pair<string,Type*> > allParams;
+     vector< pair<Atom,Type*> > allParams;
      for(int i = 0; i < params->size(); i++)
      {
           fieldDec* param = (fieldDec*)((*params)[i]);
-          string name = ((NId*)(param->id))->name;
-          allParams.push_back(pair<string,Type*>(name,(*params)[i]->type));
+          Atom name = ((NId*)(param->id))->name;
+          allParams.push_back(pair<Atom,Type*>(name,(*params)[i]->type));
      }
      return allParams;
 }
@@ -311,7 +313,7 @@ void NNil::accept(nodeVisitor* visitor){
 /********************************************
  * ID node
  * ******************************************/
-NId::NId(const int &lineNumber, string* value):node(lineNumber), name(*value){
+NId::NId(const int &lineNumber, Atom value):node(lineNumber), name(value), depth(-1), slot(-1){
 }
 
 void NId::accept(nodeVisitor* visitor){
@@ -321,7 +323,7 @@ void NId::accept(nodeVisitor* visitor){
 /********************************************
  * TYID node
  * ******************************************/
-NTyId::NTyId(const int &lineNumber, string* value):node(lineNumber), name(*value){
+NTyId::NTyId(const int &lineNumber, Atom value):node(lineNumber), name(value){
 }
 
 void NTyId::accept(nodeVisitor* visitor){
@@ -341,12 +343,8 @@ void NIntLit::accept(nodeVisitor* visitor){
 /********************************************
  * STRLIT node
  * ******************************************/
-NStrLit::NStrLit(const int &lineNumber, string* value):node(lineNumber){
-     //Process the string a wee bit to fix'er up
-     string inString = *value;
-     inString = inString.substr(1, inString.size()-2); //Cleave off the quotes
-     inString += "\0"; //Add a null terminator since I don't think the lexer adds one
-     val = inString.data();
+NStrLit::NStrLit(const int &lineNumber, Atom value):node(lineNumber){
+     val = value;
 }
 
 void NStrLit::accept(nodeVisitor* visitor){
@@ -376,19 +374,19 @@ void nodePrinter::visitNil(NNil* Nil)
 }
 void nodePrinter::visitID(NId* id)
 {
-     std::cout << "( Identifier: " << id->name << " )";
+     std::cout << "( Identifier: " << *id->name << " )";
 }
 void nodePrinter::visitTyID(NTyId* tyid)
 {
-     std::cout << "( Type Id: " << tyid->name << " )";
+     std::cout << "( Type Id: " << *tyid->name << " )";
 }
 void nodePrinter::visitIntLit(NIntLit* intLit)
 {
-     std::cout << "( INTLIT[" << intLit->value << "])";
+     std::cout << "( INTLIT[" << intLit->val << "])";
 }
 void nodePrinter::visitStrLit(NStrLit* strLit)
 {
-     std::cout << "( STRLIT[" << strLit->value << "])";
+     std::cout << "( STRLIT[" << *strLit->val << "])";
 }
 void nodePrinter::visitSubscript(subscript* Subscript)
 {
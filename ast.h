@@ -22,6 +22,7 @@
 #include <string>
 #include <vector>
 #include "SymbolTable.h"
+#include "Arena.h"
 
 using namespace std;
 
@@ -131,6 +132,21 @@ class node
            */
           virtual ~node() {}
 
+          /**
+           * @brief Nodes are carved out of the current arena, and go back with it
+           * all at once rather than one by one.
+           * 
+           */
+          static void* operator new(size_t size) {return arena->Allocate(size);}
+          static void operator delete(void* memory) {}
+
+          /**
+           * @brief The arena new nodes and child lists are allocated in; set by
+           * whoever builds the tree, before it starts.
+           * 
+           */
+          static Arena* arena;
+
           /**
            * @brief Line number of the code bit that the node represents.
            * 
@@ -147,11 +163,28 @@ class node
            * @brief Current value of the node during interpretation
            * 
            */
-          Value* value;
+          Value value;
           
      
 };
 
+/**
+ * @brief A list of child nodes, kept in the same arena as the nodes themselves.
+ * 
+ */
+class NodeList : public vector<node*, ArenaAllocator<node*> >
+{
+     public:
+          /**
+           * @brief Construct a new, empty list in the current arena.
+           * 
+           */
+          NodeList():vector<node*, ArenaAllocator<node*> >(ArenaAllocator<node*>(node::arena)) {}
+
+          static void* operator new(size_t size) {return node::arena->Allocate(size);}
+          static void operator delete(void* memory) {}
+};
+
 /**
  * @brief Represents the program production in the Tiger grammar. Top node of all Tiger programs.
  * 
@@ -386,14 +419,14 @@ class recTy : public tyDef
            * @brief Collection of the field declarations that make up this record definition.
            * 
            */
-          std::vector<node*>* fieldDecs;
+          NodeList* fieldDecs;
           /**
            * @brief Construct a new rec Ty object.
            * 
            * @param lineNumber The line number of the code bit that the node represents
            * @param fieldDecs Collection of the field declarations that make up this record definition.
            */
-          recTy(const int &lineNumber, std::vector<node*>* fieldDecs);
+          recTy(const int &lineNumber, NodeList* fieldDecs);
           /**
            * @brief Required for visitor pattern
            * 
@@ -432,9 +465,9 @@ class fieldDec : public node
           /**
            * @brief Returns a pair with the name and Type of the entire field declaration.
            * 
-           * @return pair<string, Type*> A pair  with the name and Type of the entire field declaration.
+           * @return pair<Atom, Type*> A pair  with the name and Type of the entire field declaration.
            */
-          pair<string, Type*> FieldToPair();
+          pair<Atom, Type*> FieldToPair();
 
           /**
            * @brief Required by visitor pattern.
@@ -457,7 +490,7 @@ class funDec : public decc
            * function.
            * 
            */
-          std::vector<node*>* params;
+          NodeList* params;
 
           /**
            * @brief The return type of the function.
@@ -471,6 +504,19 @@ class funDec : public decc
            */
           node* exp;
 
+          /**
+           * @brief Number of slots in the function's frame. Set during semantic analysis.
+           * 
+           */
+          int frameSize;
+
+          /**
+           * @brief The frame slot each parameter goes in, in order. Set during
+           * semantic analysis.
+           * 
+           */
+          vector<int, ArenaAllocator<int> > paramSlots;
+
           /**
            * @brief Construct a new fun Dec object
            * 
@@ -480,7 +526,7 @@ class funDec : public decc
            * @param returnType The return type of the function.
            * @param exp The definition for the function.
            */
-          funDec(const int &lineNumber, node* id, std::vector<node*>* params, node* returnType, node* exp);
+          funDec(const int &lineNumber, node* id, NodeList* params, node* returnType, node* exp);
           
           /**
            * @brief Required for visitor pattern.
@@ -491,9 +537,9 @@ class funDec : public decc
           /**
            * @brief Constructs a list of name->type pairs for all of the parameters in the function.
            * 
-           * @return vector< pair<string,Type*> > List of name->type pairs for all of the parameters in the function.
+           * @return vector< pair<Atom,Type*> > List of name->type pairs for all of the parameters in the function.
            */
-          vector< pair<string,Type*> > getParams();
+          vector< pair<Atom,Type*> > getParams();
 
 };
 /**
@@ -590,6 +636,13 @@ class fieldExp : public node
            */
           node* ID;
 
+          /**
+           * @brief Where the field is in the record's slots. Set during semantic
+           * analysis.
+           * 
+           */
+          int slot;
+
           /**
            * @brief Construct a new field Exp object
            * 
@@ -618,7 +671,7 @@ class seqExp : public node
            * @brief All of the expressions contained within this sequence.
            * 
            */
-          std::vector<node*> *exps;
+          NodeList* exps;
 
           /**
            * @brief Construct a new seq Exp object
@@ -626,7 +679,7 @@ class seqExp : public node
            * @param lineNumber The line number of the code bit that the node represents
            * @param exps All of the expressions contained within this sequence.
            */
-          seqExp(const int &lineNumber, std::vector<node*>* exps);
+          seqExp(const int &lineNumber, NodeList* exps);
 
           /**
            * @brief Required for visitor pattern.
@@ -681,7 +734,28 @@ class callExp : public node
            * @brief List of expressions to pass as parameters to the function, if any
            * 
            */
-          std::vector<node*>* exps;
+          NodeList* exps;
+
+          /**
+           * @brief Whether the call is the last thing its function does, so the
+           * function's frame can be reused for it. Set during semantic analysis.
+           * 
+           */
+          bool tail;
+
+          /**
+           * @brief The function called, or NULL for a builtin. Bound during semantic
+           * analysis, since every call's function is known from where it is.
+           * 
+           */
+          funDec* function;
+
+          /**
+           * @brief The builtin called, or NULL for a function declared in the
+           * program. Bound during semantic analysis.
+           * 
+           */
+          Builtin* builtin;
 
           /**
            * @brief Construct a new call Exp object
@@ -690,7 +764,7 @@ class callExp : public node
            * @param id Identifier of the function to call.
            * @param exps List of expressions to pass as parameters to the function, if any
            */
-          callExp(const int &lineNumber, node* id, std::vector<node*>* exps);
+          callExp(const int &lineNumber, node* id, NodeList* exps);
 
           /**
            * @brief Required for visitor pattern.
@@ -765,6 +839,113 @@ enum Operator {
       */
      OP_GEQ
 };
+/**
+ * @brief What an infix expression does once the types of its operands are known.
+ * Picked during semantic analysis so the interpreter doesn't look at types at runtime.
+ * 
+ */
+enum InfixOperation {
+     /**
+      * @brief Adds two ints.
+      * 
+      */
+     INFIX_INT_ADD,
+     /**
+      * @brief Subtracts two ints.
+      * 
+      */
+     INFIX_INT_SUBTRACT,
+     /**
+      * @brief Multiplies two ints.
+      * 
+      */
+     INFIX_INT_MULTIPLY,
+     /**
+      * @brief Divides two ints.
+      * 
+      */
+     INFIX_INT_DIVIDE,
+     /**
+      * @brief Compares two ints for equality.
+      * 
+      */
+     INFIX_INT_EQ,
+     /**
+      * @brief Compares two ints for inequality.
+      * 
+      */
+     INFIX_INT_NEQ,
+     /**
+      * @brief Less than on ints.
+      * 
+      */
+     INFIX_INT_LT,
+     /**
+      * @brief Less than or equal to on ints.
+      * 
+      */
+     INFIX_INT_LEQ,
+     /**
+      * @brief Greater than on ints.
+      * 
+      */
+     INFIX_INT_GT,
+     /**
+      * @brief Greater than or equal to on ints.
+      * 
+      */
+     INFIX_INT_GEQ,
+     /**
+      * @brief Compares two strings' contents for equality.
+      * 
+      */
+     INFIX_STR_EQ,
+     /**
+      * @brief Compares two strings' contents for inequality.
+      * 
+      */
+     INFIX_STR_NEQ,
+     /**
+      * @brief Less than on strings, by contents.
+      * 
+      */
+     INFIX_STR_LT,
+     /**
+      * @brief Less than or equal to on strings, by contents.
+      * 
+      */
+     INFIX_STR_LEQ,
+     /**
+      * @brief Greater than on strings, by contents.
+      * 
+      */
+     INFIX_STR_GT,
+     /**
+      * @brief Greater than or equal to on strings, by contents.
+      * 
+      */
+     INFIX_STR_GEQ,
+     /**
+      * @brief Compares two arrays, records or nils by identity for equality.
+      * 
+      */
+     INFIX_REF_EQ,
+     /**
+      * @brief Compares two arrays, records or nils by identity for inequality.
+      * 
+      */
+     INFIX_REF_NEQ,
+     /**
+      * @brief Logical and, only evaluating the right operand if the left is non-zero.
+      * 
+      */
+     INFIX_AND,
+     /**
+      * @brief Logical or, only evaluating the right operand if the left is zero.
+      * 
+      */
+     INFIX_OR
+};
 /**
  * @brief Represents the infixExp production in the Tiger language. Describes infix operations
  * between two operands, such as addition(+), less than (<), etc.
@@ -779,6 +960,12 @@ class infixExp : public node
            */
           Operator op;
 
+          /**
+           * @brief The operation for the operands' types. Set during semantic analysis.
+           * 
+           */
+          InfixOperation operation;
+
           /**
            * @brief Left hand side of the expression.
            * 
@@ -834,6 +1021,13 @@ class arrCreate : public node
            */
           node* postExp;
 
+          /**
+           * @brief Whether the array's elements are ints, so it can keep them unboxed.
+           * Set during semantic analysis.
+           * 
+           */
+          bool ints;
+
           /**
            * @brief Construct a new arr Create object
            * 
@@ -869,7 +1063,14 @@ class recCreate : public node
            * @brief List of field initializations.
            * 
            */
-          std::vector<node*>* fields;
+          NodeList* fields;
+
+          /**
+           * @brief The record type being instantiated, with any aliases looked
+           * through. Set during semantic analysis.
+           * 
+           */
+          RecType* record;
 
           /**
            * @brief Construct a new recCreate object
@@ -878,7 +1079,7 @@ class recCreate : public node
            * @param tyId The record type that is being instantiated.
            * @param fields List of field initializations.
            */
-          recCreate(const int &lineNumber, node* tyId, std::vector<node*>* fields);
+          recCreate(const int &lineNumber, node* tyId, NodeList* fields);
 
           /**
            * @brief Required for visitor pattern.
@@ -906,6 +1107,13 @@ class fieldCreate : public node
            */
           node* exp;
 
+          /**
+           * @brief Where the field is in the record's slots. Set during semantic
+           * analysis.
+           * 
+           */
+          int slot;
+
           /**
            * @brief Construct a new field Create object
            * 
@@ -1092,13 +1300,20 @@ class letExp : public node
            * current block's scope.
            * 
            */
-          std::vector<node*>* decs;
+          NodeList* decs;
 
           /**
            * @brief All of the expressions to be executed in the block.
            * 
            */
-          std::vector<node*>* exps;
+          NodeList* exps;
+
+          /**
+           * @brief Number of slots in the frame for this block, one per variable
+           * and function declared in it. Set during semantic analysis.
+           * 
+           */
+          int frameSize;
 
           /**
            * @brief Construct a new let Exp object
@@ -1108,7 +1323,7 @@ class letExp : public node
            * current block's scope.
            * @param exps All of the expressions to be executed in the block.
            */
-          letExp(const int &lineNumber, std::vector<node*>* decs, std::vector<node*>* exps);
+          letExp(const int &lineNumber, NodeList* decs, NodeList* exps);
 
           /**
            * @brief Required for visitor pattern.
@@ -1130,10 +1345,25 @@ class NId : public node
      
      public:
           /**
-           * @brief Name of the identifier.
+           * @brief Name of the identifier, as interned by the lexer.
+           * 
+           */
+          Atom name;
+
+          /**
+           * @brief For variable and function names, how many frames out from the
+           * current one the name was declared; -1 if it doesn't name either.
+           * Set during semantic analysis.
+           * 
+           */
+          int depth;
+
+          /**
+           * @brief For variable and function names, the slot holding it in the
+           * frame it was declared in; -1 if it doesn't name either.
            * 
            */
-          string name;
+          int slot;
           
           /**
            * @brief Construct a new NId object
@@ -1141,7 +1371,7 @@ class NId : public node
            * @param lineNumber The line number of the code bit that the node represents
            * @param value Name of the identifier.
            */
-          NId(const int &lineNumber, string* value);
+          NId(const int &lineNumber, Atom value);
 
           /**
            * @brief Required for visitor pattern.
@@ -1158,10 +1388,10 @@ class NTyId : public node
  
      public:
           /**
-           * @brief Name of the type identifier.
+           * @brief Name of the type identifier, as interned by the lexer.
            * 
            */
-          string name;
+          Atom name;
 
           /**
            * @brief Construct a new NTyId object
@@ -1169,7 +1399,7 @@ class NTyId : public node
            * @param lineNumber The line number of the code bit that the node represents
            * @param value Name of the type identifier.
            */
-          NTyId(const int &lineNumber, string* value);
+          NTyId(const int &lineNumber, Atom value);
 
           /**
            * @brief Required for visitor pattern.
@@ -1214,18 +1444,18 @@ class NStrLit : public node
  
      public:
           /**
-           * @brief The string literal this node represents.
+           * @brief The string literal this node represents, without its quotes.
            * 
            */
-          string val;
+          Atom val;
 
           /**
            * @brief Construct a new NStrLit object
            * 
            * @param lineNumber The line number of the code bit that the node represents
-           * @param value The string literal this node represents.
+           * @param value The string literal this node represents, without its quotes.
            */
-          NStrLit(const int &lineNumber, string* value);
+          NStrLit(const int &lineNumber, Atom value);
 
           /**
            * @brief Required for visitor pattern.
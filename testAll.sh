@@ -2,7 +2,7 @@
 compilerExecutable=tigerc
 dirOfTestCases=./test-cases/
 
-for testFile in $(ls $dirOfTestCases)
+for testFile in $(ls $dirOfTestCases | grep '\.tig$')
 do
     ./$compilerExecutable $dirOfTestCases$testFile &>/dev/null
     if [ $? -eq 0 ]; then
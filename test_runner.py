@@ -2,13 +2,74 @@
 import os
 import subprocess
 import re
+import tempfile
 from pprint import pprint
 
+# tests with a .out file next to them are run on every engine, with each lexer,
+# and compiled through C
+ENGINES = ['--engine=tree', '--jit=off', '--engine=vm', '--engine=closure', '--engine=stack', '--engine=flat']
+LEXERS = ['--lexer=flex', '--lexer=fast']
+
+# the C from --emit-c is built at a pinned optimization level: tail calls between
+# functions only run in constant stack once the C compiler turns them into jumps
+C_COMPILER = ['cc', '-O2']
+
+# the exit code each kind of error stops the program with
+EXIT_CODES = {'Lexer': 1, 'Parser': 2, 'Semantic': 3, 'Runtime': 4}
+error_kind = re.compile(r'ERROR:? (?:\d+: )?(Lexer|Parser|Semantic|Runtime):')
+
+def expected_exit(output):
+    m = error_kind.search(output)
+    if m:
+        return EXIT_CODES[m.group(1)]
+    return 0
+
+def run_emitted_c(f):
+    # errors caught before any C is generated come from tigerc itself
+    c = subprocess.run(['./tigerc', '--emit-c', 'test-cases/' + f], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    if c.returncode != 0:
+        return ''.join( chr(x) for x in c.stdout + c.stderr ), c.returncode, None
+    with tempfile.TemporaryDirectory() as build:
+        with open(build + '/program.c', 'wb') as source:
+            source.write(c.stdout)
+        compiled = subprocess.run(C_COMPILER + [build + '/program.c', '-o', build + '/program'], stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        if compiled.returncode != 0:
+            return None, None, ''.join( chr(x) for x in compiled.stdout )
+        c = subprocess.run([build + '/program'], stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+        return ''.join( chr(x) for x in c.stdout ), c.returncode, None
+
 if __name__ == '__main__':
 
-    # run all the tests
+    # run the tests with expected output under every engine and lexer
+    outputs = {}
+    for f in sorted(os.listdir('test-cases')):
+        if not f.endswith('.tig') or not os.path.exists('test-cases/' + f[:-4] + '.out'):
+            continue
+        with open('test-cases/' + f[:-4] + '.out') as expected_file:
+            expected = expected_file.read()
+        errors = []
+        for engine in ENGINES:
+            for lexer in LEXERS:
+                c = subprocess.run(['./tigerc', engine, lexer, 'test-cases/' + f], stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+                output = ''.join( chr(x) for x in c.stdout )
+                if output != expected:
+                    errors.append(engine + ' ' + lexer + ': incorrect output:\n' + output)
+                elif c.returncode != expected_exit(expected):
+                    errors.append(engine + ' ' + lexer + ': incorrect exit code: got ' + str(c.returncode) + ', should be ' + str(expected_exit(expected)))
+        output, returncode, compile_errors = run_emitted_c(f)
+        if compile_errors is not None:
+            errors.append('--emit-c: C compiler failed:\n' + compile_errors)
+        elif output != expected:
+            errors.append('--emit-c: incorrect output:\n' + output)
+        elif returncode != expected_exit(expected):
+            errors.append('--emit-c: incorrect exit code: got ' + str(returncode) + ', should be ' + str(expected_exit(expected)))
+        outputs[f] = errors
+
+    # run all the other tests
     results = {}
     for f in os.listdir('test-cases'):
+        if not f.endswith('.tig') or f in outputs:
+            continue
         c = subprocess.run(['./tigerc', 'test-cases/' + f], stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
         d = {}
         test = c.args[1].split('/')[1]
@@ -84,7 +145,7 @@ if __name__ == '__main__':
                 lexer_results.append(1)
             else:
                 lexer_results.append(0)
-    print('Lexer: {:d}/{:d}: {:.2%} Correct'.format(sum(lexer_results), len(lexer_results), sum(lexer_results)/len(lexer_results)))
+    print('Lexer: {:d}/{:d}: {:.2%} Correct'.format(sum(lexer_results), len(lexer_results), sum(lexer_results)/max(len(lexer_results), 1)))
 
     # Parser
     parser_results = []
@@ -101,7 +162,7 @@ if __name__ == '__main__':
                 parser_results.append(1)
             else:
                 parser_results.append(0)
-    print('Parser: {:d}/{:d}: {:.2%} Correct'.format(sum(parser_results), len(parser_results), sum(parser_results)/len(parser_results)))
+    print('Parser: {:d}/{:d}: {:.2%} Correct'.format(sum(parser_results), len(parser_results), sum(parser_results)/max(len(parser_results), 1)))
 
     # Basic
     basic_results = []
@@ -116,7 +177,7 @@ if __name__ == '__main__':
                 basic_results.append(0)
             else:
                 basic_results.append(1)
-    print('Basic: {:d}/{:d}: {:.2%} Correct'.format(sum(basic_results), len(basic_results), sum(basic_results)/len(basic_results)))
+    print('Basic: {:d}/{:d}: {:.2%} Correct'.format(sum(basic_results), len(basic_results), sum(basic_results)/max(len(basic_results), 1)))
 
     # Complex
     complex_results = []
@@ -131,7 +192,7 @@ if __name__ == '__main__':
                 complex_results.append(0)
             else:
                 complex_results.append(1)
-    print('Complex: {:d}/{:d}: {:.2%} Correct'.format(sum(complex_results), len(complex_results), sum(complex_results)/len(complex_results)))
+    print('Complex: {:d}/{:d}: {:.2%} Correct'.format(sum(complex_results), len(complex_results), sum(complex_results)/max(len(complex_results), 1)))
 
     # Recursive
     recursive_results = []
@@ -146,7 +207,11 @@ if __name__ == '__main__':
                 recursive_results.append(0)
             else:
                 recursive_results.append(1)
-    print('Recursive: {:d}/{:d}: {:.2%} Correct'.format(sum(recursive_results), len(recursive_results), sum(recursive_results)/len(recursive_results)))
+    print('Recursive: {:d}/{:d}: {:.2%} Correct'.format(sum(recursive_results), len(recursive_results), sum(recursive_results)/max(len(recursive_results), 1)))
+
+    # Output, on every engine and lexer
+    output_results = [1 if len(e) == 0 else 0 for e in outputs.values()]
+    print('Output: {:d}/{:d}: {:.2%} Correct'.format(sum(output_results), len(output_results), sum(output_results)/max(len(output_results), 1)))
 
     print('')
     print('')
@@ -158,3 +223,9 @@ if __name__ == '__main__':
             print(t)
             for e in r['errors']:
                 print('  ' + e)
+    for t, errors in sorted(outputs.items()):
+        if len(errors) != 0:
+            print()
+            print(t)
+            for e in errors:
+                print('  ' + e)
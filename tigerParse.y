@@ -4,15 +4,21 @@
      #include <string>
      #include <iostream>
      #include <vector>
+     #include <chrono>
      #include "ast.h"
      #include "SemanticAnalyzer.h"
      #include "Interpreter.h"
+     #include "CBackend.h"
+     #include "Output.h"
+     #include "SourceFile.h"
+     #include "FastLexer.h"
      
      using namespace std;
 
      extern int yylex();
      extern int yyparse();
-     extern FILE* yyin;
+     extern void ScanSource(SourceFile* source, LexerKind lexer);
+     extern SourceFile* sourceFile;
      extern int lineNumber;
      int tempLineNumber;
 
@@ -23,7 +29,10 @@
 %require "2.4.1"
 
 %code requires{
+     #include "Atom.h"
+     #include "SourceFile.h"
      class node;
+     class NodeList;
 }
 
 %start program
@@ -32,18 +41,19 @@
 
 %union{
      int iValue;
-     std::string *sValue;
+     Atom atom;
+     SourceView view;
      node *Node;
-     std::vector<node*> *listNode;
+     NodeList *listNode;
 };
 
 %type <Node> program exp lValue BREAK NIL seqExp negation callExp infixExp arrCreate 
 %type <Node> fieldCreate recCreate assignment ifThenElse ifThen whileExp forExp letExp
 %type <Node> tyDec funDec dec ty arrTy recTy fieldDec varDec
 %type <listNode> exps fieldCreates decs fieldDecs
-%type <sValue> ID
+%type <atom> ID
 %token<iValue> INTLIT
-%token<sValue> STRLIT
+%token<view> STRLIT
 %token RBRACK LBRACE RBRACE COLON PERIOD COMMA SEMICOLON  RPAREN
 
 %token ARRAY BREAK ELSE END FOR IF IN LET NIL THEN TO VAR WHILE
@@ -66,8 +76,8 @@ program:
      exp {$$ = new program(lineNumber, $1); ast = $$; }
      ;
      
-exps: /* epsilon */ { $$ = new std::vector<node*>();}
-     |   exp { $$ = new std::vector<node*>(); $$->push_back($1);}
+exps: /* epsilon */ { $$ = new NodeList();}
+     |   exp { $$ = new NodeList(); $$->push_back($1);}
      |   exps SEMICOLON exp { $$->push_back($3);}
      |   exps COMMA exp { $$->push_back($3); }
      ;
@@ -76,7 +86,7 @@ exp:
      lValue {$$ = $1;}
      | NIL {$$ = new NNil(lineNumber);}
      | INTLIT {$$ = new NIntLit(lineNumber, $1);}
-     | STRLIT {$$ = new NStrLit(lineNumber, $1);}
+     | STRLIT {$$ = new NStrLit(lineNumber, Intern(sourceFile->Chars($1) + 1, $1.length - 2));}
      | seqExp {$$ = $1;}
      | negation {$$ = $1;}
      | callExp {$$ = $1;}
@@ -95,7 +105,7 @@ exp:
 
      
 decs: /* one or more */
-     dec { $$ = new std::vector<node*>();
+     dec { $$ = new NodeList();
           $$->push_back($1);}
      | decs dec {$$->push_back($2);}
      ;
@@ -124,7 +134,7 @@ recTy:
      LBRACE  fieldDecs RBRACE {$$ = new recTy(lineNumber, $2);}
      ;
      
-fieldDecs: /* epsilon */ {$$ = new std::vector<node*>();}
+fieldDecs: /* epsilon */ {$$ = new NodeList();}
      | fieldDecs fieldDec {$$->push_back($2);}
      | fieldDecs COMMA fieldDec {$$->push_back($3);}
      ;
@@ -185,7 +195,7 @@ recCreate:
      ID LBRACE fieldCreates RBRACE {$$ = new recCreate(lineNumber, new NTyId(lineNumber, $1), $3);}
      ;
      
-fieldCreates: /*zero or more */  { $$ = new std::vector<node*>();}
+fieldCreates: /*zero or more */  { $$ = new NodeList();}
      | fieldCreates fieldCreate {$$->push_back($2);}
      | fieldCreates COMMA fieldCreate  {$$->push_back($3);}
      ;
@@ -247,25 +257,100 @@ using namespace std;
 
 int main( int argc, char *argv[] )
 	{
+          //Pull out any options, leaving the file name
+          EngineKind engine = ENGINE_TREE;
+          bool jit = true;
+          bool emitC = false;
+          GCSettings gc;
+          size_t stackLimit = STACK_DEFAULT_LIMIT;
+          OutputMode outputMode = OUTPUT_WRITE;
+          LexerKind lexer = LEXER_FLEX;
+          bool lexBench = false;
+          char* fileName = NULL;
+          for(int i = 1; i < argc; i++)
+          {
+               string arg = argv[i];
+               if(arg == "--engine=tree")
+                    engine = ENGINE_TREE;
+               else if(arg == "--engine=vm")
+                    engine = ENGINE_VM;
+               else if(arg == "--engine=closure")
+                    engine = ENGINE_CLOSURE;
+               else if(arg == "--engine=stack")
+                    engine = ENGINE_STACK;
+               else if(arg == "--engine=flat")
+                    engine = ENGINE_FLAT;
+               else if(arg == "--jit=on")
+                    jit = true;
+               else if(arg == "--jit=off")
+                    jit = false;
+               else if(arg == "--emit-c")
+                    emitC = true;
+               else if(arg == "--gc-stats")
+                    gc.stats = true;
+               else if(arg.compare(0, 10, "--gc-heap=") == 0 && atoi(arg.c_str() + 10) > 0)
+                    gc.initialHeap = (size_t)atoi(arg.c_str() + 10) * 1024;
+               else if(arg.compare(0, 12, "--gc-growth=") == 0 && atof(arg.c_str() + 12) >= 1.0)
+                    gc.growth = atof(arg.c_str() + 12);
+               else if(arg.compare(0, 14, "--stack-limit=") == 0 && atoi(arg.c_str() + 14) > 0)
+                    stackLimit = (size_t)atoi(arg.c_str() + 14) * 1024 * 1024;
+               else if(arg == "--output=write")
+                    outputMode = OUTPUT_WRITE;
+               else if(arg == "--output=writev")
+                    outputMode = OUTPUT_WRITEV;
+               else if(arg == "--lexer=flex")
+                    lexer = LEXER_FLEX;
+               else if(arg == "--lexer=fast")
+                    lexer = LEXER_FAST;
+               else if(arg == "--lex-bench")
+                    lexBench = true;
+               else if(arg.compare(0, 2, "--") == 0)
+               {
+                    cerr << "ERROR: Unknown option '" << arg << "'. Usage: tigerc [--engine=tree|vm|closure|stack|flat] [--jit=on|off] [--emit-c] [--gc-stats] [--gc-heap=KB] [--gc-growth=factor] [--stack-limit=MB] [--output=write|writev] [--lexer=flex|fast] [--lex-bench] file" << endl;
+                    return 1;
+               }
+               else
+                    fileName = argv[i];
+          }
+
+          //Everything written to standard output from here on goes through one large buffer
+          InstallOutput(outputMode);
+
           //Exit if arguments not found
-          if(argc != 2)
+          if(fileName == NULL)
           {
                cerr << "ERROR: Insufficient arguments. Please specify a file to scan." << endl; 
                return 1;
           }
 
-          //Try to get the file from the user
-          //ifstream file;
-          //file.open(argv[1]);
-          FILE *file = fopen(argv[1], "r");
-          if(!file)
+          //Try to get the file from the user, mapped whole into memory
+          SourceFile source;
+          if(!source.Open(fileName))
           {
-               cerr << "ERROR: Failed to open target file '"<< argv[1] << "'. Confirm that the file exists or the name is correct." << endl;
+               cerr << "ERROR: Failed to open target file '"<< fileName << "'. Confirm that the file exists or the name is correct." << endl;
                return -1;
           }
           
-          //Construct a lexer with the file as the input stream
-	     yyin = file;
+          //Construct a lexer that scans the source in place
+          ScanSource(&source, lexer);
+
+          //Only tokenize the source, and report how fast that went
+          if(lexBench)
+          {
+               chrono::steady_clock::time_point start = chrono::steady_clock::now();
+               size_t tokens = 0;
+               while(yylex() != 0)
+                    tokens++;
+               double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+               double megabytes = source.Length() / (1024.0 * 1024.0);
+               cerr << "Lexer: " << tokens << " tokens, " << lineNumber << " lines, " << megabytes << " MB in "
+                    << seconds * 1000 << " ms, " << megabytes / seconds << " MB/s" << endl;
+               return 0;
+          }
+
+          //The whole tree lives in one arena, given back in one go when main returns
+          Arena astArena;
+          node::arena = &astArena;
           
           
           //Begin parsing, and grab return code
@@ -281,7 +366,15 @@ int main( int argc, char *argv[] )
                SemanticAnalyzer* semanticAnalyzer = new SemanticAnalyzer(ast);
                semanticAnalyzer->AnalyzeTree();
 
-               Interpreter* interpreter = new Interpreter(ast);
+               //Write the program out as C instead of running it
+               if(emitC)
+               {
+                    CBackend backend(ast);
+                    cout << backend.Emit();
+                    return 0;
+               }
+
+               Interpreter* interpreter = new Interpreter(ast, engine, jit, gc, stackLimit);
                interpreter->Interpret();
                return 0;
           }